@@ -70,6 +70,12 @@ void AIModelSettingsTab::LoadFromConfig(const ProjectConfig& config)
   ui_->plugin_script_edit_->setText(plugin.script_path);
   ui_->plugin_detect_args_edit_->setText(plugin.detect_args);
   ui_->plugin_train_args_edit_->setText(plugin.train_args);
+  ui_->detect_nice_spin_->setValue(plugin.detect_limits.nice_level);
+  ui_->detect_affinity_edit_->setText(plugin.detect_limits.cpu_affinity);
+  ui_->detect_threads_spin_->setValue(plugin.detect_limits.max_threads);
+  ui_->train_nice_spin_->setValue(plugin.train_limits.nice_level);
+  ui_->train_affinity_edit_->setText(plugin.train_limits.cpu_affinity);
+  ui_->train_threads_spin_->setValue(plugin.train_limits.max_threads);
 
   // Populate plugin settings table
   PopulatePluginSettingsTable();
@@ -81,6 +87,7 @@ void AIModelSettingsTab::LoadFromConfig(const ProjectConfig& config)
   ui_->val_ratio_slider_->setValue(static_cast<int>(split_cfg.target_val_ratio * 100));
   ui_->test_ratio_slider_->setValue(static_cast<int>(split_cfg.target_test_ratio * 100));
   ui_->salt_edit_->setText(split_cfg.hash_salt);
+  ui_->stratify_checkbox_->setChecked(split_cfg.stratify_by_class);
   OnSplitRatioChanged();  // Update labels
   UpdateSplitStatistics();
 
@@ -137,6 +144,12 @@ void AIModelSettingsTab::SaveToConfig(ProjectConfig& config)
   plugin.script_path = ui_->plugin_script_edit_->text();
   plugin.detect_args = ui_->plugin_detect_args_edit_->text();
   plugin.train_args = ui_->plugin_train_args_edit_->text();
+  plugin.detect_limits.nice_level = ui_->detect_nice_spin_->value();
+  plugin.detect_limits.cpu_affinity = ui_->detect_affinity_edit_->text().trimmed();
+  plugin.detect_limits.max_threads = ui_->detect_threads_spin_->value();
+  plugin.train_limits.nice_level = ui_->train_nice_spin_->value();
+  plugin.train_limits.cpu_affinity = ui_->train_affinity_edit_->text().trimmed();
+  plugin.train_limits.max_threads = ui_->train_threads_spin_->value();
 
   // Save plugin settings from table
   plugin.settings = GetPluginSettingsFromTable();
@@ -151,6 +164,7 @@ void AIModelSettingsTab::SaveToConfig(ProjectConfig& config)
   split_cfg.target_val_ratio = ui_->val_ratio_slider_->value() / 100.0;
   split_cfg.target_test_ratio = ui_->test_ratio_slider_->value() / 100.0;
   split_cfg.hash_salt = ui_->salt_edit_->text();
+  split_cfg.stratify_by_class = ui_->stratify_checkbox_->isChecked();
   config.SetSplitConfig(split_cfg);
 }
 
@@ -328,6 +342,7 @@ void AIModelSettingsTab::OnSplitsEnabledChanged(int state)
   ui_->train_ratio_slider_->setEnabled(enabled);
   ui_->val_ratio_slider_->setEnabled(enabled);
   ui_->test_ratio_slider_->setEnabled(enabled);
+  ui_->stratify_checkbox_->setEnabled(enabled);
   ui_->reset_splits_button_->setEnabled(enabled);
 
   SplitConfig split_cfg = config_.GetSplitConfig();
@@ -383,21 +398,12 @@ void AIModelSettingsTab::UpdateSplitStatistics()
     return;
   }
 
-  // Calculate actual split counts
-  int total_images = config_.GetImageFiles().size();
+  // Actual split counts are maintained by the config
+  int total_images = config_.GetImageSplits().size();
   QMap<QString, int> counts;
-  counts["train"] = 0;
-  counts["val"] = 0;
-  counts["test"] = 0;
-
-  for (const auto& img : config_.GetImageFiles())
-  {
-    QString split = config_.GetImageSplit(img);
-    if (counts.contains(split))
-    {
-      counts[split]++;
-    }
-  }
+  counts["train"] = config_.GetTrainCount();
+  counts["val"] = config_.GetValCount();
+  counts["test"] = config_.GetTestCount();
 
   int target_train = static_cast<int>(ui_->train_ratio_slider_->value());
   int target_val = static_cast<int>(ui_->val_ratio_slider_->value());
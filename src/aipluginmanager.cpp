@@ -3,20 +3,28 @@
 #include <QCoreApplication>
 #include <QDir>
 #include <QDirIterator>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QStatusBar>
 #include <QTextStream>
 
 #include <iostream>
 
+#include "datasetmanifest.h"
+#include "imagelocator.h"
 #include "modelregistrationdialog.h"
 #include "polygoncanvas.h"
 #include "projectconfig.h"
+#include "reviewstatetable.h"
+#include "trainingjobqueue.h"
+#include "trainingmonitordialog.h"
+#include "trainingqueuedialog.h"
 
 AIPluginManager::AIPluginManager(QObject* parent)
     : QObject(parent),
@@ -24,17 +32,29 @@ AIPluginManager::AIPluginManager(QObject* parent)
       canvas_(nullptr),
       status_bar_(nullptr),
       image_list_(nullptr),
-      training_process_(nullptr)
+      review_states_(nullptr),
+      batch_canceled_(false),
+      training_queue_(new TrainingJobQueue(this)),
+      training_monitor_(nullptr)
 {
+  training_queue_->SetJobPreparer([this](TrainingJob* job) { return PrepareTrainingJob(job); });
+  connect(training_queue_, &TrainingJobQueue::JobStarted, this,
+          &AIPluginManager::OnTrainingJobStarted);
+  connect(training_queue_, &TrainingJobQueue::JobFinished, this,
+          &AIPluginManager::OnTrainingJobFinished);
+  connect(training_queue_, &TrainingJobQueue::JobOutput, this,
+          [this](const QString& id, const QByteArray& output) {
+            // The monitor parses incrementally and redraws on its own timer
+            if (training_monitor_ != nullptr && id == monitored_job_)
+            {
+              training_monitor_->AppendOutput(output);
+            }
+          });
 }
 
 AIPluginManager::~AIPluginManager()
 {
-  if (training_process_ != nullptr)
-  {
-    training_process_->kill();
-    training_process_->deleteLater();
-  }
+  delete training_monitor_;
 }
 
 void AIPluginManager::SetProjectConfig(ProjectConfig* config)
@@ -55,6 +75,12 @@ void AIPluginManager::SetStatusBar(QStatusBar* status_bar)
 void AIPluginManager::SetProjectDirectory(const QString& dir)
 {
   project_directory_ = dir;
+  if (training_monitor_ != nullptr && training_monitor_->IsRunning())
+  {
+    training_monitor_->Finish(false, "Project closed");
+  }
+  monitored_job_.clear();
+  training_queue_->SetProjectDirectory(dir);
 }
 
 void AIPluginManager::SetImageList(const QStringList* list)
@@ -62,6 +88,11 @@ void AIPluginManager::SetImageList(const QStringList* list)
   image_list_ = list;
 }
 
+void AIPluginManager::SetReviewStateTable(ReviewStateTable* table)
+{
+  review_states_ = table;
+}
+
 bool AIPluginManager::IsPluginAvailable() const
 {
   if (project_config_ == nullptr)
@@ -107,6 +138,19 @@ QString AIPluginManager::BuildPluginCommand(const QString& args_template,
   return result;
 }
 
+QString AIPluginManager::PluginImagePath(const QString& image_path) const
+{
+  // Referenced images are handed over under their project name with the crop applied,
+  // so plugin output matches the image shown in the canvas
+  const ImageLocator locator(project_directory_, project_config_->GetImageReferences());
+  const QString image_file = QFileInfo(image_path).fileName();
+  if (!locator.IsReference(image_file) || image_path != locator.ProjectPath(image_file))
+  {
+    return image_path;
+  }
+  return locator.ExportPath(image_file);
+}
+
 void AIPluginManager::ExecutePluginCommand(const QString& command, const QStringList& args)
 {
   const PluginConfig& plugin = project_config_->GetPluginConfig();
@@ -127,8 +171,9 @@ void AIPluginManager::ExecutePluginCommand(const QString& command, const QString
   // If env_setup is provided, wrap the command in a shell with env setup
   if (!plugin.env_setup.isEmpty())
   {
-    // Build shell command: env_setup && command args...
-    QString shell_command = plugin.env_setup + " && " + command;
+    // Build shell command: env_setup && exec command args...
+    // exec replaces the shell, so terminate()/kill() reach the plugin itself
+    QString shell_command = plugin.env_setup + " && exec " + command;
     for (const QString& arg : args)
     {
       shell_command += " " + arg;
@@ -150,6 +195,7 @@ void AIPluginManager::ExecutePluginCommand(const QString& command, const QString
     std::cout << std::endl;
   }
 
+  plugin.detect_limits.ApplyTo(&process);
   process.start(full_command, full_args);
 
   if (!process.waitForStarted())
@@ -219,15 +265,16 @@ void AIPluginManager::ParseDetectionResults(const QString& json_output)
   int added = 0;
 
   // Get image dimensions for coordinate conversion
-  QPixmap pixmap = canvas_->GetPixmap();
-  if (pixmap.isNull())
+  // Original image size: the canvas may be showing a downscaled preview
+  QSize image_size = canvas_->GetOriginalImageSize();
+  if (image_size.isEmpty())
   {
     QMessageBox::warning(nullptr, "No Image", "No image loaded.");
     return;
   }
 
-  int img_width = pixmap.width();
-  int img_height = pixmap.height();
+  int img_width = image_size.width();
+  int img_height = image_size.height();
 
   // Collect detection details for summary
   QStringList detection_details;
@@ -399,11 +446,20 @@ void AIPluginManager::RunAutoDetect(const QString& current_image_path)
     return;
   }
 
+  const QString plugin_image_path = PluginImagePath(current_image_path);
+  if (plugin_image_path.isEmpty())
+  {
+    QMessageBox::warning(nullptr, "Image Not Available",
+                         "The source file of this referenced image is missing:\n" +
+                             current_image_path);
+    return;
+  }
+
   const PluginConfig& plugin = project_config_->GetPluginConfig();
 
   // Build variable substitutions
   QMap<QString, QString> vars;
-  vars["image"] = current_image_path;
+  vars["image"] = plugin_image_path;
   vars["project"] = project_directory_;
 
   // Add all plugin settings as variables
@@ -446,16 +502,62 @@ void AIPluginManager::RunTrainModel()
     return;
   }
 
-  // Generate split files if enabled
+  QMessageBox::StandardButton reply = QMessageBox::question(
+      nullptr, "Start Training",
+      "Training is queued and runs in the background once earlier jobs have finished.\n\n"
+      "Progress is shown in the training monitor.\n\n"
+      "The trained model is registered automatically when training completes.\n\n"
+      "Start training now?",
+      QMessageBox::Ok | QMessageBox::Cancel, QMessageBox::Ok);
+
+  if (reply == QMessageBox::Cancel)
+  {
+    return;
+  }
+
+  // One job at a time by default: it claims all cores
+  EnqueueTraining("Training " + QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm"),
+                  QMap<QString, QString>(), training_queue_->TotalCores(), 0);
+  if (training_queue_->IsPaused())
+  {
+    QMessageBox::information(nullptr, "Training Queue Paused",
+                             "The training queue still holds jobs from a previous session "
+                             "and is paused.\n\n"
+                             "Resume it from Training -> Training Queue.");
+  }
+  ShowTrainingMonitor();
+}
+
+void AIPluginManager::PrepareTrainingData()
+{
+  // Generate split files if enabled (only changed files are rewritten)
+  QStringList changed_splits;
   if (project_config_->IsSplitEnabled())
   {
-    project_config_->GenerateSplitFiles(project_directory_);
+    changed_splits = project_config_->GenerateSplitFiles(project_directory_);
   }
 
-  // Remove old cache files to force plugin to rescan labels
+  // Trainers cache parsed labels per split; drop a cache only when its split
+  // file or the labels it references changed since the last run
+  DatasetManifest manifest;
+  manifest.Load(project_directory_);
+  const QString labels_dir = project_directory_ + "/labels";
   QStringList cache_files;
-  cache_files << project_directory_ + "/images.cache" << project_directory_ + "/train.cache"
-              << project_directory_ + "/val.cache" << project_directory_ + "/test.cache";
+  for (const QString& split : {QString("train"), QString("val"), QString("test")})
+  {
+    const bool labels_changed =
+        manifest.UpdateSplit(split, labels_dir, project_config_->GetImagesInSplit(split));
+    if (labels_changed || changed_splits.contains(split))
+    {
+      cache_files << project_directory_ + "/" + split + ".cache"
+                  << project_directory_ + "/splits/" + split + ".cache";
+    }
+  }
+  if (!cache_files.isEmpty())
+  {
+    // Caches shared by all splits
+    cache_files << project_directory_ + "/images.cache" << project_directory_ + "/labels.cache";
+  }
 
   for (const QString& cache_file : cache_files)
   {
@@ -467,44 +569,92 @@ void AIPluginManager::RunTrainModel()
       }
     }
   }
+  manifest.Save(project_directory_);
 
   // Generate data.yaml file
   QString data_yaml_path = project_directory_ + "/data.yaml";
-  QFile data_yaml(data_yaml_path);
-  if (data_yaml.open(QIODevice::WriteOnly | QIODevice::Text))
-  {
-    QTextStream out(&data_yaml);
-    out << "# Dataset Configuration\n";
-    out << "path: " << project_directory_ << "\n";
-    out << "train: splits/train.txt\n";
-    out << "val: splits/val.txt\n";
-    out << "test: splits/test.txt\n\n";
-    out << "# Classes\n";
-    out << "names:\n";
-
-    const auto& classes = project_config_->GetClasses();
-    for (const auto& cls : classes)
-    {
-      out << "  " << cls.id << ": " << cls.name << "\n";
-    }
+  if (DatasetManifest::WriteIfChanged(data_yaml_path,
+                                      BuildDataYaml(project_directory_ + "/splits")))
+  {
+    std::cout << "Generated data.yaml with " << project_config_->GetClasses().size()
+              << " classes" << std::endl;
+  }
+  else if (!QFile::exists(data_yaml_path))
+  {
+    QMessageBox::warning(nullptr, "Warning", "Could not create data.yaml file.");
+  }
+}
+
+QByteArray AIPluginManager::BuildDataYaml(const QString& splits_dir) const
+{
+  // Split paths are relative to the project ("splits/train.txt" for the project split)
+  const QDir project(project_directory_);
+  QByteArray data_yaml;
+  QTextStream out(&data_yaml);
+  out << "# Dataset Configuration\n";
+  out << "path: " << project_directory_ << "\n";
+  out << "train: " << project.relativeFilePath(splits_dir + "/train.txt") << "\n";
+  out << "val: " << project.relativeFilePath(splits_dir + "/val.txt") << "\n";
+  out << "test: " << project.relativeFilePath(splits_dir + "/test.txt") << "\n\n";
+  out << "# Classes\n";
+  out << "names:\n";
+
+  const auto& classes = project_config_->GetClasses();
+  for (const auto& cls : classes)
+  {
+    out << "  " << cls.id << ": " << cls.name << "\n";
+  }
+
+  out << "\n# Number of classes\n";
+  out << "nc: " << classes.size() << "\n";
+  out.flush();
+  return data_yaml;
+}
 
-    out << "\n# Number of classes\n";
-    out << "nc: " << classes.size() << "\n";
+QString AIPluginManager::EnqueueTraining(const QString& name,
+                                         const QMap<QString, QString>& overrides, int cores,
+                                         qint64 memory_mb)
+{
+  const PluginConfig& plugin = project_config_->GetPluginConfig();
 
-    data_yaml.close();
-    std::cout << "Generated data.yaml with " << classes.size() << " classes" << std::endl;
+  TrainingJob job;
+  job.id = TrainingJobQueue::NewJobId();
+  job.name = name;
+  job.working_directory = project_directory_;
+  job.run_directory = project_directory_ + "/runs/queue_" + job.id;
+  job.cores = cores;
+  job.memory_mb = memory_mb;
+  job.overrides = overrides;
+  // A seeded job trains on its own split in run_dir
+  job.shared_dataset = !overrides.contains("seed");
+
+  // Background preset by default; never more threads than the cores the job claims
+  job.limits = plugin.train_limits;
+  if (job.limits.EffectiveThreads() == 0 || job.limits.EffectiveThreads() > cores)
+  {
+    job.limits.max_threads = cores;
   }
-  else
+
+  std::cout << "Queued training job " << job.id.toStdString() << " (" << name.toStdString()
+            << ")" << std::endl;
+  return training_queue_->Enqueue(job);
+}
+
+bool AIPluginManager::PrepareTrainingJob(TrainingJob* job)
+{
+  if (project_config_ == nullptr || job->working_directory != project_directory_)
   {
-    QMessageBox::warning(nullptr, "Warning", "Could not create data.yaml file.");
+    return false;
   }
 
   const PluginConfig& plugin = project_config_->GetPluginConfig();
 
   // Build variable substitutions
   QMap<QString, QString> vars;
+  vars["architecture"] = plugin.architecture;
+  vars["backbone"] = plugin.backbone;
 
-  // Add all plugin settings as variables first
+  // Add all plugin settings as variables
   for (auto it = plugin.settings.begin(); it != plugin.settings.end(); ++it)
   {
     vars[it.key()] = it.value();
@@ -518,6 +668,35 @@ void AIPluginManager::RunTrainModel()
   vars["train_count"] = QString::number(project_config_->GetTrainCount());
   vars["val_count"] = QString::number(project_config_->GetValCount());
   vars["test_count"] = QString::number(project_config_->GetTestCount());
+  vars["run_dir"] = job->run_directory;
+  vars["job"] = job->id;
+
+  if (job->shared_dataset)
+  {
+    // The queue starts no other job on the project split while this one runs
+    PrepareTrainingData();
+  }
+  else
+  {
+    // Re-drawn split for this job only; the project split stays as it is
+    const QString splits_dir = job->run_directory + "/splits";
+    QMap<QString, int> counts;
+    project_config_->GenerateSeededSplitFiles(project_directory_, splits_dir,
+                                              job->overrides.value("seed").toInt(), &counts);
+    vars["splits"] = splits_dir;
+    vars["data_yaml"] = job->run_directory + "/data.yaml";
+    vars["train_count"] = QString::number(counts.value("train"));
+    vars["val_count"] = QString::number(counts.value("val"));
+    vars["test_count"] = QString::number(counts.value("test"));
+    DatasetManifest::WriteIfChanged(vars["data_yaml"], BuildDataYaml(splits_dir));
+  }
+
+  // Job variants (backbone, seed, ...) win over everything else
+  for (auto it = job->overrides.begin(); it != job->overrides.end(); ++it)
+  {
+    vars[it.key()] = it.value();
+  }
+  job->training_images_count = vars["train_count"].toInt();
 
   // Build command arguments
   QString args_string = BuildPluginCommand(plugin.train_args, vars);
@@ -534,167 +713,285 @@ void AIPluginManager::RunTrainModel()
   // Add parsed arguments
   args.append(args_string.split(" ", Qt::SkipEmptyParts));
 
-  QMessageBox::StandardButton reply = QMessageBox::question(
-      nullptr, "Start Training",
-      "Training will run in the background.\n\n"
-      "Check the terminal for progress.\n\n"
-      "You will be prompted to register the model when training completes.\n\n"
-      "Start training now?",
-      QMessageBox::Ok | QMessageBox::Cancel, QMessageBox::Ok);
+  job->program = plugin.command;
+  job->arguments = args;
 
-  if (reply == QMessageBox::Cancel)
+  // If env_setup is provided, wrap the command in a shell with env setup
+  if (!plugin.env_setup.isEmpty())
   {
-    return;
-  }
+    // Build shell command: env_setup && exec command args...
+    // exec replaces the shell, so terminate()/kill() reach the plugin itself
+    QString shell_command = plugin.env_setup + " && exec " + plugin.command;
+    for (const QString& arg : args)
+    {
+      shell_command += " " + arg;
+    }
 
-  // Clean up any existing training process
-  if (training_process_ != nullptr)
-  {
-    training_process_->kill();
-    training_process_->deleteLater();
+    job->program = "bash";
+    job->arguments = QStringList() << "-c" << shell_command;
   }
+  return true;
+}
 
-  // Create tmp directory for logs
-  QString tmp_dir = project_directory_ + "/tmp";
-  QDir().mkpath(tmp_dir);
-
-  // Create log file paths
-  QString log_file_path = tmp_dir + "/training_output.log";
-  QString err_file_path = tmp_dir + "/training_error.log";
-
-  // Create process for async execution
-  training_process_ = new QProcess(this);
-  training_process_->setProcessChannelMode(QProcess::SeparateChannels);
-
-  // Set working directory to project directory
-  training_process_->setWorkingDirectory(project_directory_);
-  std::cout << "Training working directory: " << project_directory_.toStdString() << std::endl;
-  std::cout << "Training logs: " << log_file_path.toStdString() << std::endl;
-
-  // Open log files for writing
-  QFile* log_file = new QFile(log_file_path, training_process_);
-  QFile* err_file = new QFile(err_file_path, training_process_);
-
-  if (!log_file->open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Append))
+void AIPluginManager::ShowTrainingMonitor()
+{
+  if (training_monitor_ == nullptr)
   {
-    std::cerr << "Warning: Could not open log file for writing" << std::endl;
-    delete log_file;
-    log_file = nullptr;
+    training_monitor_ = new TrainingMonitorDialog();
+    connect(training_monitor_, &TrainingMonitorDialog::StopRequested, this, [this]() {
+      if (!monitored_job_.isEmpty())
+      {
+        training_queue_->Cancel(monitored_job_);
+      }
+    });
   }
 
-  if (!err_file->open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Append))
+  // Follow a job that is already running; output before this point is only in its log
+  if (!training_monitor_->IsRunning())
   {
-    std::cerr << "Warning: Could not open error log file for writing" << std::endl;
-    delete err_file;
-    err_file = nullptr;
-  }
-
-  // Connect to read output in real-time and write to both terminal and log file
-  connect(training_process_, &QProcess::readyReadStandardOutput, this, [this, log_file]() {
-    QString output = training_process_->readAllStandardOutput();
-    std::cout << output.toStdString() << std::flush;
-
-    if (log_file && log_file->isOpen())
+    for (const TrainingJob& job : training_queue_->Jobs())
     {
-      log_file->write(output.toUtf8());
-      log_file->flush();
+      if (job.status == TrainingJobStatus::Running)
+      {
+        monitored_job_ = job.id;
+        training_monitor_->Start(job.log_path);
+        break;
+      }
     }
-  });
-
-  connect(training_process_, &QProcess::readyReadStandardError, this, [this, err_file]() {
-    QString error_output = training_process_->readAllStandardError();
-    std::cerr << error_output.toStdString() << std::flush;
+  }
+  training_monitor_->show();
+  training_monitor_->raise();
+  training_monitor_->activateWindow();
+}
 
-    if (err_file && err_file->isOpen())
-    {
-      err_file->write(error_output.toUtf8());
-      err_file->flush();
-    }
-  });
+void AIPluginManager::ShowTrainingQueue()
+{
+  if (project_directory_.isEmpty())
+  {
+    QMessageBox::warning(nullptr, "No Project", "Please open a project first.");
+    return;
+  }
 
-  // Connect to finished signal for model registration
-  connect(training_process_, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
-          [this, log_file, err_file](int exitCode, QProcess::ExitStatus exitStatus) {
-            // Close log files
-            if (log_file && log_file->isOpen())
+  const PluginConfig& plugin = project_config_->GetPluginConfig();
+  TrainingQueueDialog dialog(training_queue_,
+                             RegistryBackbones(plugin.plugin_id, plugin.architecture),
+                             plugin.backbone);
+
+  connect(&dialog, &TrainingQueueDialog::EnqueueRequested, this,
+          [this, &dialog](const QString& name, const QStringList& backbones,
+                          const QList<int>& seeds, int cores, qint64 memory_mb) {
+            if (!IsPluginAvailable())
             {
-              log_file->close();
+              QMessageBox::warning(&dialog, "Plugin Not Available",
+                                   "AI plugin is not configured or script not found.");
+              return;
             }
-            if (err_file && err_file->isOpen())
+            if (!seeds.isEmpty() && !project_config_->IsSplitEnabled())
             {
-              err_file->close();
+              QMessageBox::warning(&dialog, "Splits Disabled",
+                                   "Split seeds need train/val/test splits to be enabled.");
+              return;
             }
 
-            if (exitStatus == QProcess::NormalExit && exitCode == 0)
+            // One job per combination; an empty list keeps the configured value
+            const QStringList backbone_variants = backbones.isEmpty() ? QStringList{QString()}
+                                                                      : backbones;
+            QList<int> seed_variants = seeds;
+            const bool use_seeds = !seeds.isEmpty();
+            if (!use_seeds)
             {
-              std::cout << "\n=== Training completed successfully ===\n" << std::endl;
-              // Training succeeded - prompt for model registration
-              PromptModelRegistration();
-              emit TrainingComplete(true);
+              seed_variants.append(0);
             }
-            else if (exitStatus == QProcess::CrashExit)
-            {
-              std::cerr << "\n=== Training process crashed ===\n" << std::endl;
-              QMessageBox::critical(nullptr, "Training Failed", "Training process crashed.");
-              emit TrainingComplete(false);
-            }
-            else
+
+            int queued = 0;
+            for (const QString& backbone : backbone_variants)
             {
-              std::cerr << "\n=== Training failed with exit code " << exitCode << " ===\n"
-                        << std::endl;
-              QMessageBox::critical(
-                  nullptr, "Training Failed",
-                  QString("Training exited with error code %1\n\nCheck terminal for details.")
-                      .arg(exitCode));
-              emit TrainingComplete(false);
+              for (int seed : seed_variants)
+              {
+                QMap<QString, QString> overrides;
+                QString job_name = name;
+                if (!backbone.isEmpty())
+                {
+                  overrides["backbone"] = backbone;
+                  job_name += " " + backbone;
+                }
+                if (use_seeds)
+                {
+                  overrides["seed"] = QString::number(seed);
+                  job_name += QString(" seed %1").arg(seed);
+                }
+                EnqueueTraining(job_name, overrides, cores, memory_mb);
+                queued++;
+              }
             }
-
-            training_process_->deleteLater();
-            training_process_ = nullptr;
+            emit StatusMessage(QString("Queued %1 training job(s)").arg(queued), 3000);
           });
 
-  // Start process
-  QString full_command = plugin.command;
-  QStringList full_args = args;
+  dialog.exec();
+}
 
-  // If env_setup is provided, wrap the command in a shell with env setup
-  if (!plugin.env_setup.isEmpty())
+QStringList AIPluginManager::RegistryBackbones(const QString& plugin_id,
+                                               const QString& architecture)
+{
+  QFile file(":/data/model_registry.json");
+  if (!file.open(QIODevice::ReadOnly))
   {
-    // Build shell command: env_setup && command args...
-    QString shell_command = plugin.env_setup + " && " + plugin.command;
-    for (const QString& arg : args)
+    return QStringList();
+  }
+
+  const QJsonObject plugin =
+      QJsonDocument::fromJson(file.readAll()).object()["plugins"].toObject()[plugin_id]
+          .toObject();
+
+  // detectron2 lists backbones per architecture; smp lists encoders for all decoders
+  QJsonArray entries = plugin["encoders"].toArray();
+  for (const QJsonValue& value : plugin["architectures"].toArray())
+  {
+    const QJsonObject arch = value.toObject();
+    if (arch["id"].toString() == architecture)
     {
-      shell_command += " " + arg;
+      entries = arch["backbones"].toArray();
     }
+  }
 
-    full_command = "bash";
-    full_args = QStringList() << "-c" << shell_command;
+  QStringList backbones;
+  for (const QJsonValue& value : entries)
+  {
+    backbones.append(value.toObject()["id"].toString());
+  }
+  return backbones;
+}
+
+void AIPluginManager::OnTrainingJobStarted(const QString& id)
+{
+  const TrainingJob* job = training_queue_->Job(id);
+  if (job == nullptr || training_monitor_ == nullptr)
+  {
+    return;
+  }
+
+  // The monitor follows one job; it moves on when that one is done
+  if (!training_monitor_->IsRunning())
+  {
+    monitored_job_ = id;
+    training_monitor_->Start(job->log_path);
+  }
+}
+
+void AIPluginManager::OnTrainingJobFinished(const QString& id, bool success)
+{
+  const TrainingJob* job = training_queue_->Job(id);
+  if (job == nullptr)
+  {
+    return;
+  }
 
-    std::cout << "Executing training with env setup: bash -c \"" << shell_command.toStdString()
-              << "\"" << std::endl;
+  QString message;
+  if (success)
+  {
+    std::cout << "\n=== Training job " << id.toStdString() << " completed ===\n" << std::endl;
+    message = "Completed";
+  }
+  else if (job->status == TrainingJobStatus::Canceled)
+  {
+    message = "Canceled";
+  }
+  else if (job->exit_code < 0)
+  {
+    message = "Crashed";
   }
   else
   {
-    std::cout << "Executing: " << plugin.command.toStdString();
-    for (const QString& arg : args)
+    message = QString("Failed (exit code %1)").arg(job->exit_code);
+  }
+  if (!success)
+  {
+    std::cerr << "\n=== Training job " << id.toStdString() << ": " << message.toStdString()
+              << " ===\n"
+              << std::endl;
+  }
+
+  if (training_monitor_ != nullptr && monitored_job_ == id)
+  {
+    training_monitor_->Finish(success, message);
+    monitored_job_.clear();
+  }
+
+  const QString job_name = job->name;
+  if (success)
+  {
+    RegisterTrainedModel(id);
+  }
+  emit StatusMessage(QString("Training '%1': %2").arg(job_name, message), 5000);
+  emit TrainingComplete(success);
+}
+
+QString AIPluginManager::FindTrainedModel(const QString& dir, const QDateTime& newer_than)
+{
+  // Most recently modified best.pt below dir
+  QString trained_model_path;
+  QDateTime latest_time;
+  QDirIterator it(dir, QStringList() << "best.pt", QDir::Files, QDirIterator::Subdirectories);
+  while (it.hasNext())
+  {
+    QString file_path = it.next();
+    QFileInfo file_info(file_path);
+    if (newer_than.isValid() && file_info.lastModified() < newer_than)
     {
-      std::cout << " " << arg.toStdString();
+      continue;
     }
-    std::cout << std::endl;
+    if (!latest_time.isValid() || file_info.lastModified() > latest_time)
+    {
+      latest_time = file_info.lastModified();
+      trained_model_path = file_path;
+    }
+  }
+  return trained_model_path;
+}
+
+void AIPluginManager::RegisterTrainedModel(const QString& job_id)
+{
+  const TrainingJob* job = training_queue_->Job(job_id);
+  if (job == nullptr)
+  {
+    return;
   }
 
-  training_process_->start(full_command, full_args);
+  // Plugins that honour {run_dir} write there; others fall back to anything under
+  // runs/ written since the job started
+  QString trained_model_path = FindTrainedModel(job->run_directory, QDateTime());
+  if (trained_model_path.isEmpty())
+  {
+    trained_model_path = FindTrainedModel(project_directory_ + "/runs", job->started_at);
+  }
+  if (trained_model_path.isEmpty())
+  {
+    std::cout << "No best.pt found for training job " << job_id.toStdString() << std::endl;
+    return;
+  }
 
-  if (!training_process_->waitForStarted())
+  const QString relative_path = "models/" + job->id + "_best.pt";
+  const QString dest_path = project_directory_ + "/" + relative_path;
+  QDir().mkpath(project_directory_ + "/models");
+  QFile::remove(dest_path);
+  if (!QFile::copy(trained_model_path, dest_path))
   {
-    QMessageBox::critical(nullptr, "Plugin Error",
-                          "Failed to start training command:\n" + plugin.command);
-    training_process_->deleteLater();
-    training_process_ = nullptr;
+    std::cerr << "Failed to copy model to: " << dest_path.toStdString() << std::endl;
     return;
   }
 
-  std::cout << "\n=== Training started ===\n" << std::endl;
+  ModelVersion model;
+  model.name = job->name;
+  model.path = relative_path;
+  model.timestamp = QDateTime::currentDateTime();
+  model.training_images_count = job->training_images_count;
+  model.notes = QString("Trained by queued job %1 (%2)")
+                    .arg(job->id, QDir(project_directory_).relativeFilePath(job->log_path));
+  project_config_->AddModelVersion(model);
+  training_queue_->SetModelPath(job_id, relative_path);
+
+  std::cout << "Registered model '" << model.name.toStdString()
+            << "': " << relative_path.toStdString() << std::endl;
 }
 
 void AIPluginManager::RunBatchDetect()
@@ -742,9 +1039,23 @@ void AIPluginManager::RunBatchDetect()
 
   emit StatusMessage("Batch detection in progress...");
 
+  QProgressDialog progress("Running batch detection...", "Cancel", 0, total_images);
+  progress.setWindowTitle("Batch Detection");
+  progress.setWindowModality(Qt::ApplicationModal);
+  progress.setMinimumDuration(0);
+  batch_canceled_ = false;
+  connect(&progress, &QProgressDialog::canceled, this, [this]() { batch_canceled_ = true; });
+
   // Process each image
+  int index = 0;
   for (const QString& image_file : *image_list_)
   {
+    progress.setValue(index++);
+    if (batch_canceled_)
+    {
+      break;
+    }
+
     QString image_path = project_directory_ + "/images/" + image_file;
 
     // Skip if already has approved annotations (unless user wants to override)
@@ -774,23 +1085,28 @@ void AIPluginManager::RunBatchDetect()
     // Allow UI updates
     QCoreApplication::processEvents();
   }
+  progress.setValue(total_images);
 
   // Show summary
   QString summary = QString(
-                        "Batch detection complete!\n\n"
+                        "%4\n\n"
                         "Processed: %1 images\n"
                         "Detections found: %2 images\n"
                         "Skipped (approved): %3 images\n\n"
                         "Use Tools -> Next Unreviewed to review detections.")
                         .arg(processed)
                         .arg(detected)
-                        .arg(skipped);
+                        .arg(skipped)
+                        .arg(batch_canceled_ ? "Batch detection canceled."
+                                             : "Batch detection complete!");
 
   QMessageBox::information(nullptr, "Batch Detection Complete", summary);
 
-  emit StatusMessage(
-      QString("Batch detection complete: %1 detected, %2 skipped").arg(detected).arg(skipped),
-      10000);
+  emit StatusMessage(QString("Batch detection %1: %2 detected, %3 skipped")
+                         .arg(batch_canceled_ ? "canceled" : "complete")
+                         .arg(detected)
+                         .arg(skipped),
+                     10000);
 
   // Signal to jump to first unreviewed image
   emit RequestNextUnreviewed();
@@ -798,11 +1114,19 @@ void AIPluginManager::RunBatchDetect()
 
 void AIPluginManager::BatchDetectOnImage(const QString& image_path)
 {
+  const QString plugin_image_path = PluginImagePath(image_path);
+  if (plugin_image_path.isEmpty())
+  {
+    std::cerr << "Source of referenced image is missing: " << image_path.toStdString()
+              << std::endl;
+    return;
+  }
+
   const PluginConfig& plugin = project_config_->GetPluginConfig();
 
   // Build variable substitutions
   QMap<QString, QString> vars;
-  vars["image"] = image_path;
+  vars["image"] = plugin_image_path;
   vars["project"] = project_directory_;
 
   // Add all plugin settings as variables
@@ -836,8 +1160,9 @@ void AIPluginManager::BatchDetectOnImage(const QString& image_path)
   // If env_setup is provided, wrap the command in a shell with env setup
   if (!plugin.env_setup.isEmpty())
   {
-    // Build shell command: env_setup && command args...
-    QString shell_command = plugin.env_setup + " && " + plugin.command;
+    // Build shell command: env_setup && exec command args...
+    // exec replaces the shell, so terminate()/kill() reach the plugin itself
+    QString shell_command = plugin.env_setup + " && exec " + plugin.command;
     for (const QString& arg : args)
     {
       shell_command += " " + arg;
@@ -847,6 +1172,7 @@ void AIPluginManager::BatchDetectOnImage(const QString& image_path)
     full_args = QStringList() << "-c" << shell_command;
   }
 
+  plugin.detect_limits.ApplyTo(&process);
   process.start(full_command, full_args);
 
   if (!process.waitForStarted())
@@ -855,11 +1181,22 @@ void AIPluginManager::BatchDetectOnImage(const QString& image_path)
     return;
   }
 
-  if (!process.waitForFinished(30000))
+  // Wait in short slices so the batch can be canceled while an image is processed
+  QElapsedTimer timer;
+  timer.start();
+  while (process.state() != QProcess::NotRunning && !process.waitForFinished(100))
   {
-    std::cerr << "Plugin timeout for: " << image_path.toStdString() << std::endl;
-    process.kill();
-    return;
+    QCoreApplication::processEvents();
+    if (batch_canceled_ || timer.elapsed() > 30000)
+    {
+      if (!batch_canceled_)
+      {
+        std::cerr << "Plugin timeout for: " << image_path.toStdString() << std::endl;
+      }
+      process.kill();
+      process.waitForFinished(1000);
+      return;
+    }
   }
 
   QString output = process.readAll();
@@ -931,7 +1268,7 @@ void AIPluginManager::BatchDetectOnImage(const QString& image_path)
   QTextStream out(&meta_file);
 
   // Load image to get dimensions (for validation, dimensions already in JSON as normalized)
-  QPixmap pixmap(image_path);
+  QPixmap pixmap(plugin_image_path);
   if (pixmap.isNull())
   {
     std::cerr << "Failed to load image: " << image_path.toStdString() << std::endl;
@@ -1013,6 +1350,12 @@ void AIPluginManager::BatchDetectOnImage(const QString& image_path)
   meta_file.close();
   std::cout << "Saved " << detections.size() << " detections to: " << meta_path.toStdString()
             << std::endl;
+
+  if (review_states_ != nullptr &&
+      review_states_->GetState(fileInfo.fileName()) != ReviewState::Approved)
+  {
+    review_states_->SetState(fileInfo.fileName(), ReviewState::Meta);
+  }
 }
 
 void AIPluginManager::SaveToMetaFile(const QString& image_path)
@@ -1023,6 +1366,12 @@ void AIPluginManager::SaveToMetaFile(const QString& image_path)
   // Use existing ExportAnnotations logic but to .meta file
   canvas_->ExportAnnotations(meta_path, 0);
   std::cout << "Saved to meta file: " << meta_path.toStdString() << std::endl;
+
+  if (review_states_ != nullptr &&
+      review_states_->GetState(fileInfo.fileName()) != ReviewState::Approved)
+  {
+    review_states_->SetState(fileInfo.fileName(), ReviewState::Meta);
+  }
 }
 
 void AIPluginManager::LoadFromMetaFile(const QString& image_path)
@@ -1050,6 +1399,17 @@ void AIPluginManager::LoadFromMetaFile(const QString& image_path)
 bool AIPluginManager::HasMetaFile(const QString& image_path) const
 {
   QFileInfo fileInfo(image_path);
+
+  // The table only tracks the meta file for images that are not approved yet
+  if (review_states_ != nullptr && review_states_->Contains(fileInfo.fileName()))
+  {
+    ReviewState state = review_states_->GetState(fileInfo.fileName());
+    if (state != ReviewState::Approved)
+    {
+      return state == ReviewState::Meta;
+    }
+  }
+
   QString meta_path = project_directory_ + "/labels/" + fileInfo.baseName() + ".meta";
   return QFile::exists(meta_path);
 }
@@ -1057,6 +1417,12 @@ bool AIPluginManager::HasMetaFile(const QString& image_path) const
 bool AIPluginManager::HasApprovedFile(const QString& image_path) const
 {
   QFileInfo fileInfo(image_path);
+
+  if (review_states_ != nullptr && review_states_->Contains(fileInfo.fileName()))
+  {
+    return review_states_->GetState(fileInfo.fileName()) == ReviewState::Approved;
+  }
+
   QString label_path = project_directory_ + "/labels/" + fileInfo.baseName() + ".txt";
   return QFile::exists(label_path);
 }
@@ -1082,6 +1448,11 @@ void AIPluginManager::PromoteMetaToApproved(const QString& image_path)
   if (QFile::rename(meta_path, label_path))
   {
     std::cout << "Approved: " << fileInfo.baseName().toStdString() << std::endl;
+
+    if (review_states_ != nullptr)
+    {
+      review_states_->SetState(fileInfo.fileName(), ReviewState::Approved);
+    }
   }
   else
   {
@@ -1099,6 +1470,12 @@ void AIPluginManager::DeleteMetaFile(const QString& image_path)
     QFile::remove(meta_path);
     std::cout << "Rejected meta file: " << fileInfo.baseName().toStdString() << std::endl;
   }
+
+  if (review_states_ != nullptr &&
+      review_states_->GetState(fileInfo.fileName()) == ReviewState::Meta)
+  {
+    review_states_->SetState(fileInfo.fileName(), ReviewState::None);
+  }
 }
 
 int AIPluginManager::CountUnreviewedImages() const
@@ -1108,6 +1485,12 @@ int AIPluginManager::CountUnreviewedImages() const
     return 0;
   }
 
+  // Unreviewed = no approved .txt (with or without a .meta)
+  if (review_states_ != nullptr && review_states_->Size() == image_list_->size())
+  {
+    return review_states_->CountUnreviewed();
+  }
+
   int count = 0;
 
   for (const QString& image_file : *image_list_)
@@ -1133,39 +1516,15 @@ int AIPluginManager::CountUnreviewedImages() const
 void AIPluginManager::PromptModelRegistration()
 {
   // Find the trained model - search recursively in runs directory
-  QString trained_model_path;
   QString runs_dir = project_directory_ + "/runs";
-
-  // Recursively search for best.pt files
-  QDir runs(runs_dir);
-  if (runs.exists())
+  QString trained_model_path = FindTrainedModel(runs_dir, QDateTime());
+  if (!trained_model_path.isEmpty())
   {
-    QDirIterator it(runs_dir, QStringList() << "best.pt", QDir::Files,
-                    QDirIterator::Subdirectories);
-
-    QDateTime latest_time;
-
-    while (it.hasNext())
-    {
-      QString file_path = it.next();
-      QFileInfo file_info(file_path);
-
-      // Find the most recently modified best.pt
-      if (!latest_time.isValid() || file_info.lastModified() > latest_time)
-      {
-        latest_time = file_info.lastModified();
-        trained_model_path = file_path;
-      }
-    }
-
-    if (!trained_model_path.isEmpty())
-    {
-      std::cout << "Found trained model: " << trained_model_path.toStdString() << std::endl;
-    }
-    else
-    {
-      std::cout << "No best.pt found in: " << runs_dir.toStdString() << std::endl;
-    }
+    std::cout << "Found trained model: " << trained_model_path.toStdString() << std::endl;
+  }
+  else
+  {
+    std::cout << "No best.pt found in: " << runs_dir.toStdString() << std::endl;
   }
 
   // Copy to models/best.pt if found
@@ -1212,13 +1571,20 @@ void AIPluginManager::RegisterModelManually()
 
   // Count labeled images
   int labeled_count = 0;
-  QString labels_dir = project_directory_ + "/labels";
-  for (const QString& img : *image_list_)
+  if (review_states_ != nullptr && review_states_->Size() == image_list_->size())
+  {
+    labeled_count = review_states_->Count(ReviewState::Approved);
+  }
+  else
   {
-    QString label_file = labels_dir + "/" + QFileInfo(img).completeBaseName() + ".txt";
-    if (QFile::exists(label_file))
+    QString labels_dir = project_directory_ + "/labels";
+    for (const QString& img : *image_list_)
     {
-      labeled_count++;
+      QString label_file = labels_dir + "/" + QFileInfo(img).completeBaseName() + ".txt";
+      if (QFile::exists(label_file))
+      {
+        labeled_count++;
+      }
     }
   }
 
@@ -1,6 +1,9 @@
 #ifndef AIPLUGINMANAGER_H
 #define AIPLUGINMANAGER_H
 
+#include <QByteArray>
+#include <QDateTime>
+#include <QMap>
 #include <QObject>
 #include <QProcess>
 #include <QString>
@@ -9,6 +12,10 @@
 class ProjectConfig;
 class PolygonCanvas;
 class QStatusBar;
+class ReviewStateTable;
+class TrainingJobQueue;
+struct TrainingJob;
+class TrainingMonitorDialog;
 
 class AIPluginManager : public QObject
 {
@@ -24,6 +31,7 @@ class AIPluginManager : public QObject
   void SetStatusBar(QStatusBar* status_bar);
   void SetProjectDirectory(const QString& dir);
   void SetImageList(const QStringList* list);
+  void SetReviewStateTable(ReviewStateTable* table);
 
   // Plugin availability
   bool IsPluginAvailable() const;
@@ -35,8 +43,15 @@ class AIPluginManager : public QObject
   void RunBatchDetect();
   void BatchDetectOnImage(const QString& image_path);
 
-  // Training
+  // Training (queued; see TrainingJobQueue)
   void RunTrainModel();
+  void ShowTrainingMonitor();
+  void ShowTrainingQueue();
+  QString EnqueueTraining(const QString& name, const QMap<QString, QString>& overrides,
+                          int cores, qint64 memory_mb);
+
+  // Backbones model_registry.json lists for a plugin architecture
+  static QStringList RegistryBackbones(const QString& plugin_id, const QString& architecture);
 
   // Model registration
   void PromptModelRegistration();
@@ -63,13 +78,25 @@ class AIPluginManager : public QObject
                              const QMap<QString, QString>& variables) const;
   void ExecutePluginCommand(const QString& command, const QStringList& args);
   void ParseDetectionResults(const QString& json_output);
+  QString PluginImagePath(const QString& image_path) const;
+  void PrepareTrainingData();
+  bool PrepareTrainingJob(TrainingJob* job);
+  QByteArray BuildDataYaml(const QString& splits_dir) const;
+  void OnTrainingJobStarted(const QString& id);
+  void OnTrainingJobFinished(const QString& id, bool success);
+  void RegisterTrainedModel(const QString& job_id);
+  static QString FindTrainedModel(const QString& dir, const QDateTime& newer_than);
 
   ProjectConfig* project_config_;
   PolygonCanvas* canvas_;
   QStatusBar* status_bar_;
   QString project_directory_;
   const QStringList* image_list_;
-  QProcess* training_process_;
+  ReviewStateTable* review_states_;  // Optional; avoids stat() per image when set
+  bool batch_canceled_;              // Set from the batch progress dialog
+  TrainingJobQueue* training_queue_;
+  TrainingMonitorDialog* training_monitor_;  // Created on first use, kept between runs
+  QString monitored_job_;                    // Job shown in the monitor
 };
 
 #endif  // AIPLUGINMANAGER_H
@@ -0,0 +1,304 @@
+#include "contenthashindex.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include <iostream>
+
+#include "xxhash64.h"
+
+QString ContentHashIndex::IndexPath(const QString& project_dir)
+{
+  return project_dir + "/.polyseg/content_index.json";
+}
+
+bool ContentHashIndex::Load(const QString& project_dir)
+{
+  entries_.clear();
+  by_size_.clear();
+
+  QFile file(IndexPath(project_dir));
+  if (!file.exists())
+  {
+    return true;
+  }
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    std::cerr << "Cannot open content index: " << file.fileName().toStdString() << std::endl;
+    return false;
+  }
+
+  QJsonObject images = QJsonDocument::fromJson(file.readAll()).object()["images"].toObject();
+  for (auto it = images.begin(); it != images.end(); ++it)
+  {
+    QJsonObject obj = it.value().toObject();
+    ContentHashEntry entry;
+    entry.size = obj["size"].toString().toLongLong();
+    entry.mtime = obj["mtime"].toString().toLongLong();
+    bool ok = false;
+    if (obj.contains("hash"))
+    {
+      entry.hash = obj["hash"].toString().toULongLong(&ok, 16);
+      entry.has_hash = ok;
+    }
+    if (obj.contains("dhash"))
+    {
+      entry.dhash = obj["dhash"].toString().toULongLong(&ok, 16);
+      entry.has_dhash = ok;
+    }
+    if (obj.contains("source_hash"))
+    {
+      entry.source_size = obj["source_size"].toString().toLongLong();
+      entry.source_hash = obj["source_hash"].toString().toULongLong(&ok, 16);
+      entry.has_source_hash = ok;
+    }
+    entries_.insert(it.key(), entry);
+  }
+
+  RebuildSizeIndex();
+  return true;
+}
+
+bool ContentHashIndex::Save(const QString& project_dir) const
+{
+  // 64-bit values are stored as strings; JSON numbers are doubles
+  QJsonObject images;
+  for (auto it = entries_.constBegin(); it != entries_.constEnd(); ++it)
+  {
+    const ContentHashEntry& entry = it.value();
+    QJsonObject obj;
+    obj["size"] = QString::number(entry.size);
+    obj["mtime"] = QString::number(entry.mtime);
+    if (entry.has_hash)
+    {
+      obj["hash"] = QString::number(entry.hash, 16);
+    }
+    if (entry.has_dhash)
+    {
+      obj["dhash"] = QString::number(entry.dhash, 16);
+    }
+    if (entry.has_source_hash)
+    {
+      obj["source_size"] = QString::number(entry.source_size);
+      obj["source_hash"] = QString::number(entry.source_hash, 16);
+    }
+    images[it.key()] = obj;
+  }
+
+  QJsonObject root;
+  root["version"] = 1;
+  root["images"] = images;
+
+  const QString path = IndexPath(project_dir);
+  QDir().mkpath(QFileInfo(path).absolutePath());
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    std::cerr << "Cannot write content index: " << path.toStdString() << std::endl;
+    return false;
+  }
+  file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+  return file.commit();
+}
+
+void ContentHashIndex::Sync(const QString& images_dir, const QStringList& image_files,
+                            const QSet<qint64>& hash_sizes, bool need_dhash)
+{
+  QHash<QString, ContentHashEntry> synced;
+  synced.reserve(image_files.size());
+
+  for (const QString& image_file : image_files)
+  {
+    QFileInfo info(images_dir + "/" + image_file);
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+
+    ContentHashEntry entry = entries_.value(image_file);
+    if (entry.size != info.size() || entry.mtime != mtime)
+    {
+      entry = ContentHashEntry();
+      entry.size = info.size();
+      entry.mtime = mtime;
+    }
+    synced.insert(image_file, entry);
+  }
+  entries_ = synced;
+
+  // Collect the hashing work, then spread it over the cores
+  QStringList work;
+  for (auto it = entries_.constBegin(); it != entries_.constEnd(); ++it)
+  {
+    if ((!it.value().has_hash && hash_sizes.contains(it.value().size)) ||
+        (need_dhash && !it.value().has_dhash))
+    {
+      work.append(it.key());
+    }
+  }
+
+  if (!work.isEmpty())
+  {
+    QVector<ContentHashEntry> results(work.size());
+    for (int i = 0; i < work.size(); ++i)
+    {
+      results[i] = entries_.value(work[i]);
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    ContentHashEntry* outputs = results.data();
+    for (int i = 0; i < work.size(); ++i)
+    {
+      const QString path = images_dir + "/" + work[i];
+      ContentHashEntry* slot = outputs + i;
+      pool.start([slot, path, &hash_sizes, need_dhash]() {
+        if (!slot->has_hash && hash_sizes.contains(slot->size))
+        {
+          slot->has_hash = FileHash(path, &slot->hash);
+        }
+        if (need_dhash && !slot->has_dhash)
+        {
+          slot->has_dhash = PerceptualHash(path, &slot->dhash);
+        }
+      });
+    }
+    pool.waitForDone();
+
+    for (int i = 0; i < work.size(); ++i)
+    {
+      entries_.insert(work[i], results[i]);
+    }
+  }
+
+  RebuildSizeIndex();
+}
+
+void ContentHashIndex::Insert(const QString& image_file, const ContentHashEntry& entry)
+{
+  const ContentHashEntry old_entry = entries_.value(image_file);
+  by_size_.remove(old_entry.size, image_file);
+  by_size_.remove(old_entry.source_size, image_file);
+
+  entries_.insert(image_file, entry);
+  by_size_.insert(entry.size, image_file);
+  if (entry.has_source_hash && entry.source_size != entry.size)
+  {
+    by_size_.insert(entry.source_size, image_file);
+  }
+}
+
+QString ContentHashIndex::FindExact(qint64 size, quint64 hash) const
+{
+  for (auto it = by_size_.constFind(size); it != by_size_.constEnd() && it.key() == size; ++it)
+  {
+    const ContentHashEntry entry = entries_.value(it.value());
+    if ((entry.has_hash && entry.size == size && entry.hash == hash) ||
+        (entry.has_source_hash && entry.source_size == size && entry.source_hash == hash))
+    {
+      return it.value();
+    }
+  }
+  return QString();
+}
+
+QString ContentHashIndex::FindNear(quint64 dhash, int max_distance) const
+{
+  QString best;
+  int best_distance = max_distance + 1;
+  for (auto it = entries_.constBegin(); it != entries_.constEnd(); ++it)
+  {
+    if (!it.value().has_dhash)
+    {
+      continue;
+    }
+    const int distance = HammingDistance(dhash, it.value().dhash);
+    if (distance < best_distance)
+    {
+      best_distance = distance;
+      best = it.key();
+    }
+  }
+  return best;
+}
+
+bool ContentHashIndex::FileHash(const QString& path, quint64* hash)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+
+  static constexpr qint64 kBlockSize = 1024 * 1024;
+  QByteArray block(kBlockSize, Qt::Uninitialized);
+  XxHash64 hasher;
+  qint64 read = 0;
+  while ((read = file.read(block.data(), kBlockSize)) > 0)
+  {
+    hasher.AddData(block.constData(), read);
+  }
+  if (read < 0)
+  {
+    return false;
+  }
+
+  *hash = hasher.Result();
+  return true;
+}
+
+bool ContentHashIndex::PerceptualHash(const QString& path, quint64* dhash)
+{
+  // A tiny decode is enough; JPEG files are scaled inside the decoder
+  QImageReader reader(path);
+  reader.setScaledSize(QSize(9, 8));
+  QImage image;
+  if (!reader.read(&image))
+  {
+    return false;
+  }
+  if (image.size() != QSize(9, 8))
+  {
+    image = image.scaled(9, 8, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+  }
+  image = image.convertToFormat(QImage::Format_Grayscale8);
+
+  quint64 bits = 0;
+  for (int y = 0; y < 8; ++y)
+  {
+    const uchar* row = image.constScanLine(y);
+    for (int x = 0; x < 8; ++x)
+    {
+      bits = (bits << 1) | (row[x] < row[x + 1] ? 1 : 0);
+    }
+  }
+
+  *dhash = bits;
+  return true;
+}
+
+int ContentHashIndex::HammingDistance(quint64 a, quint64 b)
+{
+  return qPopulationCount(a ^ b);
+}
+
+void ContentHashIndex::RebuildSizeIndex()
+{
+  by_size_.clear();
+  by_size_.reserve(entries_.size());
+  for (auto it = entries_.constBegin(); it != entries_.constEnd(); ++it)
+  {
+    by_size_.insert(it.value().size, it.key());
+    if (it.value().has_source_hash && it.value().source_size != it.value().size)
+    {
+      by_size_.insert(it.value().source_size, it.key());
+    }
+  }
+}
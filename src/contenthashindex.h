@@ -0,0 +1,103 @@
+#ifndef CONTENTHASHINDEX_H
+#define CONTENTHASHINDEX_H
+
+#include <QHash>
+#include <QMultiHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Content fingerprint of one project image
+ *
+ * Hashes are computed lazily: an entry may only carry size and mtime until
+ * an import needs its hash (size prefilter) or its perceptual hash.
+ */
+struct ContentHashEntry
+{
+  qint64 size = 0;
+  qint64 mtime = 0;  // Last modification, ms since epoch
+  bool has_hash = false;
+  quint64 hash = 0;  // XXH64 of the file content
+  bool has_dhash = false;
+  quint64 dhash = 0;  // 64-bit difference hash of the decoded image
+  qint64 source_size = 0;  // Original file of an image cropped on import
+  bool has_source_hash = false;
+  quint64 source_hash = 0;
+};
+
+/**
+ * @brief Persistent index of image content hashes for duplicate detection
+ *
+ * Handles:
+ * - Exact duplicates: file size prefilter, then XXH64 of the content (and of the
+ *   original file for images cropped on import)
+ * - Near duplicates: 64-bit dHash compared by Hamming distance
+ * - Persistence in <project>/.polyseg/content_index.json, revalidated by size and mtime
+ */
+class ContentHashIndex
+{
+ public:
+  /**
+   * @brief Path of the index file inside a project
+   */
+  static QString IndexPath(const QString& project_dir);
+
+  /**
+   * @brief Load the index of a project (a missing file gives an empty index)
+   */
+  bool Load(const QString& project_dir);
+
+  /**
+   * @brief Save the index into the project
+   */
+  bool Save(const QString& project_dir) const;
+
+  /**
+   * @brief Bring entries in line with images/ and compute missing hashes
+   * @param images_dir Project images directory
+   * @param image_files Current image file names
+   * @param hash_sizes File sizes whose images need a content hash
+   * @param need_dhash Compute perceptual hashes for every image
+   *
+   * Entries of removed images are dropped; changed files are re-fingerprinted.
+   * Hashing runs in parallel.
+   */
+  void Sync(const QString& images_dir, const QStringList& image_files,
+            const QSet<qint64>& hash_sizes, bool need_dhash);
+
+  void Insert(const QString& image_file, const ContentHashEntry& entry);
+  ContentHashEntry Entry(const QString& image_file) const { return entries_.value(image_file); }
+  int Size() const { return entries_.size(); }
+  bool ContainsSize(qint64 size) const { return by_size_.contains(size); }
+
+  /**
+   * @brief Image with identical content, or an empty string
+   */
+  QString FindExact(qint64 size, quint64 hash) const;
+
+  /**
+   * @brief Most similar image within max_distance bits, or an empty string
+   */
+  QString FindNear(quint64 dhash, int max_distance) const;
+
+  /**
+   * @brief XXH64 of a file's content, streamed in 1 MiB blocks
+   */
+  static bool FileHash(const QString& path, quint64* hash);
+
+  /**
+   * @brief 64-bit difference hash (9x8 grayscale, adjacent pixel comparison)
+   */
+  static bool PerceptualHash(const QString& path, quint64* dhash);
+
+  static int HammingDistance(quint64 a, quint64 b);
+
+ private:
+  void RebuildSizeIndex();
+
+  QHash<QString, ContentHashEntry> entries_;
+  QMultiHash<qint64, QString> by_size_;  // File and source sizes -> image
+};
+
+#endif  // CONTENTHASHINDEX_H
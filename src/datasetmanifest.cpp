@@ -0,0 +1,239 @@
+#include "datasetmanifest.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <iostream>
+
+#include "contenthashindex.h"
+#include "projectscanner.h"
+#include "xxhash64.h"
+
+QString DatasetManifest::ManifestPath(const QString& project_dir)
+{
+  return project_dir + "/.polyseg/label_manifest.json";
+}
+
+bool DatasetManifest::Load(const QString& project_dir)
+{
+  labels_.clear();
+  split_digests_.clear();
+
+  QFile file(ManifestPath(project_dir));
+  if (!file.exists())
+  {
+    return true;
+  }
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    std::cerr << "Cannot open label manifest: " << file.fileName().toStdString() << std::endl;
+    return false;
+  }
+
+  const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+
+  const QJsonObject labels = root["labels"].toObject();
+  for (auto it = labels.begin(); it != labels.end(); ++it)
+  {
+    const QJsonObject obj = it.value().toObject();
+    LabelState state;
+    state.size = obj["size"].toString().toLongLong();
+    state.mtime = obj["mtime"].toString().toLongLong();
+    if (obj.contains("hash"))
+    {
+      state.hash = obj["hash"].toString().toULongLong(&state.has_hash, 16);
+    }
+    if (obj.contains("classes"))
+    {
+      state.has_classes = true;
+      for (const QJsonValue& value : obj["classes"].toArray())
+      {
+        state.classes.append(value.toInt());
+      }
+    }
+    labels_.insert(it.key(), state);
+  }
+
+  const QJsonObject splits = root["splits"].toObject();
+  for (auto it = splits.begin(); it != splits.end(); ++it)
+  {
+    split_digests_.insert(it.key(), it.value().toString().toULongLong(nullptr, 16));
+  }
+
+  return true;
+}
+
+bool DatasetManifest::Save(const QString& project_dir) const
+{
+  // 64-bit values are stored as strings; JSON numbers are doubles
+  QJsonObject labels;
+  for (auto it = labels_.constBegin(); it != labels_.constEnd(); ++it)
+  {
+    QJsonObject obj;
+    obj["size"] = QString::number(it.value().size);
+    obj["mtime"] = QString::number(it.value().mtime);
+    if (it.value().has_hash)
+    {
+      obj["hash"] = QString::number(it.value().hash, 16);
+    }
+    if (it.value().has_classes)
+    {
+      QJsonArray classes;
+      for (int class_id : it.value().classes)
+      {
+        classes.append(class_id);
+      }
+      obj["classes"] = classes;
+    }
+    labels[it.key()] = obj;
+  }
+
+  QJsonObject splits;
+  for (auto it = split_digests_.constBegin(); it != split_digests_.constEnd(); ++it)
+  {
+    splits[it.key()] = QString::number(it.value(), 16);
+  }
+
+  QJsonObject root;
+  root["version"] = 1;
+  root["labels"] = labels;
+  root["splits"] = splits;
+
+  const QString path = ManifestPath(project_dir);
+  QDir().mkpath(QFileInfo(path).absolutePath());
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    std::cerr << "Cannot write label manifest: " << path.toStdString() << std::endl;
+    return false;
+  }
+  file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+  return file.commit();
+}
+
+bool DatasetManifest::UpdateSplit(const QString& split, const QString& labels_dir,
+                                  const QStringList& image_files)
+{
+  QStringList sorted = image_files;
+  sorted.sort();
+
+  XxHash64 digest;
+  for (const QString& image_file : sorted)
+  {
+    const QString stem = ProjectScanner::CompleteBaseName(image_file);
+    const QFileInfo info(labels_dir + "/" + stem + ".txt");
+
+    QByteArray line = stem.toUtf8() + '\0';
+    if (info.exists())
+    {
+      LabelState& state = Refresh(stem, info);
+      if (!state.has_hash)
+      {
+        state.has_hash = ContentHashIndex::FileHash(info.filePath(), &state.hash);
+      }
+      line += QByteArray::number(state.hash, 16);
+    }
+    else
+    {
+      labels_.remove(stem);
+      line += '-';
+    }
+    digest.AddData(line + '\n');
+  }
+
+  const quint64 value = digest.Result();
+  const bool changed = !split_digests_.contains(split) || split_digests_.value(split) != value;
+  split_digests_.insert(split, value);
+  return changed;
+}
+
+QHash<QString, QVector<int>> DatasetManifest::LabelClasses(const QString& labels_dir,
+                                                           const QStringList& image_files)
+{
+  QHash<QString, QVector<int>> image_classes;
+  image_classes.reserve(image_files.size());
+  for (const QString& image_file : image_files)
+  {
+    const QString stem = ProjectScanner::CompleteBaseName(image_file);
+    const QFileInfo info(labels_dir + "/" + stem + ".txt");
+    if (!info.exists())
+    {
+      continue;
+    }
+
+    LabelState& state = Refresh(stem, info);
+    if (!state.has_classes)
+    {
+      state.classes = ReadClasses(info.filePath());
+      state.has_classes = true;
+    }
+    image_classes.insert(image_file, state.classes);
+  }
+  return image_classes;
+}
+
+DatasetManifest::LabelState& DatasetManifest::Refresh(const QString& stem, const QFileInfo& info)
+{
+  LabelState& state = labels_[stem];
+  const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+  if (state.size != info.size() || state.mtime != mtime)
+  {
+    state = LabelState();
+    state.size = info.size();
+    state.mtime = mtime;
+  }
+  return state;
+}
+
+QVector<int> DatasetManifest::ReadClasses(const QString& label_path)
+{
+  QVector<int> classes;
+  QFile file(label_path);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    return classes;
+  }
+
+  // The class id is the first field of every "class x1 y1 x2 y2 ..." line
+  while (!file.atEnd())
+  {
+    const QByteArray line = file.readLine().trimmed();
+    const int end = line.indexOf(' ');
+    bool ok = false;
+    const int class_id = line.left(end).toInt(&ok);
+    if (ok && !classes.contains(class_id))
+    {
+      classes.append(class_id);
+    }
+  }
+  std::sort(classes.begin(), classes.end());
+  return classes;
+}
+
+bool DatasetManifest::WriteIfChanged(const QString& path, const QByteArray& content)
+{
+  QFile existing(path);
+  if (existing.open(QIODevice::ReadOnly) && existing.size() == content.size() &&
+      XxHash64::Hash(existing.readAll()) == XxHash64::Hash(content))
+  {
+    return false;
+  }
+  existing.close();
+
+  QDir().mkpath(QFileInfo(path).absolutePath());
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    std::cerr << "Cannot write " << path.toStdString() << std::endl;
+    return false;
+  }
+  file.write(content);
+  return file.commit();
+}
@@ -0,0 +1,86 @@
+#ifndef DATASETMANIFEST_H
+#define DATASETMANIFEST_H
+
+#include <QByteArray>
+#include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief Label state of a dataset at the last training run
+ *
+ * Trainers (YOLO-style) cache parsed labels per split in *.cache files, and
+ * rebuilding them costs minutes on large datasets. The manifest remembers
+ * the size, mtime and hash of every label file referenced by a split, so a
+ * cache is only dropped when the labels behind it changed.
+ *
+ * Handles:
+ * - Persistence in <project>/.polyseg/label_manifest.json
+ * - Per-split label digests; files whose size and mtime did not change are not re-read
+ * - Class ids per label file, the index used for class-stratified splits
+ * - Writing generated files only when their content digest changes
+ */
+class DatasetManifest
+{
+ public:
+  /**
+   * @brief Path of the manifest file inside a project
+   */
+  static QString ManifestPath(const QString& project_dir);
+
+  /**
+   * @brief Load the manifest of a project (a missing file gives an empty manifest)
+   */
+  bool Load(const QString& project_dir);
+
+  /**
+   * @brief Save the manifest into the project
+   */
+  bool Save(const QString& project_dir) const;
+
+  /**
+   * @brief Recompute the label digest of one split
+   * @param split Split name ("train", "val", "test", or "images" without splits)
+   * @param labels_dir Project labels/ directory
+   * @param image_files Images of the split
+   * @return true if the digest differs from the one stored for the split
+   */
+  bool UpdateSplit(const QString& split, const QString& labels_dir,
+                   const QStringList& image_files);
+
+  /**
+   * @brief Class ids found in the labels of the given images
+   * @return Image file name -> sorted unique class ids (unlabeled images are left out)
+   */
+  QHash<QString, QVector<int>> LabelClasses(const QString& labels_dir,
+                                            const QStringList& image_files);
+
+  /**
+   * @brief Write a file only if its content digest differs from the file on disk
+   * @return true if the file was written (new or changed)
+   */
+  static bool WriteIfChanged(const QString& path, const QByteArray& content);
+
+ private:
+  struct LabelState
+  {
+    qint64 size = 0;
+    qint64 mtime = 0;
+    bool has_hash = false;
+    quint64 hash = 0;
+    bool has_classes = false;
+    QVector<int> classes;
+  };
+
+  // State of a label file, reset when its size or mtime changed
+  LabelState& Refresh(const QString& stem, const QFileInfo& info);
+  static QVector<int> ReadClasses(const QString& label_path);
+
+  QHash<QString, LabelState> labels_;  // Label stem -> state when last hashed
+  QMap<QString, quint64> split_digests_;
+};
+
+#endif  // DATASETMANIFEST_H
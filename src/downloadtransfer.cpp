@@ -0,0 +1,728 @@
+#include "downloadtransfer.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QSslError>
+#include <QUrl>
+
+#include "modeldownloadmanager.h"
+
+namespace
+{
+constexpr qint64 kReadBufferBytes = 2 * 1024 * 1024;  // Per reply; the socket stalls when full
+constexpr qint64 kWriteChunkBytes = 1024 * 1024;      // Smallest regular write
+constexpr qint64 kWriteAlignment = 64 * 1024;         // Regular writes end on this offset
+constexpr int kHashBufferSize = 65536;
+constexpr int kProgressIntervalMs = 250;
+constexpr int kStateIntervalMs = 1000;
+}
+
+DownloadTransfer::DownloadTransfer(QObject* parent)
+    : QObject(parent),
+      network_manager_(nullptr),
+      head_reply_(nullptr),
+      output_file_(nullptr),
+      id_(0),
+      max_segments_(1),
+      min_segment_bytes_(1),
+      total_bytes_(-1),
+      last_reported_bytes_(-1),
+      bytes_per_second_(0),
+      stream_hash_(QCryptographicHash::Sha256),
+      hashed_bytes_(0)
+{
+}
+
+DownloadTransfer::~DownloadTransfer()
+{
+  StopTransfer(true);
+}
+
+void DownloadTransfer::Start(quint64 id, const QString& url, const QString& destination,
+                             int max_segments, qint64 min_segment_bytes)
+{
+  StopTransfer(true);
+
+  id_ = id;
+  url_ = url;
+  destination_ = destination;
+  max_segments_ = qMax(1, max_segments);
+  min_segment_bytes_ = qMax<qint64>(1, min_segment_bytes);
+
+  // Created on first use so it belongs to the worker thread
+  if (!network_manager_)
+  {
+    network_manager_ = new QNetworkAccessManager(this);
+  }
+
+  // Size, range support and validators decide between resume, segments and a plain stream
+  QNetworkRequest request{QUrl(url_)};
+  request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
+                       QNetworkRequest::NoLessSafeRedirectPolicy);
+  // Byte ranges refer to the file itself, not to a compressed transfer
+  request.setRawHeader("Accept-Encoding", "identity");
+  head_reply_ = network_manager_->head(request);
+
+  connect(head_reply_, &QNetworkReply::finished, this, &DownloadTransfer::OnHeadFinished);
+  connect(head_reply_, &QNetworkReply::sslErrors, this, &DownloadTransfer::OnSslErrors);
+}
+
+void DownloadTransfer::Cancel()
+{
+  StopTransfer(true);
+}
+
+void DownloadTransfer::OnHeadFinished()
+{
+  QNetworkReply* reply = head_reply_;
+  head_reply_ = nullptr;
+  if (!reply)
+  {
+    return;
+  }
+  reply->deleteLater();
+
+  // A failed HEAD is not fatal; some servers only answer GET
+  const bool head_ok = reply->error() == QNetworkReply::NoError;
+  qint64 total = -1;
+  bool accepts_ranges = false;
+  QString etag;
+  QString last_modified;
+  if (head_ok)
+  {
+    bool ok = false;
+    total = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong(&ok);
+    if (!ok)
+    {
+      total = -1;
+    }
+    accepts_ranges = reply->rawHeader("Accept-Ranges").toLower().contains("bytes");
+    etag = QString::fromLatin1(reply->rawHeader("ETag"));
+    last_modified = QString::fromLatin1(reply->rawHeader("Last-Modified"));
+  }
+
+  BeginTransfer(head_ok, total, accepts_ranges, etag, last_modified);
+}
+
+void DownloadTransfer::BeginTransfer(bool head_ok, qint64 total, bool accepts_ranges,
+                                     const QString& etag, const QString& last_modified)
+{
+  const QString part_path = destination_ + ".part";
+  const qint64 part_size = QFileInfo::exists(part_path) ? QFileInfo(part_path).size() : 0;
+
+  // Saved progress is only valid for the same file on the server
+  const bool have_state = LoadState();
+  const bool same_remote = total_bytes_ == total && total > 0 && etag_ == etag &&
+                           (last_modified_.isEmpty() || last_modified.isEmpty() ||
+                            last_modified_ == last_modified);
+  bool fresh = false;
+  if (have_state && same_remote && accepts_ranges && part_size > 0)
+  {
+    emit StatusMessage(id_, tr("Resuming download"));
+  }
+  else if (!have_state && part_size > 0 && (!head_ok || accepts_ranges) &&
+           (total < 0 || part_size < total))
+  {
+    // .part from a single-stream download: its bytes are contiguous from 0
+    segments_ = {Segment()};
+    segments_[0].end = total > 0 ? total - 1 : -1;
+    segments_[0].done = part_size;
+    emit StatusMessage(id_, tr("Resuming download"));
+  }
+  else
+  {
+    fresh = true;
+    segments_.clear();
+    int count = 1;
+    if (accepts_ranges && total > 0 && max_segments_ > 1)
+    {
+      count = static_cast<int>(qBound<qint64>(1, total / min_segment_bytes_, max_segments_));
+    }
+    const qint64 segment_size = total > 0 ? total / count : 0;
+    for (int i = 0; i < count; ++i)
+    {
+      Segment segment;
+      segment.start = i * segment_size;
+      segment.end = total > 0 ? (i == count - 1 ? total - 1 : (i + 1) * segment_size - 1) : -1;
+      segments_.append(segment);
+    }
+  }
+  total_bytes_ = total;
+  etag_ = etag;
+  last_modified_ = last_modified;
+
+  // ReadWrite keeps existing bytes; only a fresh download starts from an empty file
+  output_file_ = new QFile(part_path, this);
+  if (!output_file_->open(QIODevice::ReadWrite))
+  {
+    const QString error = output_file_->errorString();
+    delete output_file_;
+    output_file_ = nullptr;
+    segments_.clear();
+    emit Failed(id_, tr("Cannot create output file: %1").arg(error));
+    return;
+  }
+  if (fresh)
+  {
+    output_file_->resize(0);
+    if (segments_.size() > 1 && !output_file_->resize(total))
+    {
+      const QString error = output_file_->errorString();
+      StopTransfer(false);
+      emit Failed(id_, tr("Cannot allocate %1 bytes: %2").arg(total).arg(error));
+      return;
+    }
+  }
+  SaveState();
+  state_timer_.start();
+
+  // Bytes kept from an earlier run are hashed once; new bytes as they are written
+  ResetStreamHash();
+  AdvanceStreamHash();
+
+  last_reported_bytes_ = -1;
+  bytes_per_second_ = 0;
+  ReportProgress(true);
+
+  bool all_complete = true;
+  for (int i = 0; i < segments_.size(); ++i)
+  {
+    if (!segments_[i].IsComplete())
+    {
+      all_complete = false;
+      StartSegment(i);
+    }
+  }
+  if (all_complete)
+  {
+    CompleteDownload();
+  }
+}
+
+void DownloadTransfer::StartSegment(int index)
+{
+  Segment& segment = segments_[index];
+  QNetworkRequest request{QUrl(url_)};
+  request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
+                       QNetworkRequest::NoLessSafeRedirectPolicy);
+  request.setRawHeader("Accept-Encoding", "identity");
+
+  const qint64 from = segment.start + segment.done;
+  if (from > 0 || segments_.size() > 1)
+  {
+    QByteArray range = "bytes=" + QByteArray::number(from) + "-";
+    if (segment.end >= 0)
+    {
+      range += QByteArray::number(segment.end);
+    }
+    request.setRawHeader("Range", range);
+
+    // The server sends the whole file instead of the range if it changed meanwhile
+    if (!etag_.isEmpty() && !etag_.startsWith("W/"))
+    {
+      request.setRawHeader("If-Range", etag_.toLatin1());
+    }
+    else if (!last_modified_.isEmpty())
+    {
+      request.setRawHeader("If-Range", last_modified_.toLatin1());
+    }
+  }
+
+  QNetworkReply* reply = network_manager_->get(request);
+  reply->setReadBufferSize(kReadBufferBytes);
+  segment.reply = reply;
+  segment.checked = false;
+  segment.discard = false;
+
+  connect(reply, &QNetworkReply::readyRead, this, [this, index]() { OnSegmentData(index); });
+  connect(reply, &QNetworkReply::finished, this, [this, index]() { OnSegmentFinished(index); });
+  connect(reply, &QNetworkReply::sslErrors, this, &DownloadTransfer::OnSslErrors);
+}
+
+void DownloadTransfer::OnSegmentData(int index)
+{
+  Segment& segment = segments_[index];
+  QNetworkReply* reply = segment.reply;
+  if (!reply || !output_file_)
+  {
+    return;
+  }
+
+  if (!segment.checked)
+  {
+    segment.checked = true;
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const bool asked_range = !reply->request().rawHeader("Range").isEmpty();
+    if (asked_range && status == 200)
+    {
+      // Range ignored, or the file changed (If-Range): the body is the whole file,
+      // streamed over this connection as the only segment
+      RestartAsSingleStream(index);
+      OnSegmentData(0);
+      return;
+    }
+    if (status == 416 && segments_.size() == 1 && segment.end < 0 && segment.done > 0)
+    {
+      // Resumed at the end of the file; OnSegmentFinished completes it
+      segment.discard = true;
+    }
+    else if (status != 0 && status != (asked_range ? 206 : 200))
+    {
+      // An error page is not file data: write nothing, so progress stays where it was
+      Fail(tr("Server returned HTTP %1").arg(status));
+      return;
+    }
+  }
+  if (segment.discard)
+  {
+    reply->readAll();
+    return;
+  }
+
+  QByteArray data = reply->readAll();
+  if (segment.end >= 0)
+  {
+    const qint64 remaining = segment.end - segment.start + 1 - segment.Received();
+    if (data.size() > remaining)
+    {
+      data.truncate(remaining);
+    }
+  }
+  if (data.isEmpty())
+  {
+    return;
+  }
+  segment.pending.append(data);
+
+  if (!WriteSegment(index, false))
+  {
+    return;
+  }
+
+  ReportProgress(false);
+  if (state_timer_.elapsed() >= kStateIntervalMs)
+  {
+    SaveState();
+    state_timer_.restart();
+  }
+}
+
+void DownloadTransfer::OnSegmentFinished(int index)
+{
+  if (index >= segments_.size() || !segments_[index].reply)
+  {
+    return;
+  }
+
+  QNetworkReply* reply = segments_[index].reply;
+  OnSegmentData(index);
+  if (!segments_.isEmpty() && segments_[0].reply == reply)
+  {
+    // A full response to a range request continues as the only segment
+    index = 0;
+  }
+  else if (index >= segments_.size() || segments_[index].reply != reply)
+  {
+    // Restarted or stopped while handling the data
+    return;
+  }
+  if (!WriteSegment(index, true))
+  {
+    return;
+  }
+
+  Segment& segment = segments_[index];
+  segment.reply = nullptr;
+  reply->deleteLater();
+
+  const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if (status == 416 && segments_.size() == 1 && segment.end < 0 && segment.done > 0)
+  {
+    // Resumed at the end of the file: the .part is already complete
+    segment.end = segment.start + segment.done - 1;
+  }
+  else if (reply->error() != QNetworkReply::NoError)
+  {
+    Fail(tr("Network error: %1").arg(reply->errorString()));
+    return;
+  }
+  else if (segment.end < 0)
+  {
+    // Size was unknown; the stream ended
+    segment.end = segment.start + segment.done - 1;
+    total_bytes_ = segment.end + 1;
+  }
+  else if (!segment.IsComplete())
+  {
+    Fail(tr("Connection closed before the download was complete"));
+    return;
+  }
+
+  // A finished segment may close the gap in front of later ones
+  AdvanceStreamHash();
+
+  for (const Segment& other : segments_)
+  {
+    if (!other.IsComplete())
+    {
+      SaveState();
+      return;
+    }
+  }
+  CompleteDownload();
+}
+
+void DownloadTransfer::OnSslErrors(const QList<QSslError>& errors)
+{
+  QStringList error_strings;
+  for (const QSslError& error : errors)
+  {
+    error_strings << error.errorString();
+  }
+
+  // The reply then fails and reports the download error
+  emit StatusMessage(id_, tr("SSL errors: %1").arg(error_strings.join(", ")));
+}
+
+bool DownloadTransfer::WriteSegment(int index, bool flush_all)
+{
+  Segment& segment = segments_[index];
+  const qint64 offset = segment.start + segment.done;
+  qint64 length = segment.pending.size();
+  if (!flush_all)
+  {
+    // Write whole chunks up to an aligned offset; the tail waits for more data
+    length = (offset + length) / kWriteAlignment * kWriteAlignment - offset;
+    if (length < kWriteChunkBytes)
+    {
+      return true;
+    }
+  }
+  if (length <= 0)
+  {
+    return true;
+  }
+
+  const char* data = segment.pending.constData();
+  if (!output_file_->seek(offset) || output_file_->write(data, length) != length)
+  {
+    Fail(tr("Cannot write output file: %1").arg(output_file_->errorString()));
+    return false;
+  }
+  if (offset == hashed_bytes_)
+  {
+    stream_hash_.addData(QByteArrayView(data, length));
+    hashed_bytes_ += length;
+  }
+  segment.done += length;
+  segment.pending.remove(0, length);
+  return true;
+}
+
+bool DownloadTransfer::WritePending()
+{
+  for (int i = 0; i < segments_.size(); ++i)
+  {
+    if (!WriteSegment(i, true))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void DownloadTransfer::RestartAsSingleStream(int index)
+{
+  QNetworkReply* reply = segments_[index].reply;
+  segments_[index].reply = nullptr;
+  AbortSegments();
+
+  // The file may have changed on the server: size and validators come from this
+  // response, and the .part file is rewritten from the start
+  bool ok = false;
+  const qint64 total = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong(&ok);
+  const QString etag = QString::fromLatin1(reply->rawHeader("ETag"));
+  const QString last_modified = QString::fromLatin1(reply->rawHeader("Last-Modified"));
+  if (etag != etag_ || last_modified != last_modified_)
+  {
+    emit StatusMessage(id_, tr("File changed on the server, restarting download"));
+  }
+  else if (segments_.size() > 1)
+  {
+    emit StatusMessage(id_, tr("Server ignores byte ranges, downloading over one connection"));
+  }
+  else
+  {
+    emit StatusMessage(id_, tr("Server cannot resume, restarting download"));
+  }
+  total_bytes_ = ok && total >= 0 ? total : -1;
+  etag_ = etag;
+  last_modified_ = last_modified;
+
+  segments_ = {Segment()};
+  segments_[0].end = total_bytes_ > 0 ? total_bytes_ - 1 : -1;
+  segments_[0].reply = reply;
+  segments_[0].checked = true;
+  output_file_->resize(0);
+  ResetStreamHash();
+  SaveState();
+
+  // Handlers were bound to the old segment index
+  reply->disconnect(this);
+  connect(reply, &QNetworkReply::readyRead, this, [this]() { OnSegmentData(0); });
+  connect(reply, &QNetworkReply::finished, this, [this]() { OnSegmentFinished(0); });
+  connect(reply, &QNetworkReply::sslErrors, this, &DownloadTransfer::OnSslErrors);
+}
+
+void DownloadTransfer::AbortSegments()
+{
+  for (Segment& segment : segments_)
+  {
+    if (segment.reply)
+    {
+      segment.reply->disconnect(this);
+      segment.reply->abort();
+      segment.reply->deleteLater();
+      segment.reply = nullptr;
+    }
+  }
+}
+
+void DownloadTransfer::StopTransfer(bool keep_partial)
+{
+  if (head_reply_)
+  {
+    head_reply_->disconnect(this);
+    head_reply_->abort();
+    head_reply_->deleteLater();
+    head_reply_ = nullptr;
+  }
+  AbortSegments();
+
+  if (output_file_)
+  {
+    if (keep_partial)
+    {
+      // Received bytes are worth keeping; a write error here only loses them
+      for (Segment& segment : segments_)
+      {
+        const qint64 offset = segment.start + segment.done;
+        if (!segment.pending.isEmpty() && output_file_->seek(offset) &&
+            output_file_->write(segment.pending) == segment.pending.size())
+        {
+          segment.done += segment.pending.size();
+        }
+        segment.pending.clear();
+      }
+      SaveState();
+    }
+    output_file_->close();
+    if (!keep_partial)
+    {
+      ModelDownloadManager::DiscardPartialDownload(destination_);
+    }
+    output_file_->deleteLater();
+    output_file_ = nullptr;
+  }
+  segments_.clear();
+}
+
+void DownloadTransfer::Fail(const QString& error_message)
+{
+  StopTransfer(true);
+  emit Failed(id_, error_message);
+}
+
+void DownloadTransfer::CompleteDownload()
+{
+  if (!WritePending())
+  {
+    return;
+  }
+  ReportProgress(true);
+
+  AdvanceStreamHash();
+  const bool fully_hashed = hashed_bytes_ == total_bytes_;
+  const QString digest = fully_hashed ? QString(stream_hash_.result().toHex()) : QString();
+
+  output_file_->close();
+  const QString partial_path = output_file_->fileName();
+  output_file_->deleteLater();
+  output_file_ = nullptr;
+  segments_.clear();
+  QFile::remove(ModelDownloadManager::PartialStatePath(destination_));
+
+  // Rename from .part to final name
+  if (QFile::exists(destination_))
+  {
+    QFile::remove(destination_);
+  }
+
+  if (!QFile::rename(partial_path, destination_))
+  {
+    QFile::remove(partial_path);
+    emit Failed(id_, tr("Failed to rename downloaded file"));
+    return;
+  }
+
+  emit Finished(id_, destination_, digest);
+}
+
+void DownloadTransfer::ReportProgress(bool force)
+{
+  if (!force && progress_timer_.isValid() && progress_timer_.elapsed() < kProgressIntervalMs)
+  {
+    return;
+  }
+
+  qint64 received = 0;
+  for (const Segment& segment : segments_)
+  {
+    received += segment.Received();
+  }
+
+  // Exponential moving average, so one slow interval does not swing the ETA
+  if (last_reported_bytes_ >= 0 && progress_timer_.elapsed() > 0)
+  {
+    const qint64 rate = (received - last_reported_bytes_) * 1000 / progress_timer_.elapsed();
+    bytes_per_second_ = bytes_per_second_ > 0 ? (bytes_per_second_ * 7 + rate * 3) / 10 : rate;
+  }
+  last_reported_bytes_ = received;
+  progress_timer_.restart();
+
+  qint64 eta_seconds = -1;
+  if (total_bytes_ > 0 && bytes_per_second_ > 0)
+  {
+    eta_seconds = (total_bytes_ - received) / bytes_per_second_;
+  }
+  emit Progress(id_, received, total_bytes_, bytes_per_second_, eta_seconds);
+}
+
+void DownloadTransfer::ResetStreamHash()
+{
+  stream_hash_.reset();
+  hashed_bytes_ = 0;
+}
+
+void DownloadTransfer::AdvanceStreamHash()
+{
+  if (!output_file_)
+  {
+    return;
+  }
+
+  // End of the bytes on disk contiguously from offset 0 (segments are ordered)
+  qint64 contiguous = 0;
+  for (const Segment& segment : segments_)
+  {
+    if (segment.start > contiguous)
+    {
+      break;
+    }
+    contiguous = qMax(contiguous, segment.start + segment.done);
+  }
+  if (contiguous <= hashed_bytes_)
+  {
+    return;
+  }
+
+  output_file_->flush();
+  if (!output_file_->seek(hashed_bytes_))
+  {
+    return;
+  }
+  char buffer[kHashBufferSize];
+  while (hashed_bytes_ < contiguous)
+  {
+    const qint64 bytes_read =
+        output_file_->read(buffer, qMin<qint64>(kHashBufferSize, contiguous - hashed_bytes_));
+    if (bytes_read <= 0)
+    {
+      break;
+    }
+    stream_hash_.addData(QByteArrayView(buffer, bytes_read));
+    hashed_bytes_ += bytes_read;
+  }
+}
+
+bool DownloadTransfer::LoadState()
+{
+  segments_.clear();
+  total_bytes_ = -1;
+  etag_.clear();
+  last_modified_.clear();
+
+  QFile file(ModelDownloadManager::PartialStatePath(destination_));
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+
+  const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+  if (root["url"].toString() != url_)
+  {
+    return false;
+  }
+
+  QList<Segment> segments;
+  for (const QJsonValue& value : root["segments"].toArray())
+  {
+    const QJsonObject obj = value.toObject();
+    Segment segment;
+    segment.start = obj["start"].toString().toLongLong();
+    segment.end = obj["end"].toString().toLongLong();
+    segment.done = obj["done"].toString().toLongLong();
+    segments.append(segment);
+  }
+  if (segments.isEmpty())
+  {
+    return false;
+  }
+
+  segments_ = segments;
+  total_bytes_ = root["total"].toString().toLongLong();
+  etag_ = root["etag"].toString();
+  last_modified_ = root["last_modified"].toString();
+  return true;
+}
+
+void DownloadTransfer::SaveState()
+{
+  if (!output_file_ || segments_.isEmpty())
+  {
+    return;
+  }
+  // Progress must never claim bytes that are not on disk yet; pending bytes are not counted
+  output_file_->flush();
+
+  // 64-bit values are stored as strings; JSON numbers are doubles
+  QJsonArray segments;
+  for (const Segment& segment : segments_)
+  {
+    QJsonObject obj;
+    obj["start"] = QString::number(segment.start);
+    obj["end"] = QString::number(segment.end);
+    obj["done"] = QString::number(segment.done);
+    segments.append(obj);
+  }
+
+  QJsonObject root;
+  root["url"] = url_;
+  root["total"] = QString::number(total_bytes_);
+  root["etag"] = etag_;
+  root["last_modified"] = last_modified_;
+  root["segments"] = segments;
+
+  QSaveFile file(ModelDownloadManager::PartialStatePath(destination_));
+  if (file.open(QIODevice::WriteOnly))
+  {
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.commit();
+  }
+}
@@ -0,0 +1,131 @@
+#ifndef DOWNLOADTRANSFER_H
+#define DOWNLOADTRANSFER_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class QFile;
+class QNetworkAccessManager;
+class QNetworkReply;
+class QSslError;
+
+/**
+ * @brief One HTTP download into a .part file, driven from a worker thread
+ *
+ * ModelDownloadManager moves the transfer to its worker thread; network replies,
+ * disk writes and hashing all run there, so the GUI thread only receives queued
+ * signals. Each reply's read buffer is bounded: when the disk is slower than the
+ * network the socket stalls instead of memory growing. Data is written in large
+ * chunks that end on an aligned file offset.
+ *
+ * Every signal carries the id passed to Start(), so the manager can drop reports
+ * of a transfer it already cancelled.
+ */
+class DownloadTransfer : public QObject
+{
+  Q_OBJECT
+
+ public:
+  explicit DownloadTransfer(QObject* parent = nullptr);
+  ~DownloadTransfer() override;
+
+  /**
+   * @brief Probe the URL and download it to <destination>.part
+   * @param max_segments Parallel connections (1 = single stream)
+   * @param min_segment_bytes Smallest segment; smaller files use fewer segments
+   *
+   * On success the .part file is renamed to the destination.
+   */
+  void Start(quint64 id, const QString& url, const QString& destination, int max_segments,
+             qint64 min_segment_bytes);
+
+  /**
+   * @brief Stop the transfer, keeping the .part file and its progress
+   */
+  void Cancel();
+
+ signals:
+  /**
+   * @param bytes_per_second Smoothed throughput, 0 until measured
+   * @param eta_seconds Estimated time left, -1 if unknown
+   */
+  void Progress(quint64 id, qint64 bytes_received, qint64 bytes_total, qint64 bytes_per_second,
+                qint64 eta_seconds);
+  void StatusMessage(quint64 id, const QString& message);
+
+  /**
+   * @param sha256 Digest computed while writing, empty if it could not be completed
+   */
+  void Finished(quint64 id, const QString& file_path, const QString& sha256);
+  void Failed(quint64 id, const QString& error_message);
+
+ private:
+  /**
+   * @brief Byte range of the file fetched over one connection
+   */
+  struct Segment
+  {
+    qint64 start = 0;
+    qint64 end = -1;   // Inclusive; -1 while the size is unknown
+    qint64 done = 0;   // Bytes written to disk from start
+    QByteArray pending;  // Received, not yet written
+    QNetworkReply* reply = nullptr;
+    bool checked = false;  // Response status checked
+    bool discard = false;  // Body is not file data (416 at the end of the file)
+
+    qint64 Received() const { return done + pending.size(); }
+    bool IsComplete() const { return end >= 0 && done >= end - start + 1; }
+  };
+
+  void OnHeadFinished();
+  void BeginTransfer(bool head_ok, qint64 total, bool accepts_ranges, const QString& etag,
+                     const QString& last_modified);
+  void StartSegment(int index);
+  void OnSegmentData(int index);
+  void OnSegmentFinished(int index);
+  void OnSslErrors(const QList<QSslError>& errors);
+  bool WriteSegment(int index, bool flush_all);
+  bool WritePending();
+  void RestartAsSingleStream(int index);
+  void AbortSegments();
+  void StopTransfer(bool keep_partial);
+  void Fail(const QString& error_message);
+  void CompleteDownload();
+  void ReportProgress(bool force);
+  void ResetStreamHash();
+  void AdvanceStreamHash();
+  bool LoadState();
+  void SaveState();
+
+  QNetworkAccessManager* network_manager_;
+  QNetworkReply* head_reply_;
+  QFile* output_file_;
+
+  quint64 id_;
+  QString url_;
+  QString destination_;
+  int max_segments_;
+  qint64 min_segment_bytes_;
+
+  QList<Segment> segments_;
+  qint64 total_bytes_;  // -1 if unknown
+  QString etag_;
+  QString last_modified_;
+  QElapsedTimer state_timer_;  // Throttles SaveState()
+
+  // Throughput over the reports of this run; resumed bytes do not count
+  QElapsedTimer progress_timer_;
+  qint64 last_reported_bytes_;
+  qint64 bytes_per_second_;
+
+  // SHA256 of the .part file from offset 0; segments written past the
+  // hashed prefix are read back once the gap before them is filled
+  QCryptographicHash stream_hash_;
+  qint64 hashed_bytes_;
+};
+
+#endif  // DOWNLOADTRANSFER_H
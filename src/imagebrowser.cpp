@@ -0,0 +1,164 @@
+#include "imagebrowser.h"
+
+#include <QPainter>
+#include <QPixmap>
+
+#include "reviewstatetable.h"
+#include "thumbnailcache.h"
+
+// ImageBrowserModel implementation
+
+ImageBrowserModel::ImageBrowserModel(ThumbnailCache* thumbnails, QObject* parent)
+    : QAbstractListModel(parent), thumbnails_(thumbnails), images_(nullptr), states_(nullptr)
+{
+  connect(thumbnails_, &ThumbnailCache::ThumbnailReady, this,
+          &ImageBrowserModel::OnThumbnailReady);
+}
+
+void ImageBrowserModel::SetImages(const QStringList* images, const ReviewStateTable* states)
+{
+  beginResetModel();
+  images_ = images;
+  states_ = states;
+  endResetModel();
+}
+
+void ImageBrowserModel::RefreshStates()
+{
+  const int rows = rowCount();
+  if (rows > 0)
+  {
+    emit dataChanged(index(0), index(rows - 1), {ReviewStateRole});
+  }
+}
+
+int ImageBrowserModel::rowCount(const QModelIndex& parent) const
+{
+  if (parent.isValid() || images_ == nullptr)
+  {
+    return 0;
+  }
+  return images_->size();
+}
+
+QVariant ImageBrowserModel::data(const QModelIndex& index, int role) const
+{
+  if (!index.isValid() || images_ == nullptr || index.row() >= images_->size())
+  {
+    return QVariant();
+  }
+
+  const QString& image_file = images_->at(index.row());
+
+  switch (role)
+  {
+    case Qt::DisplayRole:
+    case Qt::ToolTipRole:
+      return image_file;
+
+    case Qt::DecorationRole:
+    {
+      QPixmap thumbnail;
+      if (thumbnails_->GetThumbnail(image_file, &thumbnail))
+      {
+        return thumbnail;
+      }
+      return QVariant();
+    }
+
+    case ReviewStateRole:
+      return states_ != nullptr ? static_cast<int>(states_->GetState(index.row()))
+                                : static_cast<int>(ReviewState::None);
+
+    default:
+      return QVariant();
+  }
+}
+
+void ImageBrowserModel::OnThumbnailReady(const QString& image_file)
+{
+  if (states_ == nullptr)
+  {
+    return;
+  }
+
+  const int row = states_->IndexOf(image_file);
+  if (row >= 0 && row < rowCount())
+  {
+    emit dataChanged(index(row), index(row), {Qt::DecorationRole});
+  }
+}
+
+// ImageBrowserDelegate implementation
+
+ImageBrowserDelegate::ImageBrowserDelegate(QObject* parent) : QStyledItemDelegate(parent) {}
+
+void ImageBrowserDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
+                                 const QModelIndex& index) const
+{
+  painter->save();
+
+  const QRect rect = option.rect.adjusted(kPadding, kPadding, -kPadding, -kPadding);
+
+  if (option.state & QStyle::State_Selected)
+  {
+    painter->fillRect(option.rect, option.palette.highlight());
+  }
+
+  // Thumbnail (or placeholder while it is being generated)
+  const QRect thumb_rect(rect.left(), rect.top(), rect.width(), ThumbnailCache::kThumbnailSize);
+  const QPixmap thumbnail = index.data(Qt::DecorationRole).value<QPixmap>();
+  if (!thumbnail.isNull())
+  {
+    QSize size = thumbnail.size().scaled(thumb_rect.size(), Qt::KeepAspectRatio);
+    QRect target(QPoint(0, 0), size);
+    target.moveCenter(thumb_rect.center());
+    painter->drawPixmap(target, thumbnail);
+  }
+  else
+  {
+    painter->fillRect(thumb_rect, option.palette.mid());
+  }
+
+  // Review-state badge: green = approved, orange = AI detections to review, gray = none
+  QColor badge_color(Qt::gray);
+  switch (static_cast<ReviewState>(index.data(ImageBrowserModel::ReviewStateRole).toInt()))
+  {
+    case ReviewState::Approved:
+      badge_color = QColor(46, 160, 67);
+      break;
+    case ReviewState::Meta:
+      badge_color = QColor(230, 140, 0);
+      break;
+    case ReviewState::None:
+      break;
+  }
+
+  painter->setRenderHint(QPainter::Antialiasing);
+  painter->setPen(QPen(Qt::white, 1));
+  painter->setBrush(badge_color);
+  painter->drawEllipse(QRect(thumb_rect.right() - kBadgeSize - 2, thumb_rect.top() + 2,
+                             kBadgeSize, kBadgeSize));
+
+  // File name
+  const QRect text_rect(rect.left(), thumb_rect.bottom() + kPadding, rect.width(),
+                        option.fontMetrics.height());
+  const QString name = option.fontMetrics.elidedText(index.data(Qt::DisplayRole).toString(),
+                                                     Qt::ElideMiddle, text_rect.width());
+  painter->setPen(option.state & QStyle::State_Selected
+                      ? option.palette.color(QPalette::HighlightedText)
+                      : option.palette.color(QPalette::Text));
+  painter->drawText(text_rect, Qt::AlignHCenter | Qt::AlignVCenter, name);
+
+  painter->restore();
+}
+
+QSize ImageBrowserDelegate::sizeHint(const QStyleOptionViewItem& option,
+                                     const QModelIndex& index) const
+{
+  Q_UNUSED(index);
+
+  // Same size for every item, so the view can use uniform item sizes
+  return QSize(ThumbnailCache::kThumbnailSize + 2 * kPadding,
+               ThumbnailCache::kThumbnailSize + option.fontMetrics.height() + 3 * kPadding);
+}
@@ -0,0 +1,71 @@
+#ifndef IMAGEBROWSER_H
+#define IMAGEBROWSER_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+#include <QStyledItemDelegate>
+
+class ReviewStateTable;
+class ThumbnailCache;
+
+/**
+ * @brief List model over the project image list for the image browser
+ *
+ * Rows map 1:1 to the MainWindow image list. Thumbnails are only requested
+ * from data(), so a virtualized view generates them for visible rows only.
+ */
+class ImageBrowserModel : public QAbstractListModel
+{
+  Q_OBJECT
+
+ public:
+  enum Roles
+  {
+    ReviewStateRole = Qt::UserRole + 1  // int value of ReviewState
+  };
+
+  explicit ImageBrowserModel(ThumbnailCache* thumbnails, QObject* parent = nullptr);
+
+  /**
+   * @brief Point the model at the image list and review states (resets the model)
+   * @param images Image file names; must outlive the model or be reset
+   * @param states Review states parallel to images
+   */
+  void SetImages(const QStringList* images, const ReviewStateTable* states);
+
+  /**
+   * @brief Repaint review-state badges after states changed
+   */
+  void RefreshStates();
+
+  int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+ private:
+  void OnThumbnailReady(const QString& image_file);
+
+  ThumbnailCache* thumbnails_;
+  const QStringList* images_;
+  const ReviewStateTable* states_;
+};
+
+/**
+ * @brief Paints a thumbnail tile with its file name and review-state badge
+ */
+class ImageBrowserDelegate : public QStyledItemDelegate
+{
+  Q_OBJECT
+
+ public:
+  explicit ImageBrowserDelegate(QObject* parent = nullptr);
+
+  void paint(QPainter* painter, const QStyleOptionViewItem& option,
+             const QModelIndex& index) const override;
+  QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+
+ private:
+  static constexpr int kPadding = 4;
+  static constexpr int kBadgeSize = 12;
+};
+
+#endif  // IMAGEBROWSER_H
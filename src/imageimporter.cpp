@@ -0,0 +1,932 @@
+#include "imageimporter.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThread>
+
+#include <iostream>
+
+#include "projectscanner.h"
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+
+// Crop rectangle for an image size, empty if the crop does not fit
+QRect CropRect(const CropConfig& crop, const QSize& image_size)
+{
+  int crop_width = crop.width > 0 ? crop.width : image_size.width() - crop.x;
+  int crop_height = crop.height > 0 ? crop.height : image_size.height() - crop.y;
+
+  if (crop.x >= 0 && crop.y >= 0 && crop_width > 0 && crop_height > 0 &&
+      crop.x + crop_width <= image_size.width() && crop.y + crop_height <= image_size.height())
+  {
+    return QRect(crop.x, crop.y, crop_width, crop_height);
+  }
+  return QRect();
+}
+
+bool WriteBytes(const QString& dest_path, const QByteArray& data)
+{
+  QSaveFile file(dest_path);
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    return false;
+  }
+  file.write(data);
+  return file.commit();
+}
+
+#ifdef Q_OS_LINUX
+// Reflink (copy-on-write clone) or in-kernel copy; false means "use a plain copy"
+bool KernelCopy(const QString& source_path, const QString& dest_path)
+{
+  int in_fd = ::open(QFile::encodeName(source_path).constData(), O_RDONLY | O_CLOEXEC);
+  if (in_fd < 0)
+  {
+    return false;
+  }
+
+  struct stat st;
+  if (::fstat(in_fd, &st) != 0)
+  {
+    ::close(in_fd);
+    return false;
+  }
+
+  int out_fd = ::open(QFile::encodeName(dest_path).constData(),
+                      O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 0777);
+  if (out_fd < 0)
+  {
+    ::close(in_fd);
+    return false;
+  }
+
+  bool ok = ::ioctl(out_fd, FICLONE, in_fd) == 0;
+  if (!ok)
+  {
+    off_t remaining = st.st_size;
+    while (remaining > 0)
+    {
+      ssize_t copied =
+          ::copy_file_range(in_fd, nullptr, out_fd, nullptr, static_cast<size_t>(remaining), 0);
+      if (copied <= 0)
+      {
+        break;
+      }
+      remaining -= copied;
+    }
+    ok = remaining == 0;
+  }
+
+  ::close(out_fd);
+  ::close(in_fd);
+
+  if (!ok)
+  {
+    QFile::remove(dest_path);
+  }
+  return ok;
+}
+#endif
+
+}  // namespace
+
+ImageImporter::ImageImporter(QObject* parent)
+    : QObject(parent),
+      memory_(kMemoryBudgetKiB),
+      canceled_(0),
+      reference_mode_(false),
+      check_duplicates_(false),
+      detect_near_(false),
+      near_distance_(0),
+      total_(0),
+      done_(0)
+{
+  pool_.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+}
+
+ImageImporter::~ImageImporter()
+{
+  Cancel();
+  pool_.waitForDone();
+}
+
+QString ImageImporter::ImportFileName(const QString& source_path,
+                                      const ImportPathConfig& import_config)
+{
+  QFileInfo file_info(source_path);
+
+  // Get the directory part of the source path
+  QString dir_path = file_info.absolutePath();
+
+  // Remove base path if configured
+  QString remaining_path = dir_path;
+  if (!import_config.base_path.isEmpty() && dir_path.startsWith(import_config.base_path))
+  {
+    remaining_path = dir_path.mid(import_config.base_path.length());
+    // Remove leading slash if present
+    if (remaining_path.startsWith("/"))
+    {
+      remaining_path = remaining_path.mid(1);
+    }
+  }
+
+  // Split path into components and filter out skip folders
+  QStringList filtered_parts;
+  for (const QString& part : remaining_path.split("/", Qt::SkipEmptyParts))
+  {
+    if (!import_config.skip_folders.contains(part))
+    {
+      filtered_parts.append(part);
+    }
+  }
+
+  // Create prefix from remaining parts
+  QString prefix;
+  if (!filtered_parts.isEmpty())
+  {
+    prefix = filtered_parts.join("_") + "_";
+  }
+
+  return prefix + file_info.fileName();
+}
+
+bool ImageImporter::CopyImageFile(const QString& source_path, const QString& dest_path)
+{
+#ifdef Q_OS_LINUX
+  if (KernelCopy(source_path, dest_path))
+  {
+    return true;
+  }
+#endif
+  return QFile::copy(source_path, dest_path);
+}
+
+bool ImageImporter::LinkImageFile(const QString& existing_path, const QString& dest_path)
+{
+#ifdef Q_OS_UNIX
+  if (::link(QFile::encodeName(existing_path).constData(),
+             QFile::encodeName(dest_path).constData()) == 0)
+  {
+    return true;
+  }
+#endif
+  // Other filesystem or platform - a copy still gives the expected file
+  return CopyImageFile(existing_path, dest_path);
+}
+
+bool ImageImporter::CropImageFile(const QString& source_path, const QString& dest_path,
+                                  const CropConfig& crop)
+{
+  // Read the file once; decoding and the fallback copy both use these bytes
+  QFile source(source_path);
+  if (!source.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+  QByteArray data = source.readAll();
+  source.close();
+
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+  QImageReader reader(&buffer);
+
+  // With the size known up front the decoder only has to produce the clip rect
+  QRect crop_rect;
+  const QSize header_size = reader.size();
+  if (header_size.isValid())
+  {
+    crop_rect = CropRect(crop, header_size);
+    if (crop_rect.isEmpty())
+    {
+      return WriteBytes(dest_path, data);  // Crop does not fit - keep the original
+    }
+    reader.setClipRect(crop_rect);
+  }
+
+  QImage image;
+  if (!reader.read(&image))
+  {
+    // Not decodable here - keep the original file, as a plain copy would
+    return WriteBytes(dest_path, data);
+  }
+
+  if (!header_size.isValid())
+  {
+    crop_rect = CropRect(crop, image.size());
+    if (crop_rect.isEmpty())
+    {
+      return WriteBytes(dest_path, data);
+    }
+    image = image.copy(crop_rect);
+  }
+
+  QSaveFile file(dest_path);
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    return false;
+  }
+  QImageWriter writer(&file, QFileInfo(dest_path).suffix().toLower().toLatin1());
+  if (!writer.write(image))
+  {
+    std::cerr << "Failed to encode " << dest_path.toStdString() << ": "
+              << writer.errorString().toStdString() << std::endl;
+    file.cancelWriting();
+    return false;
+  }
+  return file.commit();
+}
+
+bool ImageImporter::ReadJpegInfo(const QString& path, QSize* size, QSize* mcu_size)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+
+  auto byte_at = [](const QByteArray& data, int i) { return static_cast<uchar>(data[i]); };
+
+  QByteArray soi = file.read(2);
+  if (soi.size() != 2 || byte_at(soi, 0) != 0xFF || byte_at(soi, 1) != 0xD8)
+  {
+    return false;
+  }
+
+  // Walk marker segments (skipping EXIF etc.) until the frame header
+  char c;
+  while (file.getChar(&c))
+  {
+    if (static_cast<uchar>(c) != 0xFF)
+    {
+      return false;
+    }
+
+    uchar marker = 0xFF;
+    while (marker == 0xFF)
+    {
+      if (!file.getChar(&c))
+      {
+        return false;
+      }
+      marker = static_cast<uchar>(c);
+    }
+
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+    {
+      continue;  // Standalone markers have no length
+    }
+    if (marker == 0xD9 || marker == 0xDA)
+    {
+      return false;  // End of image or scan data before a frame header
+    }
+
+    QByteArray length_bytes = file.read(2);
+    if (length_bytes.size() != 2)
+    {
+      return false;
+    }
+    const int length = (byte_at(length_bytes, 0) << 8) | byte_at(length_bytes, 1);
+    if (length < 2)
+    {
+      return false;
+    }
+
+    // Only Huffman baseline, extended and progressive frames can be cropped losslessly
+    if (marker != 0xC0 && marker != 0xC1 && marker != 0xC2)
+    {
+      if (marker >= 0xC3 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 &&
+          marker != 0xCC)
+      {
+        return false;  // Other frame types
+      }
+      if (!file.seek(file.pos() + length - 2))
+      {
+        return false;
+      }
+      continue;
+    }
+
+    QByteArray sof = file.read(length - 2);
+    if (sof.size() < 6)
+    {
+      return false;
+    }
+
+    const int height = (byte_at(sof, 1) << 8) | byte_at(sof, 2);
+    const int width = (byte_at(sof, 3) << 8) | byte_at(sof, 4);
+    const int components = byte_at(sof, 5);
+    if (width <= 0 || height <= 0 || sof.size() < 6 + 3 * components)
+    {
+      return false;
+    }
+
+    // Single-component (grayscale) scans are not interleaved: MCU is one 8x8 block
+    int max_h = 1;
+    int max_v = 1;
+    if (components > 1)
+    {
+      for (int i = 0; i < components; ++i)
+      {
+        const int sampling = byte_at(sof, 6 + 3 * i + 1);
+        max_h = qMax(max_h, sampling >> 4);
+        max_v = qMax(max_v, sampling & 0x0F);
+      }
+    }
+
+    *size = QSize(width, height);
+    *mcu_size = QSize(8 * max_h, 8 * max_v);
+    return true;
+  }
+
+  return false;
+}
+
+QRect ImageImporter::SnapToMcu(const QRect& rect, const QSize& mcu_size, const QSize& image_size)
+{
+  auto snap = [](int value, int step, int extent, int limit) {
+    int snapped = ((value + step / 2) / step) * step;
+    if (snapped + extent > limit)
+    {
+      snapped -= step;
+    }
+    return snapped;
+  };
+
+  const int x = snap(rect.x(), mcu_size.width(), rect.width(), image_size.width());
+  const int y = snap(rect.y(), mcu_size.height(), rect.height(), image_size.height());
+  if (x < 0 || y < 0)
+  {
+    return QRect();
+  }
+  return QRect(x, y, rect.width(), rect.height());
+}
+
+bool ImageImporter::LosslessJpegCrop(const QString& jpegtran, const QString& source_path,
+                                     const QString& dest_path, const QRect& rect)
+{
+  // Written next to the destination and renamed, so images/ never shows a partial file.
+  // Metadata is dropped like the decode/encode path does, so an EXIF orientation
+  // tag cannot make plugins see a differently rotated image than the labels.
+  const QString temp_path = dest_path + ".part";
+  const QString geometry =
+      QString("%1x%2+%3+%4").arg(rect.width()).arg(rect.height()).arg(rect.x()).arg(rect.y());
+
+  QProcess process;
+  process.start(jpegtran, QStringList() << "-copy" << "none" << "-crop" << geometry
+                                        << "-outfile" << temp_path << source_path);
+  bool ok = process.waitForFinished(60000) && process.exitStatus() == QProcess::NormalExit &&
+            process.exitCode() == 0;
+
+  // Old jpegtran builds without -crop fail here and fall back to decode/encode
+  QSize output_size;
+  QSize mcu_size;
+  ok = ok && ReadJpegInfo(temp_path, &output_size, &mcu_size) && output_size == rect.size() &&
+       QFile::rename(temp_path, dest_path);
+
+  if (!ok)
+  {
+    QFile::remove(temp_path);
+  }
+  return ok;
+}
+
+void ImageImporter::Start(const QStringList& files, const QString& project_dir,
+                          const ImportPathConfig& import_config, const CropConfig& crop)
+{
+  result_ = ImportResult();
+  canceled_.storeRelaxed(0);
+  done_ = 0;
+  total_ = 0;
+
+  project_dir_ = project_dir;
+  images_dir_ = project_dir + "/images";
+  crop_ = crop;
+  QDir().mkpath(images_dir_);
+  jpegtran_ = crop.enabled && !reference_mode_ ? QStandardPaths::findExecutable("jpegtran")
+                                                : QString();
+
+  duplicate_policy_ = import_config.duplicate_policy;
+  check_duplicates_ = duplicate_policy_ != "import";
+  detect_near_ = check_duplicates_ && import_config.detect_near_duplicates;
+  near_distance_ = import_config.near_duplicate_distance;
+  hash_sizes_.clear();
+  batch_hashes_.clear();
+  batch_dhashes_.clear();
+  new_entries_.clear();
+  pending_links_.clear();
+
+  // Destination names are reserved up front so parallel workers never collide
+  QSet<QString> reserved;
+  sources_.clear();
+  dest_names_.clear();
+  for (const QString& source_path : files)
+  {
+    QString dest_name = ImportFileName(source_path, import_config);
+    if (reserved.contains(dest_name) || existing_references_.contains(dest_name) ||
+        QFile::exists(images_dir_ + "/" + dest_name))
+    {
+      result_.skipped++;
+      continue;
+    }
+    reserved.insert(dest_name);
+    sources_.append(source_path);
+    dest_names_.append(dest_name);
+  }
+
+  total_ = sources_.size();
+  if (total_ == 0)
+  {
+    QMetaObject::invokeMethod(this, [this]() { Finish(); }, Qt::QueuedConnection);
+    return;
+  }
+
+  emit Progress(0, total_);
+
+  if (check_duplicates_)
+  {
+    // Index sync may hash project images; keep it off the GUI thread
+    pool_.start([this]() { PrepareDuplicateCheck(); });
+  }
+  else
+  {
+    Dispatch();
+  }
+}
+
+void ImageImporter::PrepareDuplicateCheck()
+{
+  QHash<qint64, int> size_counts;
+  for (const QString& source_path : sources_)
+  {
+    size_counts[QFileInfo(source_path).size()]++;
+  }
+
+  // Size prefilter: only project images sharing a size with a source are hashed
+  QSet<qint64> source_sizes;
+  for (auto it = size_counts.constBegin(); it != size_counts.constEnd(); ++it)
+  {
+    source_sizes.insert(it.key());
+  }
+
+  index_.Load(project_dir_);
+  const QStringList images =
+      QDir(images_dir_).entryList(ProjectScanner::ImageNameFilters(), QDir::Files);
+  index_.Sync(images_dir_, images, source_sizes, detect_near_);
+
+  // Referenced images only exist in the config; their import hash stands in for a scan
+  for (auto it = existing_references_.constBegin(); it != existing_references_.constEnd(); ++it)
+  {
+    if (it->has_hash)
+    {
+      ContentHashEntry entry;
+      entry.size = it->size;
+      entry.mtime = it->mtime;
+      entry.has_hash = true;
+      entry.hash = it->hash;
+      index_.Insert(it.key(), entry);
+    }
+  }
+
+  // ...and only sources sharing a size with an image or another source
+  for (auto it = size_counts.constBegin(); it != size_counts.constEnd(); ++it)
+  {
+    if (it.value() > 1 || index_.ContainsSize(it.key()))
+    {
+      hash_sizes_.insert(it.key());
+    }
+  }
+
+  QMetaObject::invokeMethod(this, [this]() { Dispatch(); }, Qt::QueuedConnection);
+}
+
+void ImageImporter::Dispatch()
+{
+  if (canceled_.loadRelaxed() != 0)
+  {
+    result_.canceled = true;
+    Finish();
+    return;
+  }
+
+  for (int i = 0; i < sources_.size(); ++i)
+  {
+    const QString source_path = sources_[i];
+    const QString dest_name = dest_names_[i];
+    pool_.start([this, source_path, dest_name]() { ImportOne(source_path, dest_name); });
+  }
+}
+
+void ImageImporter::SetReferenceMode(const QMap<QString, ImageReference>& existing_references)
+{
+  reference_mode_ = true;
+  existing_references_ = existing_references;
+}
+
+void ImageImporter::Cancel()
+{
+  canceled_.storeRelaxed(1);
+}
+
+void ImageImporter::ImportOne(const QString& source_path, const QString& dest_name)
+{
+  const QString dest_path = images_dir_ + "/" + dest_name;
+  const CropConfig& crop = crop_;
+
+  FileOutcome outcome;
+  outcome.source_name = QFileInfo(source_path).fileName();
+  outcome.dest_name = dest_name;
+  bool ok = false;
+  bool canceled = canceled_.loadRelaxed() != 0;
+
+  if (!canceled && check_duplicates_ && HandleDuplicate(source_path, &outcome))
+  {
+    QMetaObject::invokeMethod(
+        this, [this, outcome]() { OnFileDone(outcome); }, Qt::QueuedConnection);
+    return;
+  }
+
+  if (reference_mode_)
+  {
+    if (canceled)
+    {
+      outcome.status = FileStatus::Canceled;
+    }
+    else
+    {
+      CreateReference(source_path, &outcome);
+    }
+    QMetaObject::invokeMethod(
+        this, [this, outcome]() { OnFileDone(outcome); }, Qt::QueuedConnection);
+    return;
+  }
+
+  if (!canceled && crop.enabled)
+  {
+    // I/O-bound path first; it needs no decoded pixels
+    outcome.lossless = TryLosslessCrop(source_path, dest_path, crop, &outcome.adjustment);
+    ok = outcome.lossless;
+  }
+
+  if (!canceled && !ok)
+  {
+    // Reserve memory for the encoded file plus the decoded and cropped images
+    int cost_kib = 1024;
+    if (crop.enabled)
+    {
+      const qint64 file_bytes = QFileInfo(source_path).size();
+      const QSize size = QImageReader(source_path).size();
+      const qint64 decoded_bytes =
+          size.isValid() ? 2LL * size.width() * size.height() * 4 : 8 * file_bytes;
+      cost_kib = static_cast<int>(
+          qBound<qint64>(1, (file_bytes + decoded_bytes) / 1024, kMemoryBudgetKiB));
+    }
+
+    memory_.acquire(cost_kib);
+    canceled = canceled_.loadRelaxed() != 0;
+    if (!canceled)
+    {
+      ok = crop.enabled ? CropImageFile(source_path, dest_path, crop)
+                        : CopyImageFile(source_path, dest_path);
+    }
+    memory_.release(cost_kib);
+  }
+
+  if (canceled)
+  {
+    outcome.status = FileStatus::Canceled;
+  }
+  else if (ok)
+  {
+    outcome.status = FileStatus::Added;
+    if (crop.enabled)
+    {
+      // The hashes describe the source; keep them as its identity, not the file's
+      outcome.entry.source_size = QFileInfo(source_path).size();
+      outcome.entry.has_source_hash = outcome.entry.has_hash;
+      outcome.entry.source_hash = outcome.entry.hash;
+      outcome.entry.has_hash = false;
+      outcome.entry.has_dhash = false;
+    }
+    const QFileInfo dest_info(dest_path);
+    outcome.entry.size = dest_info.size();
+    outcome.entry.mtime = dest_info.lastModified().toMSecsSinceEpoch();
+  }
+  else
+  {
+    outcome.status = FileStatus::Failed;
+  }
+
+  QMetaObject::invokeMethod(
+      this, [this, outcome]() { OnFileDone(outcome); }, Qt::QueuedConnection);
+}
+
+bool ImageImporter::HandleDuplicate(const QString& source_path, FileOutcome* outcome)
+{
+  const qint64 size = QFileInfo(source_path).size();
+  ContentHashEntry& entry = outcome->entry;
+
+  // Cropped imports always hash the source: it is the only record of the original
+  if (hash_sizes_.contains(size) || crop_.enabled)
+  {
+    entry.has_hash = ContentHashIndex::FileHash(source_path, &entry.hash);
+  }
+
+  QString match;
+  bool in_batch = false;
+  if (entry.has_hash)
+  {
+    match = index_.FindExact(size, entry.hash);
+    if (match.isEmpty())
+    {
+      QMutexLocker locker(&batch_mutex_);
+      const QPair<qint64, quint64> key(size, entry.hash);
+      match = batch_hashes_.value(key);
+      in_batch = !match.isEmpty();
+      if (!in_batch)
+      {
+        batch_hashes_.insert(key, outcome->dest_name);
+      }
+    }
+  }
+
+  if (!match.isEmpty())
+  {
+    outcome->match = match;
+    outcome->status = FileStatus::Duplicate;
+
+    // References share the source anyway; the link is the new reference itself
+    if (duplicate_policy_ == "link" && reference_mode_)
+    {
+      return in_batch;
+    }
+
+    // A match from this batch may not be written yet; it is linked in Finish()
+    if (duplicate_policy_ == "link" && in_batch)
+    {
+      outcome->link_later = true;
+    }
+    else if (duplicate_policy_ == "link")
+    {
+      const QString dest_path = images_dir_ + "/" + outcome->dest_name;
+      if (LinkImageFile(images_dir_ + "/" + match, dest_path))
+      {
+        outcome->status = FileStatus::Linked;
+        entry = index_.Entry(match);
+        const QFileInfo dest_info(dest_path);
+        entry.size = dest_info.size();
+        entry.mtime = dest_info.lastModified().toMSecsSinceEpoch();
+      }
+      else
+      {
+        outcome->status = FileStatus::Failed;
+      }
+    }
+    return true;
+  }
+
+  if (detect_near_ && ContentHashIndex::PerceptualHash(source_path, &entry.dhash))
+  {
+    entry.has_dhash = true;
+    match = index_.FindNear(entry.dhash, near_distance_);
+    {
+      QMutexLocker locker(&batch_mutex_);
+      for (int i = 0; i < batch_dhashes_.size() && match.isEmpty(); ++i)
+      {
+        if (ContentHashIndex::HammingDistance(entry.dhash, batch_dhashes_[i].first) <=
+            near_distance_)
+        {
+          match = batch_dhashes_[i].second;
+        }
+      }
+      batch_dhashes_.append(qMakePair(entry.dhash, outcome->dest_name));
+    }
+
+    if (!match.isEmpty())
+    {
+      // Similar is not identical: only the skip policy drops the image
+      outcome->match = match;
+      outcome->similar = true;
+      if (duplicate_policy_ == "skip")
+      {
+        outcome->status = FileStatus::Duplicate;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+void ImageImporter::CreateReference(const QString& source_path, FileOutcome* outcome) const
+{
+  const QFileInfo info(source_path);
+  ImageReference& ref = outcome->reference;
+  ref.path = info.absoluteFilePath();
+  ref.size = info.size();
+  ref.mtime = info.lastModified().toMSecsSinceEpoch();
+
+  // The duplicate check may already have read the file
+  ref.has_hash = outcome->entry.has_hash;
+  ref.hash = outcome->entry.hash;
+  if (!ref.has_hash)
+  {
+    ref.has_hash = ContentHashIndex::FileHash(source_path, &ref.hash);
+  }
+  if (!ref.has_hash)
+  {
+    outcome->status = FileStatus::Failed;
+    return;
+  }
+
+  // The crop is only recorded here and applied whenever the image is read
+  if (crop_.enabled)
+  {
+    const QSize image_size = QImageReader(source_path).size();
+    const QRect rect = image_size.isValid() ? CropRect(crop_, image_size) : QRect();
+    if (!rect.isEmpty() && rect != QRect(QPoint(0, 0), image_size))
+    {
+      ref.crop = rect;
+    }
+  }
+
+  outcome->has_reference = true;
+  outcome->status = !outcome->match.isEmpty() && !outcome->similar ? FileStatus::Linked
+                                                                      : FileStatus::Added;
+}
+
+bool ImageImporter::TryLosslessCrop(const QString& source_path, const QString& dest_path,
+                                    const CropConfig& crop, QString* adjustment) const
+{
+  QSize image_size;
+  QSize mcu_size;
+  if (jpegtran_.isEmpty() || !ReadJpegInfo(source_path, &image_size, &mcu_size))
+  {
+    return false;
+  }
+
+  const QRect rect = CropRect(crop, image_size);
+  if (rect.isEmpty())
+  {
+    return false;
+  }
+
+  QRect aligned = rect;
+  if (rect.x() % mcu_size.width() != 0 || rect.y() % mcu_size.height() != 0)
+  {
+    if (!crop.snap_to_mcu)
+    {
+      return false;
+    }
+    aligned = SnapToMcu(rect, mcu_size, image_size);
+    if (aligned.isEmpty())
+    {
+      return false;
+    }
+  }
+
+  if (!LosslessJpegCrop(jpegtran_, source_path, dest_path, aligned))
+  {
+    return false;
+  }
+
+  if (aligned != rect)
+  {
+    *adjustment = QString("Crop offset (%1, %2) moved to (%3, %4) for %5x%6 JPEG blocks")
+                      .arg(rect.x())
+                      .arg(rect.y())
+                      .arg(aligned.x())
+                      .arg(aligned.y())
+                      .arg(mcu_size.width())
+                      .arg(mcu_size.height());
+  }
+  return true;
+}
+
+void ImageImporter::OnFileDone(const FileOutcome& outcome)
+{
+  done_++;
+
+  switch (outcome.status)
+  {
+    case FileStatus::Canceled:
+      result_.canceled = true;
+      break;
+    case FileStatus::Duplicate:
+      if (outcome.link_later)
+      {
+        pending_links_.append(outcome);
+        break;
+      }
+      result_.duplicates.append(outcome.source_name + (outcome.similar ? " ~ " : " = ") +
+                                outcome.match);
+      break;
+    case FileStatus::Failed:
+      result_.failed.append(outcome.dest_name);
+      break;
+    case FileStatus::Linked:
+      result_.linked++;
+      [[fallthrough]];
+    case FileStatus::Added:
+      result_.added.append(outcome.dest_name);
+      if (outcome.similar)
+      {
+        result_.similar.append(QString("%1 ~ %2").arg(outcome.dest_name, outcome.match));
+      }
+      if (outcome.lossless)
+      {
+        result_.lossless_cropped++;
+      }
+      if (!outcome.adjustment.isEmpty() &&
+          !result_.crop_adjustments.contains(outcome.adjustment))
+      {
+        result_.crop_adjustments.append(outcome.adjustment);
+      }
+      if (outcome.has_reference)
+      {
+        result_.references.insert(outcome.dest_name, outcome.reference);
+      }
+      else if (check_duplicates_)
+      {
+        new_entries_.insert(outcome.dest_name, outcome.entry);
+      }
+      break;
+  }
+
+  emit Progress(done_, total_);
+
+  if (done_ == total_)
+  {
+    Finish();
+  }
+}
+
+void ImageImporter::LinkToBatchImage(const FileOutcome& outcome)
+{
+  // The match was not written (canceled or failed): nothing to link to
+  const auto match = new_entries_.constFind(outcome.match);
+  if (result_.canceled || match == new_entries_.constEnd())
+  {
+    result_.duplicates.append(outcome.source_name + " = " + outcome.match);
+    return;
+  }
+
+  const QString dest_path = images_dir_ + "/" + outcome.dest_name;
+  if (!LinkImageFile(images_dir_ + "/" + outcome.match, dest_path))
+  {
+    result_.failed.append(outcome.dest_name);
+    return;
+  }
+
+  ContentHashEntry entry = match.value();
+  const QFileInfo dest_info(dest_path);
+  entry.size = dest_info.size();
+  entry.mtime = dest_info.lastModified().toMSecsSinceEpoch();
+  new_entries_.insert(outcome.dest_name, entry);
+  result_.linked++;
+  result_.added.append(outcome.dest_name);
+}
+
+void ImageImporter::Finish()
+{
+  // Every copy of the batch is written now, so duplicates within it can link
+  for (const FileOutcome& outcome : pending_links_)
+  {
+    LinkToBatchImage(outcome);
+  }
+  pending_links_.clear();
+
+  // Workers are done; the index can take the new images and be persisted
+  if (check_duplicates_ && !new_entries_.isEmpty())
+  {
+    for (auto it = new_entries_.constBegin(); it != new_entries_.constEnd(); ++it)
+    {
+      index_.Insert(it.key(), it.value());
+    }
+    index_.Save(project_dir_);
+    new_entries_.clear();
+  }
+
+  emit Finished(result_);
+}
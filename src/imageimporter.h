@@ -0,0 +1,204 @@
+#ifndef IMAGEIMPORTER_H
+#define IMAGEIMPORTER_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QRect>
+#include <QSemaphore>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+#include "contenthashindex.h"
+#include "projectconfig.h"
+
+/**
+ * @brief Outcome of one import run
+ */
+struct ImportResult
+{
+  QStringList added;             // File names created in images/
+  int skipped = 0;               // Destination already existed
+  QStringList failed;            // Destination names that could not be written
+  bool canceled = false;
+  int lossless_cropped = 0;      // JPEGs cropped without re-encoding
+  QStringList crop_adjustments;  // Distinct MCU snaps applied, for the user
+  QStringList duplicates;        // Not imported: "<source> = <image>" ("~" if only similar)
+  int linked = 0;                // Added as hardlinks to identical images
+  QStringList similar;           // Imported near-duplicates: "<image> ~ <existing image>"
+  QMap<QString, ImageReference> references;  // New referenced images (reference mode)
+};
+
+/**
+ * @brief Imports images into a project on a thread pool
+ *
+ * Handles:
+ * - Destination naming from ImportPathConfig (prefix from folder structure)
+ * - Duplicate detection against the project's ContentHashIndex and within the
+ *   batch, with the configured policy (skip, hardlink or import)
+ * - Reference mode: nothing is written to images/; each source is recorded as
+ *   an ImageReference (path, size, mtime, hash, virtual crop)
+ * - Crop: JPEGs are cropped losslessly in the DCT domain (jpegtran) when the
+ *   crop offset is on the MCU grid, optionally snapped to it
+ * - Other crops: each file is read once, decoded with the crop as clip rect
+ *   and encoded once, entirely in memory
+ * - No crop: kernel-side copy (reflink, then copy_file_range) where available
+ * - A byte budget on decoded images in flight, so many workers on large
+ *   images cannot exhaust memory
+ * - Progress reporting and cancellation
+ */
+class ImageImporter : public QObject
+{
+  Q_OBJECT
+
+ public:
+  explicit ImageImporter(QObject* parent = nullptr);
+  ~ImageImporter() override;
+
+  /**
+   * @brief Destination file name for a source image
+   * @param source_path Absolute path of the source image
+   * @param import_config Base path and folders to drop from the prefix
+   * @return e.g. "cam1_day2_img001.jpg" for ".../cam1/day2/img001.jpg"
+   */
+  static QString ImportFileName(const QString& source_path, const ImportPathConfig& import_config);
+
+  /**
+   * @brief Copy a file, preferring a reflink or in-kernel copy
+   * @return true if dest_path was created with the full content
+   */
+  static bool CopyImageFile(const QString& source_path, const QString& dest_path);
+
+  /**
+   * @brief Hardlink an existing project image under a new name (copy if unsupported)
+   */
+  static bool LinkImageFile(const QString& existing_path, const QString& dest_path);
+
+  /**
+   * @brief Read, crop and encode one image in memory
+   * @return true if dest_path was written; invalid crop bounds copy the file unchanged
+   */
+  static bool CropImageFile(const QString& source_path, const QString& dest_path,
+                            const CropConfig& crop);
+
+  /**
+   * @brief Read image and MCU size from a JPEG frame header
+   * @param mcu_size Minimum coded unit (8x8, 16x8, 16x16...) for the sampling factors
+   * @return false if the file is not a baseline/progressive JPEG
+   */
+  static bool ReadJpegInfo(const QString& path, QSize* size, QSize* mcu_size);
+
+  /**
+   * @brief Move a crop offset to the nearest MCU boundary, keeping its size
+   * @return Empty rect if the snapped crop does not fit the image
+   */
+  static QRect SnapToMcu(const QRect& rect, const QSize& mcu_size, const QSize& image_size);
+
+  /**
+   * @brief Crop a JPEG with jpegtran without decoding to pixels
+   * @param rect Crop with an MCU-aligned offset
+   * @return true if dest_path holds exactly rect
+   */
+  static bool LosslessJpegCrop(const QString& jpegtran, const QString& source_path,
+                               const QString& dest_path, const QRect& rect);
+
+  /**
+   * @brief Start importing files asynchronously
+   * @param files Source image paths
+   * @param project_dir Project directory (images go to images/)
+   * @param import_config Naming and duplicate handling configuration
+   * @param crop Crop configuration (ignored unless enabled)
+   */
+  void Start(const QStringList& files, const QString& project_dir,
+             const ImportPathConfig& import_config, const CropConfig& crop);
+
+  /**
+   * @brief Record references instead of copying files; call before Start()
+   * @param existing_references References already in the project (names are taken,
+   *        and their hashes count for duplicate detection)
+   */
+  void SetReferenceMode(const QMap<QString, ImageReference>& existing_references);
+
+  /**
+   * @brief Stop after the files currently being written
+   */
+  void Cancel();
+
+ signals:
+  void Progress(int done, int total);
+  void Finished(const ImportResult& result);
+
+ private:
+  enum class FileStatus
+  {
+    Added,
+    Linked,
+    Duplicate,
+    Failed,
+    Canceled
+  };
+
+  struct FileOutcome
+  {
+    QString source_name;
+    QString dest_name;
+    FileStatus status = FileStatus::Failed;
+    bool lossless = false;
+    QString adjustment;
+    QString match;         // Existing image for duplicates, links and similar images
+    bool similar = false;  // match is a near-duplicate, not identical
+    bool link_later = false;  // match is from this batch; linked once it is written
+    ContentHashEntry entry;
+    bool has_reference = false;
+    ImageReference reference;
+  };
+
+  void PrepareDuplicateCheck();
+  void Dispatch();
+  void ImportOne(const QString& source_path, const QString& dest_name);
+  bool HandleDuplicate(const QString& source_path, FileOutcome* outcome);
+  void CreateReference(const QString& source_path, FileOutcome* outcome) const;
+  bool TryLosslessCrop(const QString& source_path, const QString& dest_path,
+                       const CropConfig& crop, QString* adjustment) const;
+  void OnFileDone(const FileOutcome& outcome);
+  void LinkToBatchImage(const FileOutcome& outcome);
+  void Finish();
+
+  static constexpr int kMemoryBudgetKiB = 512 * 1024;
+
+  QThreadPool pool_;
+  QSemaphore memory_;  // KiB of decoded image data allowed in flight
+  QAtomicInt canceled_;
+  QString jpegtran_;  // Empty if jpegtran is not installed
+
+  QString project_dir_;
+  QString images_dir_;
+  CropConfig crop_;
+  QStringList sources_;
+  QStringList dest_names_;
+  bool reference_mode_;
+  QMap<QString, ImageReference> existing_references_;
+
+  // Duplicate detection; index_ and hash_sizes_ are read-only while workers run
+  bool check_duplicates_;
+  QString duplicate_policy_;
+  bool detect_near_;
+  int near_distance_;
+  ContentHashIndex index_;
+  QSet<qint64> hash_sizes_;  // Source sizes that may have an exact duplicate
+  QMutex batch_mutex_;
+  QHash<QPair<qint64, quint64>, QString> batch_hashes_;
+  QVector<QPair<quint64, QString>> batch_dhashes_;
+  QHash<QString, ContentHashEntry> new_entries_;
+  QVector<FileOutcome> pending_links_;  // Duplicates of images from this batch
+
+  ImportResult result_;
+  int total_;
+  int done_;
+};
+
+#endif  // IMAGEIMPORTER_H
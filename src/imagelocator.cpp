@@ -0,0 +1,183 @@
+#include "imagelocator.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include <iostream>
+
+#include "contenthashindex.h"
+#include "imageimporter.h"
+
+ImageLocator::ImageLocator(const QString& project_dir,
+                           const QMap<QString, ImageReference>& references)
+    : project_dir_(project_dir), references_(references)
+{
+}
+
+QString ImageLocator::ProjectPath(const QString& image_file) const
+{
+  return project_dir_ + "/images/" + image_file;
+}
+
+QString ImageLocator::SourcePath(const QString& image_file) const
+{
+  auto it = references_.constFind(image_file);
+  return it != references_.constEnd() ? it->path : ProjectPath(image_file);
+}
+
+QRect ImageLocator::CropRect(const QString& image_file) const
+{
+  auto it = references_.constFind(image_file);
+  return it != references_.constEnd() ? it->crop : QRect();
+}
+
+QImage ImageLocator::Read(const QString& image_file) const
+{
+  QImageReader reader(SourcePath(image_file));
+  const QRect crop = CropRect(image_file);
+  if (!crop.isNull())
+  {
+    reader.setClipRect(crop);
+  }
+
+  QImage image;
+  if (!reader.read(&image))
+  {
+    std::cerr << "Failed to read image: " << reader.fileName().toStdString() << " ("
+              << reader.errorString().toStdString() << ")" << std::endl;
+  }
+  return image;
+}
+
+QString ImageLocator::ExportPath(const QString& image_file) const
+{
+  auto it = references_.constFind(image_file);
+  if (it == references_.constEnd())
+  {
+    return ProjectPath(image_file);
+  }
+
+  const ImageReference& ref = *it;
+  const QFileInfo source_info(ref.path);
+  if (!source_info.exists())
+  {
+    return QString();
+  }
+
+  const QString export_path = ExportDirectory() + "/" + image_file;
+  const QFileInfo export_info(export_path);
+
+  if (ref.crop.isNull())
+  {
+#ifdef Q_OS_UNIX
+    if (export_info.isSymLink() && export_info.symLinkTarget() == source_info.absoluteFilePath())
+    {
+      return export_path;
+    }
+    PrepareExportDirectory();
+    QFile::remove(export_path);
+    if (QFile::link(ref.path, export_path))
+    {
+      return export_path;
+    }
+#endif
+    // No symlinks here; the source path still has the right pixels
+    return ref.path;
+  }
+
+  // Materialized once, rebuilt when the source is modified
+  if (export_info.exists() && !export_info.isSymLink() &&
+      export_info.lastModified() >= source_info.lastModified())
+  {
+    return export_path;
+  }
+
+  PrepareExportDirectory();
+  QFile::remove(export_path);
+
+  CropConfig crop;
+  crop.enabled = true;
+  crop.x = ref.crop.x();
+  crop.y = ref.crop.y();
+  crop.width = ref.crop.width();
+  crop.height = ref.crop.height();
+  if (!ImageImporter::CropImageFile(ref.path, export_path, crop))
+  {
+    std::cerr << "Failed to materialize crop: " << export_path.toStdString() << std::endl;
+    return QString();
+  }
+  return export_path;
+}
+
+QStringList ImageLocator::ExportPaths(const QStringList& image_files) const
+{
+  QVector<QString> paths(image_files.size());
+
+  QThreadPool pool;
+  pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+  QString* outputs = paths.data();
+  for (int i = 0; i < image_files.size(); ++i)
+  {
+    if (!IsReference(image_files[i]))
+    {
+      outputs[i] = ProjectPath(image_files[i]);
+      continue;
+    }
+
+    const QString image_file = image_files[i];
+    QString* slot = outputs + i;
+    pool.start([this, image_file, slot]() { *slot = ExportPath(image_file); });
+  }
+  pool.waitForDone();
+
+  return QStringList(paths.begin(), paths.end());
+}
+
+QStringList ImageLocator::VerifyReferences() const
+{
+  QStringList changed;
+  for (auto it = references_.constBegin(); it != references_.constEnd(); ++it)
+  {
+    const ImageReference& ref = it.value();
+    const QFileInfo info(ref.path);
+    if (!info.exists() || info.size() != ref.size)
+    {
+      changed.append(it.key());
+      continue;
+    }
+
+    if (info.lastModified().toMSecsSinceEpoch() != ref.mtime)
+    {
+      quint64 hash = 0;
+      if (!ref.has_hash || !ContentHashIndex::FileHash(ref.path, &hash) || hash != ref.hash)
+      {
+        changed.append(it.key());
+      }
+    }
+  }
+  return changed;
+}
+
+QString ImageLocator::ExportDirectory() const
+{
+  return project_dir_ + "/.polyseg/resolved/images";
+}
+
+void ImageLocator::PrepareExportDirectory() const
+{
+  QDir().mkpath(ExportDirectory());
+#ifdef Q_OS_UNIX
+  // YOLO trainers find a label by replacing /images/ with /labels/ in the image path
+  const QString labels_link = project_dir_ + "/.polyseg/resolved/labels";
+  if (!QFileInfo(labels_link).isSymLink())
+  {
+    QFile::link(QDir(project_dir_).absoluteFilePath("labels"), labels_link);
+  }
+#endif
+}
@@ -0,0 +1,86 @@
+#ifndef IMAGELOCATOR_H
+#define IMAGELOCATOR_H
+
+#include <QImage>
+#include <QMap>
+#include <QRect>
+#include <QString>
+#include <QStringList>
+
+#include "projectconfig.h"
+
+/**
+ * @brief Resolves project image names to the files holding their pixels
+ *
+ * Images are named by their file name in images/ in both storage modes; labels
+ * and meta files follow that name. In reference mode the pixels live in the
+ * source file and any crop is applied when the image is read.
+ *
+ * Handles:
+ * - Copied images: images/<name>
+ * - Referenced images: external path plus virtual crop
+ * - Export paths for plugins and trainers, named after the project image
+ *   (symlink to the source, or the crop materialized once) in
+ *   .polyseg/resolved/images/, next to a resolved/labels link to labels/
+ * - Detecting moved or modified sources
+ *
+ * A value type; copies are cheap and safe to use from worker threads.
+ */
+class ImageLocator
+{
+ public:
+  ImageLocator() = default;
+  ImageLocator(const QString& project_dir, const QMap<QString, ImageReference>& references);
+
+  const QString& ProjectDirectory() const { return project_dir_; }
+  bool IsReference(const QString& image_file) const { return references_.contains(image_file); }
+  QStringList ReferencedImages() const { return references_.keys(); }
+
+  /**
+   * @brief Logical path <project>/images/<name>, used to name labels and meta files
+   */
+  QString ProjectPath(const QString& image_file) const;
+
+  /**
+   * @brief File to decode: images/<name> or the referenced source
+   */
+  QString SourcePath(const QString& image_file) const;
+
+  /**
+   * @brief Crop to apply to SourcePath(); null when the file is used as is
+   */
+  QRect CropRect(const QString& image_file) const;
+
+  /**
+   * @brief Decode an image with its crop applied
+   */
+  QImage Read(const QString& image_file) const;
+
+  /**
+   * @brief Path to hand to external tools (plugins, trainers)
+   * @return Empty if a referenced source is missing or its crop cannot be written
+   */
+  QString ExportPath(const QString& image_file) const;
+
+  /**
+   * @brief ExportPath() for many images; crops are materialized in parallel
+   */
+  QStringList ExportPaths(const QStringList& image_files) const;
+
+  /**
+   * @brief Referenced images whose source is missing or has different content
+   *
+   * Size and mtime are compared first; the hash is only read when the mtime
+   * changed but the size did not (e.g. a copy that did not keep timestamps).
+   */
+  QStringList VerifyReferences() const;
+
+ private:
+  QString ExportDirectory() const;
+  void PrepareExportDirectory() const;
+
+  QString project_dir_;
+  QMap<QString, ImageReference> references_;
+};
+
+#endif  // IMAGELOCATOR_H
@@ -0,0 +1,277 @@
+#include "imageprefetchcache.h"
+
+#include <QFile>
+#include <QImageReader>
+#include <QThread>
+#include <QtMath>
+
+#include <iostream>
+
+#include "projectscanner.h"
+
+// PrefetchedImage implementation
+
+qint64 PrefetchedImage::ByteCount() const
+{
+  qint64 bytes = image.sizeInBytes();
+  for (const Polygon& polygon : polygons)
+  {
+    bytes += static_cast<qint64>(sizeof(Polygon)) +
+             polygon.points.size() * static_cast<qint64>(sizeof(QPoint));
+  }
+  return bytes;
+}
+
+// ImagePrefetchCache implementation
+
+ImagePrefetchCache::ImagePrefetchCache(QObject* parent)
+    : QObject(parent),
+      prefetch_ahead_(kDefaultPrefetchAhead),
+      prefetch_behind_(kDefaultPrefetchBehind),
+      generation_(0)
+{
+  // Leave cores for the GUI thread and for plugin processes
+  pool_.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+  SetByteBudget(kDefaultByteBudget);
+}
+
+ImagePrefetchCache::~ImagePrefetchCache()
+{
+  generation_++;
+  pool_.clear();
+  pool_.waitForDone();
+}
+
+void ImagePrefetchCache::SetImageLocator(const ImageLocator& locator)
+{
+  // New references only add images; cached decodes stay valid
+  if (locator.ProjectDirectory() != locator_.ProjectDirectory())
+  {
+    Clear();
+  }
+  locator_ = locator;
+}
+
+void ImagePrefetchCache::SetByteBudget(qint64 bytes)
+{
+  cache_.setMaxCost(static_cast<qsizetype>(qMax<qint64>(1, bytes / 1024)));
+}
+
+void ImagePrefetchCache::SetPrefetchWindow(int ahead, int behind)
+{
+  prefetch_ahead_ = qMax(0, ahead);
+  prefetch_behind_ = qMax(0, behind);
+}
+
+bool ImagePrefetchCache::TryGet(const QString& image_file, PrefetchedImage* entry)
+{
+  const PrefetchedImage* cached = cache_.object(image_file);
+  if (cached == nullptr)
+  {
+    return false;
+  }
+  *entry = *cached;
+  return true;
+}
+
+void ImagePrefetchCache::Request(const QString& image_file)
+{
+  if (cache_.contains(image_file))
+  {
+    emit ImageReady(image_file);
+    return;
+  }
+  StartDecode(image_file);
+}
+
+void ImagePrefetchCache::Prefetch(const QStringList& images, int current_index)
+{
+  const int count = images.size();
+  if (count == 0 || current_index < 0 || current_index >= count ||
+      locator_.ProjectDirectory().isEmpty())
+  {
+    return;
+  }
+
+  // Nearest neighbours first, forward direction preferred
+  const int steps = qMin(qMax(prefetch_ahead_, prefetch_behind_), count - 1);
+  for (int step = 1; step <= steps; ++step)
+  {
+    if (step <= prefetch_ahead_)
+    {
+      StartDecode(images[(current_index + step) % count]);
+    }
+    if (step <= prefetch_behind_)
+    {
+      StartDecode(images[((current_index - step) % count + count) % count]);
+    }
+  }
+}
+
+void ImagePrefetchCache::Invalidate(const QString& image_file)
+{
+  cache_.remove(image_file);
+  pending_.remove(image_file);
+  stale_labels_.remove(image_file);
+}
+
+void ImagePrefetchCache::InvalidateLabel(const QString& image_file)
+{
+  PrefetchedImage* cached = cache_.object(image_file);
+  if (cached != nullptr)
+  {
+    cached->label_valid = false;
+    cached->polygons.clear();
+  }
+
+  if (pending_.contains(image_file))
+  {
+    stale_labels_.insert(image_file);
+  }
+}
+
+void ImagePrefetchCache::InvalidateAllLabels()
+{
+  const QList<QString> keys = cache_.keys();
+  for (const QString& key : keys)
+  {
+    InvalidateLabel(key);
+  }
+  stale_labels_.unite(pending_);
+}
+
+void ImagePrefetchCache::Clear()
+{
+  generation_++;
+  pool_.clear();
+  pending_.clear();
+  stale_labels_.clear();
+  cache_.clear();
+}
+
+PrefetchedImage ImagePrefetchCache::Decode(const QString& image_path, const QString& label_path,
+                                           const QRect& crop)
+{
+  PrefetchedImage entry;
+
+  QImageReader reader(image_path);
+  if (!crop.isNull())
+  {
+    reader.setClipRect(crop);
+  }
+  if (!reader.read(&entry.image))
+  {
+    entry.error = reader.errorString();
+    std::cerr << "Failed to decode image: " << image_path.toStdString() << " ("
+              << entry.error.toStdString() << ")" << std::endl;
+    return entry;
+  }
+
+  entry.original_size = entry.image.size();
+  ReadLabel(label_path, &entry);
+  return entry;
+}
+
+PrefetchedImage ImagePrefetchCache::DecodePreview(const QString& image_path,
+                                                  const QString& label_path, double scale,
+                                                  const QRect& crop)
+{
+  QImageReader reader(image_path);
+  const QSize original_size = crop.isNull() ? reader.size() : crop.size();
+
+  // Rounded up, so PolygonCanvas::PreviewCovers() holds for the result
+  const QSize preview_size(qCeil(original_size.width() * scale),
+                           qCeil(original_size.height() * scale));
+  if (!original_size.isValid() || preview_size.isEmpty() ||
+      (preview_size.width() >= original_size.width() &&
+       preview_size.height() >= original_size.height()))
+  {
+    return Decode(image_path, label_path, crop);
+  }
+
+  // The clip rect is applied before scaling, in source coordinates
+  PrefetchedImage entry;
+  if (!crop.isNull())
+  {
+    reader.setClipRect(crop);
+  }
+  reader.setScaledSize(preview_size);
+  if (!reader.read(&entry.image))
+  {
+    entry.error = reader.errorString();
+    std::cerr << "Failed to decode image preview: " << image_path.toStdString() << " ("
+              << entry.error.toStdString() << ")" << std::endl;
+    return entry;
+  }
+
+  entry.original_size = original_size;
+  ReadLabel(label_path, &entry);
+  return entry;
+}
+
+void ImagePrefetchCache::ReadLabel(const QString& label_path, PrefetchedImage* entry)
+{
+  // Colors are applied when the polygons are handed to the canvas
+  QFile label_file(label_path);
+  if (label_file.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    entry->has_label = true;
+    entry->polygons =
+        PolygonCanvas::ParseAnnotations(label_file.readAll(), entry->original_size, {});
+  }
+  entry->label_valid = true;
+}
+
+QString ImagePrefetchCache::LabelPath(const QString& image_file) const
+{
+  return locator_.ProjectDirectory() + "/labels/" + ProjectScanner::CompleteBaseName(image_file) + ".txt";
+}
+
+void ImagePrefetchCache::Insert(const QString& image_file, const PrefetchedImage& entry)
+{
+  const qsizetype cost = static_cast<qsizetype>(qMax<qint64>(1, entry.ByteCount() / 1024));
+  cache_.insert(image_file, new PrefetchedImage(entry), cost);
+}
+
+void ImagePrefetchCache::StartDecode(const QString& image_file)
+{
+  if (cache_.contains(image_file) || pending_.contains(image_file))
+  {
+    return;
+  }
+
+  pending_.insert(image_file);
+
+  const int generation = generation_;
+  const QString image_path = locator_.SourcePath(image_file);
+  const QString label_path = LabelPath(image_file);
+  const QRect crop = locator_.CropRect(image_file);
+
+  pool_.start([this, image_file, image_path, label_path, crop, generation]() {
+    PrefetchedImage entry = Decode(image_path, label_path, crop);
+    QMetaObject::invokeMethod(
+        this,
+        [this, image_file, entry, generation]() mutable {
+          // Dropped by Clear() or Invalidate() while decoding
+          if (generation != generation_ || !pending_.remove(image_file))
+          {
+            return;
+          }
+          if (stale_labels_.remove(image_file))
+          {
+            entry.label_valid = false;
+            entry.polygons.clear();
+          }
+          if (entry.image.isNull())
+          {
+            emit DecodeFailed(image_file, entry.error);
+          }
+          else if (!cache_.contains(image_file))
+          {
+            Insert(image_file, entry);
+            emit ImageReady(image_file);
+          }
+        },
+        Qt::QueuedConnection);
+  });
+}
@@ -0,0 +1,157 @@
+#ifndef IMAGEPREFETCHCACHE_H
+#define IMAGEPREFETCHCACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+#include "imagelocator.h"
+#include "polygoncanvas.h"
+
+/**
+ * @brief Decoded image plus its parsed label file
+ */
+struct PrefetchedImage
+{
+  QImage image;
+  QSize original_size;       // Full (cropped) size; larger than image for previews
+  bool label_valid = false;  // polygons reflect labels/ at decode time
+  bool has_label = false;    // a label file existed
+  QVector<Polygon> polygons;
+  QString error;             // Decoder message when image is null
+
+  qint64 ByteCount() const;
+};
+
+/**
+ * @brief Background decode cache for next/previous image navigation
+ *
+ * Handles:
+ * - Decoding images and parsing their labels with QImageReader on a thread pool
+ * - Prefetching the next N and previous M images in navigation order
+ * - LRU eviction under a byte budget
+ *
+ * All public methods must be called from the GUI thread; the GUI thread only
+ * has to convert the cached QImage to a QPixmap.
+ */
+class ImagePrefetchCache : public QObject
+{
+  Q_OBJECT
+
+ public:
+  explicit ImagePrefetchCache(QObject* parent = nullptr);
+  ~ImagePrefetchCache() override;
+
+  /**
+   * @brief Set where project images are read from; drops the cache if the project changed
+   */
+  void SetImageLocator(const ImageLocator& locator);
+
+  /**
+   * @brief Maximum memory held by decoded images
+   */
+  void SetByteBudget(qint64 bytes);
+
+  /**
+   * @brief Number of images to prefetch after and before the current one
+   */
+  void SetPrefetchWindow(int ahead, int behind);
+
+  /**
+   * @brief Get a cached full-resolution image without decoding
+   * @return false if the image is not cached yet
+   */
+  bool TryGet(const QString& image_file, PrefetchedImage* entry);
+
+  /**
+   * @brief Decode one image in the background; ImageReady() or DecodeFailed() follows
+   */
+  void Request(const QString& image_file);
+
+  /**
+   * @brief Queue background decodes around current_index
+   * @param images Navigation order (usually the project image list)
+   * @param current_index Index of the image being shown
+   */
+  void Prefetch(const QStringList& images, int current_index);
+
+  /**
+   * @brief Drop a cached image (e.g. deleted or replaced on disk)
+   */
+  void Invalidate(const QString& image_file);
+
+  /**
+   * @brief Mark the parsed label of one image as stale
+   */
+  void InvalidateLabel(const QString& image_file);
+
+  /**
+   * @brief Mark every parsed label as stale (labels/ changed on disk)
+   */
+  void InvalidateAllLabels();
+
+  /**
+   * @brief Drop all cached images and ignore decodes still in flight
+   */
+  void Clear();
+
+  /**
+   * @brief Decode an image and parse its label file
+   * @param image_path Absolute image path
+   * @param label_path Absolute label path (may not exist)
+   * @param crop Region to decode (virtual crop of a referenced image); null = whole image
+   */
+  static PrefetchedImage Decode(const QString& image_path, const QString& label_path,
+                                const QRect& crop = QRect());
+
+  /**
+   * @brief Decode a downscaled preview with just the pixels a zoom level shows
+   * @param scale Device pixels per image pixel (PolygonCanvas::DisplayScale())
+   *
+   * Uses QImageReader::setScaledSize, which lets the JPEG decoder skip DCT
+   * coefficients instead of decoding every pixel. Polygons are parsed in
+   * original image coordinates. Decodes the full image when the scale needs
+   * every pixel or the format cannot report its size up front, so the result
+   * never has to be refined at that zoom.
+   */
+  static PrefetchedImage DecodePreview(const QString& image_path, const QString& label_path,
+                                       double scale, const QRect& crop = QRect());
+
+ signals:
+  /**
+   * @brief Emitted when a background decode has been added to the cache
+   */
+  void ImageReady(const QString& image_file);
+
+  /**
+   * @brief Emitted when a background decode failed; the image is not cached
+   * @param error Decoder message
+   */
+  void DecodeFailed(const QString& image_file, const QString& error);
+
+ private:
+  static void ReadLabel(const QString& label_path, PrefetchedImage* entry);
+  QString LabelPath(const QString& image_file) const;
+  void Insert(const QString& image_file, const PrefetchedImage& entry);
+  void StartDecode(const QString& image_file);
+
+  static constexpr qint64 kDefaultByteBudget = 512LL * 1024 * 1024;
+  static constexpr int kDefaultPrefetchAhead = 3;
+  static constexpr int kDefaultPrefetchBehind = 1;
+
+  ImageLocator locator_;
+  QCache<QString, PrefetchedImage> cache_;  // Cost in KiB
+  QSet<QString> pending_;       // Decodes in flight
+  QSet<QString> stale_labels_;  // In-flight decodes whose label changed meanwhile
+  int prefetch_ahead_;
+  int prefetch_behind_;
+  int generation_;  // Bumped on Clear() so stale decodes are dropped
+  QThreadPool pool_;
+};
+
+#endif  // IMAGEPREFETCHCACHE_H
@@ -0,0 +1,235 @@
+#include "imagestatestore.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <iostream>
+
+#include "projectconfig.h"
+
+QString ImageStateStore::StorePath(const QString& project_dir)
+{
+  return project_dir + "/.polyseg/image_state.bin";
+}
+
+bool ImageStateStore::Load(const QString& project_dir, QMap<QString, DatasetSplit>* splits,
+                           QMap<QString, ImageReference>* references)
+{
+  pending_.clear();
+  pending_count_ = 0;
+  rewrite_ = false;
+  loaded_dir_ = project_dir;
+  file_records_ = 0;
+
+  QFile file(StorePath(project_dir));
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_6_0);
+  quint32 magic = 0;
+  quint16 version = 0;
+  in >> magic >> version;
+  if (magic != kMagic || version != kVersion)
+  {
+    std::cerr << "Invalid image state file: " << file.fileName().toStdString() << std::endl;
+    loaded_dir_.clear();
+    return false;
+  }
+
+  while (!in.atEnd())
+  {
+    quint8 type = 0;
+    QString filename;
+    in >> type >> filename;
+
+    if (type == kSplit)
+    {
+      quint8 split = 0;
+      in >> split;
+      // Split counters are indexed by the value, so an out of range byte is corruption
+      if (split > static_cast<quint8>(DatasetSplit::Test))
+      {
+        in.setStatus(QDataStream::ReadCorruptData);
+      }
+      else if (in.status() == QDataStream::Ok)
+      {
+        splits->insert(filename, static_cast<DatasetSplit>(split));
+      }
+    }
+    else if (type == kClearSplits)
+    {
+      splits->clear();
+    }
+    else if (type == kReference)
+    {
+      ImageReference ref;
+      in >> ref.path >> ref.size >> ref.mtime >> ref.has_hash >> ref.hash >> ref.crop;
+      if (in.status() == QDataStream::Ok)
+      {
+        references->insert(filename, ref);
+      }
+    }
+    else if (type == kRemoveReference)
+    {
+      references->remove(filename);
+    }
+    else
+    {
+      in.setStatus(QDataStream::ReadCorruptData);
+    }
+
+    if (in.status() != QDataStream::Ok)
+    {
+      // Torn or corrupt tail (e.g. crash during append): keep what was read
+      // and write a clean file on next save
+      std::cerr << "Image state truncated after " << file_records_ << " records" << std::endl;
+      rewrite_ = true;
+      break;
+    }
+    file_records_++;
+  }
+
+  return true;
+}
+
+void ImageStateStore::RecordSplit(const QString& filename, DatasetSplit split)
+{
+  pending_.append(SplitRecord(filename, split));
+  pending_count_++;
+}
+
+void ImageStateStore::RecordClearSplits()
+{
+  QDataStream out(&pending_, QIODevice::WriteOnly | QIODevice::Append);
+  out.setVersion(QDataStream::Qt_6_0);
+  out << static_cast<quint8>(kClearSplits) << QString();
+  pending_count_++;
+}
+
+void ImageStateStore::RecordReference(const QString& filename, const ImageReference& reference)
+{
+  pending_.append(ReferenceRecord(filename, reference));
+  pending_count_++;
+}
+
+void ImageStateStore::RecordRemoveReference(const QString& filename)
+{
+  QDataStream out(&pending_, QIODevice::WriteOnly | QIODevice::Append);
+  out.setVersion(QDataStream::Qt_6_0);
+  out << static_cast<quint8>(kRemoveReference) << filename;
+  pending_count_++;
+}
+
+void ImageStateStore::MarkRewrite()
+{
+  pending_.clear();
+  pending_count_ = 0;
+  rewrite_ = true;
+}
+
+bool ImageStateStore::Flush(const QString& project_dir, const QMap<QString, DatasetSplit>& splits,
+                            const QMap<QString, ImageReference>& references)
+{
+  const QString path = StorePath(project_dir);
+  const qint64 live_records = splits.size() + references.size();
+
+  if (rewrite_ || loaded_dir_ != project_dir || !QFile::exists(path) ||
+      file_records_ + pending_count_ > 2 * live_records + kCompactSlack)
+  {
+    return Rewrite(project_dir, splits, references);
+  }
+  if (pending_count_ == 0)
+  {
+    return true;
+  }
+
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+  {
+    std::cerr << "Cannot append image state: " << path.toStdString() << std::endl;
+    return false;
+  }
+  if (file.write(pending_) != pending_.size() || !file.flush())
+  {
+    std::cerr << "Failed to append image state: " << path.toStdString() << std::endl;
+    rewrite_ = true;
+    return false;
+  }
+
+  file_records_ += pending_count_;
+  pending_.clear();
+  pending_count_ = 0;
+  return true;
+}
+
+QByteArray ImageStateStore::Header()
+{
+  QByteArray data;
+  QDataStream out(&data, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_6_0);
+  out << kMagic << kVersion;
+  return data;
+}
+
+QByteArray ImageStateStore::SplitRecord(const QString& filename, DatasetSplit split)
+{
+  QByteArray data;
+  QDataStream out(&data, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_6_0);
+  out << static_cast<quint8>(kSplit) << filename << static_cast<quint8>(split);
+  return data;
+}
+
+QByteArray ImageStateStore::ReferenceRecord(const QString& filename,
+                                            const ImageReference& reference)
+{
+  QByteArray data;
+  QDataStream out(&data, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_6_0);
+  out << static_cast<quint8>(kReference) << filename << reference.path << reference.size
+      << reference.mtime << reference.has_hash << reference.hash << reference.crop;
+  return data;
+}
+
+bool ImageStateStore::Rewrite(const QString& project_dir,
+                              const QMap<QString, DatasetSplit>& splits,
+                              const QMap<QString, ImageReference>& references)
+{
+  QByteArray data = Header();
+  for (auto it = splits.constBegin(); it != splits.constEnd(); ++it)
+  {
+    data.append(SplitRecord(it.key(), it.value()));
+  }
+  for (auto it = references.constBegin(); it != references.constEnd(); ++it)
+  {
+    data.append(ReferenceRecord(it.key(), it.value()));
+  }
+
+  const QString path = StorePath(project_dir);
+  QDir().mkpath(QFileInfo(path).absolutePath());
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    std::cerr << "Cannot write image state: " << path.toStdString() << std::endl;
+    return false;
+  }
+  file.write(data);
+  if (!file.commit())
+  {
+    std::cerr << "Failed to write image state: " << path.toStdString() << std::endl;
+    return false;
+  }
+
+  loaded_dir_ = project_dir;
+  file_records_ = splits.size() + references.size();
+  pending_.clear();
+  pending_count_ = 0;
+  rewrite_ = false;
+  return true;
+}
@@ -0,0 +1,89 @@
+#ifndef IMAGESTATESTORE_H
+#define IMAGESTATESTORE_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+
+// Defined in projectconfig.h, which holds a store by value
+enum class DatasetSplit : quint8;
+struct ImageReference;
+
+/**
+ * @brief Append-only binary journal of per-image project state
+ *
+ * The project JSON holds configuration only; per-image splits and image
+ * references live in <project>/.polyseg/image_state.bin. Changes are recorded
+ * as small records and appended on save, so saving a project costs
+ * O(changes) instead of re-serializing every image.
+ *
+ * Handles:
+ * - Replaying the journal on load (last record for an image wins)
+ * - Recovering from a torn final record (the file is compacted on next save)
+ * - Compacting the journal when stale records dominate
+ */
+class ImageStateStore
+{
+ public:
+  /**
+   * @brief Path of the journal inside a project
+   */
+  static QString StorePath(const QString& project_dir);
+
+  /**
+   * @brief Replay the journal of a project
+   * @return false if no journal exists or its header is invalid
+   */
+  bool Load(const QString& project_dir, QMap<QString, DatasetSplit>* splits,
+            QMap<QString, ImageReference>* references);
+
+  void RecordSplit(const QString& filename, DatasetSplit split);
+  void RecordClearSplits();
+  void RecordReference(const QString& filename, const ImageReference& reference);
+  void RecordRemoveReference(const QString& filename);
+
+  /**
+   * @brief Drop pending records and rewrite the whole state on next Flush()
+   *
+   * Used when the state was replaced wholesale (e.g. migrated from project JSON).
+   */
+  void MarkRewrite();
+
+  bool HasPendingChanges() const { return pending_count_ > 0 || rewrite_; }
+
+  /**
+   * @brief Write pending records to the project's journal
+   *
+   * Appends to the existing file; writes a compacted file instead when the
+   * journal belongs to another directory, is missing, or is mostly stale.
+   */
+  bool Flush(const QString& project_dir, const QMap<QString, DatasetSplit>& splits,
+             const QMap<QString, ImageReference>& references);
+
+ private:
+  enum RecordType : quint8
+  {
+    kSplit = 1,
+    kClearSplits = 2,
+    kReference = 3,
+    kRemoveReference = 4
+  };
+
+  static QByteArray Header();
+  static QByteArray SplitRecord(const QString& filename, DatasetSplit split);
+  static QByteArray ReferenceRecord(const QString& filename, const ImageReference& reference);
+  bool Rewrite(const QString& project_dir, const QMap<QString, DatasetSplit>& splits,
+               const QMap<QString, ImageReference>& references);
+
+  static constexpr quint32 kMagic = 0x50534953;  // "PSIS"
+  static constexpr quint16 kVersion = 1;
+  static constexpr int kCompactSlack = 1024;
+
+  QString loaded_dir_;       // Project the on-disk journal belongs to
+  qint64 file_records_ = 0;  // Records in the on-disk journal
+  QByteArray pending_;       // Serialized records not yet written
+  int pending_count_ = 0;
+  bool rewrite_ = false;
+};
+
+#endif  // IMAGESTATESTORE_H
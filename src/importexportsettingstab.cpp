@@ -40,6 +40,7 @@ void ImportExportSettingsTab::LoadFromConfig(const ProjectConfig& config)
   ui_->crop_y_spinbox_->setValue(crop_cfg.y);
   ui_->crop_width_spinbox_->setValue(crop_cfg.width);
   ui_->crop_height_spinbox_->setValue(crop_cfg.height);
+  ui_->crop_snap_to_mcu_checkbox_->setChecked(crop_cfg.snap_to_mcu);
 
   // Load import path configuration
   const ImportPathConfig& import_path_cfg = config.GetImportPathConfig();
@@ -49,6 +50,12 @@ void ImportExportSettingsTab::LoadFromConfig(const ProjectConfig& config)
   {
     ui_->skip_folders_list_->addItem(folder);
   }
+  ui_->storage_mode_combo_->setCurrentIndex(import_path_cfg.storage_mode == "reference" ? 1 : 0);
+  const int policy_index =
+      QStringList({"skip", "link", "import"}).indexOf(import_path_cfg.duplicate_policy);
+  ui_->duplicate_policy_combo_->setCurrentIndex(qMax(0, policy_index));
+  ui_->detect_near_duplicates_checkbox_->setChecked(import_path_cfg.detect_near_duplicates);
+  ui_->near_duplicate_distance_spinbox_->setValue(import_path_cfg.near_duplicate_distance);
 
   // Load image extensions (default for now)
   ui_->image_extensions_edit_->setText("jpg, jpeg, png, bmp, tiff");
@@ -63,6 +70,7 @@ void ImportExportSettingsTab::SaveToConfig(ProjectConfig& config)
   crop_cfg.y = ui_->crop_y_spinbox_->value();
   crop_cfg.width = ui_->crop_width_spinbox_->value();
   crop_cfg.height = ui_->crop_height_spinbox_->value();
+  crop_cfg.snap_to_mcu = ui_->crop_snap_to_mcu_checkbox_->isChecked();
   config.SetCropConfig(crop_cfg);
 
   // Save import path configuration
@@ -73,6 +81,12 @@ void ImportExportSettingsTab::SaveToConfig(ProjectConfig& config)
   {
     import_path_cfg.skip_folders.append(ui_->skip_folders_list_->item(i)->text());
   }
+  import_path_cfg.storage_mode =
+      ui_->storage_mode_combo_->currentIndex() == 1 ? "reference" : "copy";
+  import_path_cfg.duplicate_policy =
+      QStringList({"skip", "link", "import"}).value(ui_->duplicate_policy_combo_->currentIndex());
+  import_path_cfg.detect_near_duplicates = ui_->detect_near_duplicates_checkbox_->isChecked();
+  import_path_cfg.near_duplicate_distance = ui_->near_duplicate_distance_spinbox_->value();
   config.SetImportPathConfig(import_path_cfg);
 }
 
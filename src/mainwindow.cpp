@@ -8,6 +8,7 @@
 #include <QDialogButtonBox>
 #include <QDir>
 #include <QDirIterator>
+#include <QDockWidget>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QFormLayout>
@@ -22,11 +23,14 @@
 #include <QKeyEvent>
 #include <QLabel>
 #include <QLineEdit>
+#include <QListView>
 #include <QListWidget>
 #include <QMessageBox>
 #include <QPixmap>
+#include <QPointer>
 #include <QProcess>
 #include <QProgressBar>
+#include <QProgressDialog>
 #include <QPushButton>
 #include <QRegularExpression>
 #include <QSettings>
@@ -34,14 +38,23 @@
 #include <QStandardPaths>
 #include <QStatusBar>
 #include <QTextEdit>
+#include <QThreadPool>
 #include <QVBoxLayout>
 
 #include <iostream>
 
 #include "aipluginmanager.h"
+#include "datasetmanifest.h"
+#include "imagebrowser.h"
+#include "imageimporter.h"
+#include "imagelocator.h"
+#include "imageprefetchcache.h"
 #include "pluginwizard.h"
 #include "polygoncanvas.h"
+#include "projectscanner.h"
+#include "pythonenvironmentmanager.h"
 #include "settingsdialog.h"
+#include "thumbnailcache.h"
 #include "ui_mainwindow.h"
 
 MainWindow::MainWindow(QWidget* parent)
@@ -52,7 +65,8 @@ MainWindow::MainWindow(QWidget* parent)
       status_left_(nullptr),
       status_center_(nullptr),
       status_right_(nullptr),
-      ai_plugin_manager_(nullptr)
+      ai_plugin_manager_(nullptr),
+      project_scanner_(nullptr)
 {
   ui->setupUi(this);
 
@@ -61,6 +75,7 @@ MainWindow::MainWindow(QWidget* parent)
   ai_plugin_manager_->SetProjectConfig(&project_config_);
   ai_plugin_manager_->SetCanvas(ui->label);
   ai_plugin_manager_->SetStatusBar(statusBar());
+  ai_plugin_manager_->SetReviewStateTable(&review_states_);
 
   // Connect AI Plugin Manager signals
   connect(ai_plugin_manager_, &AIPluginManager::StatusMessage, this,
@@ -69,6 +84,30 @@ MainWindow::MainWindow(QWidget* parent)
           &MainWindow::UpdateStatusBar);
   connect(ai_plugin_manager_, &AIPluginManager::RequestNextUnreviewed, this,
           &MainWindow::NextUnreviewedImage);
+  connect(ai_plugin_manager_, &AIPluginManager::TrainingComplete, this, [this](bool success) {
+    // Successful jobs register their model version
+    if (success)
+    {
+      SaveProjectConfig();
+    }
+  });
+
+  // Initialize project scanner (incremental updates from the file system)
+  project_scanner_ = new ProjectScanner(this);
+  connect(project_scanner_, &ProjectScanner::ImagesChanged, this,
+          &MainWindow::OnProjectImagesChanged);
+  connect(project_scanner_, &ProjectScanner::LabelsChanged, this,
+          &MainWindow::OnProjectLabelsChanged);
+  connect(project_scanner_, &ProjectScanner::MetaFilesChanged, this,
+          &MainWindow::OnProjectLabelsChanged);
+  connect(project_scanner_, &ProjectScanner::ScanFinished, this,
+          &MainWindow::OnProjectScanFinished);
+
+  image_cache_ = new ImagePrefetchCache(this);
+  connect(image_cache_, &ImagePrefetchCache::ImageReady, this, &MainWindow::OnImageDecoded);
+  connect(image_cache_, &ImagePrefetchCache::DecodeFailed, this, &MainWindow::OnImageDecodeFailed);
+
+  SetupImageBrowser();
 
   // Setup status bar
   status_left_ = new QLabel(this);
@@ -130,6 +169,10 @@ MainWindow::MainWindow(QWidget* parent)
   connect(ui->actionAutoDetect, &QAction::triggered, this, &MainWindow::RunAutoDetect);
   connect(ui->actionBatchDetect, &QAction::triggered, this, &MainWindow::RunBatchDetect);
   connect(ui->actionTrainModel, &QAction::triggered, this, &MainWindow::RunTrainModel);
+  connect(ui->actionTrainingMonitor, &QAction::triggered, ai_plugin_manager_,
+          &AIPluginManager::ShowTrainingMonitor);
+  connect(ui->actionTrainingQueue, &QAction::triggered, ai_plugin_manager_,
+          &AIPluginManager::ShowTrainingQueue);
   connect(ui->actionProjectSettings, &QAction::triggered, this, &MainWindow::ShowProjectSettings);
   connect(ui->actionProjectStatistics, &QAction::triggered, this, &MainWindow::ShowProjectStatistics);
 
@@ -209,14 +252,14 @@ void MainWindow::Load()
   }
 
   auto pixmap = QPixmap(filename);
-  ui->label->setPixmap(pixmap);
-  ui->label->setFixedSize(pixmap.size());
+  ui->label->SetImage(pixmap, pixmap.size());
   current_image_path_ = filename;
 }
 
 void MainWindow::Increase()
 {
   ui->label->Increase();
+  RefineCurrentImage();
 }
 
 void MainWindow::Decrease()
@@ -227,6 +270,7 @@ void MainWindow::Decrease()
 void MainWindow::ResetZoom()
 {
   ui->label->ResetZoom();
+  RefineCurrentImage();
 }
 
 void MainWindow::OnClassSelected(int index)
@@ -315,125 +359,114 @@ void MainWindow::AddImagesToProject()
     return;
   }
 
-  // Copy images to project's images/ folder
-  QString images_dir = project_directory_ + "/images";
-  QDir dir;
-  if (!dir.exists(images_dir))
-  {
-    dir.mkpath(images_dir);
-  }
+  // Copy (and crop) on a thread pool; the window stays responsive
+  ImageImporter* importer = new ImageImporter(this);
+  QProgressDialog* progress =
+      new QProgressDialog("Adding images to project...", "Cancel", 0, files.size(), this);
+  progress->setWindowTitle("Add Images");
+  progress->setWindowModality(Qt::WindowModal);
+  progress->setMinimumDuration(500);
+  progress->setAutoClose(false);
+  progress->setAutoReset(false);
+
+  ui->actionAddImages->setEnabled(false);
 
-  int copied = 0;
-  int skipped = 0;
-  QStringList failed;
+  connect(progress, &QProgressDialog::canceled, importer, &ImageImporter::Cancel);
+  connect(importer, &ImageImporter::Progress, progress, [progress](int done, int total) {
+    progress->setMaximum(total);
+    progress->setValue(done);
+  });
+  connect(importer, &ImageImporter::Finished, this,
+          [this, importer, progress](const ImportResult& result) {
+            progress->close();
+            progress->deleteLater();
+            importer->deleteLater();
+            ui->actionAddImages->setEnabled(true);
+            OnImagesImported(result);
+          });
 
-  for (const QString& source_path : files)
+  if (project_config_.IsReferenceMode())
   {
-    QFileInfo file_info(source_path);
-    QString filename = file_info.fileName();
-    
-    // Generate prefix from folder structure using ImportPathConfig
-    QString prefix;
-    const ImportPathConfig& import_cfg = project_config_.GetImportPathConfig();
-    
-    // Get the directory part of the source path
-    QString dir_path = file_info.absolutePath();
-    
-    // Remove base path if configured
-    QString remaining_path = dir_path;
-    if (!import_cfg.base_path.isEmpty() && dir_path.startsWith(import_cfg.base_path))
-    {
-      remaining_path = dir_path.mid(import_cfg.base_path.length());
-      // Remove leading slash if present
-      if (remaining_path.startsWith("/"))
-      {
-        remaining_path = remaining_path.mid(1);
-      }
-    }
-    
-    // Split path into components and filter out skip folders
-    QStringList path_parts = remaining_path.split("/", Qt::SkipEmptyParts);
-    QStringList filtered_parts;
-    
-    for (const QString& part : path_parts)
-    {
-      if (!import_cfg.skip_folders.contains(part))
-      {
-        filtered_parts.append(part);
-      }
-    }
-    
-    // Create prefix from remaining parts
-    if (!filtered_parts.isEmpty())
-    {
-      prefix = filtered_parts.join("_") + "_";
-    }
-    
-    // Create final filename with prefix
-    QString prefixed_filename = prefix + filename;
-    QString dest_path = images_dir + "/" + prefixed_filename;
+    importer->SetReferenceMode(project_config_.GetImageReferences());
+  }
 
-    // Check if file already exists
-    if (QFile::exists(dest_path))
-    {
-      skipped++;
-      continue;
-    }
+  CropConfig crop = project_config_.GetCropConfig();
+  crop.enabled = project_config_.IsCropEnabled();
+  importer->Start(files, project_directory_, project_config_.GetImportPathConfig(), crop);
+}
 
-    // Copy file
-    if (QFile::copy(source_path, dest_path))
-    {
-      // Apply crop if enabled
-      if (project_config_.IsCropEnabled())
-      {
-        const CropConfig& crop = project_config_.GetCropConfig();
-        QImage image(dest_path);
-        
-        if (!image.isNull())
-        {
-          int crop_width = crop.width > 0 ? crop.width : image.width() - crop.x;
-          int crop_height = crop.height > 0 ? crop.height : image.height() - crop.y;
-          
-          // Validate crop bounds
-          if (crop.x >= 0 && crop.y >= 0 && 
-              crop.x + crop_width <= image.width() && 
-              crop.y + crop_height <= image.height())
-          {
-            QImage cropped = image.copy(crop.x, crop.y, crop_width, crop_height);
-            
-            // Save cropped image (overwrite the copied file)
-            if (!cropped.save(dest_path))
-            {
-              // If save fails, remove the file and mark as failed
-              QFile::remove(dest_path);
-              failed.append(prefixed_filename);
-              continue;
-            }
-          }
-        }
-      }
-      
-      copied++;
-    }
-    else
-    {
-      failed.append(prefixed_filename);
-    }
+void MainWindow::OnImagesImported(const ImportResult& result)
+{
+  if (!result.references.isEmpty())
+  {
+    project_config_.AddImageReferences(result.references);
+    UpdateImageLocator();
   }
 
-  // Rescan project images (this will update splits for labeled images)
-  ScanProjectImages();
+  // Merge the new files into the scan snapshot instead of rescanning the whole project
+  if (project_scanner_->GetProjectDirectory() == project_directory_)
+  {
+    project_scanner_->AddImages(result.added);
+  }
+  else
+  {
+    ScanProjectImages();
+  }
   SaveProjectConfig();
 
   // Show results
-  QString message = QString("Images added: %1\n").arg(copied);
-  if (skipped > 0)
+  QString message = QString("Images added: %1\n").arg(result.added.size());
+  if (!result.references.isEmpty())
+  {
+    message += QString("Referenced in place (not copied): %1\n").arg(result.references.size());
+  }
+  if (result.skipped > 0)
+  {
+    message += QString("Skipped (already exist): %1\n").arg(result.skipped);
+  }
+  if (!result.duplicates.isEmpty())
+  {
+    message += QString("Skipped (duplicate content): %1\n").arg(result.duplicates.size());
+  }
+  if (result.linked > 0)
+  {
+    message += QString("Linked to identical images: %1\n").arg(result.linked);
+  }
+  if (result.canceled)
   {
-    message += QString("Skipped (already exist): %1\n").arg(skipped);
+    message += "Import canceled before all images were added.\n";
   }
-  if (!failed.isEmpty())
+  if (result.lossless_cropped > 0)
   {
-    message += QString("\nFailed to copy:\n%1").arg(failed.join("\n"));
+    message += QString("Cropped losslessly (JPEG): %1\n").arg(result.lossless_cropped);
+  }
+  if (!result.crop_adjustments.isEmpty())
+  {
+    message += QString("\nCrop adjusted for lossless JPEG cropping:\n%1\n")
+                   .arg(result.crop_adjustments.join("\n"));
+  }
+  if (!result.duplicates.isEmpty())
+  {
+    // "=" identical, "~" visually similar
+    QStringList shown = result.duplicates.mid(0, 20);
+    if (result.duplicates.size() > shown.size())
+    {
+      shown.append(QString("... and %1 more").arg(result.duplicates.size() - shown.size()));
+    }
+    message += QString("\nDuplicates not imported:\n%1\n").arg(shown.join("\n"));
+  }
+  if (!result.similar.isEmpty())
+  {
+    QStringList shown = result.similar.mid(0, 20);
+    if (result.similar.size() > shown.size())
+    {
+      shown.append(QString("... and %1 more").arg(result.similar.size() - shown.size()));
+    }
+    message += QString("\nImported, but similar to existing images:\n%1\n").arg(shown.join("\n"));
+  }
+  if (!result.failed.isEmpty())
+  {
+    message += QString("\nFailed to copy:\n%1").arg(result.failed.join("\n"));
   }
 
   QMessageBox::information(this, "Add Images Complete", message);
@@ -509,6 +542,7 @@ void MainWindow::AutoSaveCurrentImage()
 
   // Get filename without extension
   QFileInfo fileInfo(current_image_path_);
+  image_cache_->InvalidateLabel(fileInfo.fileName());
   QString labelsDir = project_directory_ + "/labels";
   QString labelPath = labelsDir + "/" + fileInfo.completeBaseName() + ".txt";
 
@@ -519,6 +553,13 @@ void MainWindow::AutoSaveCurrentImage()
     {
       QFile::remove(labelPath);
     }
+
+    if (review_states_.GetState(current_image_index_) == ReviewState::Approved)
+    {
+      bool has_meta = ai_plugin_manager_->HasMetaFile(current_image_path_);
+      review_states_.SetState(current_image_index_,
+                              has_meta ? ReviewState::Meta : ReviewState::None);
+    }
   }
   else
   {
@@ -531,7 +572,10 @@ void MainWindow::AutoSaveCurrentImage()
     
     // Save annotations
     ui->label->ExportAnnotations(labelPath, 0);
+    review_states_.SetState(current_image_index_, ReviewState::Approved);
   }
+
+  image_browser_model_->RefreshStates();
 }
 
 void MainWindow::LoadImageAtIndex(int index)
@@ -553,36 +597,54 @@ void MainWindow::LoadImageAtIndex(int index)
 
   // Load new image
   current_image_index_ = index;
-  QString imagePath = project_directory_ + "/images/" + image_list_[index];
+  const ImageLocator locator(project_directory_, project_config_.GetImageReferences());
+  QString imagePath = locator.ProjectPath(image_list_[index]);
 
-  QPixmap pixmap(imagePath);
-  if (pixmap.isNull())
+  QFileInfo fileInfo(imagePath);
+  QString labelPath = project_directory_ + "/labels/" + fileInfo.completeBaseName() + ".txt";
+
+  // Full resolution if it was prefetched, otherwise decoded at the current zoom:
+  // a downscaled preview below 100% (refined once zoom needs more pixels), the
+  // full image at 100% and above
+  PrefetchedImage entry;
+  if (!image_cache_->TryGet(image_list_[index], &entry))
+  {
+    entry = ImagePrefetchCache::DecodePreview(locator.SourcePath(image_list_[index]), labelPath,
+                                              ui->label->DisplayScale(),
+                                              locator.CropRect(image_list_[index]));
+  }
+  if (entry.image.isNull())
   {
-    QMessageBox::critical(this, "Error", "Failed to load image:\n" + imagePath);
+    QMessageBox::critical(this, "Error",
+                          "Failed to load image:\n" + locator.SourcePath(image_list_[index]) +
+                              "\n\n" + entry.error);
     return;
   }
 
   current_image_path_ = imagePath;
-  ui->label->setPixmap(pixmap);
+  ui->label->SetImage(QPixmap::fromImage(entry.image), entry.original_size);
   // Don't reset zoom - keep current zoom level
   // ui->label->ResetZoom();
 
   // Load existing annotations if they exist
-  QFileInfo fileInfo(imagePath);
-  QString labelPath = project_directory_ + "/labels/" + fileInfo.completeBaseName() + ".txt";
 
   // Temporarily disconnect auto-save signal during loading
   disconnect(ui->label, &PolygonCanvas::PolygonsChanged, this, &MainWindow::AutoSaveCurrentImage);
 
-  if (QFile::exists(labelPath))
+  // Get class colors from project config
+  QVector<QColor> class_colors;
+  for (const auto& cls : project_config_.GetClasses())
   {
-    // Get class colors from project config
-    QVector<QColor> class_colors;
-    for (const auto& cls : project_config_.GetClasses())
-    {
-      class_colors.append(cls.color);
-    }
+    class_colors.append(cls.color);
+  }
 
+  if (entry.label_valid && entry.has_label)
+  {
+    // Label was parsed together with the image
+    ui->label->SetPolygons(entry.polygons, class_colors);
+  }
+  else if (!entry.label_valid && QFile::exists(labelPath))
+  {
     ui->label->LoadAnnotations(labelPath, class_colors);
   }
   else
@@ -598,6 +660,52 @@ void MainWindow::LoadImageAtIndex(int index)
 
   // Set focus to canvas for keyboard shortcuts
   ui->label->setFocus();
+
+  RefineCurrentImage();
+  image_cache_->Prefetch(image_list_, current_image_index_);
+
+  QModelIndex browser_index = image_browser_model_->index(current_image_index_);
+  image_browser_view_->setCurrentIndex(browser_index);
+  image_browser_view_->scrollTo(browser_index);
+}
+
+void MainWindow::RefineCurrentImage()
+{
+  if (current_image_index_ >= 0 && current_image_index_ < image_list_.size() &&
+      ui->label->NeedsFullResolution())
+  {
+    image_cache_->Request(image_list_[current_image_index_]);
+  }
+}
+
+void MainWindow::OnImageDecoded(const QString& image_file)
+{
+  if (current_image_index_ < 0 || current_image_index_ >= image_list_.size() ||
+      image_list_[current_image_index_] != image_file || !ui->label->NeedsFullResolution())
+  {
+    return;
+  }
+
+  // Swap the preview for the full-resolution image; polygons are unaffected
+  PrefetchedImage entry;
+  if (image_cache_->TryGet(image_file, &entry))
+  {
+    ui->label->SetImage(QPixmap::fromImage(entry.image), entry.original_size);
+  }
+}
+
+void MainWindow::OnImageDecodeFailed(const QString& image_file, const QString& error)
+{
+  // Failed prefetches of other images are reported when they are opened
+  if (current_image_index_ < 0 || current_image_index_ >= image_list_.size() ||
+      image_list_[current_image_index_] != image_file)
+  {
+    return;
+  }
+
+  // The preview stays on screen; zooming in requests the full image again
+  statusBar()->showMessage(
+      QString("Failed to load full resolution of %1: %2").arg(image_file, error), 10000);
 }
 
 void MainWindow::NextImage()
@@ -799,6 +907,7 @@ void MainWindow::CreateNewProject()
     newWindow->OnClassSelected(0);
   }
   
+  newWindow->ScanProjectImages();
   newWindow->UpdateWindowTitle();
   newWindow->show();
 
@@ -850,19 +959,11 @@ void MainWindow::OpenProject()
     
     newWindow->ScanProjectImages();
     newWindow->UpdateWindowTitle();
-    
-    // Load first image if available
-    if (!newWindow->image_list_.isEmpty())
-    {
-      newWindow->LoadImageAtIndex(0);
-    }
-    
     newWindow->show();
 
     QMessageBox::information(newWindow, "Project Opened",
-                             QString("Loaded: %1\nImages found: %2")
-                                 .arg(newWindow->project_config_.GetProjectName())
-                                 .arg(newWindow->image_list_.size()));
+                             QString("Loaded: %1")
+                                 .arg(newWindow->project_config_.GetProjectName()));
   }
   else
   {
@@ -890,40 +991,34 @@ void MainWindow::ScanProjectImages()
     return;
   }
 
-  image_list_.clear();
-  QDir imagesDir(project_directory_ + "/images");
-  QStringList filters;
-  filters << "*.jpg" << "*.jpeg" << "*.png" << "*.bmp";
+  // One listing of images/ and labels/ on the scanner's worker; the watcher keeps
+  // it current afterwards. Until OnProjectScanFinished() the project shows empty.
+  const QStringList referenced = project_config_.GetImageReferences().keys();
+  project_scanner_->Watch(project_directory_, referenced);
+  ApplyScanSnapshot();
+  statusBar()->showMessage("Scanning project...");
+}
 
-  image_list_ = imagesDir.entryList(filters, QDir::Files, QDir::Name);
-  project_config_.SetTotalImages(image_list_.size());
+void MainWindow::OnProjectScanFinished()
+{
+  ApplyScanSnapshot();
+  VerifyImageReferences();
+  UpdateWindowTitle();
+  UpdateStatusBar();
+  statusBar()->showMessage(QString("Found %1 images, %2 labeled")
+                               .arg(image_list_.size())
+                               .arg(project_config_.GetLabeledImages()),
+                           5000);
 
-  // Count labeled images and build list
-  int labeled = 0;
-  QStringList labeled_images;
-  QDir labelsDir(project_directory_ + "/labels");
-  for (const QString& image : image_list_)
-  {
-    QFileInfo imageInfo(image);
-    QString labelFile = imageInfo.completeBaseName() + ".txt";
-    if (labelsDir.exists(labelFile))
-    {
-      labeled++;
-      labeled_images.append(image);
-    }
-  }
+  std::cout << "Found " << image_list_.size() << " images, "
+            << project_config_.GetLabeledImages() << " labeled" << std::endl;
 
-  // Update image splits if enabled - only for labeled images
-  if (project_config_.IsSplitEnabled())
+  // A freshly opened project starts at its first image
+  if (current_image_index_ < 0 && !image_list_.isEmpty())
   {
-    project_config_.UpdateImageSplits(labeled_images);
+    LoadImageAtIndex(0);
   }
 
-  int totalPolygons = 0;  // TODO: count from label files
-  project_config_.UpdateStatistics(image_list_.size(), labeled, totalPolygons);
-
-  std::cout << "Found " << image_list_.size() << " images, " << labeled << " labeled" << std::endl;
-
   // Show split statistics if enabled
   if (project_config_.IsSplitEnabled())
   {
@@ -931,12 +1026,216 @@ void MainWindow::ScanProjectImages()
               << " Val: " << project_config_.GetValCount()
               << " Test: " << project_config_.GetTestCount() << std::endl;
   }
+}
+
+void MainWindow::ApplyScanSnapshot()
+{
+  const ProjectScanResult& scan = project_scanner_->GetSnapshot();
+
+  // Keep the current image selected even if its index shifts
+  QString current_image;
+  if (current_image_index_ >= 0 && current_image_index_ < image_list_.size())
+  {
+    current_image = image_list_[current_image_index_];
+  }
+
+  image_list_ = scan.images;
+  review_states_.Rebuild(image_list_, scan.labels, scan.metas);
+
+  if (!current_image.isEmpty())
+  {
+    current_image_index_ = image_list_.indexOf(current_image);
+    if (current_image_index_ < 0)
+    {
+      // Current image was deleted from disk
+      current_image_path_.clear();
+      ui->label->ClearAllPolygons();
+    }
+  }
+
+  // Update image splits if enabled - only for labeled images
+  AssignNewSplits(scan.LabeledImages());
+
+  int totalPolygons = 0;  // TODO: count from label files
+  project_config_.UpdateStatistics(image_list_.size(), scan.LabeledCount(), totalPolygons);
+
+  UpdateImageLocator();
+  image_browser_model_->SetImages(&image_list_, &review_states_);
+  if (current_image_index_ >= 0)
+  {
+    image_browser_view_->setCurrentIndex(image_browser_model_->index(current_image_index_));
+  }
 
   // Update AI plugin manager with project info
   ai_plugin_manager_->SetProjectDirectory(project_directory_);
   ai_plugin_manager_->SetImageList(&image_list_);
 }
 
+void MainWindow::AssignNewSplits(const QStringList& labeled_images)
+{
+  if (!project_config_.IsSplitEnabled() ||
+      project_config_.CountUnassignedImages(labeled_images) == 0)
+  {
+    return;
+  }
+
+  QHash<QString, QVector<int>> image_classes;
+  if (project_config_.GetSplitConfig().stratify_by_class)
+  {
+    // Class balance counts every labeled image. Class ids come from the label
+    // manifest; only changed labels are re-read
+    const QStringList all_labeled = project_scanner_->GetSnapshot().LabeledImages();
+    DatasetManifest manifest;
+    manifest.Load(project_directory_);
+    image_classes = manifest.LabelClasses(project_directory_ + "/labels", all_labeled);
+    manifest.Save(project_directory_);
+  }
+  project_config_.UpdateImageSplits(labeled_images, image_classes);
+}
+
+void MainWindow::UpdateImageLocator()
+{
+  const ImageLocator locator(project_directory_, project_config_.GetImageReferences());
+  image_cache_->SetImageLocator(locator);
+  thumbnail_cache_->SetImageLocator(locator);
+  project_scanner_->SetReferencedImages(locator.ReferencedImages());
+}
+
+void MainWindow::VerifyImageReferences()
+{
+  if (project_config_.GetImageReferences().isEmpty())
+  {
+    return;
+  }
+
+  // Sources may sit on slow network storage; stat them off the GUI thread
+  const ImageLocator locator(project_directory_, project_config_.GetImageReferences());
+  const QString project_dir = project_directory_;
+  QPointer<MainWindow> self(this);
+  QThreadPool::globalInstance()->start([self, locator, project_dir]() {
+    const QStringList changed = locator.VerifyReferences();
+    if (self.isNull())
+    {
+      return;
+    }
+    QMetaObject::invokeMethod(
+        self,
+        [self, changed, project_dir]() {
+          if (self.isNull() || changed.isEmpty() || project_dir != self->project_directory_)
+          {
+            return;
+          }
+          for (const QString& image_file : changed)
+          {
+            std::cerr << "Referenced image missing or modified: " << image_file.toStdString()
+                      << std::endl;
+          }
+          self->statusBar()->showMessage(
+              QString("%1 referenced images are missing or were modified since import")
+                  .arg(changed.size()),
+              10000);
+        },
+        Qt::QueuedConnection);
+  });
+}
+
+void MainWindow::SetupImageBrowser()
+{
+  thumbnail_cache_ = new ThumbnailCache(this);
+  image_browser_model_ = new ImageBrowserModel(thumbnail_cache_, this);
+
+  // Uniform item sizes + batched layout keep the view virtualized: only
+  // visible rows are laid out, painted, and asked for thumbnails
+  image_browser_view_ = new QListView(this);
+  image_browser_view_->setViewMode(QListView::IconMode);
+  image_browser_view_->setFlow(QListView::LeftToRight);
+  image_browser_view_->setWrapping(true);
+  image_browser_view_->setResizeMode(QListView::Adjust);
+  image_browser_view_->setMovement(QListView::Static);
+  image_browser_view_->setUniformItemSizes(true);
+  image_browser_view_->setLayoutMode(QListView::Batched);
+  image_browser_view_->setBatchSize(500);
+  image_browser_view_->setSelectionMode(QAbstractItemView::SingleSelection);
+  image_browser_view_->setItemDelegate(new ImageBrowserDelegate(image_browser_view_));
+  image_browser_view_->setModel(image_browser_model_);
+
+  connect(image_browser_view_->selectionModel(), &QItemSelectionModel::currentChanged, this,
+          [this](const QModelIndex& current) {
+            if (current.isValid() && current.row() != current_image_index_)
+            {
+              ui->label->FinishCurrentPolygon();
+              LoadImageAtIndex(current.row());
+            }
+          });
+
+  QDockWidget* dock = new QDockWidget("Images", this);
+  dock->setObjectName("imageBrowserDock");
+  dock->setWidget(image_browser_view_);
+  addDockWidget(Qt::BottomDockWidgetArea, dock);
+
+  ui->menuView->addSeparator();
+  ui->menuView->addAction(dock->toggleViewAction());
+}
+
+void MainWindow::OnProjectImagesChanged(const QStringList& added, const QStringList& removed)
+{
+  std::cout << "Project images changed: +" << added.size() << " -" << removed.size()
+            << std::endl;
+
+  for (const QString& image : removed)
+  {
+    image_cache_->Invalidate(image);
+  }
+
+  // The initial scan is applied once, on ScanFinished
+  if (project_scanner_->IsScanning())
+  {
+    return;
+  }
+
+  ApplyScanSnapshot();
+  UpdateWindowTitle();
+  UpdateStatusBar();
+}
+
+void MainWindow::OnProjectLabelsChanged(const QStringList& added, const QStringList& removed)
+{
+  // The initial scan is applied once, on ScanFinished
+  if (project_scanner_->IsScanning())
+  {
+    image_cache_->InvalidateAllLabels();
+    return;
+  }
+
+  // Only the images with these stems change (also fired for .meta changes); the
+  // image list and every other state stay as they are
+  const ProjectScanResult& scan = project_scanner_->GetSnapshot();
+  QStringList newly_labeled;
+  for (const QStringList* stems : {&added, &removed})
+  {
+    for (const QString& stem : *stems)
+    {
+      for (int index : review_states_.IndicesForStem(stem))
+      {
+        const QString& image = image_list_[index];
+        image_cache_->InvalidateLabel(image);
+        review_states_.Update(image, scan.labels, scan.metas);
+        if (scan.IsLabeled(image))
+        {
+          newly_labeled.append(image);
+        }
+      }
+    }
+  }
+
+  AssignNewSplits(newly_labeled);
+  int totalPolygons = 0;  // TODO: count from label files
+  project_config_.UpdateStatistics(image_list_.size(), scan.LabeledCount(), totalPolygons);
+  image_browser_model_->RefreshStates();
+  UpdateWindowTitle();
+  UpdateStatusBar();
+}
+
 // ============================================================================
 // AI Plugin System (delegated to AIPluginManager)
 // ============================================================================
@@ -988,6 +1287,13 @@ void MainWindow::ShowPluginWizard()
     // Update AI plugin manager
     ai_plugin_manager_->SetProjectConfig(&project_config_);
 
+    // Custom plugins bring their own environment; registry plugins install into <project>/.venv
+    if (new_config.use_project_venv && new_config.plugin_id != "custom")
+    {
+      PreparePluginEnvironment(new_config);
+      return;
+    }
+
     QMessageBox::information(this, "Plugin Configured",
                              QString("Plugin '%1' has been configured successfully.\n\n"
                                      "You can now use Tools -> Auto Detect to run AI detection.")
@@ -995,6 +1301,65 @@ void MainWindow::ShowPluginWizard()
   }
 }
 
+void MainWindow::PreparePluginEnvironment(const PluginConfig& plugin)
+{
+  // Installing a plugin's frameworks takes minutes; the window stays usable meanwhile
+  PythonEnvironmentManager* python = new PythonEnvironmentManager(this);
+  QProgressDialog* progress =
+      new QProgressDialog("Detecting Python environment...", "Cancel", 0, 0, this);
+  progress->setWindowTitle("Plugin Environment");
+  progress->setWindowModality(Qt::WindowModal);
+  progress->setMinimumDuration(0);
+  progress->setAutoClose(false);
+  progress->setAutoReset(false);
+
+  const QString plugin_id = plugin.plugin_id;
+  const QString plugin_name = plugin.name;
+  const QString project_dir = project_directory_;
+  const bool isolated = !plugin.use_shared_env;
+
+  connect(progress, &QProgressDialog::canceled, this, [this, python, progress]() {
+    // Cancel() does not report back; the project keeps its configuration
+    python->disconnect(this);
+    python->Cancel();
+    python->deleteLater();
+    progress->deleteLater();
+    statusBar()->showMessage("Plugin environment setup canceled", 5000);
+  });
+  connect(python, &PythonEnvironmentManager::venvCreationProgress, progress,
+          &QProgressDialog::setLabelText);
+  connect(python, &PythonEnvironmentManager::installationProgress, progress,
+          [progress](const QString& message, int) { progress->setLabelText(message); });
+  connect(python, &PythonEnvironmentManager::detectionFinished, this,
+          [python, plugin_id, project_dir, isolated](const PythonInfo&) {
+            python->PrepareProjectEnvironment(plugin_id, project_dir, isolated);
+          });
+  connect(python, &PythonEnvironmentManager::environmentReady, this,
+          [this, python, progress, plugin_name](bool success, const QString& venv_path,
+                                               const QString& error_message) {
+            progress->close();
+            progress->deleteLater();
+            python->deleteLater();
+
+            if (!success)
+            {
+              QMessageBox::warning(this, "Plugin Environment",
+                                   QString("Plugin '%1' is configured, but its Python "
+                                           "environment could not be prepared:\n\n%2")
+                                       .arg(plugin_name, error_message));
+              return;
+            }
+            QMessageBox::information(
+                this, "Plugin Configured",
+                QString("Plugin '%1' has been configured successfully.\n"
+                        "Python environment: %2\n\n"
+                        "You can now use Tools -> Auto Detect to run AI detection.")
+                    .arg(plugin_name, venv_path));
+          });
+
+  python->DetectPythonAsync();
+}
+
 void MainWindow::PromptModelRegistration()
 {
   ai_plugin_manager_->PromptModelRegistration();
@@ -1045,38 +1410,31 @@ void MainWindow::NextUnreviewedImage()
     return;
   }
 
-  int start_index = current_image_index_ + 1;
-
-  for (int i = 0; i < image_list_.size(); ++i)
+  int idx = review_states_.FindNextUnreviewed(current_image_index_ + 1);
+  if (idx >= 0)
   {
-    int idx = (start_index + i) % image_list_.size();
     QString image_path = project_directory_ + "/images/" + image_list_[idx];
+    bool has_meta = review_states_.GetState(idx) == ReviewState::Meta;
 
-    bool has_meta = ai_plugin_manager_->HasMetaFile(image_path);
-    bool has_approved = ai_plugin_manager_->HasApprovedFile(image_path);
+    LoadImageAtIndex(idx);
 
-    if ((has_meta && !has_approved) || (!has_meta && !has_approved))
+    if (has_meta)
     {
-      LoadImageAtIndex(idx);
-
-      if (has_meta)
-      {
-        ai_plugin_manager_->LoadFromMetaFile(image_path);
-        statusBar()->showMessage(
-            QString("Reviewing AI detections - Edit and Approve/Reject (Image %1/%2)")
-                .arg(idx + 1)
-                .arg(image_list_.size()),
-            5000);
-      }
-      else
-      {
-        statusBar()->showMessage(QString("No detections - Annotate manually (Image %1/%2)")
-                                     .arg(idx + 1)
-                                     .arg(image_list_.size()),
-                                 5000);
-      }
-      return;
+      ai_plugin_manager_->LoadFromMetaFile(image_path);
+      statusBar()->showMessage(
+          QString("Reviewing AI detections - Edit and Approve/Reject (Image %1/%2)")
+              .arg(idx + 1)
+              .arg(image_list_.size()),
+          5000);
     }
+    else
+    {
+      statusBar()->showMessage(QString("No detections - Annotate manually (Image %1/%2)")
+                                   .arg(idx + 1)
+                                   .arg(image_list_.size()),
+                               5000);
+    }
+    return;
   }
 
   QMessageBox::information(this, "Review Complete",
@@ -1151,15 +1509,7 @@ void MainWindow::ShowProjectStatistics()
 
   // Progress bar
   int total = image_list_.size();
-  int labeled = 0;
-  for (const QString& img : image_list_)
-  {
-    QString img_path = project_directory_ + "/images/" + img;
-    if (ai_plugin_manager_->HasApprovedFile(img_path))
-    {
-      labeled++;
-    }
-  }
+  int labeled = review_states_.Count(ReviewState::Approved);
 
   QProgressBar* progress = new QProgressBar(&dialog);
   progress->setRange(0, total);
@@ -1206,14 +1556,14 @@ void MainWindow::UpdateStatusBar()
     QString img_name = image_list_[current_image_index_];
     QString labelPath = project_directory_ + "/labels/" + QFileInfo(img_name).completeBaseName() + ".txt";
     QString annotated = QFile::exists(labelPath) ? " - Annotated" : "";
-    QPixmap pixmap = ui->label->GetPixmap();
+    QSize image_size = ui->label->GetOriginalImageSize();
     status_center_->setText(QString("Image %1/%2%3 - %4 (%5x%6)")
                                 .arg(current_image_index_ + 1)
                                 .arg(image_list_.size())
                                 .arg(annotated)
                                 .arg(img_name)
-                                .arg(pixmap.width())
-                                .arg(pixmap.height()));
+                                .arg(image_size.width())
+                                .arg(image_size.height()));
   }
   else
   {
@@ -1772,13 +2122,6 @@ void MainWindow::OpenRecentProject()
     
     newWindow->ScanProjectImages();
     newWindow->UpdateWindowTitle();
-    
-    // Load first image if available
-    if (!newWindow->image_list_.isEmpty())
-    {
-      newWindow->LoadImageAtIndex(0);
-    }
-    
     newWindow->show();
   }
   else
@@ -1821,12 +2164,6 @@ void MainWindow::LoadLastProject()
     ScanProjectImages();
     UpdateWindowTitle();
     
-    // Load first image if available
-    if (!image_list_.isEmpty())
-    {
-      LoadImageAtIndex(0);
-    }
-    
     std::cout << "Loaded last project: " << project_config_.GetProjectName().toStdString() 
               << " with " << image_list_.size() << " images" << std::endl;
   }
@@ -4,6 +4,7 @@
 #include <QMainWindow>
 
 #include "projectconfig.h"
+#include "reviewstatetable.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui
@@ -11,9 +12,15 @@ namespace Ui
 class MainWindow;
 }
 class QLabel;
+class QListView;
 QT_END_NAMESPACE
 
 class AIPluginManager;
+class ImageBrowserModel;
+class ImagePrefetchCache;
+class ProjectScanner;
+class ThumbnailCache;
+struct ImportResult;
 
 class MainWindow : public QMainWindow
 {
@@ -88,6 +95,19 @@ class MainWindow : public QMainWindow
   void SaveProjectConfig();
   void UpdateWindowTitle();
   void ScanProjectImages();
+  void ApplyScanSnapshot();
+  void AssignNewSplits(const QStringList& labeled_images);
+  void OnProjectScanFinished();
+  void UpdateImageLocator();
+  void VerifyImageReferences();
+  void OnProjectImagesChanged(const QStringList& added, const QStringList& removed);
+  void OnProjectLabelsChanged(const QStringList& added, const QStringList& removed);
+  void RefineCurrentImage();
+  void SetupImageBrowser();
+  void OnImagesImported(const ImportResult& result);
+  void PreparePluginEnvironment(const PluginConfig& plugin);
+  void OnImageDecoded(const QString& image_file);
+  void OnImageDecodeFailed(const QString& image_file, const QString& error);
   void UpdateStatusBar();
   void LoadShortcuts();
   void SaveShortcuts();
@@ -119,5 +139,19 @@ class MainWindow : public QMainWindow
 
   // AI Plugin Manager
   AIPluginManager* ai_plugin_manager_;
+
+  // Watches images/ and labels/ for incremental rescans
+  ProjectScanner* project_scanner_;
+
+  // Review state per image (none / meta / approved), parallel to image_list_
+  ReviewStateTable review_states_;
+
+  // Background decode of neighbouring images for fast navigation
+  ImagePrefetchCache* image_cache_;
+
+  // Thumbnail strip with review-state badges (dockable)
+  ThumbnailCache* thumbnail_cache_;
+  ImageBrowserModel* image_browser_model_;
+  QListView* image_browser_view_;
 };
 #endif  // MAINWINDOW_H
@@ -0,0 +1,228 @@
+#include "modelcacheindex.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <iostream>
+
+QString ModelCacheIndex::IndexPath(const QString& store_dir)
+{
+  return QDir(store_dir).filePath("index.json");
+}
+
+bool ModelCacheIndex::Load(const QString& store_dir)
+{
+  store_dir_ = store_dir;
+  entries_.clear();
+  total_bytes_ = 0;
+  budget_bytes_ = 0;
+
+  QFile file(IndexPath(store_dir));
+  if (!file.exists())
+  {
+    return true;
+  }
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    std::cerr << "Cannot read model cache index: " << file.fileName().toStdString()
+              << std::endl;
+    return false;
+  }
+
+  // 64-bit values are stored as strings; JSON numbers are doubles
+  const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+  budget_bytes_ = root["budget"].toString().toLongLong();
+  const QJsonObject models = root["models"].toObject();
+  for (auto it = models.begin(); it != models.end(); ++it)
+  {
+    const QJsonObject obj = it.value().toObject();
+    Entry entry;
+    entry.size = obj["size"].toString().toLongLong();
+    entry.last_used = obj["last_used"].toString().toLongLong();
+    for (const QJsonValue& value : obj["files"].toArray())
+    {
+      entry.files.append(value.toString());
+    }
+    for (const QJsonValue& value : obj["references"].toArray())
+    {
+      entry.references.append(value.toString());
+    }
+    entries_.insert(it.key(), entry);
+    total_bytes_ += entry.size;
+  }
+  return true;
+}
+
+bool ModelCacheIndex::Save() const
+{
+  if (store_dir_.isEmpty())
+  {
+    return false;
+  }
+
+  QJsonObject models;
+  for (auto it = entries_.begin(); it != entries_.end(); ++it)
+  {
+    QJsonObject obj;
+    obj["size"] = QString::number(it->size);
+    obj["last_used"] = QString::number(it->last_used);
+    obj["files"] = QJsonArray::fromStringList(it->files);
+    obj["references"] = QJsonArray::fromStringList(it->references);
+    models[it.key()] = obj;
+  }
+
+  QJsonObject root;
+  root["budget"] = QString::number(budget_bytes_);
+  root["models"] = models;
+
+  QDir().mkpath(store_dir_);
+  QSaveFile file(IndexPath(store_dir_));
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    std::cerr << "Cannot write model cache index: " << file.fileName().toStdString()
+              << std::endl;
+    return false;
+  }
+  file.write(QJsonDocument(root).toJson());
+  return file.commit();
+}
+
+void ModelCacheIndex::AddFile(const QString& sha256, qint64 size, const QString& file_path)
+{
+  const QString key = sha256.toLower();
+  if (!entries_.contains(key))
+  {
+    Entry entry;
+    entry.size = size;
+    entries_.insert(key, entry);
+    total_bytes_ += size;
+  }
+
+  Entry& entry = entries_[key];
+  if (!entry.files.contains(file_path))
+  {
+    entry.files.append(file_path);
+  }
+  entry.last_used = QDateTime::currentMSecsSinceEpoch();
+}
+
+void ModelCacheIndex::RemoveFile(const QString& file_path)
+{
+  for (Entry& entry : entries_)
+  {
+    entry.files.removeAll(file_path);
+  }
+}
+
+void ModelCacheIndex::Touch(const QString& sha256)
+{
+  auto it = entries_.find(sha256.toLower());
+  if (it != entries_.end())
+  {
+    it->last_used = QDateTime::currentMSecsSinceEpoch();
+  }
+}
+
+void ModelCacheIndex::AddReference(const QString& sha256, const QString& path)
+{
+  auto it = entries_.find(sha256.toLower());
+  if (it != entries_.end() && !it->references.contains(path))
+  {
+    it->references.append(path);
+  }
+}
+
+void ModelCacheIndex::RemoveReference(const QString& sha256, const QString& path)
+{
+  auto it = entries_.find(sha256.toLower());
+  if (it != entries_.end())
+  {
+    it->references.removeAll(path);
+  }
+}
+
+bool ModelCacheIndex::Contains(const QString& sha256) const
+{
+  return entries_.contains(sha256.toLower());
+}
+
+ModelCacheIndex::Entry ModelCacheIndex::Value(const QString& sha256) const
+{
+  return entries_.value(sha256.toLower());
+}
+
+void ModelCacheIndex::Remove(const QString& sha256)
+{
+  auto it = entries_.find(sha256.toLower());
+  if (it != entries_.end())
+  {
+    total_bytes_ -= it->size;
+    entries_.erase(it);
+  }
+}
+
+void ModelCacheIndex::Clear()
+{
+  entries_.clear();
+  total_bytes_ = 0;
+}
+
+qint64 ModelCacheIndex::TotalBytes() const
+{
+  return total_bytes_;
+}
+
+qint64 ModelCacheIndex::Budget() const
+{
+  return budget_bytes_;
+}
+
+void ModelCacheIndex::SetBudget(qint64 bytes)
+{
+  budget_bytes_ = qMax<qint64>(0, bytes);
+}
+
+QStringList ModelCacheIndex::EvictionCandidates(const QStringList& keep)
+{
+  if (budget_bytes_ <= 0 || total_bytes_ <= budget_bytes_)
+  {
+    return QStringList();
+  }
+
+  // Deleted projects no longer pin their models
+  QList<QPair<qint64, QString>> unreferenced;
+  for (auto it = entries_.begin(); it != entries_.end(); ++it)
+  {
+    it->references.erase(std::remove_if(it->references.begin(), it->references.end(),
+                                        [](const QString& path)
+                                        { return !QFileInfo::exists(path); }),
+                         it->references.end());
+    if (it->references.isEmpty() && !keep.contains(it.key()))
+    {
+      unreferenced.append({it->last_used, it.key()});
+    }
+  }
+  std::sort(unreferenced.begin(), unreferenced.end());
+
+  QStringList candidates;
+  qint64 remaining = total_bytes_;
+  for (const auto& candidate : unreferenced)
+  {
+    if (remaining <= budget_bytes_)
+    {
+      break;
+    }
+    candidates.append(candidate.second);
+    remaining -= entries_[candidate.second].size;
+  }
+  return candidates;
+}
@@ -0,0 +1,101 @@
+#ifndef MODELCACHEINDEX_H
+#define MODELCACHEINDEX_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Index of the content-addressed model store with a byte budget
+ *
+ * Shared workstations collect stale checkpoints; walking the cache to size it
+ * gets slow and clearing it is all-or-nothing. The index keeps one entry per
+ * stored digest, so the cache size is a running total and old models can be
+ * evicted one by one.
+ *
+ * Handles:
+ * - Persistence in ~/.polyseg/models/store/index.json
+ * - Size, last-used time, linked files and referencing projects per digest
+ * - Least recently used eviction of unreferenced models above the budget
+ *
+ * A reference is a project path (directory or model file) that needs the
+ * model; it pins the entry until the path no longer exists.
+ */
+class ModelCacheIndex
+{
+ public:
+  struct Entry
+  {
+    qint64 size = 0;
+    qint64 last_used = 0;    // ms since epoch
+    QStringList files;       // Hardlinks or copies of the stored file
+    QStringList references;  // Project paths using the model
+  };
+
+  /**
+   * @brief Path of the index file inside a store directory
+   */
+  static QString IndexPath(const QString& store_dir);
+
+  /**
+   * @brief Load the index of a store (a missing file gives an empty index)
+   */
+  bool Load(const QString& store_dir);
+
+  /**
+   * @brief Save the index into the store directory it was loaded from
+   */
+  bool Save() const;
+
+  /**
+   * @brief Record a file holding the stored content and mark the entry used
+   * @param size Size of the stored file; only used for a new entry
+   */
+  void AddFile(const QString& sha256, qint64 size, const QString& file_path);
+
+  /**
+   * @brief Forget a file in whichever entry lists it
+   */
+  void RemoveFile(const QString& file_path);
+
+  /**
+   * @brief Mark an entry as used now
+   */
+  void Touch(const QString& sha256);
+
+  void AddReference(const QString& sha256, const QString& path);
+  void RemoveReference(const QString& sha256, const QString& path);
+
+  bool Contains(const QString& sha256) const;
+  Entry Value(const QString& sha256) const;
+  void Remove(const QString& sha256);
+  void Clear();
+
+  /**
+   * @brief Total size of the stored files (O(1))
+   */
+  qint64 TotalBytes() const;
+
+  /**
+   * @brief Byte budget of the store, 0 for unlimited
+   */
+  qint64 Budget() const;
+  void SetBudget(qint64 bytes);
+
+  /**
+   * @brief Digests to evict to get within the budget, least recently used first
+   * @param keep Digests that must stay (e.g. in use by running downloads)
+   *
+   * References to paths that no longer exist are dropped first; entries that
+   * are still referenced are never returned.
+   */
+  QStringList EvictionCandidates(const QStringList& keep);
+
+ private:
+  QString store_dir_;
+  QMap<QString, Entry> entries_;
+  qint64 total_bytes_ = 0;
+  qint64 budget_bytes_ = 0;
+};
+
+#endif  // MODELCACHEINDEX_H
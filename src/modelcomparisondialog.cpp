@@ -1,17 +1,54 @@
 #include "modelcomparisondialog.h"
 
+#include <QHeaderView>
 #include <QMessageBox>
 
+#include <algorithm>
+
+#include "imagelocator.h"
 #include "polygoncanvas.h"
 #include "ui_modelcomparisondialog.h"
 
+namespace
+{
+using ClassMetrics = ModelComparisonEngine::ClassMetrics;
+
+ClassMetrics SumMetrics(const QMap<int, ClassMetrics>& metrics)
+{
+  ClassMetrics sum;
+  for (const ClassMetrics& class_metrics : metrics)
+  {
+    sum.Add(class_metrics);
+  }
+  return sum;
+}
+
+QTableWidgetItem* NumberItem(double value)
+{
+  // Numbers as display data so sorting is numeric
+  QTableWidgetItem* item = new QTableWidgetItem;
+  item->setData(Qt::DisplayRole, qRound(value * 1000.0) / 1000.0);
+  item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+  return item;
+}
+
+QTableWidgetItem* TextItem(const QString& text)
+{
+  QTableWidgetItem* item = new QTableWidgetItem(text);
+  item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+  return item;
+}
+}  // namespace
+
 ModelComparisonDialog::ModelComparisonDialog(ProjectConfig& config, const QString& project_dir,
                                              QWidget* parent)
     : QDialog(parent),
       ui_(new Ui::ModelComparisonDialog),
       config_(config),
       project_dir_(project_dir),
-      current_image_index_(0)
+      current_image_index_(0),
+      engine_(new ModelComparisonEngine(config, project_dir, this)),
+      has_results_(false)
 {
   ui_->setupUi(this);
   SetupUI();
@@ -21,6 +58,8 @@ ModelComparisonDialog::ModelComparisonDialog(ProjectConfig& config, const QStrin
 
 ModelComparisonDialog::~ModelComparisonDialog()
 {
+  // Keep the predictions finished so far for the next comparison
+  engine_->Cancel();
   delete ui_;
 }
 
@@ -41,6 +80,11 @@ void ModelComparisonDialog::SetupUI()
     ui_->model_a_combo_->setCurrentIndex(0);
     ui_->model_b_combo_->setCurrentIndex(1);
   }
+
+  ui_->progress_bar_->setVisible(false);
+  ui_->class_table_->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+  ui_->image_table_->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+  ui_->image_table_->verticalHeader()->setVisible(false);
 }
 
 void ModelComparisonDialog::ConnectSignals()
@@ -54,21 +98,18 @@ void ModelComparisonDialog::ConnectSignals()
   connect(ui_->prev_button_, &QPushButton::clicked, this, &ModelComparisonDialog::OnPreviousImage);
   connect(ui_->next_button_, &QPushButton::clicked, this, &ModelComparisonDialog::OnNextImage);
   connect(ui_->compare_button_, &QPushButton::clicked, this, &ModelComparisonDialog::RunComparison);
+  connect(ui_->image_table_, &QTableWidget::cellClicked, this,
+          &ModelComparisonDialog::OnImageRowClicked);
+  connect(engine_, &ModelComparisonEngine::progress, this,
+          &ModelComparisonDialog::OnComparisonProgress);
+  connect(engine_, &ModelComparisonEngine::finished, this,
+          &ModelComparisonDialog::OnComparisonFinished);
 }
 
 void ModelComparisonDialog::LoadTestImages()
 {
   // Get all images assigned to test split
-  test_images_.clear();
-  const QMap<QString, QString>& splits = config_.GetImageSplits();
-
-  for (auto it = splits.begin(); it != splits.end(); ++it)
-  {
-    if (it.value() == "test")
-    {
-      test_images_.append(it.key());
-    }
-  }
+  test_images_ = config_.GetImagesInSplit("test");
 
   // Populate image dropdown
   ui_->image_combo_->clear();
@@ -98,21 +139,16 @@ void ModelComparisonDialog::LoadImageAtIndex(int index)
   }
 
   current_image_index_ = index;
-  QString image_path = project_dir_ + "/images/" + test_images_[index];
+  const ImageLocator locator(project_dir_, config_.GetImageReferences());
 
   // Load image in both canvases
-  QPixmap pixmap(image_path);
+  QPixmap pixmap = QPixmap::fromImage(locator.Read(test_images_[index]));
   if (!pixmap.isNull())
   {
     ui_->canvas_a_->setPixmap(pixmap);
     ui_->canvas_b_->setPixmap(pixmap);
-    ui_->canvas_a_->ClearAllPolygons();
-    ui_->canvas_b_->ClearAllPolygons();
-
-    // Reset stats
-    ui_->stats_a_->setText("Not yet run");
-    ui_->stats_b_->setText("Not yet run");
   }
+  ShowResultsForImage(index);
 
   // Update combo box
   ui_->image_combo_->setCurrentIndex(index);
@@ -122,21 +158,81 @@ void ModelComparisonDialog::LoadImageAtIndex(int index)
   ui_->next_button_->setEnabled(index < test_images_.size() - 1);
 }
 
-void ModelComparisonDialog::RunDetectionOnModel(const QString& model_path, PolygonCanvas* canvas)
+void ModelComparisonDialog::ShowResultsForImage(int index)
 {
-  // TODO: This should call the plugin with the specific model
-  // For now, just show a placeholder
-  Q_UNUSED(model_path);
-  Q_UNUSED(canvas);
+  if (!has_results_ || index < 0 || index >= engine_->Results().size())
+  {
+    ui_->canvas_a_->ClearAllPolygons();
+    ui_->canvas_b_->ClearAllPolygons();
+    ui_->stats_a_->setText("Not yet run");
+    ui_->stats_b_->setText("Not yet run");
+    return;
+  }
+
+  ShowDetections(0, ui_->canvas_a_, ui_->stats_a_);
+  ShowDetections(1, ui_->canvas_b_, ui_->stats_b_);
+}
+
+void ModelComparisonDialog::ShowDetections(int model, PolygonCanvas* canvas, QLabel* stats)
+{
+  const ModelComparisonEngine::ImageResult& result =
+      engine_->Results()[current_image_index_];
+  if (result.failed[model])
+  {
+    canvas->ClearAllPolygons();
+    stats->setText("Detection failed (see log)");
+    return;
+  }
+
+  QVector<QColor> class_colors;
+  for (const ProjectClass& cls : config_.GetClasses())
+  {
+    class_colors.append(cls.color);
+  }
+
+  // Predictions are normalized; the canvas works in image pixels
+  const QSize image_size = canvas->GetOriginalImageSize();
+  QVector<Polygon> polygons;
+  for (const ModelComparisonEngine::Detection& detection : result.detections[model])
+  {
+    Polygon polygon;
+    // Classes unknown to the project fall outside class_colors and are drawn red
+    polygon.class_id =
+        detection.class_id >= 0 ? detection.class_id : static_cast<int>(class_colors.size());
+    for (const QPointF& point : detection.points)
+    {
+      polygon.points.append(QPoint(qRound(point.x() * image_size.width()),
+                                   qRound(point.y() * image_size.height())));
+    }
+    polygons.append(polygon);
+  }
+  canvas->SetPolygons(polygons, class_colors);
 
-  QMessageBox::information(
-      this, "Detection Placeholder",
-      QString("Would run detection using model:\n%1\n\nThis requires plugin integration.")
-          .arg(model_path));
+  QString text = QString("Detections: %1").arg(polygons.size());
+  if (result.has_labels)
+  {
+    const ClassMetrics metrics = SumMetrics(result.metrics[model]);
+    text += QString(" | Precision: %1 | Recall: %2 | Mask IoU: %3")
+                .arg(metrics.Precision(), 0, 'f', 3)
+                .arg(metrics.Recall(), 0, 'f', 3)
+                .arg(metrics.MaskIoU(), 0, 'f', 3);
+  }
+  else
+  {
+    text += " | No approved labels";
+  }
+  text += QString(" | Disagreement: %1").arg(result.disagreement, 0, 'f', 3);
+  stats->setText(text);
 }
 
 void ModelComparisonDialog::RunComparison()
 {
+  if (engine_->IsRunning())
+  {
+    engine_->Cancel();
+    return;
+  }
+
   if (test_images_.isEmpty())
   {
     return;
@@ -154,23 +250,150 @@ void ModelComparisonDialog::RunComparison()
     return;
   }
 
-  QString model_a_path = project_dir_ + "/" + models[model_a_idx].path;
-  QString model_b_path = project_dir_ + "/" + models[model_b_idx].path;
+  ClearResults();
+
+  // Both models run over the whole test split; cached predictions are reused
+  if (!engine_->Start(GetModelPath(model_a_idx), GetModelPath(model_b_idx), test_images_))
+  {
+    QMessageBox::warning(this, "Plugin Not Configured",
+                         "Model comparison runs the project's detection plugin.\n\n"
+                         "Please configure the plugin in Project Settings.");
+    return;
+  }
 
-  // Clear previous results
-  ui_->canvas_a_->ClearAllPolygons();
-  ui_->canvas_b_->ClearAllPolygons();
+  ui_->compare_button_->setText("Cancel");
+  ui_->progress_bar_->setValue(0);
+  ui_->progress_bar_->setVisible(true);
+}
 
-  // Run detection on both models
-  RunDetectionOnModel(model_a_path, ui_->canvas_a_);
-  RunDetectionOnModel(model_b_path, ui_->canvas_b_);
+void ModelComparisonDialog::OnComparisonProgress(int done, int total)
+{
+  ui_->progress_bar_->setMaximum(qMax(1, total));
+  ui_->progress_bar_->setValue(done);
+}
 
-  // Update stats (placeholder for now)
-  int count_a = ui_->canvas_a_->GetPolygons().size();
-  int count_b = ui_->canvas_b_->GetPolygons().size();
+void ModelComparisonDialog::OnComparisonFinished(bool canceled)
+{
+  ui_->compare_button_->setText("Run Comparison");
+  ui_->progress_bar_->setVisible(false);
 
-  ui_->stats_a_->setText(QString("Detections: %1").arg(count_a));
-  ui_->stats_b_->setText(QString("Detections: %1").arg(count_b));
+  if (canceled)
+  {
+    return;
+  }
+
+  has_results_ = true;
+  PopulateClassTable();
+  PopulateImageTable();
+  ShowResultsForImage(current_image_index_);
+}
+
+void ModelComparisonDialog::PopulateClassTable()
+{
+  const QMap<int, ClassMetrics> totals[2] = {engine_->Totals(0), engine_->Totals(1)};
+
+  QList<int> class_ids = totals[0].keys();
+  for (int class_id : totals[1].keys())
+  {
+    if (!class_ids.contains(class_id))
+    {
+      class_ids.append(class_id);
+    }
+  }
+  std::sort(class_ids.begin(), class_ids.end());
+
+  QTableWidget* table = ui_->class_table_;
+  table->setRowCount(0);
+
+  auto add_row = [table](const QString& name, const ClassMetrics (&metrics)[2])
+  {
+    const int row = table->rowCount();
+    table->insertRow(row);
+    table->setItem(row, 0, new QTableWidgetItem(name));
+    for (int model = 0; model < 2; ++model)
+    {
+      table->setItem(row, 1 + model * 3, NumberItem(metrics[model].Precision()));
+      table->setItem(row, 2 + model * 3, NumberItem(metrics[model].Recall()));
+      table->setItem(row, 3 + model * 3, NumberItem(metrics[model].MaskIoU()));
+    }
+  };
+
+  for (int class_id : class_ids)
+  {
+    QString name = "(unknown class)";
+    for (const ProjectClass& cls : config_.GetClasses())
+    {
+      if (cls.id == class_id)
+      {
+        name = cls.name;
+        break;
+      }
+    }
+    const ClassMetrics metrics[2] = {totals[0].value(class_id), totals[1].value(class_id)};
+    add_row(name, metrics);
+  }
+
+  // Micro-averaged over all classes
+  const ClassMetrics all[2] = {SumMetrics(totals[0]), SumMetrics(totals[1])};
+  add_row("All classes", all);
+}
+
+void ModelComparisonDialog::PopulateImageTable()
+{
+  QTableWidget* table = ui_->image_table_;
+  table->setSortingEnabled(false);
+  table->setRowCount(0);
+
+  const QVector<ModelComparisonEngine::ImageResult>& results = engine_->Results();
+  for (int i = 0; i < results.size(); ++i)
+  {
+    const ModelComparisonEngine::ImageResult& result = results[i];
+    const int row = table->rowCount();
+    table->insertRow(row);
+
+    QTableWidgetItem* name_item = new QTableWidgetItem(result.image);
+    name_item->setData(Qt::UserRole, i);
+    table->setItem(row, 0, name_item);
+
+    for (int model = 0; model < 2; ++model)
+    {
+      if (result.failed[model])
+      {
+        table->setItem(row, 1 + model, TextItem("failed"));
+      }
+      else if (!result.has_labels)
+      {
+        table->setItem(row, 1 + model, TextItem("unlabeled"));
+      }
+      else
+      {
+        table->setItem(row, 1 + model, NumberItem(SumMetrics(result.metrics[model]).F1()));
+      }
+    }
+    table->setItem(row, 3, NumberItem(result.disagreement));
+  }
+
+  // Images the models disagree on most come first for review
+  table->setSortingEnabled(true);
+  table->sortItems(3, Qt::DescendingOrder);
+}
+
+void ModelComparisonDialog::ClearResults()
+{
+  has_results_ = false;
+  ui_->class_table_->setRowCount(0);
+  ui_->image_table_->setRowCount(0);
+  ShowResultsForImage(current_image_index_);
+}
+
+void ModelComparisonDialog::OnImageRowClicked(int row, int column)
+{
+  Q_UNUSED(column);
+  const QTableWidgetItem* item = ui_->image_table_->item(row, 0);
+  if (item != nullptr)
+  {
+    LoadImageAtIndex(item->data(Qt::UserRole).toInt());
+  }
 }
 
 QString ModelComparisonDialog::GetModelPath(int model_index) const
@@ -187,16 +410,16 @@ void ModelComparisonDialog::OnModelAChanged(int index)
 {
   Q_UNUSED(index);
   // Reset results when model changes
-  ui_->canvas_a_->ClearAllPolygons();
-  ui_->stats_a_->setText("Not yet run");
+  engine_->Cancel();
+  ClearResults();
 }
 
 void ModelComparisonDialog::OnModelBChanged(int index)
 {
   Q_UNUSED(index);
   // Reset results when model changes
-  ui_->canvas_b_->ClearAllPolygons();
-  ui_->stats_b_->setText("Not yet run");
+  engine_->Cancel();
+  ClearResults();
 }
 
 void ModelComparisonDialog::OnPreviousImage()
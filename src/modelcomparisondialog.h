@@ -3,9 +3,11 @@
 
 #include <QDialog>
 
+#include "modelcomparisonengine.h"
 #include "projectconfig.h"
 
 class PolygonCanvas;
+class QLabel;
 
 namespace Ui
 {
@@ -28,13 +30,20 @@ class ModelComparisonDialog : public QDialog
   void OnNextImage();
   void OnImageSelected(int index);
   void RunComparison();
+  void OnComparisonProgress(int done, int total);
+  void OnComparisonFinished(bool canceled);
+  void OnImageRowClicked(int row, int column);
 
  private:
   void SetupUI();
   void ConnectSignals();
   void LoadTestImages();
   void LoadImageAtIndex(int index);
-  void RunDetectionOnModel(const QString& model_path, PolygonCanvas* canvas);
+  void ShowResultsForImage(int index);
+  void ShowDetections(int model, PolygonCanvas* canvas, QLabel* stats);
+  void PopulateClassTable();
+  void PopulateImageTable();
+  void ClearResults();
   QString GetModelPath(int model_index) const;
 
   Ui::ModelComparisonDialog* ui_;
@@ -42,6 +51,8 @@ class ModelComparisonDialog : public QDialog
   QString project_dir_;
   QStringList test_images_;
   int current_image_index_;
+  ModelComparisonEngine* engine_;
+  bool has_results_;  // Engine results match the selected models
 };
 
 #endif  // MODELCOMPARISONDIALOG_H
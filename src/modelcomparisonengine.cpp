@@ -0,0 +1,773 @@
+#include "modelcomparisonengine.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPainter>
+#include <QProcess>
+#include <QSaveFile>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <iostream>
+
+#include "imagelocator.h"
+#include "projectscanner.h"
+
+namespace
+{
+// Masks are rendered on a square grid over normalized coordinates
+constexpr int kMaskSize = 512;
+constexpr double kMatchIoU = 0.5;
+constexpr int kDetectTimeoutMs = 30000;
+
+struct Overlap
+{
+  qint64 intersection = 0;
+  qint64 union_area = 0;
+};
+
+QImage RenderMask(const QList<QPolygonF>& polygons)
+{
+  QImage mask(kMaskSize, kMaskSize, QImage::Format_Grayscale8);
+  mask.fill(0);
+
+  QPainter painter(&mask);
+  painter.setPen(Qt::NoPen);
+  painter.setBrush(Qt::white);
+  painter.scale(kMaskSize, kMaskSize);
+  for (const QPolygonF& polygon : polygons)
+  {
+    painter.drawPolygon(polygon);
+  }
+  return mask;
+}
+
+Overlap MaskOverlap(const QImage& a, const QImage& b)
+{
+  Overlap overlap;
+  for (int y = 0; y < kMaskSize; ++y)
+  {
+    const uchar* line_a = a.constScanLine(y);
+    const uchar* line_b = b.constScanLine(y);
+    for (int x = 0; x < kMaskSize; ++x)
+    {
+      const bool in_a = line_a[x] != 0;
+      const bool in_b = line_b[x] != 0;
+      overlap.intersection += (in_a && in_b) ? 1 : 0;
+      overlap.union_area += (in_a || in_b) ? 1 : 0;
+    }
+  }
+  return overlap;
+}
+
+double IoU(const Overlap& overlap)
+{
+  return overlap.union_area > 0
+             ? static_cast<double>(overlap.intersection) / static_cast<double>(overlap.union_area)
+             : 0.0;
+}
+
+QList<QPolygonF> PolygonsOfClass(const QVector<ModelComparisonEngine::Detection>& detections,
+                                 int class_id)
+{
+  QList<QPolygonF> polygons;
+  for (const auto& detection : detections)
+  {
+    if (detection.class_id == class_id)
+    {
+      polygons.append(detection.points);
+    }
+  }
+  return polygons;
+}
+
+QSet<int> ClassIds(const QVector<ModelComparisonEngine::Detection>& a,
+                   const QVector<ModelComparisonEngine::Detection>& b)
+{
+  QSet<int> ids;
+  for (const auto& detection : a)
+  {
+    ids.insert(detection.class_id);
+  }
+  for (const auto& detection : b)
+  {
+    ids.insert(detection.class_id);
+  }
+  return ids;
+}
+
+QJsonArray DetectionsToJson(const QVector<ModelComparisonEngine::Detection>& detections)
+{
+  QJsonArray array;
+  for (const auto& detection : detections)
+  {
+    QJsonArray points;
+    for (const QPointF& point : detection.points)
+    {
+      points.append(point.x());
+      points.append(point.y());
+    }
+    QJsonObject obj;
+    obj["class_id"] = detection.class_id;
+    obj["confidence"] = detection.confidence;
+    obj["points"] = points;
+    array.append(obj);
+  }
+  return array;
+}
+
+QVector<ModelComparisonEngine::Detection> DetectionsFromJson(const QJsonArray& array)
+{
+  QVector<ModelComparisonEngine::Detection> detections;
+  for (const QJsonValue& value : array)
+  {
+    const QJsonObject obj = value.toObject();
+    const QJsonArray points = obj["points"].toArray();
+    ModelComparisonEngine::Detection detection;
+    detection.class_id = obj["class_id"].toInt(-1);
+    detection.confidence = obj["confidence"].toDouble(1.0);
+    for (int i = 0; i + 1 < points.size(); i += 2)
+    {
+      detection.points.append(QPointF(points[i].toDouble(), points[i + 1].toDouble()));
+    }
+    detections.append(detection);
+  }
+  return detections;
+}
+
+QString ImageStamp(const QString& path)
+{
+  const QFileInfo info(path);
+  return QString("%1:%2").arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch());
+}
+}  // namespace
+
+double ModelComparisonEngine::ClassMetrics::Precision() const
+{
+  const int predicted = true_positives + false_positives;
+  return predicted > 0 ? static_cast<double>(true_positives) / predicted : 0.0;
+}
+
+double ModelComparisonEngine::ClassMetrics::Recall() const
+{
+  const int labeled = true_positives + false_negatives;
+  return labeled > 0 ? static_cast<double>(true_positives) / labeled : 0.0;
+}
+
+double ModelComparisonEngine::ClassMetrics::F1() const
+{
+  const int total = 2 * true_positives + false_positives + false_negatives;
+  return total > 0 ? 2.0 * true_positives / total : 0.0;
+}
+
+double ModelComparisonEngine::ClassMetrics::MaskIoU() const
+{
+  return IoU({intersection, union_area});
+}
+
+void ModelComparisonEngine::ClassMetrics::Add(const ClassMetrics& other)
+{
+  true_positives += other.true_positives;
+  false_positives += other.false_positives;
+  false_negatives += other.false_negatives;
+  intersection += other.intersection;
+  union_area += other.union_area;
+}
+
+ModelComparisonEngine::ModelComparisonEngine(const ProjectConfig& config,
+                                             const QString& project_dir, QObject* parent)
+    : QObject(parent),
+      config_(config),
+      project_dir_(project_dir),
+      max_concurrent_(qBound(1, QThread::idealThreadCount() / 2, 4))
+{
+}
+
+ModelComparisonEngine::~ModelComparisonEngine()
+{
+  // ~QProcess waits for the process and would report back into a destroyed engine
+  for (QProcess* process : running_.keys())
+  {
+    process->disconnect(this);
+    process->kill();
+    process->waitForFinished(1000);
+  }
+}
+
+QString ModelComparisonEngine::CacheDirectory(const QString& project_dir)
+{
+  return project_dir + "/.polyseg/comparison";
+}
+
+bool ModelComparisonEngine::Start(const QString& model_a, const QString& model_b,
+                                  const QStringList& images)
+{
+  if (active_)
+  {
+    return false;
+  }
+
+  const PluginConfig& plugin = config_.GetPluginConfig();
+  if (plugin.command.isEmpty() || plugin.script_path.isEmpty())
+  {
+    std::cerr << "Model comparison needs a configured detect plugin" << std::endl;
+    return false;
+  }
+
+  active_ = true;
+  canceled_ = false;
+  done_ = 0;
+  pending_.clear();
+  results_.clear();
+  results_.resize(images.size());
+  remaining_.fill(0, images.size());
+  plugin_images_.clear();
+  image_stamps_.clear();
+
+  model_paths_[0] = QDir(project_dir_).absoluteFilePath(model_a);
+  model_paths_[1] = QDir(project_dir_).absoluteFilePath(model_b);
+  for (int model = 0; model < 2; ++model)
+  {
+    cache_keys_[model] = ModelCacheKey(model_paths_[model]);
+    LoadCache(model);
+  }
+
+  // Cached predictions are reused while the file handed to the plugin is unchanged
+  const ImageLocator locator(project_dir_, config_.GetImageReferences());
+  for (int i = 0; i < images.size(); ++i)
+  {
+    const QString& image = images[i];
+    results_[i].image = image;
+
+    const QString plugin_image =
+        locator.IsReference(image) ? locator.ExportPath(image) : locator.ProjectPath(image);
+    const QString stamp = plugin_image.isEmpty() ? QString() : ImageStamp(plugin_image);
+    plugin_images_.append(plugin_image);
+    image_stamps_.append(stamp);
+
+    for (int model = 0; model < 2; ++model)
+    {
+      const QJsonObject cached = caches_[model][image].toObject();
+      if (plugin_image.isEmpty())
+      {
+        std::cerr << "Source of referenced image is missing: " << image.toStdString()
+                  << std::endl;
+        results_[i].failed[model] = true;
+      }
+      else if (!cached.isEmpty() && cached["stamp"].toString() == stamp)
+      {
+        results_[i].detections[model] = DetectionsFromJson(cached["detections"].toArray());
+      }
+      else
+      {
+        pending_.enqueue({i, model});
+        remaining_[i]++;
+      }
+    }
+
+    if (remaining_[i] == 0)
+    {
+      EvaluateImage(i);
+    }
+  }
+
+  total_ = pending_.size();
+  emit progress(0, total_);
+
+  StartJobs();
+  if (running_.isEmpty() && pending_.isEmpty())
+  {
+    // Everything was cached; report once the caller is back in the event loop
+    QTimer::singleShot(0, this, [this]() { Finish(); });
+  }
+  return true;
+}
+
+void ModelComparisonEngine::Cancel()
+{
+  if (!active_)
+  {
+    return;
+  }
+
+  canceled_ = true;
+  pending_.clear();
+  for (QProcess* process : running_.keys())
+  {
+    process->disconnect(this);
+    process->kill();
+    process->waitForFinished(1000);
+    process->deleteLater();
+  }
+  running_.clear();
+  Finish();
+}
+
+QMap<int, ModelComparisonEngine::ClassMetrics> ModelComparisonEngine::Totals(int model) const
+{
+  QMap<int, ClassMetrics> totals;
+  for (const ImageResult& result : results_)
+  {
+    // Both models are scored on the same images
+    if (!result.has_labels || result.failed[0] || result.failed[1])
+    {
+      continue;
+    }
+    for (auto it = result.metrics[model].begin(); it != result.metrics[model].end(); ++it)
+    {
+      totals[it.key()].Add(it.value());
+    }
+  }
+  return totals;
+}
+
+QString ModelComparisonEngine::ModelCacheKey(const QString& model_path) const
+{
+  // Anything that changes what the plugin outputs invalidates the cache
+  const PluginConfig& plugin = config_.GetPluginConfig();
+  const QFileInfo model_info(model_path);
+  const QFileInfo script_info(QDir(project_dir_).absoluteFilePath(plugin.script_path));
+
+  QStringList parts = {model_info.absoluteFilePath(),
+                       QString::number(model_info.size()),
+                       QString::number(model_info.lastModified().toMSecsSinceEpoch()),
+                       QString::number(script_info.lastModified().toMSecsSinceEpoch()),
+                       plugin.env_setup,
+                       plugin.command,
+                       plugin.script_path,
+                       plugin.detect_args};
+  for (auto it = plugin.settings.begin(); it != plugin.settings.end(); ++it)
+  {
+    if (it.key() != "model")
+    {
+      parts.append(it.key() + "=" + it.value());
+    }
+  }
+
+  const QByteArray digest =
+      QCryptographicHash::hash(parts.join('\n').toUtf8(), QCryptographicHash::Sha256);
+  return QString::fromLatin1(digest.toHex().left(16));
+}
+
+void ModelComparisonEngine::LoadCache(int model)
+{
+  caches_[model] = QJsonObject();
+
+  QFile file(CacheDirectory(project_dir_) + "/" + cache_keys_[model] + ".json");
+  if (file.open(QIODevice::ReadOnly))
+  {
+    caches_[model] = QJsonDocument::fromJson(file.readAll()).object()["images"].toObject();
+  }
+}
+
+void ModelComparisonEngine::SaveCache(int model) const
+{
+  QJsonObject root;
+  root["model"] = model_paths_[model];
+  root["images"] = caches_[model];
+
+  QDir().mkpath(CacheDirectory(project_dir_));
+  QSaveFile file(CacheDirectory(project_dir_) + "/" + cache_keys_[model] + ".json");
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    std::cerr << "Cannot write comparison cache: " << file.fileName().toStdString()
+              << std::endl;
+    return;
+  }
+  file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+  file.commit();
+}
+
+void ModelComparisonEngine::StartJobs()
+{
+  while (running_.size() < max_concurrent_ && !pending_.isEmpty())
+  {
+    const Job job = pending_.dequeue();
+    if (!StartJob(job))
+    {
+      results_[job.image].failed[job.model] = true;
+      CompleteJob(job);
+    }
+  }
+}
+
+bool ModelComparisonEngine::StartJob(const Job& job)
+{
+  const PluginConfig& plugin = config_.GetPluginConfig();
+
+  // Same invocation as AIPluginManager, with the compared model as {model}
+  QMap<QString, QString> vars;
+  for (auto it = plugin.settings.begin(); it != plugin.settings.end(); ++it)
+  {
+    vars[it.key()] = it.value();
+  }
+  vars["image"] = plugin_images_[job.image];
+  vars["project"] = project_dir_;
+  vars["model"] = model_paths_[job.model];
+
+  QString args_string = plugin.detect_args;
+  for (auto it = vars.begin(); it != vars.end(); ++it)
+  {
+    args_string.replace("{" + it.key() + "}", it.value());
+  }
+
+  QString script = plugin.script_path;
+  if (!script.startsWith("/"))
+  {
+    script = project_dir_ + "/" + script;
+  }
+  QStringList args;
+  args.append(script);
+  args.append(args_string.split(" ", Qt::SkipEmptyParts));
+
+  QString command = plugin.command;
+  if (!plugin.env_setup.isEmpty())
+  {
+    // exec so that kill() on timeout or cancel stops the plugin, not just the shell
+    QString shell_command = plugin.env_setup + " && exec " + plugin.command;
+    for (const QString& arg : args)
+    {
+      shell_command += " " + arg;
+    }
+    command = "bash";
+    args = QStringList() << "-c" << shell_command;
+  }
+
+  QProcess* process = new QProcess(this);
+  process->setProcessChannelMode(QProcess::MergedChannels);
+  process->setWorkingDirectory(project_dir_);
+  plugin.detect_limits.ApplyTo(process);
+
+  connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+          [this, process]() { OnJobFinished(process); });
+  connect(process, &QProcess::errorOccurred, this,
+          [this, process](QProcess::ProcessError error)
+          {
+            if (error == QProcess::FailedToStart)
+            {
+              OnJobFinished(process);
+            }
+          });
+  QTimer::singleShot(kDetectTimeoutMs, process, [process]() { process->kill(); });
+
+  running_.insert(process, job);
+  process->start(command, args);
+  return true;
+}
+
+void ModelComparisonEngine::OnJobFinished(QProcess* process)
+{
+  if (!running_.contains(process))
+  {
+    return;
+  }
+
+  const Job job = running_.take(process);
+  process->disconnect(this);
+  process->deleteLater();
+
+  ImageResult& result = results_[job.image];
+  bool ok = process->error() != QProcess::FailedToStart &&
+            process->exitStatus() == QProcess::NormalExit && process->exitCode() == 0;
+  if (ok)
+  {
+    const QVector<Detection> detections =
+        ParseDetections(process->readAll(), config_.GetClasses(), &ok);
+    if (ok)
+    {
+      result.detections[job.model] = detections;
+
+      QJsonObject cached;
+      cached["stamp"] = image_stamps_[job.image];
+      cached["detections"] = DetectionsToJson(detections);
+      caches_[job.model][result.image] = cached;
+    }
+  }
+  if (!ok)
+  {
+    std::cerr << "Comparison detect failed for " << result.image.toStdString() << " with "
+              << model_paths_[job.model].toStdString() << std::endl;
+    result.failed[job.model] = true;
+  }
+
+  CompleteJob(job);
+  StartJobs();
+  if (running_.isEmpty() && pending_.isEmpty())
+  {
+    Finish();
+  }
+}
+
+void ModelComparisonEngine::CompleteJob(const Job& job)
+{
+  done_++;
+  emit progress(done_, total_);
+
+  if (--remaining_[job.image] == 0)
+  {
+    EvaluateImage(job.image);
+  }
+}
+
+void ModelComparisonEngine::EvaluateImage(int image)
+{
+  ImageResult& result = results_[image];
+
+  // Named like the labels the canvas saves
+  const QString label_path =
+      project_dir_ + "/labels/" + ProjectScanner::CompleteBaseName(result.image) + ".txt";
+  result.has_labels = QFile::exists(label_path);
+  if (result.has_labels)
+  {
+    const QVector<Detection> labels = ReadLabels(label_path);
+    for (int model = 0; model < 2; ++model)
+    {
+      if (!result.failed[model])
+      {
+        result.metrics[model] = Evaluate(result.detections[model], labels);
+      }
+    }
+  }
+
+  // Only one model producing output is as far apart as they get; with both failed
+  // there is nothing to compare
+  if (result.failed[0] && result.failed[1])
+  {
+    result.disagreement = 0.0;
+  }
+  else if (result.failed[0] || result.failed[1])
+  {
+    result.disagreement = 1.0;
+  }
+  else
+  {
+    result.disagreement = Disagreement(result.detections[0], result.detections[1]);
+  }
+}
+
+void ModelComparisonEngine::Finish()
+{
+  if (!active_)
+  {
+    return;
+  }
+
+  active_ = false;
+  SaveCache(0);
+  SaveCache(1);
+  emit finished(canceled_);
+}
+
+QVector<ModelComparisonEngine::Detection> ModelComparisonEngine::ParseDetections(
+    const QByteArray& output, const QVector<ProjectClass>& classes, bool* ok)
+{
+  QVector<Detection> detections;
+  *ok = false;
+
+  // Plugins may print warnings or logs before the JSON object
+  QJsonDocument doc = QJsonDocument::fromJson(output);
+  if (!doc.isObject())
+  {
+    const int json_start = output.indexOf('{');
+    if (json_start > 0)
+    {
+      doc = QJsonDocument::fromJson(output.mid(json_start));
+    }
+  }
+
+  const QJsonObject root = doc.object();
+  if ((root.contains("success") && !root["success"].toBool()) ||
+      !root["detections"].isArray())
+  {
+    return detections;
+  }
+  *ok = true;
+
+  for (const QJsonValue& det_val : root["detections"].toArray())
+  {
+    const QJsonObject det = det_val.toObject();
+    const QJsonArray points_array = det["points"].toArray();
+
+    Detection detection;
+    detection.confidence = det["confidence"].toDouble(1.0);
+
+    const QString class_name = det["class"].toString();
+    const int plugin_class_id = det["class_id"].toInt(-1);
+    for (const ProjectClass& cls : classes)
+    {
+      if (cls.name == class_name)
+      {
+        detection.class_id = cls.id;
+        break;
+      }
+      if (class_name.isEmpty() && cls.id == plugin_class_id)
+      {
+        detection.class_id = cls.id;
+      }
+    }
+
+    // Flat [x1, y1, x2, y2, ...] or pairs [[x1, y1], [x2, y2], ...]
+    if (!points_array.isEmpty() && points_array[0].isDouble())
+    {
+      for (int i = 0; i + 1 < points_array.size(); i += 2)
+      {
+        detection.points.append(
+            QPointF(points_array[i].toDouble(), points_array[i + 1].toDouble()));
+      }
+    }
+    else
+    {
+      for (const QJsonValue& point_val : points_array)
+      {
+        const QJsonArray point = point_val.toArray();
+        if (point.size() >= 2)
+        {
+          detection.points.append(QPointF(point[0].toDouble(), point[1].toDouble()));
+        }
+      }
+    }
+
+    if (detection.points.size() >= 3)
+    {
+      detections.append(detection);
+    }
+  }
+  return detections;
+}
+
+QVector<ModelComparisonEngine::Detection> ModelComparisonEngine::ReadLabels(
+    const QString& label_path)
+{
+  QVector<Detection> labels;
+
+  QFile file(label_path);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    return labels;
+  }
+
+  QTextStream in(&file);
+  while (!in.atEnd())
+  {
+    const QStringList parts = in.readLine().split(' ', Qt::SkipEmptyParts);
+    if (parts.size() < 7)  // class_id + at least 3 points
+    {
+      continue;
+    }
+
+    bool ok = false;
+    Detection label;
+    label.class_id = parts[0].toInt(&ok);
+    if (!ok)
+    {
+      continue;
+    }
+    for (int i = 1; i + 1 < parts.size(); i += 2)
+    {
+      label.points.append(QPointF(parts[i].toDouble(), parts[i + 1].toDouble()));
+    }
+    labels.append(label);
+  }
+  return labels;
+}
+
+QMap<int, ModelComparisonEngine::ClassMetrics> ModelComparisonEngine::Evaluate(
+    const QVector<Detection>& predictions, const QVector<Detection>& labels)
+{
+  QMap<int, ClassMetrics> metrics;
+
+  for (int class_id : ClassIds(predictions, labels))
+  {
+    ClassMetrics& class_metrics = metrics[class_id];
+
+    QVector<Detection> class_predictions;
+    for (const Detection& prediction : predictions)
+    {
+      if (prediction.class_id == class_id)
+      {
+        class_predictions.append(prediction);
+      }
+    }
+    std::stable_sort(class_predictions.begin(), class_predictions.end(),
+                     [](const Detection& a, const Detection& b)
+                     { return a.confidence > b.confidence; });
+
+    const QList<QPolygonF> class_labels = PolygonsOfClass(labels, class_id);
+    QVector<QImage> label_masks;
+    for (const QPolygonF& label : class_labels)
+    {
+      label_masks.append(RenderMask({label}));
+    }
+
+    // Greedy matching by confidence, as in COCO evaluation
+    QVector<bool> matched(class_labels.size(), false);
+    for (const Detection& prediction : class_predictions)
+    {
+      const QImage prediction_mask = RenderMask({prediction.points});
+      const QRectF prediction_bounds = prediction.points.boundingRect();
+
+      int best = -1;
+      double best_iou = kMatchIoU;
+      for (int i = 0; i < class_labels.size(); ++i)
+      {
+        if (matched[i] || !prediction_bounds.intersects(class_labels[i].boundingRect()))
+        {
+          continue;
+        }
+        const double iou = IoU(MaskOverlap(prediction_mask, label_masks[i]));
+        if (iou >= best_iou)
+        {
+          best = i;
+          best_iou = iou;
+        }
+      }
+
+      if (best >= 0)
+      {
+        matched[best] = true;
+        class_metrics.true_positives++;
+      }
+      else
+      {
+        class_metrics.false_positives++;
+      }
+    }
+    class_metrics.false_negatives =
+        static_cast<int>(std::count(matched.begin(), matched.end(), false));
+
+    const Overlap overlap = MaskOverlap(RenderMask(PolygonsOfClass(predictions, class_id)),
+                                        RenderMask(class_labels));
+    class_metrics.intersection = overlap.intersection;
+    class_metrics.union_area = overlap.union_area;
+  }
+  return metrics;
+}
+
+double ModelComparisonEngine::Disagreement(const QVector<Detection>& a,
+                                           const QVector<Detection>& b)
+{
+  const QSet<int> class_ids = ClassIds(a, b);
+  if (class_ids.isEmpty())
+  {
+    return 0.0;
+  }
+
+  double iou_sum = 0.0;
+  for (int class_id : class_ids)
+  {
+    const Overlap overlap = MaskOverlap(RenderMask(PolygonsOfClass(a, class_id)),
+                                        RenderMask(PolygonsOfClass(b, class_id)));
+    // Both masks can be empty for polygons too small to cover a pixel
+    iou_sum += overlap.union_area > 0 ? IoU(overlap) : 1.0;
+  }
+  return 1.0 - iou_sum / class_ids.size();
+}
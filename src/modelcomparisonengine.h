@@ -0,0 +1,190 @@
+#ifndef MODELCOMPARISONENGINE_H
+#define MODELCOMPARISONENGINE_H
+
+#include <QJsonObject>
+#include <QMap>
+#include <QObject>
+#include <QPolygonF>
+#include <QQueue>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "projectconfig.h"
+
+class QProcess;
+
+/**
+ * @brief Evaluates two model versions over a set of images against approved labels
+ *
+ * Comparing models one image at a time shows how they differ on that image but
+ * not which one is better. The engine runs the project's detect plugin with each
+ * model over every image (several processes at once), then scores the
+ * predictions against the approved labels (labels/<name>.txt).
+ *
+ * Handles:
+ * - Concurrent plugin runs with the model passed as the {model} variable
+ * - A prediction cache per model in <project>/.polyseg/comparison, keyed by the
+ *   model file and plugin command; images are re-run only if their file changed
+ * - Per-class precision and recall (instances matched at mask IoU >= 0.5) and
+ *   mask IoU, per image and over all images
+ * - A per-image disagreement score between the two models
+ *
+ * Masks are rasterized in normalized coordinates; IoU does not depend on the
+ * aspect ratio, so images never have to be decoded.
+ */
+class ModelComparisonEngine : public QObject
+{
+  Q_OBJECT
+
+ public:
+  /**
+   * @brief A predicted or labeled polygon in normalized coordinates
+   */
+  struct Detection
+  {
+    int class_id = -1;  // -1 for plugin classes unknown to the project
+    double confidence = 1.0;
+    QPolygonF points;
+  };
+
+  /**
+   * @brief Instance counts and mask pixel counts of one class
+   */
+  struct ClassMetrics
+  {
+    int true_positives = 0;
+    int false_positives = 0;
+    int false_negatives = 0;
+    qint64 intersection = 0;  // Mask pixels predicted and labeled
+    qint64 union_area = 0;    // Mask pixels predicted or labeled
+
+    double Precision() const;
+    double Recall() const;
+    double F1() const;
+    double MaskIoU() const;
+    void Add(const ClassMetrics& other);
+  };
+
+  /**
+   * @brief Predictions and scores of both models on one image
+   *
+   * Index 0 is model A, index 1 model B.
+   */
+  struct ImageResult
+  {
+    QString image;
+    bool has_labels = false;  // Metrics are only computed for labeled images
+    bool failed[2] = {false, false};
+    QVector<Detection> detections[2];
+    QMap<int, ClassMetrics> metrics[2];
+    double disagreement = 0.0;  // 0 = identical masks, 1 = no overlap or one model failed
+  };
+
+  ModelComparisonEngine(const ProjectConfig& config, const QString& project_dir,
+                        QObject* parent = nullptr);
+  ~ModelComparisonEngine() override;
+
+  /**
+   * @brief Start evaluating two models over the images
+   * @param model_a, model_b Model files, relative to the project or absolute
+   * @return False if a comparison is running or the plugin is not configured
+   */
+  bool Start(const QString& model_a, const QString& model_b, const QStringList& images);
+
+  /**
+   * @brief Stop running plugins; finished() reports the canceled run
+   */
+  void Cancel();
+
+  bool IsRunning() const { return active_; }
+
+  /**
+   * @brief Number of plugin processes run at once
+   *
+   * Defaults to half the cores, at most 4; GPU plugins share the device.
+   */
+  int GetMaxConcurrent() const { return max_concurrent_; }
+  void SetMaxConcurrent(int count) { max_concurrent_ = qMax(1, count); }
+
+  /**
+   * @brief Results in the order of the images passed to Start()
+   */
+  const QVector<ImageResult>& Results() const { return results_; }
+
+  /**
+   * @brief Metrics of a model (0 or 1) summed over the labeled images both models ran on
+   */
+  QMap<int, ClassMetrics> Totals(int model) const;
+
+  /**
+   * @brief Directory holding the prediction caches of a project
+   */
+  static QString CacheDirectory(const QString& project_dir);
+
+  /**
+   * @brief Parse plugin detect output, skipping log lines before the JSON
+   * @param classes Project classes; plugin class names are mapped to their ids
+   * @param ok Set to false if the output holds no detections array
+   */
+  static QVector<Detection> ParseDetections(const QByteArray& output,
+                                            const QVector<ProjectClass>& classes, bool* ok);
+
+  /**
+   * @brief Read a YOLO polygon label file (class_id x1 y1 x2 y2 ...)
+   */
+  static QVector<Detection> ReadLabels(const QString& label_path);
+
+  /**
+   * @brief Score predictions against labels, per class
+   */
+  static QMap<int, ClassMetrics> Evaluate(const QVector<Detection>& predictions,
+                                          const QVector<Detection>& labels);
+
+  /**
+   * @brief 1 - mean per-class mask IoU between two sets of predictions
+   */
+  static double Disagreement(const QVector<Detection>& a, const QVector<Detection>& b);
+
+ signals:
+  void progress(int done, int total);
+  void finished(bool canceled);
+
+ private:
+  struct Job
+  {
+    int image = 0;
+    int model = 0;
+  };
+
+  QString ModelCacheKey(const QString& model_path) const;
+  void LoadCache(int model);
+  void SaveCache(int model) const;
+  void StartJobs();
+  bool StartJob(const Job& job);
+  void OnJobFinished(QProcess* process);
+  void CompleteJob(const Job& job);
+  void EvaluateImage(int image);
+  void Finish();
+
+  const ProjectConfig& config_;
+  QString project_dir_;
+  int max_concurrent_;
+
+  QString model_paths_[2];
+  QString cache_keys_[2];
+  QJsonObject caches_[2];      // Image name -> {"stamp", "detections"}
+  QStringList plugin_images_;  // Paths handed to the plugin, per image
+  QStringList image_stamps_;   // Size and mtime of those files
+  QVector<ImageResult> results_;
+  QVector<int> remaining_;  // Models still to run per image
+
+  QQueue<Job> pending_;
+  QMap<QProcess*, Job> running_;
+  int done_ = 0;
+  int total_ = 0;
+  bool canceled_ = false;
+  bool active_ = false;  // Between Start() and finished()
+};
+
+#endif  // MODELCOMPARISONENGINE_H
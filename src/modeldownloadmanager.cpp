@@ -1,29 +1,65 @@
 #include "modeldownloadmanager.h"
 
 #include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
-#include <QDirIterator>
+#include <QFile>
 #include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSettings>
 #include <QStandardPaths>
+#include <QThread>
 #include <QUrl>
 
+#include <cstdio>
+#include <iostream>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#include "downloadtransfer.h"
+
 namespace
 {
 constexpr int kChecksumBufferSize = 65536;  // 64KB buffer for checksum calculation
+constexpr int kDefaultSegments = 4;         // Parallel connections per download
+constexpr int kDefaultConcurrentDownloads = 2;
+constexpr qint64 kMinSegmentBytes = 32LL * 1024 * 1024;
 }
 
 ModelDownloadManager::ModelDownloadManager(QObject* parent)
     : QObject(parent),
-      network_manager_(new QNetworkAccessManager(this)),
-      current_reply_(nullptr),
-      output_file_(nullptr),
-      download_to_cache_(true)
+      worker_thread_(new QThread(this)),
+      worker_context_(new QObject()),
+      next_transfer_id_(0),
+      max_concurrent_(kDefaultConcurrentDownloads),
+      batch_running_(false),
+      max_segments_(kDefaultSegments),
+      min_segment_bytes_(kMinSegmentBytes)
 {
+  cache_index_.Load(GetStoreDir());
+  QSettings settings("PolySeg", "PolySeg");
+  if (settings.contains("models/cache_budget_mb"))
+  {
+    cache_index_.SetBudget(settings.value("models/cache_budget_mb").toLongLong() * 1024 * 1024);
+  }
+
+  // Network replies, disk writes and store rehashes run off the GUI thread
+  worker_context_->moveToThread(worker_thread_);
+  connect(worker_thread_, &QThread::finished, worker_context_, &QObject::deleteLater);
+  worker_thread_->start();
 }
 
 ModelDownloadManager::~ModelDownloadManager()
 {
+  // Receivers may already be half destroyed (e.g. the owning widget)
+  blockSignals(true);
   CancelDownload();
+  worker_thread_->quit();
+  worker_thread_->wait();
 }
 
 QString ModelDownloadManager::GetGlobalCacheDir()
@@ -37,6 +73,16 @@ QString ModelDownloadManager::GetPluginCacheDir(const QString& plugin_id)
   return QDir::cleanPath(GetGlobalCacheDir() + "/" + plugin_id);
 }
 
+QString ModelDownloadManager::GetStoreDir()
+{
+  return QDir::cleanPath(GetGlobalCacheDir() + "/store");
+}
+
+QString ModelDownloadManager::StorePath(const QString& sha256)
+{
+  return QDir::cleanPath(GetStoreDir() + "/" + sha256.toLower());
+}
+
 bool ModelDownloadManager::IsModelCached(const QString& model_id,
                                          const QString& plugin_id) const
 {
@@ -59,11 +105,16 @@ QString ModelDownloadManager::GetCachedModelPath(const QString& model_id,
   filters << model_id + ".*" << model_id;
 
   dir.setNameFilters(filters);
-  QStringList files = dir.entryList(QDir::Files);
+  const QStringList files = dir.entryList(QDir::Files);
 
-  if (!files.isEmpty())
+  for (const QString& file : files)
   {
-    return dir.absoluteFilePath(files.first());
+    // Skip partial downloads and digest records
+    if (!file.endsWith(".part") && !file.endsWith(".part.json") &&
+        !file.endsWith(".sha256.json"))
+    {
+      return dir.absoluteFilePath(file);
+    }
   }
 
   return QString();
@@ -71,54 +122,48 @@ QString ModelDownloadManager::GetCachedModelPath(const QString& model_id,
 
 void ModelDownloadManager::DownloadModel(const ModelDownloadInfo& info)
 {
-  download_to_cache_ = true;
   EnsureCacheDirectoryExists(info.plugin_id);
-
-  QString cache_dir = GetPluginCacheDir(info.plugin_id);
-  QString filename = GetModelFileName(info.id, info.download_url);
-  current_destination_ = QDir::cleanPath(cache_dir + "/" + filename);
+  const QString destination = CachePathFor(info);
 
   // Check if already cached
-  if (QFile::exists(current_destination_))
+  if (QFile::exists(destination))
   {
     emit statusMessage(tr("Model already cached, verifying checksum..."));
 
     if (!info.checksum_sha256.isEmpty())
     {
-      bool valid = VerifyChecksum(current_destination_, info.checksum_sha256);
-      emit checksumVerified(valid, current_destination_);
+      bool valid = VerifyChecksum(destination, info.checksum_sha256);
+      emit checksumVerified(valid, destination);
 
       if (valid)
       {
+        cache_index_.Touch(info.checksum_sha256);
+        cache_index_.Save();
         emit statusMessage(tr("Using cached model"));
-        emit downloadFinished(current_destination_);
+        emit downloadFinished(destination);
         return;
       }
       else
       {
         emit statusMessage(tr("Cached file corrupted, re-downloading..."));
-        QFile::remove(current_destination_);
+        QFile::remove(destination);
+        QFile::remove(DigestRecordPath(destination));
       }
     }
     else
     {
       // No checksum to verify, assume cached file is valid
-      emit downloadFinished(current_destination_);
+      emit downloadFinished(destination);
       return;
     }
   }
 
-  // Start download
-  current_download_ = info;
-  StartDownload();
+  EnqueueDownload(info, destination);
 }
 
 void ModelDownloadManager::DownloadModelToPath(const ModelDownloadInfo& info,
                                                const QString& destination)
 {
-  download_to_cache_ = false;
-  current_destination_ = destination;
-
   // Ensure parent directory exists
   QFileInfo file_info(destination);
   QDir parent_dir = file_info.absoluteDir();
@@ -139,6 +184,8 @@ void ModelDownloadManager::DownloadModelToPath(const ModelDownloadInfo& info,
 
       if (valid)
       {
+        cache_index_.Touch(info.checksum_sha256);
+        cache_index_.Save();
         emit statusMessage(tr("File verified"));
         emit downloadFinished(destination);
         return;
@@ -147,6 +194,7 @@ void ModelDownloadManager::DownloadModelToPath(const ModelDownloadInfo& info,
       {
         emit statusMessage(tr("Existing file corrupted, re-downloading..."));
         QFile::remove(destination);
+        QFile::remove(DigestRecordPath(destination));
       }
     }
     else
@@ -156,261 +204,667 @@ void ModelDownloadManager::DownloadModelToPath(const ModelDownloadInfo& info,
     }
   }
 
-  current_download_ = info;
-  StartDownload();
+  EnqueueDownload(info, destination);
 }
 
-void ModelDownloadManager::StartDownload()
+QString ModelDownloadManager::EnqueueDownload(const ModelDownloadInfo& info,
+                                              const QString& destination)
 {
-  if (current_reply_)
+  QString target = destination;
+  if (target.isEmpty())
   {
-    emit downloadError(tr("Download already in progress"));
-    return;
+    EnsureCacheDirectoryExists(info.plugin_id);
+    target = CachePathFor(info);
   }
-
-  QUrl url(current_download_.download_url);
-  if (!url.isValid())
+  else
   {
-    emit downloadError(tr("Invalid download URL: %1").arg(current_download_.download_url));
-    return;
+    QDir().mkpath(QFileInfo(target).absolutePath());
   }
 
-  emit statusMessage(tr("Starting download: %1").arg(current_download_.name));
-
-  // Open output file
-  output_file_ = new QFile(current_destination_ + ".part", this);
-  if (!output_file_->open(QIODevice::WriteOnly))
+  const int existing = FindEntry(target);
+  if (existing >= 0 && (queue_[existing].item.status == DownloadItemStatus::Queued ||
+                        queue_[existing].item.status == DownloadItemStatus::Downloading))
   {
-    emit downloadError(
-        tr("Cannot create output file: %1").arg(output_file_->errorString()));
-    delete output_file_;
-    output_file_ = nullptr;
-    return;
+    return target;
   }
 
-  // Create request
-  QNetworkRequest request(url);
-  request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
-                       QNetworkRequest::NoLessSafeRedirectPolicy);
-
-  // Start download
-  current_reply_ = network_manager_->get(request);
-
-  connect(current_reply_, &QNetworkReply::downloadProgress, this,
-          &ModelDownloadManager::OnDownloadProgress);
-  connect(current_reply_, &QNetworkReply::finished, this,
-          &ModelDownloadManager::OnDownloadFinished);
-  connect(current_reply_, &QNetworkReply::errorOccurred, this,
-          &ModelDownloadManager::OnDownloadError);
-  connect(current_reply_, &QNetworkReply::sslErrors, this,
-          &ModelDownloadManager::OnSslErrors);
-  connect(current_reply_, &QNetworkReply::readyRead, this, [this]() {
-    if (output_file_ && current_reply_)
+  // A new batch starts once the previous one is done
+  if (!IsDownloading())
+  {
+    for (QueueEntry& entry : queue_)
     {
-      output_file_->write(current_reply_->readAll());
+      entry.in_batch = false;
     }
-  });
+  }
+  batch_running_ = true;
+
+  QueueEntry entry;
+  entry.item.info = info;
+  entry.item.destination = target;
+  entry.item.bytes_total = info.size_bytes > 0 ? info.size_bytes : -1;
+  queue_.append(entry);
+
+  if (!QUrl(info.download_url).isValid())
+  {
+    FailEntry(queue_.size() - 1, tr("Invalid download URL: %1").arg(info.download_url));
+  }
+  ScheduleDownloads();
+  return target;
+}
+
+void ModelDownloadManager::SetMaxConcurrentDownloads(int count)
+{
+  max_concurrent_ = qMax(1, count);
+  ScheduleDownloads();
 }
 
-void ModelDownloadManager::CancelDownload()
+QList<DownloadQueueItem> ModelDownloadManager::QueueItems() const
 {
-  if (current_reply_)
+  QList<DownloadQueueItem> items;
+  for (const QueueEntry& entry : queue_)
   {
-    current_reply_->abort();
-    current_reply_->deleteLater();
-    current_reply_ = nullptr;
+    items.append(entry.item);
   }
+  return items;
+}
 
-  if (output_file_)
+void ModelDownloadManager::ScheduleDownloads()
+{
+  // Indexed loop: handlers of the signals emitted below may enqueue more
+  for (int i = 0; i < queue_.size(); ++i)
   {
-    QString partial_path = output_file_->fileName();
-    output_file_->close();
-    output_file_->deleteLater();
-    output_file_ = nullptr;
+    if (queue_[i].item.status != DownloadItemStatus::Queued)
+    {
+      continue;
+    }
 
-    // Remove partial file
-    QFile::remove(partial_path);
+    // Same content may be stored: no network needed once the worker has verified it
+    if (StartStoreCheck(i))
+    {
+      continue;
+    }
+
+    // Same file already downloading for another destination: share that download
+    const ModelDownloadInfo& info = queue_[i].item.info;
+    int leader = -1;
+    int running = 0;
+    for (int j = 0; j < queue_.size(); ++j)
+    {
+      if (!queue_[j].transfer)
+      {
+        continue;
+      }
+      ++running;
+      const ModelDownloadInfo& other = queue_[j].item.info;
+      if (other.download_url == info.download_url ||
+          (!info.checksum_sha256.isEmpty() &&
+           other.checksum_sha256.compare(info.checksum_sha256, Qt::CaseInsensitive) == 0))
+      {
+        leader = j;
+      }
+    }
+    if (leader >= 0)
+    {
+      queue_[i].leader = queue_[leader].item.destination;
+      queue_[i].item.status = DownloadItemStatus::Downloading;
+      continue;
+    }
+
+    if (running < max_concurrent_)
+    {
+      StartTransfer(i);
+    }
   }
 
-  emit statusMessage(tr("Download cancelled"));
+  ReportQueueProgress();
+  if (batch_running_ && !IsDownloading())
+  {
+    batch_running_ = false;
+    emit queueFinished();
+  }
 }
 
-bool ModelDownloadManager::IsDownloading() const
+void ModelDownloadManager::StartTransfer(int index)
 {
-  return current_reply_ != nullptr;
+  // Transfers are created here and then handed to the worker thread
+  DownloadTransfer* transfer = new DownloadTransfer();
+  transfer->moveToThread(worker_thread_);
+  connect(transfer, &DownloadTransfer::Progress, this, &ModelDownloadManager::OnTransferProgress);
+  connect(transfer, &DownloadTransfer::StatusMessage, this,
+          &ModelDownloadManager::OnTransferStatus);
+  connect(transfer, &DownloadTransfer::Finished, this, &ModelDownloadManager::OnTransferFinished);
+  connect(transfer, &DownloadTransfer::Failed, this, &ModelDownloadManager::OnTransferFailed);
+
+  QueueEntry& entry = queue_[index];
+  entry.transfer = transfer;
+  entry.transfer_id = ++next_transfer_id_;
+  entry.item.status = DownloadItemStatus::Downloading;
+
+  // Only copies cross to the worker thread
+  const quint64 id = entry.transfer_id;
+  const QString download_url = entry.item.info.download_url;
+  const QString destination = entry.item.destination;
+  const int max_segments = max_segments_;
+  const qint64 min_segment_bytes = min_segment_bytes_;
+  QMetaObject::invokeMethod(
+      transfer,
+      [=]() { transfer->Start(id, download_url, destination, max_segments, min_segment_bytes); },
+      Qt::QueuedConnection);
+
+  emit statusMessage(tr("Starting download: %1").arg(entry.item.info.name));
 }
 
-bool ModelDownloadManager::VerifyChecksum(const QString& file_path,
-                                          const QString& expected_sha256)
+bool ModelDownloadManager::StartStoreCheck(int index)
 {
-  QString actual = CalculateChecksum(file_path);
-  return actual.compare(expected_sha256, Qt::CaseInsensitive) == 0;
+  QueueEntry& entry = queue_[index];
+  if (entry.checking_store)
+  {
+    return true;
+  }
+
+  // Only a checksum names the content; a URL may serve a new file any time
+  const QString digest = entry.item.info.checksum_sha256.toLower();
+  if (entry.store_checked || digest.isEmpty() || !QFile::exists(StorePath(digest)))
+  {
+    return false;
+  }
+
+  entry.checking_store = true;
+  const QString destination = entry.item.destination;
+  QMetaObject::invokeMethod(
+      worker_context_,
+      [this, destination, digest]() {
+        // A stored file that no longer matches its name is dropped and fetched again
+        const QString object = StorePath(digest);
+        const bool valid = VerifyChecksum(object, digest);
+        if (!valid)
+        {
+          QFile::remove(object);
+          QFile::remove(DigestRecordPath(object));
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, destination, digest, valid]() { OnStoreChecked(destination, digest, valid); },
+            Qt::QueuedConnection);
+      },
+      Qt::QueuedConnection);
+  return true;
 }
 
-QString ModelDownloadManager::CalculateChecksum(const QString& file_path)
+void ModelDownloadManager::OnStoreChecked(const QString& destination, const QString& digest,
+                                          bool valid)
 {
-  QFile file(file_path);
-  if (!file.open(QIODevice::ReadOnly))
+  const int index = FindEntry(destination);
+  if (index < 0 || !queue_[index].checking_store)
   {
-    return QString();
+    return;
   }
+  queue_[index].checking_store = false;
+  queue_[index].store_checked = true;
 
-  QCryptographicHash hash(QCryptographicHash::Sha256);
-  char buffer[kChecksumBufferSize];
+  // Canceled while the worker was hashing
+  if (queue_[index].item.status != DownloadItemStatus::Queued)
+  {
+    ScheduleDownloads();
+    return;
+  }
 
-  while (!file.atEnd())
+  if (valid && LinkOrCopy(StorePath(digest), destination))
   {
-    qint64 bytes_read = file.read(buffer, kChecksumBufferSize);
-    if (bytes_read > 0)
+    IndexStoredFile(digest, destination);
+    emit statusMessage(tr("Using stored model: %1").arg(queue_[index].item.info.name));
+    FinishEntry(index, digest);
+  }
+  ScheduleDownloads();
+}
+
+void ModelDownloadManager::ReleaseTransfer(int index, bool cancel)
+{
+  QueueEntry& entry = queue_[index];
+  if (!entry.transfer)
+  {
+    return;
+  }
+
+  DownloadTransfer* transfer = entry.transfer;
+  if (cancel)
+  {
+    // Waits until the worker has written out received bytes and saved progress
+    QMetaObject::invokeMethod(
+        transfer, [transfer]() { transfer->Cancel(); }, Qt::BlockingQueuedConnection);
+  }
+  transfer->disconnect(this);
+  transfer->deleteLater();
+  entry.transfer = nullptr;
+  entry.transfer_id = 0;
+}
+
+void ModelDownloadManager::FinishEntry(int index, const QString& sha256)
+{
+  // Copies: handlers of the signals below may enqueue and grow queue_
+  const QString file_path = queue_[index].item.destination;
+  const ModelDownloadInfo info = queue_[index].item.info;
+
+  if (!sha256.isEmpty())
+  {
+    WriteDigestRecord(file_path, sha256);
+  }
+
+  // Verify checksum if provided
+  QString digest = sha256;
+  if (!info.checksum_sha256.isEmpty())
+  {
+    emit statusMessage(tr("Download complete, verifying checksum..."));
+    const QString actual = sha256.isEmpty() ? FileChecksum(file_path) : sha256;
+    digest = actual;
+    bool valid = actual.compare(info.checksum_sha256, Qt::CaseInsensitive) == 0;
+    emit checksumVerified(valid, file_path);
+
+    if (!valid)
     {
-      hash.addData(QByteArrayView(buffer, bytes_read));
+      QFile::remove(file_path);
+      QFile::remove(DigestRecordPath(file_path));
+      FailEntry(index, tr("Checksum verification failed"));
+      return;
     }
   }
 
-  return hash.result().toHex();
+  queue_[index].digest = digest.toLower();
+  DownloadQueueItem& item = queue_[index].item;
+  item.status = DownloadItemStatus::Finished;
+  item.bytes_total = QFileInfo(file_path).size();
+  item.bytes_received = item.bytes_total;
+  item.bytes_per_second = 0;
+
+  emit statusMessage(tr("Model ready: %1").arg(info.name));
+  emit downloadFinished(file_path);
 }
 
-qint64 ModelDownloadManager::GetCacheSize() const
+void ModelDownloadManager::FailEntry(int index, const QString& error_message)
 {
-  QString cache_dir = GetGlobalCacheDir();
-  qint64 total_size = 0;
+  DownloadQueueItem& item = queue_[index].item;
+  item.status = DownloadItemStatus::Failed;
+  item.error = error_message;
+  item.bytes_per_second = 0;
+
+  const QString destination = item.destination;
+  emit itemFailed(destination, error_message);
+  emit downloadError(error_message);
+}
+
+void ModelDownloadManager::FinishFollowers(int index, const QString& sha256)
+{
+  const QString leader = queue_[index].item.destination;
+  const bool finished = queue_[index].item.status == DownloadItemStatus::Finished;
 
-  QDirIterator it(cache_dir, QDir::Files, QDirIterator::Subdirectories);
-  while (it.hasNext())
+  for (int i = 0; i < queue_.size(); ++i)
   {
-    it.next();
-    total_size += it.fileInfo().size();
-  }
+    if (queue_[i].leader != leader || queue_[i].item.status != DownloadItemStatus::Downloading)
+    {
+      continue;
+    }
+    queue_[i].leader.clear();
 
-  return total_size;
+    if (!finished)
+    {
+      // Try on its own; another URL for the same checksum may still work
+      queue_[i].item.status = DownloadItemStatus::Queued;
+    }
+    else if (LinkOrCopy(leader, queue_[i].item.destination))
+    {
+      if (!sha256.isEmpty())
+      {
+        IndexStoredFile(sha256, queue_[i].item.destination);
+      }
+      FinishEntry(i, sha256);
+    }
+    else
+    {
+      FailEntry(i, tr("Cannot create file: %1").arg(queue_[i].item.destination));
+    }
+  }
 }
 
-void ModelDownloadManager::ClearCache()
+void ModelDownloadManager::ReportQueueProgress()
 {
-  QString cache_dir = GetGlobalCacheDir();
-  QDir dir(cache_dir);
+  qint64 received = 0;
+  qint64 total = 0;
+  qint64 bytes_per_second = 0;
+  bool total_known = true;
+  bool any = false;
+  for (const QueueEntry& entry : queue_)
+  {
+    const DownloadQueueItem& item = entry.item;
+    if (!entry.in_batch || item.status == DownloadItemStatus::Failed ||
+        item.status == DownloadItemStatus::Canceled)
+    {
+      continue;
+    }
+    any = true;
+    received += item.bytes_received;
+    bytes_per_second += item.bytes_per_second;
+    if (item.bytes_total < 0)
+    {
+      total_known = false;
+    }
+    else
+    {
+      total += item.bytes_total;
+    }
+  }
+  if (!any)
+  {
+    return;
+  }
 
-  if (dir.exists())
+  qint64 eta_seconds = -1;
+  if (total_known && bytes_per_second > 0)
   {
-    dir.removeRecursively();
+    eta_seconds = qMax<qint64>(0, total - received) / bytes_per_second;
   }
+  emit downloadProgress(received, total_known ? total : -1, bytes_per_second, eta_seconds);
+}
 
-  emit statusMessage(tr("Cache cleared"));
+int ModelDownloadManager::FindEntry(const QString& destination) const
+{
+  // Latest entry wins; earlier ones may be finished attempts
+  for (int i = queue_.size() - 1; i >= 0; --i)
+  {
+    if (queue_[i].item.destination == destination)
+    {
+      return i;
+    }
+  }
+  return -1;
 }
 
-bool ModelDownloadManager::RemoveCachedModel(const QString& model_id,
-                                             const QString& plugin_id)
+int ModelDownloadManager::FindTransfer(quint64 id) const
 {
-  QString path = GetCachedModelPath(model_id, plugin_id);
-  if (path.isEmpty())
+  for (int i = 0; i < queue_.size(); ++i)
   {
-    return false;
+    if (queue_[i].transfer && queue_[i].transfer_id == id)
+    {
+      return i;
+    }
   }
+  return -1;
+}
 
-  return QFile::remove(path);
+void ModelDownloadManager::OnTransferProgress(quint64 id, qint64 bytes_received,
+                                              qint64 bytes_total, qint64 bytes_per_second,
+                                              qint64 eta_seconds)
+{
+  const int index = FindTransfer(id);
+  if (index < 0)
+  {
+    return;
+  }
+
+  DownloadQueueItem& item = queue_[index].item;
+  item.bytes_received = bytes_received;
+  item.bytes_total = bytes_total;
+  item.bytes_per_second = bytes_per_second;
+
+  const QString destination = item.destination;
+  emit itemProgress(destination, bytes_received, bytes_total, bytes_per_second, eta_seconds);
+  ReportQueueProgress();
 }
 
-void ModelDownloadManager::OnDownloadProgress(qint64 bytes_received, qint64 bytes_total)
+void ModelDownloadManager::OnTransferStatus(quint64 id, const QString& message)
 {
-  emit downloadProgress(bytes_received, bytes_total);
+  const int index = FindTransfer(id);
+  if (index < 0)
+  {
+    return;
+  }
+  emit statusMessage(QString("%1: %2").arg(queue_[index].item.info.name, message));
 }
 
-void ModelDownloadManager::OnDownloadFinished()
+void ModelDownloadManager::OnTransferFinished(quint64 id, const QString& file_path,
+                                              const QString& sha256)
 {
-  if (!current_reply_ || !output_file_)
+  const int index = FindTransfer(id);
+  if (index < 0)
   {
     return;
   }
+  ReleaseTransfer(index, false);
 
-  // Write any remaining data
-  if (current_reply_->bytesAvailable() > 0)
+  // Store once per content; other plugins and projects link to it
+  const QString expected = queue_[index].item.info.checksum_sha256;
+  if (!sha256.isEmpty() &&
+      (expected.isEmpty() || expected.compare(sha256, Qt::CaseInsensitive) == 0))
   {
-    output_file_->write(current_reply_->readAll());
+    AddToStore(file_path, sha256);
+    IndexStoredFile(sha256, file_path);
   }
 
-  output_file_->close();
+  FinishEntry(index, sha256);
+  FinishFollowers(index, sha256);
+  EvictToBudget();
+  ScheduleDownloads();
+}
 
-  // Check for errors
-  if (current_reply_->error() != QNetworkReply::NoError)
+void ModelDownloadManager::OnTransferFailed(quint64 id, const QString& error_message)
+{
+  const int index = FindTransfer(id);
+  if (index < 0)
   {
-    QString error_msg = current_reply_->errorString();
-    QFile::remove(output_file_->fileName());
+    return;
+  }
+  ReleaseTransfer(index, false);
 
-    output_file_->deleteLater();
-    output_file_ = nullptr;
-    current_reply_->deleteLater();
-    current_reply_ = nullptr;
+  FailEntry(index, error_message);
+  FinishFollowers(index, QString());
+  ScheduleDownloads();
+}
 
-    emit downloadError(error_msg);
+void ModelDownloadManager::CancelDownload(const QString& destination)
+{
+  bool canceled = false;
+  for (int i = 0; i < queue_.size(); ++i)
+  {
+    QueueEntry& entry = queue_[i];
+    if ((!destination.isEmpty() && entry.item.destination != destination) ||
+        (entry.item.status != DownloadItemStatus::Queued &&
+         entry.item.status != DownloadItemStatus::Downloading))
+    {
+      continue;
+    }
+    ReleaseTransfer(i, true);
+    entry.item.status = DownloadItemStatus::Canceled;
+    entry.item.bytes_per_second = 0;
+    entry.leader.clear();
+    canceled = true;
+  }
+  if (!canceled)
+  {
     return;
   }
 
-  // Rename from .part to final name
-  QString partial_path = output_file_->fileName();
-  output_file_->deleteLater();
-  output_file_ = nullptr;
-
-  if (QFile::exists(current_destination_))
+  // Entries that shared a cancelled download fetch on their own
+  for (QueueEntry& entry : queue_)
   {
-    QFile::remove(current_destination_);
+    if (!entry.leader.isEmpty())
+    {
+      const int leader = FindEntry(entry.leader);
+      if (leader < 0 || queue_[leader].item.status == DownloadItemStatus::Canceled)
+      {
+        entry.leader.clear();
+        entry.item.status = DownloadItemStatus::Queued;
+      }
+    }
   }
 
-  if (!QFile::rename(partial_path, current_destination_))
+  emit statusMessage(tr("Download cancelled"));
+  ScheduleDownloads();
+}
+
+void ModelDownloadManager::DiscardPartialDownload(const QString& destination)
+{
+  QFile::remove(destination + ".part");
+  QFile::remove(PartialStatePath(destination));
+}
+
+QString ModelDownloadManager::PartialStatePath(const QString& destination)
+{
+  return destination + ".part.json";
+}
+
+void ModelDownloadManager::SetSegmentation(int max_segments, qint64 min_segment_bytes)
+{
+  max_segments_ = qMax(1, max_segments);
+  min_segment_bytes_ = qMax<qint64>(1, min_segment_bytes);
+}
+
+bool ModelDownloadManager::IsDownloading() const
+{
+  for (const QueueEntry& entry : queue_)
   {
-    emit downloadError(tr("Failed to rename downloaded file"));
-    QFile::remove(partial_path);
-    current_reply_->deleteLater();
-    current_reply_ = nullptr;
-    return;
+    if (entry.item.status == DownloadItemStatus::Queued ||
+        entry.item.status == DownloadItemStatus::Downloading)
+    {
+      return true;
+    }
   }
+  return false;
+}
 
-  emit statusMessage(tr("Download complete, verifying checksum..."));
+bool ModelDownloadManager::VerifyChecksum(const QString& file_path,
+                                          const QString& expected_sha256)
+{
+  QString actual = FileChecksum(file_path);
+  return actual.compare(expected_sha256, Qt::CaseInsensitive) == 0;
+}
 
-  // Verify checksum if provided
-  if (!current_download_.checksum_sha256.isEmpty())
+QString ModelDownloadManager::CalculateChecksum(const QString& file_path)
+{
+  QFile file(file_path);
+  if (!file.open(QIODevice::ReadOnly))
   {
-    bool valid = VerifyChecksum(current_destination_, current_download_.checksum_sha256);
-    emit checksumVerified(valid, current_destination_);
+    return QString();
+  }
 
-    if (!valid)
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+  char buffer[kChecksumBufferSize];
+
+  while (!file.atEnd())
+  {
+    qint64 bytes_read = file.read(buffer, kChecksumBufferSize);
+    if (bytes_read > 0)
     {
-      emit downloadError(tr("Checksum verification failed"));
-      QFile::remove(current_destination_);
-      current_reply_->deleteLater();
-      current_reply_ = nullptr;
-      return;
+      hash.addData(QByteArrayView(buffer, bytes_read));
     }
   }
 
-  current_reply_->deleteLater();
-  current_reply_ = nullptr;
+  return hash.result().toHex();
+}
 
-  emit statusMessage(tr("Model ready: %1").arg(current_download_.name));
-  emit downloadFinished(current_destination_);
+qint64 ModelDownloadManager::GetCacheSize() const
+{
+  // Plugin cache files are hardlinks into the store (or copies of stored files,
+  // without hardlinks), which the index sizes
+  return cache_index_.TotalBytes();
 }
 
-void ModelDownloadManager::OnDownloadError(QNetworkReply::NetworkError error)
+void ModelDownloadManager::ClearCache()
 {
-  Q_UNUSED(error);
+  QString cache_dir = GetGlobalCacheDir();
+  QDir dir(cache_dir);
 
-  if (!current_reply_)
+  if (dir.exists())
   {
-    return;
+    dir.removeRecursively();
+  }
+  cache_index_.Clear();
+  cache_index_.Save();
+
+  emit statusMessage(tr("Cache cleared"));
+}
+
+void ModelDownloadManager::SetCacheBudget(qint64 bytes)
+{
+  cache_index_.SetBudget(bytes);
+  cache_index_.Save();
+  EvictToBudget();
+}
+
+qint64 ModelDownloadManager::GetCacheBudget() const
+{
+  return cache_index_.Budget();
+}
+
+int ModelDownloadManager::EvictToBudget()
+{
+  // Models of queued and running downloads stay, and so do the ones the running
+  // batch has finished: their paths were just reported to the caller
+  QStringList keep;
+  for (const QueueEntry& entry : queue_)
+  {
+    if ((entry.item.status == DownloadItemStatus::Queued ||
+         entry.item.status == DownloadItemStatus::Downloading) &&
+        !entry.item.info.checksum_sha256.isEmpty())
+    {
+      keep.append(entry.item.info.checksum_sha256.toLower());
+    }
+    else if (batch_running_ && entry.in_batch &&
+             entry.item.status == DownloadItemStatus::Finished && !entry.digest.isEmpty())
+    {
+      keep.append(entry.digest);
+    }
+  }
+
+  const QStringList evict = cache_index_.EvictionCandidates(keep);
+  const QString cache_prefix = GetGlobalCacheDir() + "/";
+  for (const QString& sha256 : evict)
+  {
+    const ModelCacheIndex::Entry entry = cache_index_.Value(sha256);
+    for (const QString& file : entry.files)
+    {
+      if (file.startsWith(cache_prefix))
+      {
+        QFile::remove(file);
+        QFile::remove(DigestRecordPath(file));
+      }
+    }
+    QFile::remove(StorePath(sha256));
+    QFile::remove(DigestRecordPath(StorePath(sha256)));
+    cache_index_.Remove(sha256);
   }
 
-  QString error_message = current_reply_->errorString();
-  emit downloadError(tr("Network error: %1").arg(error_message));
+  if (!evict.isEmpty())
+  {
+    cache_index_.Save();
+    emit statusMessage(tr("Removed %1 unused model(s) from the cache").arg(evict.size()));
+  }
+  return evict.size();
+}
+
+void ModelDownloadManager::AddCacheReference(const QString& sha256, const QString& path)
+{
+  cache_index_.AddReference(sha256, path);
+  cache_index_.Save();
+}
+
+void ModelDownloadManager::RemoveCacheReference(const QString& sha256, const QString& path)
+{
+  cache_index_.RemoveReference(sha256, path);
+  cache_index_.Save();
 }
 
-void ModelDownloadManager::OnSslErrors(const QList<QSslError>& errors)
+bool ModelDownloadManager::RemoveCachedModel(const QString& model_id,
+                                             const QString& plugin_id)
 {
-  QStringList error_strings;
-  for (const QSslError& error : errors)
+  QString path = GetCachedModelPath(model_id, plugin_id);
+  if (path.isEmpty())
   {
-    error_strings << error.errorString();
+    return false;
   }
 
-  emit downloadError(tr("SSL errors: %1").arg(error_strings.join(", ")));
+  QFile::remove(DigestRecordPath(path));
+  cache_index_.RemoveFile(path);
+  cache_index_.Save();
+  return QFile::remove(path);
 }
 
 void ModelDownloadManager::EnsureCacheDirectoryExists(const QString& plugin_id)
@@ -450,3 +904,148 @@ QString ModelDownloadManager::GetModelFileName(const QString& model_id,
 
   return model_id + extension;
 }
+
+QString ModelDownloadManager::FileChecksum(const QString& file_path)
+{
+  const QString recorded = ReadDigestRecord(file_path);
+  if (!recorded.isEmpty())
+  {
+    return recorded;
+  }
+
+  const QString actual = CalculateChecksum(file_path);
+  if (!actual.isEmpty())
+  {
+    WriteDigestRecord(file_path, actual);
+  }
+  return actual;
+}
+
+QString ModelDownloadManager::DigestRecordPath(const QString& file_path)
+{
+  return file_path + ".sha256.json";
+}
+
+QString ModelDownloadManager::ReadDigestRecord(const QString& file_path)
+{
+  QFile file(DigestRecordPath(file_path));
+  const QFileInfo info(file_path);
+  if (!info.exists() || !file.open(QIODevice::ReadOnly))
+  {
+    return QString();
+  }
+
+  const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+  if (root["size"].toString().toLongLong() != info.size() ||
+      root["mtime"].toString().toLongLong() != info.lastModified().toMSecsSinceEpoch())
+  {
+    return QString();
+  }
+  return root["sha256"].toString();
+}
+
+void ModelDownloadManager::WriteDigestRecord(const QString& file_path, const QString& sha256)
+{
+  const QFileInfo info(file_path);
+  if (!info.exists())
+  {
+    return;
+  }
+
+  QJsonObject root;
+  root["size"] = QString::number(info.size());
+  root["mtime"] = QString::number(info.lastModified().toMSecsSinceEpoch());
+  root["sha256"] = sha256.toLower();
+
+  QSaveFile file(DigestRecordPath(file_path));
+  if (file.open(QIODevice::WriteOnly))
+  {
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.commit();
+  }
+}
+
+QString ModelDownloadManager::CachePathFor(const ModelDownloadInfo& info) const
+{
+  QString cache_dir = GetPluginCacheDir(info.plugin_id);
+  QString filename = GetModelFileName(info.id, info.download_url);
+  return QDir::cleanPath(cache_dir + "/" + filename);
+}
+
+void ModelDownloadManager::IndexStoredFile(const QString& sha256, const QString& file_path)
+{
+  const QString object = StorePath(sha256);
+  if (!QFile::exists(object))
+  {
+    return;
+  }
+
+  cache_index_.AddFile(sha256, QFileInfo(object).size(), file_path);
+  // Files outside the cache belong to projects, which keep the model alive
+  if (!file_path.startsWith(GetGlobalCacheDir() + "/"))
+  {
+    cache_index_.AddReference(sha256, file_path);
+  }
+  cache_index_.Save();
+}
+
+void ModelDownloadManager::AddToStore(const QString& file_path, const QString& sha256)
+{
+  const QString object = StorePath(sha256);
+  QDir().mkpath(GetStoreDir());
+
+  if (!QFile::exists(object))
+  {
+    // Without hardlinks (non-POSIX, store on another file system) the store keeps
+    // a copy: the index and eviction only know stored files
+    if (!HardLink(file_path, object))
+    {
+      const QString copy_path = object + ".copy";
+      QFile::remove(copy_path);
+      if (!QFile::copy(file_path, copy_path) ||
+          std::rename(QFile::encodeName(copy_path).constData(),
+                      QFile::encodeName(object).constData()) != 0)
+      {
+        std::cerr << "Cannot add model to store: " << object.toStdString() << std::endl;
+        QFile::remove(copy_path);
+      }
+    }
+    return;
+  }
+
+  // Same content stored before: replace the new file by a link to it
+  const QString link_path = file_path + ".link";
+  QFile::remove(link_path);
+  if (HardLink(object, link_path) &&
+      std::rename(QFile::encodeName(link_path).constData(),
+                  QFile::encodeName(file_path).constData()) != 0)
+  {
+    QFile::remove(link_path);
+  }
+}
+
+bool ModelDownloadManager::HardLink(const QString& source, const QString& target)
+{
+#ifdef Q_OS_UNIX
+  return ::link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) ==
+         0;
+#else
+  Q_UNUSED(source);
+  Q_UNUSED(target);
+  return false;
+#endif
+}
+
+bool ModelDownloadManager::LinkOrCopy(const QString& source, const QString& target)
+{
+  if (QFileInfo(source).canonicalFilePath() == QFileInfo(target).canonicalFilePath())
+  {
+    return true;
+  }
+  QFile::remove(target);
+  QFile::remove(DigestRecordPath(target));
+  QDir().mkpath(QFileInfo(target).absolutePath());
+
+  // Another file system cannot share the inode
+  return HardLink(source, target) || QFile::copy(source, target);
+}
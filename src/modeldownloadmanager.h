@@ -2,10 +2,14 @@
 #define MODELDOWNLOADMANAGER_H
 
 #include <QObject>
+#include <QList>
 #include <QMap>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QFile>
+#include <QString>
+
+#include "modelcacheindex.h"
+
+class DownloadTransfer;
+class QThread;
 
 /**
  * @brief Information about a model to download
@@ -20,14 +24,64 @@ struct ModelDownloadInfo
   QString plugin_id;  // "detectron2" or "smp"
 };
 
+/**
+ * @brief State of one download in the ModelDownloadManager queue
+ */
+enum class DownloadItemStatus
+{
+  Queued,
+  Downloading,
+  Finished,
+  Failed,
+  Canceled
+};
+
+/**
+ * @brief One queued model download and its progress
+ */
+struct DownloadQueueItem
+{
+  ModelDownloadInfo info;
+  QString destination;
+  DownloadItemStatus status = DownloadItemStatus::Queued;
+  qint64 bytes_received = 0;
+  qint64 bytes_total = -1;  // -1 if unknown
+  qint64 bytes_per_second = 0;
+  QString error;
+};
+
 /**
  * @brief Manages downloading and caching of AI model files
  *
  * Handles:
  * - Global model cache (~/.polyseg/models/)
  * - Download with progress tracking
- * - SHA256 checksum verification
- * - Resume interrupted downloads
+ * - SHA256 checksum verification, hashed while the file is written
+ * - Resume interrupted downloads (HTTP Range from the existing .part file)
+ * - Parallel segmented download into a preallocated .part file
+ *
+ * Progress of each segment is persisted next to the .part file
+ * (<destination>.part.json), so a cancelled or interrupted download
+ * continues where it stopped, as long as the server still reports the same
+ * size and validator (ETag / Last-Modified). The transfer itself runs on a
+ * worker thread (see DownloadTransfer); signals arrive on the owner's thread.
+ *
+ * Verified digests are recorded next to the file (<file>.sha256.json, with
+ * size and modification time), so a cache hit only rehashes a file that
+ * changed since it was verified.
+ *
+ * Downloads are queued and run several at a time. Finished files are stored
+ * once per content in ~/.polyseg/models/store/<sha256> and hardlinked to each
+ * destination, so the same checkpoint requested by several plugins or
+ * projects is downloaded and stored only once: queued requests share a
+ * download by URL or checksum, later ones are served from the store only when
+ * they give the checksum (a URL may serve a new file any time). The stored
+ * copy is rehashed on the worker thread before it is linked.
+ * Destinations on another file system get a copy.
+ *
+ * The store is tracked by a ModelCacheIndex: its size is known without a
+ * directory walk, and with a byte budget the least recently used models that
+ * no project references are evicted.
  */
 class ModelDownloadManager : public QObject
 {
@@ -83,13 +137,70 @@ class ModelDownloadManager : public QObject
   void DownloadModelToPath(const ModelDownloadInfo& info, const QString& destination);
 
   /**
-   * @brief Cancel the current download
+   * @brief Add a download to the queue
+   * @param info Download information
+   * @param destination Target file path; empty for the plugin cache
+   * @return Destination path, which identifies the item in signals
+   *
+   * Unlike DownloadModel, an existing destination is not re-verified. A
+   * destination that is already queued is not added twice.
+   */
+  QString EnqueueDownload(const ModelDownloadInfo& info, const QString& destination = QString());
+
+  /**
+   * @brief Number of downloads that run at the same time (default 2)
+   */
+  void SetMaxConcurrentDownloads(int count);
+
+  /**
+   * @brief Items of the current and finished downloads, in queue order
+   */
+  QList<DownloadQueueItem> QueueItems() const;
+
+  /**
+   * @brief Cancel queued and running downloads
+   * @param destination Item to cancel; empty cancels all
+   *
+   * The .part file and its progress are kept; the next download of the same
+   * URL to the same destination resumes from there.
+   */
+  void CancelDownload(const QString& destination = QString());
+
+  /**
+   * @brief Content-addressed store shared by all plugin caches
+   * @return Path to ~/.polyseg/models/store/
+   */
+  static QString GetStoreDir();
+
+  /**
+   * @brief Path of a stored model file
+   * @param sha256 Content digest (hex string)
+   */
+  static QString StorePath(const QString& sha256);
+
+  /**
+   * @brief Remove the .part file and saved progress for a destination
+   */
+  static void DiscardPartialDownload(const QString& destination);
+
+  /**
+   * @brief Path of the persisted segment progress for a destination
+   */
+  static QString PartialStatePath(const QString& destination);
+
+  /**
+   * @brief Configure parallel segmented downloads
+   * @param max_segments Parallel connections per download (1 = single stream)
+   * @param min_segment_bytes Smallest segment; smaller files use fewer segments
+   *
+   * Segments are only used when the server supports byte ranges and reports
+   * the file size.
    */
-  void CancelDownload();
+  void SetSegmentation(int max_segments, qint64 min_segment_bytes);
 
   /**
    * @brief Check if a download is in progress
-   * @return true if currently downloading
+   * @return true if any download is queued or running
    */
   bool IsDownloading() const;
 
@@ -108,9 +219,24 @@ class ModelDownloadManager : public QObject
    */
   static QString CalculateChecksum(const QString& file_path);
 
+  /**
+   * @brief SHA256 of a file, taken from its digest record when still valid
+   * @param file_path Path to file
+   * @return Checksum as hex string, empty on error
+   *
+   * The file is only hashed when the record is missing or its size or
+   * modification time no longer match; the record is then rewritten.
+   */
+  static QString FileChecksum(const QString& file_path);
+
+  /**
+   * @brief Path of the verified-digest record for a file
+   */
+  static QString DigestRecordPath(const QString& file_path);
+
   /**
    * @brief Get size of cached models
-   * @return Total cache size in bytes
+   * @return Total size of the stored models in bytes, from the cache index
    */
   qint64 GetCacheSize() const;
 
@@ -119,6 +245,43 @@ class ModelDownloadManager : public QObject
    */
   void ClearCache();
 
+  /**
+   * @brief Set the byte budget of the model store and evict down to it
+   * @param bytes Budget in bytes, 0 for unlimited
+   *
+   * The "models/cache_budget_mb" setting, when present, overrides the budget
+   * saved with the store index on construction.
+   */
+  void SetCacheBudget(qint64 bytes);
+
+  /**
+   * @brief Byte budget of the model store, 0 for unlimited
+   */
+  qint64 GetCacheBudget() const;
+
+  /**
+   * @brief Evict least recently used, unreferenced models until the store fits its budget
+   * @return Number of evicted models
+   *
+   * Evicting removes the stored file and its links in the plugin caches; files
+   * outside ~/.polyseg/models are never deleted. Models the running batch has
+   * finished are kept, even when they alone exceed the budget.
+   */
+  int EvictToBudget();
+
+  /**
+   * @brief Pin a stored model for a project path (directory or model file)
+   *
+   * Referenced models are not evicted while the path exists. Downloads to a
+   * project destination reference their destination automatically.
+   */
+  void AddCacheReference(const QString& sha256, const QString& path);
+
+  /**
+   * @brief Release a reference added with AddCacheReference
+   */
+  void RemoveCacheReference(const QString& sha256, const QString& path);
+
   /**
    * @brief Remove a specific cached model
    * @param model_id Model identifier
@@ -132,8 +295,30 @@ class ModelDownloadManager : public QObject
    * @brief Emitted during download to report progress
    * @param bytes_received Bytes downloaded so far
    * @param bytes_total Total file size (-1 if unknown)
+   * @param bytes_per_second Smoothed throughput (0 until measured)
+   * @param eta_seconds Estimated time left (-1 if unknown)
+   */
+  void downloadProgress(qint64 bytes_received, qint64 bytes_total, qint64 bytes_per_second,
+                        qint64 eta_seconds);
+
+  /**
+   * @brief Emitted with the progress of one queued download
+   *
+   * downloadProgress reports the sum over the items queued since the queue
+   * was last empty.
+   */
+  void itemProgress(const QString& destination, qint64 bytes_received, qint64 bytes_total,
+                    qint64 bytes_per_second, qint64 eta_seconds);
+
+  /**
+   * @brief Emitted together with downloadError when a queued download fails
    */
-  void downloadProgress(qint64 bytes_received, qint64 bytes_total);
+  void itemFailed(const QString& destination, const QString& error_message);
+
+  /**
+   * @brief Emitted when the last queued download has finished or failed
+   */
+  void queueFinished();
 
   /**
    * @brief Emitted when download completes successfully
@@ -161,22 +346,55 @@ class ModelDownloadManager : public QObject
   void statusMessage(const QString& message);
 
  private slots:
-  void OnDownloadProgress(qint64 bytes_received, qint64 bytes_total);
-  void OnDownloadFinished();
-  void OnDownloadError(QNetworkReply::NetworkError error);
-  void OnSslErrors(const QList<QSslError>& errors);
+  void OnTransferProgress(quint64 id, qint64 bytes_received, qint64 bytes_total,
+                          qint64 bytes_per_second, qint64 eta_seconds);
+  void OnTransferStatus(quint64 id, const QString& message);
+  void OnTransferFinished(quint64 id, const QString& file_path, const QString& sha256);
+  void OnTransferFailed(quint64 id, const QString& error_message);
 
  private:
-  void StartDownload();
+  struct QueueEntry
+  {
+    DownloadQueueItem item;
+    quint64 transfer_id = 0;  // 0 while no transfer runs for the entry
+    DownloadTransfer* transfer = nullptr;
+    QString leader;  // Destination of the entry downloading the same file
+    bool in_batch = true;  // Counted in the aggregate progress
+    bool checking_store = false;  // Worker is verifying the stored copy
+    bool store_checked = false;   // Stored copy was missing or corrupt: download
+    QString digest;               // SHA-256 of the finished file, if known
+  };
+
+  void ScheduleDownloads();
+  void StartTransfer(int index);
+  bool StartStoreCheck(int index);
+  void OnStoreChecked(const QString& destination, const QString& digest, bool valid);
+  void ReleaseTransfer(int index, bool cancel);
+  void FinishEntry(int index, const QString& sha256);
+  void FailEntry(int index, const QString& error_message);
+  void FinishFollowers(int index, const QString& sha256);
+  void ReportQueueProgress();
+  int FindEntry(const QString& destination) const;
+  int FindTransfer(quint64 id) const;
+  static void AddToStore(const QString& file_path, const QString& sha256);
+  void IndexStoredFile(const QString& sha256, const QString& file_path);
+  static bool HardLink(const QString& source, const QString& target);
+  static bool LinkOrCopy(const QString& source, const QString& target);
+  QString CachePathFor(const ModelDownloadInfo& info) const;
   void EnsureCacheDirectoryExists(const QString& plugin_id);
   QString GetModelFileName(const QString& model_id, const QString& url) const;
+  static QString ReadDigestRecord(const QString& file_path);
+  static void WriteDigestRecord(const QString& file_path, const QString& sha256);
 
-  QNetworkAccessManager* network_manager_;
-  QNetworkReply* current_reply_;
-  QFile* output_file_;
-  ModelDownloadInfo current_download_;
-  QString current_destination_;
-  bool download_to_cache_;
+  QThread* worker_thread_;   // Runs every DownloadTransfer
+  QObject* worker_context_;  // Lives in worker_thread_; runs store checks
+  QList<QueueEntry> queue_;
+  ModelCacheIndex cache_index_;
+  quint64 next_transfer_id_;
+  int max_concurrent_;
+  bool batch_running_;  // queueFinished is due once the queue is idle
+  int max_segments_;
+  qint64 min_segment_bytes_;
 };
 
 #endif  // MODELDOWNLOADMANAGER_H
@@ -113,7 +113,6 @@ PluginConfig PluginWizard::BuildPluginConfig() const
   config.architecture = selected_architecture_;
   config.backbone = selected_backbone_;
   config.pretrained_model_id = selected_model_id_;
-  config.use_project_venv = custom_plugin_config_.use_project_venv;
 
   // Determine model source
   if (selected_model_id_.isEmpty() || selected_model_id_ == "scratch")
@@ -139,6 +138,7 @@ PluginConfig PluginWizard::BuildPluginConfig() const
     config.name = custom_plugin_config_.name.isEmpty() ? "Custom Plugin" : custom_plugin_config_.name;
     config.command = custom_plugin_config_.command;
     config.env_setup = custom_plugin_config_.env_setup;
+    config.use_project_venv = custom_plugin_config_.use_project_venv;
     config.detect_args = detect_args_;
     config.train_args = train_args_;
 
@@ -165,7 +165,9 @@ PluginConfig PluginWizard::BuildPluginConfig() const
     config.detect_args = QString("detect --image {image} --model {model} --conf %1")
                              .arg(confidence_threshold_, 0, 'f', 2);
 
-    // Set env_setup for venv if used
+    // A full venv and an overlay over the shared base both live in <project>/.venv
+    config.use_project_venv = create_project_venv_;
+    config.use_shared_env = create_project_venv_ && share_base_environment_;
     if (config.use_project_venv)
     {
       QString venv_path = QDir(project_dir_).filePath(".venv");
@@ -67,7 +67,7 @@ struct CustomPluginConfig
   QString requirements_file;
   QString env_setup;
   QString name;
-  bool use_project_venv;
+  bool use_project_venv = false;
 };
 
 /**
@@ -155,16 +155,23 @@ class PluginWizard : public QWizard
   QString GetModelPath() const { return model_path_; }
   void SetModelPath(const QString& path) { model_path_ = path; }
 
+  // Project venv of registry plugins, prepared once the wizard is accepted
+  bool GetCreateProjectVenv() const { return create_project_venv_; }
+  void SetCreateProjectVenv(bool create) { create_project_venv_ = create; }
+
+  bool GetShareBaseEnvironment() const { return share_base_environment_; }
+  void SetShareBaseEnvironment(bool share) { share_base_environment_ = share; }
+
   // Python info
   struct PythonInfo
   {
     QString path;
     QString version;
-    bool has_venv;
-    bool has_pip;
-    bool has_cuda;
+    bool has_venv = false;
+    bool has_pip = false;
+    bool has_cuda = false;
     QString cuda_version;
-    bool has_mps;  // Apple Silicon Metal Performance Shaders
+    bool has_mps = false;  // Apple Silicon Metal Performance Shaders
   };
 
   PythonInfo GetPythonInfo() const { return python_info_; }
@@ -203,6 +210,8 @@ class PluginWizard : public QWizard
 
   // Python environment
   PythonInfo python_info_;
+  bool create_project_venv_ = true;
+  bool share_base_environment_ = true;
 
   // Pages
   WelcomePage* welcome_page_;
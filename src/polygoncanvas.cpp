@@ -7,6 +7,7 @@
 #include <QPainter>
 #include <QStyle>
 #include <QTextStream>
+#include <QtMath>
 
 #include <iostream>
 #include <limits>
@@ -69,36 +70,78 @@ PolygonCanvas::PolygonCanvas(QWidget* parent) : QLabel(parent)
 
 void PolygonCanvas::Increase()
 {
-  scalar_ = scalar_ + 1.0f;
-
-  QSize size = pixmap().size();
-  size.setWidth(static_cast<int>(size.width() * scalar_));
-  size.setHeight(static_cast<int>(size.height() * scalar_));
-  setFixedSize(size);
+  // Below 100% zoom moves in halving steps, above it in whole steps
+  scalar_ = (scalar_ < 1.0f) ? scalar_ * 2.0f : scalar_ + 1.0f;
+  ApplyZoom();
 }
 
 void PolygonCanvas::Decrease()
 {
-  auto new_scalar_ = scalar_ - 1.0f;
-  if (new_scalar_ > 0)
+  auto new_scalar_ = (scalar_ > 1.0f) ? scalar_ - 1.0f : scalar_ / 2.0f;
+  if (new_scalar_ >= MIN_ZOOM)
   {
     scalar_ = new_scalar_;
   }
-
-  QSize size = pixmap().size();
-  size.setWidth(static_cast<int>(size.width() * scalar_));
-  size.setHeight(static_cast<int>(size.height() * scalar_));
-  setFixedSize(size);
+  ApplyZoom();
 }
 
 void PolygonCanvas::ResetZoom()
 {
   scalar_ = 1.0;
-  QSize size = pixmap().size();
+  ApplyZoom();
+  std::cout << "Zoom reset to 100%" << std::endl;
+}
+
+void PolygonCanvas::SetImage(const QPixmap& pixmap, const QSize& original_size)
+{
+  original_size_ = original_size.isValid() ? original_size : pixmap.size();
+  setPixmap(pixmap);
+  ApplyZoom();
+}
+
+bool PolygonCanvas::NeedsFullResolution() const
+{
+  QSize shown = pixmap().size();
+  if (pixmap().isNull() || shown == GetOriginalImageSize())
+  {
+    return false;
+  }
+
+  return !PreviewCovers(shown, GetOriginalImageSize(), DisplayScale());
+}
+
+double PolygonCanvas::DisplayScale() const
+{
+  return scalar_ * devicePixelRatioF();
+}
+
+bool PolygonCanvas::PreviewCovers(const QSize& shown, const QSize& original_size,
+                                  double display_scale)
+{
+  // Preview is enough while it has at least as many pixels as the screen shows
+  return qCeil(original_size.width() * display_scale) <= shown.width() &&
+         qCeil(original_size.height() * display_scale) <= shown.height();
+}
+
+QPoint PolygonCanvas::WidgetToImage(const QPoint& widget_pos, float zoom,
+                                    const QSize& original_size)
+{
+  // Zoom is relative to the original image, whatever resolution the pixmap has
+  return ClampToImageBounds(widget_pos / zoom, original_size);
+}
+
+QSize PolygonCanvas::DisplaySize() const
+{
+  QSize size = GetOriginalImageSize();
   size.setWidth(static_cast<int>(size.width() * scalar_));
   size.setHeight(static_cast<int>(size.height() * scalar_));
-  setFixedSize(size);
-  std::cout << "Zoom reset to 100%" << std::endl;
+  return size;
+}
+
+void PolygonCanvas::ApplyZoom()
+{
+  setFixedSize(DisplaySize());
+  update();
 }
 
 void PolygonCanvas::StartNewPolygon(int class_id, QColor color)
@@ -149,13 +192,10 @@ void PolygonCanvas::ClearCurrentPolygon()
 
 void PolygonCanvas::mouseMoveEvent(QMouseEvent* ev)
 {
-  auto pos = ev->pos() / scalar_;
-
-  // Clamp position to image bounds
-  QPixmap pix = pixmap();
-  if (!pix.isNull())
+  QPoint pos = ev->pos() / scalar_;
+  if (!pixmap().isNull())
   {
-    pos = ClampToImageBounds(pos, pix.size());
+    pos = WidgetToImage(ev->pos(), scalar_, GetOriginalImageSize());
   }
 
   active_point_pos_ = pos;
@@ -164,12 +204,9 @@ void PolygonCanvas::mouseMoveEvent(QMouseEvent* ev)
 void PolygonCanvas::mousePressEvent(QMouseEvent* ev)
 {
   QPoint pos = ev->pos() / scalar_;
-
-  // Clamp position to image bounds
-  QPixmap pix = pixmap();
-  if (!pix.isNull())
+  if (!pixmap().isNull())
   {
-    pos = ClampToImageBounds(pos, pix.size());
+    pos = WidgetToImage(ev->pos(), scalar_, GetOriginalImageSize());
   }
 
   // Check if editing current polygon being drawn
@@ -201,12 +238,9 @@ void PolygonCanvas::mousePressEvent(QMouseEvent* ev)
 void PolygonCanvas::mouseReleaseEvent(QMouseEvent* ev)
 {
   QPoint pos = ev->pos() / scalar_;
-
-  // Clamp position to image bounds
-  QPixmap pix = pixmap();
-  if (!pix.isNull())
+  if (!pixmap().isNull())
   {
-    pos = ClampToImageBounds(pos, pix.size());
+    pos = WidgetToImage(ev->pos(), scalar_, GetOriginalImageSize());
   }
 
   // Right click finishes current polygon
@@ -374,7 +408,7 @@ QSize PolygonCanvas::GetOriginalImageSize() const
 {
   if (!pixmap().isNull())
   {
-    return pixmap().size();
+    return original_size_.isValid() ? original_size_ : pixmap().size();
   }
   return QSize(0, 0);
 }
@@ -438,11 +472,40 @@ void PolygonCanvas::LoadAnnotations(const QString& filepath, const QVector<QColo
     return;
   }
 
-  float img_width = static_cast<float>(img_size.width());
-  float img_height = static_cast<float>(img_size.height());
+  polygons_ = ParseAnnotations(file.readAll(), img_size, class_colors);
 
-  polygons_.clear();
-  QTextStream in(&file);
+  file.close();
+  update();
+
+  std::cout << "Loaded " << polygons_.size() << " polygons from: " << filepath.toStdString()
+            << std::endl;
+}
+
+void PolygonCanvas::SetPolygons(const QVector<Polygon>& polygons,
+                                const QVector<QColor>& class_colors)
+{
+  polygons_ = polygons;
+  for (Polygon& polygon : polygons_)
+  {
+    polygon.color =
+        (polygon.class_id < class_colors.size()) ? class_colors[polygon.class_id] : Qt::red;
+  }
+  update();
+}
+
+QVector<Polygon> PolygonCanvas::ParseAnnotations(const QByteArray& data, const QSize& image_size,
+                                                 const QVector<QColor>& class_colors)
+{
+  QVector<Polygon> polygons;
+  if (image_size.width() == 0 || image_size.height() == 0)
+  {
+    return polygons;
+  }
+
+  float img_width = static_cast<float>(image_size.width());
+  float img_height = static_cast<float>(image_size.height());
+
+  QTextStream in(data);
 
   while (!in.atEnd())
   {
@@ -492,15 +555,11 @@ void PolygonCanvas::LoadAnnotations(const QString& filepath, const QVector<QColo
 
     if (polygon.points.size() >= 3)
     {
-      polygons_.append(polygon);
+      polygons.append(polygon);
     }
   }
 
-  file.close();
-  update();
-
-  std::cout << "Loaded " << polygons_.size() << " polygons from: " << filepath.toStdString()
-            << std::endl;
+  return polygons;
 }
 
 void PolygonCanvas::ClearAllPolygons()
@@ -644,10 +703,9 @@ void PolygonCanvas::HandlePointDrag(const QPoint& position)
   QPoint clamped_pos = position;
 
   // Clamp position to image bounds
-  QPixmap pix = pixmap();
-  if (!pix.isNull())
+  if (!pixmap().isNull())
   {
-    clamped_pos = ClampToImageBounds(position, pix.size());
+    clamped_pos = ClampToImageBounds(position, GetOriginalImageSize());
   }
 
   // Try editing current polygon first
@@ -696,10 +754,9 @@ void PolygonCanvas::HandlePointInsertion(const QPoint& position)
   QPoint clamped_pos = position;
 
   // Clamp position to image bounds
-  QPixmap pix = pixmap();
-  if (!pix.isNull())
+  if (!pixmap().isNull())
   {
-    clamped_pos = ClampToImageBounds(position, pix.size());
+    clamped_pos = ClampToImageBounds(position, GetOriginalImageSize());
   }
 
   bool ctrl_pressed = QGuiApplication::keyboardModifiers().testFlag(Qt::ControlModifier);
@@ -765,8 +822,8 @@ void PolygonCanvas::DrawImage(QPainter& painter)
   QPixmap pix = pixmap();
   if (!pix.isNull())
   {
-    pix = pix.scaled(pix.width() * scalar_, pix.height() * scalar_);
-    painter.drawPixmap(0, 0, pix);
+    // Scales both zoom and preview resolution to original image coordinates
+    painter.drawPixmap(QRect(QPoint(0, 0), DisplaySize()), pix);
   }
 }
 
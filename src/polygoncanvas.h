@@ -26,12 +26,35 @@ class PolygonCanvas : public QLabel
   void Decrease();
   void ResetZoom();
 
+  // Show an image that may be a downscaled preview of an original_size image.
+  // Polygons and mouse positions always use original image coordinates.
+  void SetImage(const QPixmap& pixmap, const QSize& original_size);
+  bool NeedsFullResolution() const;
+
+  // Device pixels per original image pixel at the current zoom
+  double DisplayScale() const;
+
+  // True if an image of shown size has enough pixels for original_size displayed
+  // at display_scale device pixels per image pixel
+  static bool PreviewCovers(const QSize& shown, const QSize& original_size, double display_scale);
+
+  // Map a widget position at the given zoom to original image coordinates, clamped
+  // to the image
+  static QPoint WidgetToImage(const QPoint& widget_pos, float zoom, const QSize& original_size);
+
   QVector<Polygon> GetPolygons() const { return polygons_; }
   QSize GetOriginalImageSize() const;
   void ExportAnnotations(const QString& filename, int class_id = 0);
   void LoadAnnotations(const QString& filepath, const QVector<QColor>& class_colors);
   void ClearAllPolygons();
 
+  // Replace polygons with already parsed ones (recolored from class_colors)
+  void SetPolygons(const QVector<Polygon>& polygons, const QVector<QColor>& class_colors);
+
+  // Parse YOLO polygon label data into pixel coordinates; safe to call from any thread
+  static QVector<Polygon> ParseAnnotations(const QByteArray& data, const QSize& image_size,
+                                           const QVector<QColor>& class_colors);
+
   void StartNewPolygon(int class_id = 0, QColor color = Qt::red);
   void FinishCurrentPolygon();
   void ClearCurrentPolygon();
@@ -78,11 +101,14 @@ class PolygonCanvas : public QLabel
   void DrawPoints(QPainter& painter);
   void DrawSegments(QPainter& painter);
   void DrawClosingSegment(QPainter& painter);
+  QSize DisplaySize() const;
+  void ApplyZoom();
 
   // Constants
   static constexpr int POINT_SELECT_TOLERANCE = 5;
   static constexpr int POINT_DRAW_SIZE = 5;
   static constexpr int LINE_WIDTH = 1;
+  static constexpr float MIN_ZOOM = 0.125f;
 
   // State management helpers
   void SaveState();
@@ -95,6 +121,7 @@ class PolygonCanvas : public QLabel
   QPoint active_point_;
   QPoint active_point_pos_;
   float scalar_ = 1.0;
+  QSize original_size_;  // Size of the image on disk (pixmap may be a preview)
 
   // Undo/Redo stacks
   QStack<QVector<Polygon>> undo_stack_;
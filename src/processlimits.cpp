@@ -0,0 +1,161 @@
+#include "processlimits.h"
+
+#include <QProcess>
+#include <QStringList>
+#include <QThread>
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#endif
+
+namespace
+{
+// Highest CPU number + 1 an affinity mask can hold; also bounds the parsed list
+#ifdef Q_OS_LINUX
+constexpr int kMaxCpus = CPU_SETSIZE;
+#else
+constexpr int kMaxCpus = 1024;
+#endif
+}  // namespace
+
+ProcessLimits::ProcessLimits() : nice_level(0), cpu_affinity(""), max_threads(0)
+{
+}
+
+QJsonObject ProcessLimits::ToJson() const
+{
+  QJsonObject obj;
+  obj["nice_level"] = nice_level;
+  obj["cpu_affinity"] = cpu_affinity;
+  obj["max_threads"] = max_threads;
+  return obj;
+}
+
+ProcessLimits ProcessLimits::FromJson(const QJsonObject& json)
+{
+  ProcessLimits limits;
+  limits.nice_level = qBound(0, json["nice_level"].toInt(0), 19);
+  limits.cpu_affinity = json["cpu_affinity"].toString("");
+  limits.max_threads = json["max_threads"].toInt(0);
+  return limits;
+}
+
+ProcessLimits ProcessLimits::Background()
+{
+  ProcessLimits limits;
+  limits.nice_level = 10;
+  limits.max_threads = -1;
+  return limits;
+}
+
+bool ProcessLimits::IsDefault() const
+{
+  return nice_level == 0 && cpu_affinity.trimmed().isEmpty() && max_threads == 0;
+}
+
+bool ProcessLimits::ParseCpuList(const QString& list, QList<int>* cpus)
+{
+  QList<int> parsed;
+  for (const QString& part : list.split(',', Qt::SkipEmptyParts))
+  {
+    const QStringList range = part.trimmed().split('-');
+    bool ok_first = false;
+    bool ok_last = false;
+    const int first = range.value(0).trimmed().toInt(&ok_first);
+    const int last = range.size() == 2 ? range[1].trimmed().toInt(&ok_last) : first;
+    if (!ok_first || (range.size() == 2 && !ok_last) || range.size() > 2 || first < 0 ||
+        last < first || last >= kMaxCpus)
+    {
+      return false;
+    }
+    for (int cpu = first; cpu <= last; ++cpu)
+    {
+      parsed.append(cpu);
+    }
+  }
+
+  std::sort(parsed.begin(), parsed.end());
+  parsed.erase(std::unique(parsed.begin(), parsed.end()), parsed.end());
+  if (cpus != nullptr)
+  {
+    *cpus = parsed;
+  }
+  return true;
+}
+
+int ProcessLimits::EffectiveThreads() const
+{
+  if (max_threads >= 0)
+  {
+    return max_threads;
+  }
+  return qMax(1, QThread::idealThreadCount() + max_threads);
+}
+
+QProcessEnvironment ProcessLimits::Environment(const QProcessEnvironment& base) const
+{
+  QProcessEnvironment env = base;
+  const int thread_count = EffectiveThreads();
+  if (thread_count > 0)
+  {
+    const QString threads = QString::number(thread_count);
+    for (const char* name : {"OMP_NUM_THREADS", "MKL_NUM_THREADS", "OPENBLAS_NUM_THREADS",
+                             "NUMEXPR_NUM_THREADS", "VECLIB_MAXIMUM_THREADS"})
+    {
+      env.insert(name, threads);
+    }
+  }
+  return env;
+}
+
+void ProcessLimits::ApplyTo(QProcess* process) const
+{
+  if (IsDefault())
+  {
+    return;
+  }
+
+  process->setProcessEnvironment(Environment(QProcessEnvironment::systemEnvironment()));
+
+#ifdef Q_OS_UNIX
+  // Everything the child runs is prepared here; between fork and exec only
+  // system calls are made
+  const int nice_level_copy = nice_level;
+#ifdef Q_OS_LINUX
+  QList<int> cpus;
+  if (!cpu_affinity.trimmed().isEmpty() && !ParseCpuList(cpu_affinity, &cpus))
+  {
+    std::cerr << "Ignoring invalid CPU affinity: " << cpu_affinity.toStdString() << std::endl;
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus)
+  {
+    if (cpu < CPU_SETSIZE)
+    {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  const bool set_affinity = CPU_COUNT(&cpu_set) > 0;
+#endif
+
+  process->setChildProcessModifier([=]() {
+    if (nice_level_copy > 0)
+    {
+      setpriority(PRIO_PROCESS, 0, nice_level_copy);
+    }
+#ifdef Q_OS_LINUX
+    if (set_affinity)
+    {
+      sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+    }
+#endif
+  });
+#endif
+}
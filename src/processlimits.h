@@ -0,0 +1,62 @@
+#ifndef PROCESSLIMITS_H
+#define PROCESSLIMITS_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QProcessEnvironment>
+#include <QString>
+
+class QProcess;
+
+/**
+ * @brief Scheduling limits applied to a plugin process when it is spawned
+ *
+ * Keeps long-running plugin work (training, batch detection) from starving
+ * the annotation UI:
+ * - nice level lowers the CPU priority of the process
+ * - CPU affinity pins it to a subset of cores (Linux)
+ * - thread cap sets OMP_NUM_THREADS and friends, which also bounds PyTorch's
+ *   intra-op thread pool
+ */
+struct ProcessLimits
+{
+  int nice_level;        // 0 = inherit, 1..19 = lower priority
+  QString cpu_affinity;  // CPU list, e.g. "0-3,6"; empty = all CPUs
+  int max_threads;       // Thread cap for math libraries; 0 = library default,
+                         // < 0 = all cores but |max_threads| (portable between machines)
+
+  ProcessLimits();
+  QJsonObject ToJson() const;
+  static ProcessLimits FromJson(const QJsonObject& json);
+
+  /**
+   * @brief Preset for training: low priority, one core left for the UI
+   */
+  static ProcessLimits Background();
+
+  bool IsDefault() const;
+
+  /**
+   * @brief Thread cap resolved for this machine, 0 if none
+   */
+  int EffectiveThreads() const;
+
+  /**
+   * @brief Parse a CPU list ("0-3,6")
+   * @return false on syntax errors or CPUs beyond CPU_SETSIZE; cpus is sorted and unique on
+   *         success
+   */
+  static bool ParseCpuList(const QString& list, QList<int>* cpus);
+
+  /**
+   * @brief Environment with the thread cap variables set
+   */
+  QProcessEnvironment Environment(const QProcessEnvironment& base) const;
+
+  /**
+   * @brief Set environment and priority/affinity hooks on a process before start()
+   */
+  void ApplyTo(QProcess* process) const;
+};
+
+#endif  // PROCESSLIMITS_H
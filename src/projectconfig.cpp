@@ -1,14 +1,20 @@
 #include "projectconfig.h"
 
-#include <QCryptographicHash>
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonDocument>
 #include <QUuid>
 
+#include <algorithm>
+#include <climits>
 #include <iostream>
 
+#include "datasetmanifest.h"
+#include "imagelocator.h"
+#include "xxhash64.h"
+
 PluginConfig::PluginConfig()
     : enabled(false),
       name("AI Plugin"),
@@ -22,7 +28,9 @@ PluginConfig::PluginConfig()
       backbone(""),
       pretrained_model_id(""),
       model_source(""),
-      use_project_venv(false)
+      use_project_venv(false),
+      use_shared_env(false),
+      train_limits(ProcessLimits::Background())
 {
 }
 
@@ -51,6 +59,9 @@ QJsonObject PluginConfig::ToJson() const
   obj["pretrained_model_id"] = pretrained_model_id;
   obj["model_source"] = model_source;
   obj["use_project_venv"] = use_project_venv;
+  obj["use_shared_env"] = use_shared_env;
+  obj["detect_limits"] = detect_limits.ToJson();
+  obj["train_limits"] = train_limits.ToJson();
 
   return obj;
 }
@@ -89,6 +100,15 @@ PluginConfig PluginConfig::FromJson(const QJsonObject& json)
   pc.pretrained_model_id = json["pretrained_model_id"].toString("");
   pc.model_source = json["model_source"].toString("");
   pc.use_project_venv = json["use_project_venv"].toBool(false);
+  pc.use_shared_env = json["use_shared_env"].toBool(false);
+  if (json.contains("detect_limits"))
+  {
+    pc.detect_limits = ProcessLimits::FromJson(json["detect_limits"].toObject());
+  }
+  if (json.contains("train_limits"))
+  {
+    pc.train_limits = ProcessLimits::FromJson(json["train_limits"].toObject());
+  }
 
   return pc;
 }
@@ -99,7 +119,8 @@ CropConfig::CropConfig()
       x(0),
       y(0),
       width(0),
-      height(0)
+      height(0),
+      snap_to_mcu(false)
 {
 }
 
@@ -111,6 +132,7 @@ QJsonObject CropConfig::ToJson() const
   obj["y"] = y;
   obj["width"] = width;
   obj["height"] = height;
+  obj["snap_to_mcu"] = snap_to_mcu;
   return obj;
 }
 
@@ -122,13 +144,18 @@ CropConfig CropConfig::FromJson(const QJsonObject& json)
   cc.y = json["y"].toInt(0);
   cc.width = json["width"].toInt(0);
   cc.height = json["height"].toInt(0);
+  cc.snap_to_mcu = json["snap_to_mcu"].toBool(false);
   return cc;
 }
 
 // ImportPathConfig implementation
 ImportPathConfig::ImportPathConfig()
     : base_path(""),
-      skip_folders(QStringList() << "BMP" << "Dane_Surowe")
+      skip_folders(QStringList() << "BMP" << "Dane_Surowe"),
+      storage_mode("copy"),
+      duplicate_policy("skip"),
+      detect_near_duplicates(false),
+      near_duplicate_distance(4)
 {
 }
 
@@ -142,6 +169,10 @@ QJsonObject ImportPathConfig::ToJson() const
     arr.append(folder);
   }
   obj["skip_folders"] = arr;
+  obj["storage_mode"] = storage_mode;
+  obj["duplicate_policy"] = duplicate_policy;
+  obj["detect_near_duplicates"] = detect_near_duplicates;
+  obj["near_duplicate_distance"] = near_duplicate_distance;
   return obj;
 }
 
@@ -162,17 +193,64 @@ ImportPathConfig ImportPathConfig::FromJson(const QJsonObject& json)
   {
     ipc.skip_folders << "BMP" << "Dane_Surowe";
   }
+
+  ipc.storage_mode = json["storage_mode"].toString("copy");
+  ipc.duplicate_policy = json["duplicate_policy"].toString("skip");
+  ipc.detect_near_duplicates = json["detect_near_duplicates"].toBool(false);
+  ipc.near_duplicate_distance = json["near_duplicate_distance"].toInt(4);
   
   return ipc;
 }
 
+// ImageReference implementation
+ImageReference::ImageReference() : size(0), mtime(0), hash(0), has_hash(false)
+{
+}
+
+QJsonObject ImageReference::ToJson() const
+{
+  // 64-bit values are stored as strings; JSON numbers are doubles
+  QJsonObject obj;
+  obj["path"] = path;
+  obj["size"] = QString::number(size);
+  obj["mtime"] = QString::number(mtime);
+  if (has_hash)
+  {
+    obj["hash"] = QString::number(hash, 16);
+  }
+  if (!crop.isNull())
+  {
+    obj["crop"] = QJsonArray({crop.x(), crop.y(), crop.width(), crop.height()});
+  }
+  return obj;
+}
+
+ImageReference ImageReference::FromJson(const QJsonObject& json)
+{
+  ImageReference ref;
+  ref.path = json["path"].toString();
+  ref.size = json["size"].toString().toLongLong();
+  ref.mtime = json["mtime"].toString().toLongLong();
+  if (json.contains("hash"))
+  {
+    ref.hash = json["hash"].toString().toULongLong(&ref.has_hash, 16);
+  }
+  QJsonArray crop = json["crop"].toArray();
+  if (crop.size() == 4)
+  {
+    ref.crop = QRect(crop[0].toInt(), crop[1].toInt(), crop[2].toInt(), crop[3].toInt());
+  }
+  return ref;
+}
+
 // SplitConfig implementation
 SplitConfig::SplitConfig()
     : enabled(false),
       target_train_ratio(0.7),
       target_val_ratio(0.2),
       target_test_ratio(0.1),
-      hash_salt(QUuid::createUuid().toString())
+      hash_salt(QUuid::createUuid().toString()),
+      stratify_by_class(false)
 {
 }
 
@@ -184,6 +262,7 @@ QJsonObject SplitConfig::ToJson() const
   obj["target_val_ratio"] = target_val_ratio;
   obj["target_test_ratio"] = target_test_ratio;
   obj["hash_salt"] = hash_salt;
+  obj["stratify_by_class"] = stratify_by_class;
   return obj;
 }
 
@@ -195,6 +274,7 @@ SplitConfig SplitConfig::FromJson(const QJsonObject& json)
   sc.target_val_ratio = json["target_val_ratio"].toDouble(0.2);
   sc.target_test_ratio = json["target_test_ratio"].toDouble(0.1);
   sc.hash_salt = json["hash_salt"].toString(QUuid::createUuid().toString());
+  sc.stratify_by_class = json["stratify_by_class"].toBool(false);
   return sc;
 }
 
@@ -281,7 +361,20 @@ bool ProjectConfig::LoadFromFile(const QString& filepath)
     return false;
   }
 
-  FromJson(doc.object());
+  const QJsonObject json = doc.object();
+  FromJson(json);
+
+  // Per-image state lives in the side-car journal. Projects saved by older
+  // versions carry it in the JSON; it is moved to the journal on next save
+  if (json.contains("image_splits") || json.contains("image_references"))
+  {
+    image_state_.MarkRewrite();
+  }
+  else
+  {
+    image_state_.Load(QFileInfo(filepath).absolutePath(), &image_splits_, &image_references_);
+    RecountSplits();
+  }
   return true;
 }
 
@@ -298,6 +391,9 @@ bool ProjectConfig::SaveToFile(const QString& filepath)
   file.write(doc.toJson(QJsonDocument::Indented));
   file.close();
 
+  // Only the per-image changes since the last save are appended
+  image_state_.Flush(QFileInfo(filepath).absolutePath(), image_splits_, image_references_);
+
   std::cout << "Project saved to: " << filepath.toStdString() << std::endl;
   return true;
 }
@@ -436,13 +532,6 @@ QJsonObject ProjectConfig::ToJson() const
   // Train/Val/Test Splits
   obj["split_config"] = split_config_.ToJson();
 
-  QJsonObject splits_obj;
-  for (auto it = image_splits_.begin(); it != image_splits_.end(); ++it)
-  {
-    splits_obj[it.key()] = it.value();
-  }
-  obj["image_splits"] = splits_obj;
-
   // Model Versions
   QJsonArray models_array;
   for (const auto& mv : model_versions_)
@@ -506,18 +595,26 @@ void ProjectConfig::FromJson(const QJsonObject& json)
     import_path_config_ = ImportPathConfig::FromJson(json["import_path_config"].toObject());
   }
 
+  // Image references and splits are read from the JSON only for projects
+  // saved before the image state journal existed
+  image_references_.clear();
+  QJsonObject references_obj = json["image_references"].toObject();
+  for (auto it = references_obj.begin(); it != references_obj.end(); ++it)
+  {
+    image_references_[it.key()] = ImageReference::FromJson(it.value().toObject());
+  }
+
   // Load split configuration
   if (json.contains("split_config"))
   {
     split_config_ = SplitConfig::FromJson(json["split_config"].toObject());
   }
 
-  // Load image splits
-  image_splits_.clear();
+  ClearImageSplits();
   QJsonObject splits_obj = json["image_splits"].toObject();
   for (auto it = splits_obj.begin(); it != splits_obj.end(); ++it)
   {
-    image_splits_[it.key()] = it.value().toString();
+    AssignSplit(it.key(), SplitFromName(it.value().toString()));
   }
 
   // Load model versions
@@ -534,55 +631,156 @@ void ProjectConfig::FromJson(const QJsonObject& json)
             << " classes" << std::endl;
 }
 
+void ProjectConfig::AddImageReferences(const QMap<QString, ImageReference>& references)
+{
+  for (auto it = references.begin(); it != references.end(); ++it)
+  {
+    image_references_[it.key()] = it.value();
+    image_state_.RecordReference(it.key(), it.value());
+  }
+}
+
+void ProjectConfig::RemoveImageReference(const QString& filename)
+{
+  if (image_references_.remove(filename) > 0)
+  {
+    image_state_.RecordRemoveReference(filename);
+  }
+}
+
 // Train/Val/Test Split Management Implementation
 
+QString ProjectConfig::SplitName(DatasetSplit split)
+{
+  switch (split)
+  {
+    case DatasetSplit::Train:
+      return "train";
+    case DatasetSplit::Val:
+      return "val";
+    case DatasetSplit::Test:
+      return "test";
+    case DatasetSplit::None:
+      break;
+  }
+  return "";
+}
+
+DatasetSplit ProjectConfig::SplitFromName(const QString& name)
+{
+  if (name == "train")
+  {
+    return DatasetSplit::Train;
+  }
+  if (name == "val")
+  {
+    return DatasetSplit::Val;
+  }
+  if (name == "test")
+  {
+    return DatasetSplit::Test;
+  }
+  return DatasetSplit::None;
+}
+
 QString ProjectConfig::GetImageSplit(const QString& filename) const
 {
-  return image_splits_.value(filename, "");
+  return SplitName(image_splits_.value(filename, DatasetSplit::None));
 }
 
 void ProjectConfig::SetImageSplit(const QString& filename, const QString& split)
 {
-  image_splits_[filename] = split;
+  AssignSplit(filename, SplitFromName(split));
 }
 
-QString ProjectConfig::DeterministicSplitForImage(const QString& filename) const
+void ProjectConfig::ClearImageSplits()
 {
-  if (!split_config_.enabled)
+  image_splits_.clear();
+  for (int& count : split_counts_)
   {
-    return "";
+    count = 0;
+  }
+  image_state_.RecordClearSplits();
+}
+
+void ProjectConfig::RecountSplits()
+{
+  for (int& count : split_counts_)
+  {
+    count = 0;
   }
+  for (DatasetSplit split : image_splits_)
+  {
+    split_counts_[static_cast<int>(split)]++;
+  }
+}
 
-  // Use MD5 hash of filename + salt for deterministic assignment
-  QString input = filename + split_config_.hash_salt;
-  QByteArray hash = QCryptographicHash::hash(input.toUtf8(), QCryptographicHash::Md5);
+void ProjectConfig::AssignSplit(const QString& filename, DatasetSplit split)
+{
+  auto it = image_splits_.find(filename);
+  if (it != image_splits_.end())
+  {
+    split_counts_[static_cast<int>(it.value())]--;
+    it.value() = split;
+  }
+  else
+  {
+    image_splits_.insert(filename, split);
+  }
+  split_counts_[static_cast<int>(split)]++;
+  image_state_.RecordSplit(filename, split);
+}
 
-  // Convert first 4 bytes to integer
-  quint32 hash_value = 0;
-  for (int i = 0; i < 4 && i < hash.size(); ++i)
+int ProjectConfig::CountUnassignedImages(const QStringList& images) const
+{
+  int count = 0;
+  for (const QString& img : images)
   {
-    hash_value = (hash_value << 8) | static_cast<quint8>(hash[i]);
+    if (!image_splits_.contains(img))
+    {
+      count++;
+    }
   }
+  return count;
+}
 
-  // Map to 0.0-1.0 range
-  double normalized = static_cast<double>(hash_value) / static_cast<double>(UINT32_MAX);
+quint64 ProjectConfig::SplitSeed(const QString& salt)
+{
+  return XxHash64::Hash(salt.toUtf8());
+}
+
+DatasetSplit ProjectConfig::HashSplit(const QString& filename, quint64 seed) const
+{
+  // XXH64 of the filename keyed by the salt; the top 53 bits map exactly to [0, 1)
+  const quint64 hash = XxHash64::Hash(filename.toUtf8(), seed);
+  const double normalized = static_cast<double>(hash >> 11) / 9007199254740992.0;
 
   // Assign based on cumulative ratios
   if (normalized < split_config_.target_train_ratio)
   {
-    return "train";
+    return DatasetSplit::Train;
   }
   else if (normalized < split_config_.target_train_ratio + split_config_.target_val_ratio)
   {
-    return "val";
+    return DatasetSplit::Val;
   }
   else
   {
-    return "test";
+    return DatasetSplit::Test;
   }
 }
 
-void ProjectConfig::UpdateImageSplits(const QStringList& all_images)
+QString ProjectConfig::DeterministicSplitForImage(const QString& filename) const
+{
+  if (!split_config_.enabled)
+  {
+    return "";
+  }
+  return SplitName(HashSplit(filename, SplitSeed(split_config_.hash_salt)));
+}
+
+void ProjectConfig::UpdateImageSplits(const QStringList& all_images,
+                                      const QHash<QString, QVector<int>>& image_classes)
 {
   if (!split_config_.enabled)
   {
@@ -591,130 +789,213 @@ void ProjectConfig::UpdateImageSplits(const QStringList& all_images)
 
   // For existing images: keep their assignments (immutable!)
   // For new images: assign deterministically to maintain target ratios
-
+  QStringList new_images;
   for (const QString& img : all_images)
   {
     if (!image_splits_.contains(img))
     {
-      // New image - assign deterministically
-      QString split = DeterministicSplitForImage(img);
-      image_splits_[img] = split;
+      new_images.append(img);
     }
-    // Existing images keep their split assignment
   }
-
-  std::cout << "Updated splits: Train=" << GetTrainCount() << " Val=" << GetValCount()
-            << " Test=" << GetTestCount() << std::endl;
-}
-
-void ProjectConfig::GenerateSplitFiles(const QString& project_dir)
-{
-  if (!split_config_.enabled)
+  if (new_images.isEmpty())
   {
-    std::cerr << "Splits not enabled" << std::endl;
     return;
   }
 
-  // Create splits directory
-  QString splits_dir = project_dir + "/splits";
-  QDir dir;
-  if (!dir.exists(splits_dir))
+  const quint64 seed = SplitSeed(split_config_.hash_salt);
+  if (split_config_.stratify_by_class && !image_classes.isEmpty())
   {
-    dir.mkpath(splits_dir);
+    AssignStratified(new_images, image_classes, seed);
   }
-
-  // Separate images by split
-  QStringList train_images, val_images, test_images;
-  for (auto it = image_splits_.begin(); it != image_splits_.end(); ++it)
+  else
   {
-    QString filename = it.key();
-    QString split = it.value();
-    
-    // Use absolute path for plugin compatibility
-    QString full_path = project_dir + "/images/" + filename;
-
-    if (split == "train")
+    for (const QString& img : new_images)
     {
-      train_images.append(full_path);
+      AssignSplit(img, HashSplit(img, seed));
     }
-    else if (split == "val")
+  }
+
+  std::cout << "Updated splits: Train=" << GetTrainCount() << " Val=" << GetValCount()
+            << " Test=" << GetTestCount() << std::endl;
+}
+
+void ProjectConfig::AssignStratified(const QStringList& new_images,
+                                     const QHash<QString, QVector<int>>& image_classes,
+                                     quint64 seed)
+{
+  // Per-class image counts in each split, including the fixed existing assignments
+  QHash<int, QVector<int>> class_counts;  // class id → count per DatasetSplit
+  QHash<int, int> class_totals;
+  auto count_image = [&](const QString& img, DatasetSplit split) {
+    for (int class_id : image_classes.value(img))
     {
-      val_images.append(full_path);
+      QVector<int>& counts = class_counts[class_id];
+      counts.resize(4);
+      counts[static_cast<int>(split)]++;
     }
-    else if (split == "test")
+  };
+  for (auto it = image_splits_.constBegin(); it != image_splits_.constEnd(); ++it)
+  {
+    count_image(it.key(), it.value());
+  }
+  for (const QString& img : new_images)
+  {
+    for (int class_id : image_classes.value(img))
     {
-      test_images.append(full_path);
+      class_totals[class_id]++;
     }
   }
-
-  // Write train.txt
-  QFile train_file(splits_dir + "/train.txt");
-  if (train_file.open(QIODevice::WriteOnly | QIODevice::Text))
+  for (auto it = class_counts.constBegin(); it != class_counts.constEnd(); ++it)
   {
-    for (const QString& img : train_images)
+    for (int count : it.value())
     {
-      train_file.write((img + "\n").toUtf8());
+      class_totals[it.key()] += count;
     }
-    train_file.close();
-    std::cout << "Generated train.txt with " << train_images.size() << " images" << std::endl;
   }
 
-  // Write val.txt
-  QFile val_file(splits_dir + "/val.txt");
-  if (val_file.open(QIODevice::WriteOnly | QIODevice::Text))
+  // Rarest class of each image decides its split; rare classes are placed first
+  auto rarest_class = [&](const QString& img) {
+    int rarest = -1;
+    for (int class_id : image_classes.value(img))
+    {
+      if (rarest < 0 || class_totals.value(class_id) < class_totals.value(rarest))
+      {
+        rarest = class_id;
+      }
+    }
+    return rarest;
+  };
+  QStringList ordered = new_images;
+  std::sort(ordered.begin(), ordered.end(), [&](const QString& a, const QString& b) {
+    const int class_a = rarest_class(a);
+    const int class_b = rarest_class(b);
+    const int total_a = class_a < 0 ? INT_MAX : class_totals.value(class_a);
+    const int total_b = class_b < 0 ? INT_MAX : class_totals.value(class_b);
+    return total_a != total_b ? total_a < total_b : a < b;
+  });
+
+  const double ratios[4] = {0.0, split_config_.target_train_ratio, split_config_.target_val_ratio,
+                            split_config_.target_test_ratio};
+  const DatasetSplit candidates[3] = {DatasetSplit::Train, DatasetSplit::Val, DatasetSplit::Test};
+
+  for (const QString& img : ordered)
   {
-    for (const QString& img : val_images)
+    const int class_id = rarest_class(img);
+    DatasetSplit split = HashSplit(img, seed);
+    if (class_id >= 0)
     {
-      val_file.write((img + "\n").toUtf8());
+      // Split furthest below its share of this class; the hash split wins ties
+      QVector<int>& counts = class_counts[class_id];
+      counts.resize(4);
+      const int total = class_totals.value(class_id);
+      auto deficit = [&](DatasetSplit candidate) {
+        const int index = static_cast<int>(candidate);
+        return ratios[index] * total - counts[index];
+      };
+      double best_deficit = deficit(split);
+      for (DatasetSplit candidate : candidates)
+      {
+        if (deficit(candidate) > best_deficit)
+        {
+          best_deficit = deficit(candidate);
+          split = candidate;
+        }
+      }
     }
-    val_file.close();
-    std::cout << "Generated val.txt with " << val_images.size() << " images" << std::endl;
+
+    AssignSplit(img, split);
+    count_image(img, split);
   }
+}
 
-  // Write test.txt
-  QFile test_file(splits_dir + "/test.txt");
-  if (test_file.open(QIODevice::WriteOnly | QIODevice::Text))
+QStringList ProjectConfig::GenerateSplitFiles(const QString& project_dir)
+{
+  if (!split_config_.enabled)
   {
-    for (const QString& img : test_images)
-    {
-      test_file.write((img + "\n").toUtf8());
-    }
-    test_file.close();
-    std::cout << "Generated test.txt with " << test_images.size() << " images" << std::endl;
+    std::cerr << "Splits not enabled" << std::endl;
+    return QStringList();
   }
+  return WriteSplitFiles(project_dir, project_dir + "/splits", image_splits_, nullptr);
 }
 
-int ProjectConfig::GetTrainCount() const
+QStringList ProjectConfig::GenerateSeededSplitFiles(const QString& project_dir,
+                                                    const QString& output_dir, int seed,
+                                                    QMap<QString, int>* counts) const
 {
-  int count = 0;
-  for (const QString& split : image_splits_)
+  // Same ratios, different draw; stratification only applies to the project split
+  const quint64 hash_seed = SplitSeed(split_config_.hash_salt + ":" + QString::number(seed));
+  QMap<QString, DatasetSplit> splits;
+  for (auto it = image_splits_.constBegin(); it != image_splits_.constEnd(); ++it)
   {
-    if (split == "train")
-      count++;
+    splits.insert(it.key(), HashSplit(it.key(), hash_seed));
   }
-  return count;
+  return WriteSplitFiles(project_dir, output_dir, splits, counts);
 }
 
-int ProjectConfig::GetValCount() const
+QStringList ProjectConfig::WriteSplitFiles(const QString& project_dir, const QString& output_dir,
+                                           const QMap<QString, DatasetSplit>& splits,
+                                           QMap<QString, int>* counts) const
 {
-  int count = 0;
-  for (const QString& split : image_splits_)
+  // Use absolute paths for plugin compatibility. Referenced images resolve to a
+  // path named after the project image (symlink or materialized crop), so
+  // plugins still find labels/<stem>.txt
+  const ImageLocator locator(project_dir, image_references_);
+  const QStringList export_paths = locator.ExportPaths(splits.keys());
+
+  // Separate images by split; the map is ordered, so the file content is stable
+  QMap<QString, QByteArray> contents = {
+      {"train", QByteArray()}, {"val", QByteArray()}, {"test", QByteArray()}};
+  QMap<QString, int> split_counts;
+  int index = 0;
+  for (auto it = splits.constBegin(); it != splits.constEnd(); ++it, ++index)
   {
-    if (split == "val")
-      count++;
+    QString full_path = export_paths[index];
+    if (full_path.isEmpty())
+    {
+      std::cerr << "Skipping unavailable image: " << it.key().toStdString() << std::endl;
+      continue;
+    }
+
+    const QString split = SplitName(it.value());
+    auto content = contents.find(split);
+    if (content != contents.end())
+    {
+      content->append((full_path + "\n").toUtf8());
+      split_counts[split]++;
+    }
   }
-  return count;
+
+  // Only rewrite files whose content changed, so trainers keep their caches
+  QStringList changed;
+  for (auto it = contents.constBegin(); it != contents.constEnd(); ++it)
+  {
+    const QString file_name = it.key() + ".txt";
+    if (DatasetManifest::WriteIfChanged(output_dir + "/" + file_name, it.value()))
+    {
+      changed.append(it.key());
+      std::cout << "Generated " << file_name.toStdString() << " with "
+                << split_counts.value(it.key()) << " images" << std::endl;
+    }
+  }
+  if (counts != nullptr)
+  {
+    *counts = split_counts;
+  }
+  return changed;
 }
 
-int ProjectConfig::GetTestCount() const
+QStringList ProjectConfig::GetImagesInSplit(const QString& split) const
 {
-  int count = 0;
-  for (const QString& split : image_splits_)
+  const DatasetSplit wanted = SplitFromName(split);
+  QStringList images;
+  for (auto it = image_splits_.constBegin(); it != image_splits_.constEnd(); ++it)
   {
-    if (split == "test")
-      count++;
+    if (it.value() == wanted)
+    {
+      images.append(it.key());
+    }
   }
-  return count;
+  return images;
 }
 
 // Model Version Management Implementation
@@ -763,7 +1044,7 @@ void ProjectConfig::ResetAllSplits()
   split_config_.hash_salt = QUuid::createUuid().toString(QUuid::WithoutBraces);
 
   // Clear all assignments
-  image_splits_.clear();
+  ClearImageSplits();
 
   // Model versions list will be kept but old models are archived
 }
@@ -3,12 +3,17 @@
 
 #include <QColor>
 #include <QDateTime>
+#include <QHash>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QMap>
+#include <QRect>
 #include <QString>
 #include <QVector>
 
+#include "imagestatestore.h"
+#include "processlimits.h"
+
 struct ProjectClass
 {
   int id;
@@ -40,6 +45,11 @@ struct PluginConfig
   QString pretrained_model_id; // "coco_mask_rcnn_R_50_FPN_3x", etc.
   QString model_source;        // "downloaded", "existing", "scratch", "trained"
   bool use_project_venv;       // Whether to use project-specific virtual environment
+  bool use_shared_env;         // Project venv is an overlay over the plugin's shared base
+
+  // Priority, CPU affinity and thread caps applied at spawn
+  ProcessLimits detect_limits;  // Default: inherit (interactive)
+  ProcessLimits train_limits;   // Default: ProcessLimits::Background()
 
   PluginConfig();
   QJsonObject ToJson() const;
@@ -50,10 +60,11 @@ struct PluginConfig
 struct CropConfig
 {
   bool enabled;
-  int x;       // Top-left X coordinate
-  int y;       // Top-left Y coordinate
-  int width;   // Crop width (0 = use full image width)
-  int height;  // Crop height (0 = use full image height)
+  int x;             // Top-left X coordinate
+  int y;             // Top-left Y coordinate
+  int width;         // Crop width (0 = use full image width)
+  int height;        // Crop height (0 = use full image height)
+  bool snap_to_mcu;  // Move X/Y to the JPEG MCU grid so JPEGs crop losslessly
 
   CropConfig();
   QJsonObject ToJson() const;
@@ -65,12 +76,31 @@ struct ImportPathConfig
 {
   QString base_path;           // Base path to strip (e.g., "/home/user/Images")
   QStringList skip_folders;    // Folders to skip in remaining path (e.g., ["BMP", "Dane_Surowe"])
+  QString storage_mode;        // "copy" into images/ or "reference" the source files in place
+  QString duplicate_policy;    // "skip", "link" (hardlink to existing image) or "import"
+  bool detect_near_duplicates; // Also match visually similar images (perceptual hash)
+  int near_duplicate_distance; // Max differing dHash bits to count as near duplicate
   
   ImportPathConfig();
   QJsonObject ToJson() const;
   static ImportPathConfig FromJson(const QJsonObject& json);
 };
 
+// External image used in place of a copy in images/ (reference storage mode)
+struct ImageReference
+{
+  QString path;        // Absolute path of the source image
+  qint64 size;         // File size at import, to detect replaced sources
+  qint64 mtime;        // Last modification at import (ms since epoch)
+  quint64 hash;        // XXH64 of the source content
+  bool has_hash;
+  QRect crop;          // Applied when the image is read; null = whole image
+
+  ImageReference();
+  QJsonObject ToJson() const;
+  static ImageReference FromJson(const QJsonObject& json);
+};
+
 // Train/Val/Test split configuration
 struct SplitConfig
 {
@@ -78,7 +108,8 @@ struct SplitConfig
   double target_train_ratio;
   double target_val_ratio;
   double target_test_ratio;
-  QString hash_salt;  // UUID for deterministic assignment
+  QString hash_salt;        // UUID for deterministic assignment
+  bool stratify_by_class;   // Balance classes of new labeled images across splits
 
   SplitConfig();
   QJsonObject ToJson() const;
@@ -99,6 +130,15 @@ struct ModelVersion
   static ModelVersion FromJson(const QJsonObject& json);
 };
 
+// Split of one image, one byte per image instead of a string
+enum class DatasetSplit : quint8
+{
+  None,
+  Train,
+  Val,
+  Test
+};
+
 // Annotation type
 enum class AnnotationType
 {
@@ -170,21 +210,38 @@ class ProjectConfig
   ImportPathConfig& GetImportPathConfig() { return import_path_config_; }
   const ImportPathConfig& GetImportPathConfig() const { return import_path_config_; }
   void SetImportPathConfig(const ImportPathConfig& config) { import_path_config_ = config; }
+  bool IsReferenceMode() const { return import_path_config_.storage_mode == "reference"; }
+
+  // Image References (reference storage mode)
+  const QMap<QString, ImageReference>& GetImageReferences() const { return image_references_; }
+  void AddImageReferences(const QMap<QString, ImageReference>& references);
+  void RemoveImageReference(const QString& filename);
 
-  const QMap<QString, QString>& GetImageSplits() const { return image_splits_; }
+  static QString SplitName(DatasetSplit split);  // "train"/"val"/"test", empty for None
+  static DatasetSplit SplitFromName(const QString& name);
+
+  const QMap<QString, DatasetSplit>& GetImageSplits() const { return image_splits_; }
   QString GetImageSplit(const QString& filename) const;
   void SetImageSplit(const QString& filename, const QString& split);
-  void ClearImageSplits() { image_splits_.clear(); }
+  void ClearImageSplits();
   void ResetAllSplits();
   QStringList GetImageFiles() const;
+  int CountUnassignedImages(const QStringList& images) const;
 
   QString DeterministicSplitForImage(const QString& filename) const;
-  void UpdateImageSplits(const QStringList& all_images);
-  void GenerateSplitFiles(const QString& project_dir);
-
-  int GetTrainCount() const;
-  int GetValCount() const;
-  int GetTestCount() const;
+  // image_classes (image → class ids) is only used when stratify_by_class is set
+  void UpdateImageSplits(const QStringList& all_images,
+                         const QHash<QString, QVector<int>>& image_classes = {});
+  QStringList GenerateSplitFiles(const QString& project_dir);  // Returns the splits rewritten
+  // Re-draws the assigned images with a salt derived from seed into output_dir/<split>.txt,
+  // leaving the project split untouched; counts receives images per split
+  QStringList GenerateSeededSplitFiles(const QString& project_dir, const QString& output_dir,
+                                       int seed, QMap<QString, int>* counts = nullptr) const;
+  QStringList GetImagesInSplit(const QString& split) const;
+
+  int GetTrainCount() const { return split_counts_[static_cast<int>(DatasetSplit::Train)]; }
+  int GetValCount() const { return split_counts_[static_cast<int>(DatasetSplit::Val)]; }
+  int GetTestCount() const { return split_counts_[static_cast<int>(DatasetSplit::Test)]; }
 
   // Model Version Management
   const QList<ModelVersion>& GetModelVersions() const { return model_versions_; }
@@ -212,15 +269,32 @@ class ProjectConfig
   // Import Path Configuration
   ImportPathConfig import_path_config_;
 
+  // Referenced images: project file name → source
+  QMap<QString, ImageReference> image_references_;
+
   // Train/Val/Test Splits
   SplitConfig split_config_;
-  QMap<QString, QString> image_splits_;  // filename → "train"/"val"/"test"
+  QMap<QString, DatasetSplit> image_splits_;  // filename → split
+  int split_counts_[4] = {0, 0, 0, 0};        // Images per DatasetSplit, kept in sync
+
+  // Journal of per-image state (splits, references); not part of the project JSON
+  ImageStateStore image_state_;
 
   // Model Versions
   QList<ModelVersion> model_versions_;
 
   QJsonObject ToJson() const;
   void FromJson(const QJsonObject& json);
+
+  void AssignSplit(const QString& filename, DatasetSplit split);
+  void RecountSplits();
+  static quint64 SplitSeed(const QString& salt);
+  DatasetSplit HashSplit(const QString& filename, quint64 seed) const;
+  void AssignStratified(const QStringList& new_images,
+                        const QHash<QString, QVector<int>>& image_classes, quint64 seed);
+  QStringList WriteSplitFiles(const QString& project_dir, const QString& output_dir,
+                              const QMap<QString, DatasetSplit>& splits,
+                              QMap<QString, int>* counts) const;
 };
 
 #endif  // PROJECTCONFIG_H
@@ -0,0 +1,460 @@
+#include "projectscanner.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <iostream>
+
+// ProjectScanResult implementation
+
+int ProjectScanResult::LabeledCount() const
+{
+  int count = 0;
+  for (char flag : labeled)
+  {
+    if (flag != 0)
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+QStringList ProjectScanResult::LabeledImages() const
+{
+  QStringList result;
+  for (int i = 0; i < images.size() && i < labeled.size(); ++i)
+  {
+    if (labeled[i] != 0)
+    {
+      result.append(images[i]);
+    }
+  }
+  return result;
+}
+
+bool ProjectScanResult::IsLabeled(const QString& image_file) const
+{
+  return labels.contains(ProjectScanner::CompleteBaseName(image_file));
+}
+
+// ProjectScanner implementation
+
+ProjectScanner::ProjectScanner(QObject* parent)
+    : QObject(parent),
+      watcher_(new QFileSystemWatcher(this)),
+      images_timer_(new QTimer(this)),
+      labels_timer_(new QTimer(this)),
+      generation_(0),
+      scanning_(false),
+      references_changed_(false)
+{
+  // Directory listings run one at a time so their results apply in order
+  pool_.setMaxThreadCount(1);
+
+  images_timer_->setSingleShot(true);
+  images_timer_->setInterval(kWatchDebounceMs);
+  labels_timer_->setSingleShot(true);
+  labels_timer_->setInterval(kWatchDebounceMs);
+
+  connect(watcher_, &QFileSystemWatcher::directoryChanged, this,
+          &ProjectScanner::OnDirectoryChanged);
+  connect(images_timer_, &QTimer::timeout, this, [this]() { StartListing(WatchedDir::Images); });
+  connect(labels_timer_, &QTimer::timeout, this, [this]() { StartListing(WatchedDir::Labels); });
+}
+
+ProjectScanner::~ProjectScanner()
+{
+  Stop();
+  pool_.waitForDone();
+}
+
+QStringList ProjectScanner::ImageNameFilters()
+{
+  return QStringList() << "*.jpg" << "*.jpeg" << "*.png" << "*.bmp";
+}
+
+QString ProjectScanner::CompleteBaseName(const QString& file_name)
+{
+  int last_dot = file_name.lastIndexOf('.');
+  if (last_dot <= 0)
+  {
+    return file_name;
+  }
+  return file_name.left(last_dot);
+}
+
+ProjectScanResult ProjectScanner::Scan(const QString& project_dir,
+                                       const QStringList& referenced_images)
+{
+  ProjectScanResult result;
+  if (project_dir.isEmpty())
+  {
+    return result;
+  }
+
+  result.images = MergeImages(ListImages(project_dir + "/images"), referenced_images);
+  ListLabelStems(project_dir + "/labels", &result.labels, &result.metas);
+  ClassifyImages(result);
+
+  return result;
+}
+
+QStringList ProjectScanner::ListImages(const QString& images_dir)
+{
+  QDir dir(images_dir);
+  return dir.entryList(ImageNameFilters(), QDir::Files, QDir::Name);
+}
+
+QStringList ProjectScanner::MergeImages(QStringList listed, const QStringList& referenced)
+{
+  if (referenced.isEmpty())
+  {
+    return listed;
+  }
+
+  listed.append(referenced);
+  listed.sort();
+  listed.removeDuplicates();
+  return listed;
+}
+
+void ProjectScanner::ListLabelStems(const QString& labels_dir, QSet<QString>* labels,
+                                    QSet<QString>* metas)
+{
+  // Approved labels and unreviewed meta files come from the same single listing
+  QDir dir(labels_dir);
+  const QStringList files =
+      dir.entryList(QStringList() << "*.txt" << "*.meta", QDir::Files, QDir::NoSort);
+
+  labels->clear();
+  metas->clear();
+  labels->reserve(files.size());
+  for (const QString& file : files)
+  {
+    if (file.endsWith(".meta"))
+    {
+      metas->insert(CompleteBaseName(file));
+    }
+    else
+    {
+      labels->insert(CompleteBaseName(file));
+    }
+  }
+}
+
+void ProjectScanner::ClassifyImages(ProjectScanResult& result)
+{
+  // A hash lookup per image; even 100k images take a few milliseconds
+  const int count = result.images.size();
+  result.labeled.fill(0, count);
+  for (int i = 0; i < count; ++i)
+  {
+    result.labeled[i] = result.labels.contains(CompleteBaseName(result.images[i])) ? 1 : 0;
+  }
+}
+
+void ProjectScanner::Watch(const QString& project_dir, const QStringList& referenced_images)
+{
+  Stop();
+
+  project_dir_ = project_dir;
+  referenced_images_ = referenced_images;
+
+  if (project_dir_.isEmpty())
+  {
+    return;
+  }
+
+  // Listings of watcher events queue behind the scan on the single worker, so
+  // they are applied after it and diff against its result
+  scanning_ = true;
+  const int generation = generation_;
+  pool_.start([this, project_dir, referenced_images, generation]() {
+    ProjectScanResult result = Scan(project_dir, referenced_images);
+    QMetaObject::invokeMethod(
+        this,
+        [this, result, generation]() {
+          if (generation == generation_)
+          {
+            ApplyScan(result);
+          }
+        },
+        Qt::QueuedConnection);
+  });
+
+  // The project root is watched too, so a labels/ folder created later is picked up
+  QStringList paths;
+  paths << project_dir_;
+  for (const QString& sub_dir : {QString("/images"), QString("/labels")})
+  {
+    if (QFileInfo::exists(project_dir_ + sub_dir))
+    {
+      paths << project_dir_ + sub_dir;
+    }
+  }
+  watcher_->addPaths(paths);
+}
+
+void ProjectScanner::Stop()
+{
+  generation_++;
+  scanning_ = false;
+  references_changed_ = false;
+  images_timer_->stop();
+  labels_timer_->stop();
+
+  const QStringList watched = watcher_->directories();
+  if (!watched.isEmpty())
+  {
+    watcher_->removePaths(watched);
+  }
+
+  project_dir_.clear();
+  referenced_images_.clear();
+  snapshot_ = ProjectScanResult();
+}
+
+void ProjectScanner::SetReferencedImages(const QStringList& referenced_images)
+{
+  referenced_images_ = referenced_images;
+  references_changed_ = scanning_;
+}
+
+void ProjectScanner::AddImages(const QStringList& image_files)
+{
+  QSet<QString> known(snapshot_.images.begin(), snapshot_.images.end());
+  QStringList added;
+  for (const QString& file : image_files)
+  {
+    if (!known.contains(file))
+    {
+      known.insert(file);
+      added.append(file);
+    }
+  }
+
+  if (added.isEmpty())
+  {
+    return;
+  }
+
+  snapshot_.images.append(added);
+  snapshot_.images.sort();
+  ClassifyImages(snapshot_);
+
+  emit ImagesChanged(added, QStringList());
+}
+
+void ProjectScanner::OnDirectoryChanged(const QString& path)
+{
+  if (project_dir_.isEmpty())
+  {
+    return;
+  }
+
+  const QString images_dir = project_dir_ + "/images";
+  const QString labels_dir = project_dir_ + "/labels";
+
+  if (path == images_dir)
+  {
+    images_timer_->start();
+  }
+  else if (path == labels_dir)
+  {
+    labels_timer_->start();
+  }
+  else if (path == project_dir_)
+  {
+    // A watched sub-directory may have been created (or recreated)
+    const QStringList watched = watcher_->directories();
+    if (!watched.contains(images_dir) && QFileInfo::exists(images_dir))
+    {
+      watcher_->addPath(images_dir);
+      images_timer_->start();
+    }
+    if (!watched.contains(labels_dir) && QFileInfo::exists(labels_dir))
+    {
+      watcher_->addPath(labels_dir);
+      labels_timer_->start();
+    }
+  }
+}
+
+void ProjectScanner::StartListing(WatchedDir which)
+{
+  if (project_dir_.isEmpty())
+  {
+    return;
+  }
+
+  const int generation = generation_;
+  const QString dir = project_dir_ + (which == WatchedDir::Images ? "/images" : "/labels");
+
+  const QStringList referenced = referenced_images_;
+
+  pool_.start([this, which, dir, referenced, generation]() {
+    if (which == WatchedDir::Images)
+    {
+      QStringList images = MergeImages(ListImages(dir), referenced);
+      QMetaObject::invokeMethod(
+          this,
+          [this, images, generation]() {
+            if (generation == generation_)
+            {
+              ApplyImageListing(images);
+            }
+          },
+          Qt::QueuedConnection);
+    }
+    else
+    {
+      QSet<QString> labels;
+      QSet<QString> metas;
+      ListLabelStems(dir, &labels, &metas);
+      QMetaObject::invokeMethod(
+          this,
+          [this, labels, metas, generation]() {
+            if (generation == generation_)
+            {
+              ApplyLabelListing(labels, metas);
+            }
+          },
+          Qt::QueuedConnection);
+    }
+  });
+}
+
+void ProjectScanner::ApplyScan(ProjectScanResult result)
+{
+  // References imported while the scan ran have no file in images/ for the watcher to see
+  if (references_changed_)
+  {
+    result.images = MergeImages(result.images, referenced_images_);
+    ClassifyImages(result);
+  }
+
+  QStringList images_added;
+  QStringList images_removed;
+  DiffStems(QSet<QString>(snapshot_.images.begin(), snapshot_.images.end()),
+            QSet<QString>(result.images.begin(), result.images.end()), &images_added,
+            &images_removed);
+
+  QStringList labels_added;
+  QStringList labels_removed;
+  DiffStems(snapshot_.labels, result.labels, &labels_added, &labels_removed);
+
+  QStringList metas_added;
+  QStringList metas_removed;
+  DiffStems(snapshot_.metas, result.metas, &metas_added, &metas_removed);
+
+  snapshot_ = result;
+
+  std::cout << "Project scanned: " << snapshot_.images.size() << " images, "
+            << snapshot_.labels.size() << " labels" << std::endl;
+
+  if (!images_added.isEmpty() || !images_removed.isEmpty())
+  {
+    emit ImagesChanged(images_added, images_removed);
+  }
+  if (!labels_added.isEmpty() || !labels_removed.isEmpty())
+  {
+    emit LabelsChanged(labels_added, labels_removed);
+  }
+  if (!metas_added.isEmpty() || !metas_removed.isEmpty())
+  {
+    emit MetaFilesChanged(metas_added, metas_removed);
+  }
+
+  scanning_ = false;
+  references_changed_ = false;
+  emit ScanFinished();
+}
+
+void ProjectScanner::ApplyImageListing(const QStringList& images)
+{
+  const QSet<QString> old_set(snapshot_.images.begin(), snapshot_.images.end());
+  const QSet<QString> new_set(images.begin(), images.end());
+
+  QStringList added;
+  for (const QString& image : images)
+  {
+    if (!old_set.contains(image))
+    {
+      added.append(image);
+    }
+  }
+
+  QStringList removed;
+  for (const QString& image : snapshot_.images)
+  {
+    if (!new_set.contains(image))
+    {
+      removed.append(image);
+    }
+  }
+
+  if (added.isEmpty() && removed.isEmpty())
+  {
+    return;
+  }
+
+  snapshot_.images = images;
+  ClassifyImages(snapshot_);
+
+  std::cout << "Images changed on disk: +" << added.size() << " -" << removed.size() << std::endl;
+  emit ImagesChanged(added, removed);
+}
+
+void ProjectScanner::ApplyLabelListing(const QSet<QString>& labels, const QSet<QString>& metas)
+{
+  QStringList labels_added;
+  QStringList labels_removed;
+  DiffStems(snapshot_.labels, labels, &labels_added, &labels_removed);
+
+  QStringList metas_added;
+  QStringList metas_removed;
+  DiffStems(snapshot_.metas, metas, &metas_added, &metas_removed);
+
+  const bool labels_changed = !labels_added.isEmpty() || !labels_removed.isEmpty();
+  const bool metas_changed = !metas_added.isEmpty() || !metas_removed.isEmpty();
+
+  if (labels_changed)
+  {
+    snapshot_.labels = labels;
+    ClassifyImages(snapshot_);
+  }
+  if (metas_changed)
+  {
+    snapshot_.metas = metas;
+  }
+
+  if (labels_changed)
+  {
+    emit LabelsChanged(labels_added, labels_removed);
+  }
+  if (metas_changed)
+  {
+    emit MetaFilesChanged(metas_added, metas_removed);
+  }
+}
+
+void ProjectScanner::DiffStems(const QSet<QString>& before, const QSet<QString>& after,
+                               QStringList* added, QStringList* removed)
+{
+  for (const QString& stem : after)
+  {
+    if (!before.contains(stem))
+    {
+      added->append(stem);
+    }
+  }
+
+  for (const QString& stem : before)
+  {
+    if (!after.contains(stem))
+    {
+      removed->append(stem);
+    }
+  }
+}
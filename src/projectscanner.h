@@ -0,0 +1,170 @@
+#ifndef PROJECTSCANNER_H
+#define PROJECTSCANNER_H
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * @brief Snapshot of a project's images/ and labels/ directories
+ *
+ * Built from exactly one directory listing per folder; label lookups are
+ * hash-set hits instead of per-image stat() calls.
+ */
+struct ProjectScanResult
+{
+  QStringList images;       // Image file names in images/ plus referenced images, sorted
+  QSet<QString> labels;     // Stems of labels/*.txt (file name without ".txt")
+  QSet<QString> metas;      // Stems of labels/*.meta (unreviewed AI detections)
+  QVector<char> labeled;    // labeled[i] != 0 if images[i] has a label file
+
+  int LabeledCount() const;
+  QStringList LabeledImages() const;
+  bool IsLabeled(const QString& image_file) const;
+};
+
+/**
+ * @brief Scans project image/label folders and keeps the snapshot up to date
+ *
+ * Handles:
+ * - One-shot scan using a single directory read of images/ and labels/
+ * - The initial scan on a worker thread, delivered as change signals
+ * - QFileSystemWatcher-driven incremental updates, listed on a worker thread
+ */
+class ProjectScanner : public QObject
+{
+  Q_OBJECT
+
+ public:
+  explicit ProjectScanner(QObject* parent = nullptr);
+  ~ProjectScanner() override;
+
+  /**
+   * @brief Image file name filters recognised in images/
+   */
+  static QStringList ImageNameFilters();
+
+  /**
+   * @brief Strip the last extension from a file name ("a.b.jpg" -> "a.b")
+   *
+   * Same result as QFileInfo::completeBaseName() without touching the disk.
+   */
+  static QString CompleteBaseName(const QString& file_name);
+
+  /**
+   * @brief Scan a project synchronously
+   * @param project_dir Project root directory
+   * @param referenced_images Images stored as references (reference storage mode)
+   * @return Snapshot of images and labels
+   */
+  static ProjectScanResult Scan(const QString& project_dir,
+                                const QStringList& referenced_images = QStringList());
+
+  /**
+   * @brief Scan a project on the worker thread and watch it for changes
+   * @param project_dir Project root directory
+   * @param referenced_images Images without a file in images/, kept across relistings
+   *
+   * The snapshot starts empty. The scan result arrives like a watcher update:
+   * ImagesChanged, LabelsChanged and MetaFilesChanged against the empty
+   * snapshot, then ScanFinished.
+   */
+  void Watch(const QString& project_dir, const QStringList& referenced_images = QStringList());
+
+  /**
+   * @brief True between Watch() and ScanFinished()
+   */
+  bool IsScanning() const { return scanning_; }
+
+  /**
+   * @brief Replace the referenced images merged into every listing of images/
+   */
+  void SetReferencedImages(const QStringList& referenced_images);
+
+  /**
+   * @brief Stop watching and drop the snapshot
+   */
+  void Stop();
+
+  /**
+   * @brief Current snapshot (updated before the change signals are emitted)
+   */
+  const ProjectScanResult& GetSnapshot() const { return snapshot_; }
+
+  /**
+   * @brief Project currently being watched (empty when stopped)
+   */
+  QString GetProjectDirectory() const { return project_dir_; }
+
+  /**
+   * @brief Merge images the application added itself, without waiting for the watcher
+   * @param image_files File names relative to images/
+   */
+  void AddImages(const QStringList& image_files);
+
+ signals:
+  /**
+   * @brief Emitted when image files appear in or disappear from images/
+   */
+  void ImagesChanged(const QStringList& added, const QStringList& removed);
+
+  /**
+   * @brief Emitted when label files appear in or disappear from labels/
+   * @param added Stems of new label files
+   * @param removed Stems of deleted label files
+   */
+  void LabelsChanged(const QStringList& added, const QStringList& removed);
+
+  /**
+   * @brief Emitted when .meta files appear in or disappear from labels/
+   * @param added Stems of new meta files
+   * @param removed Stems of deleted meta files
+   */
+  void MetaFilesChanged(const QStringList& added, const QStringList& removed);
+
+  /**
+   * @brief Emitted once the initial scan of Watch() has been applied
+   */
+  void ScanFinished();
+
+ private:
+  enum class WatchedDir
+  {
+    Images,
+    Labels
+  };
+
+  static QStringList ListImages(const QString& images_dir);
+  static QStringList MergeImages(QStringList listed, const QStringList& referenced);
+  static void ListLabelStems(const QString& labels_dir, QSet<QString>* labels,
+                             QSet<QString>* metas);
+  static void ClassifyImages(ProjectScanResult& result);
+
+  void OnDirectoryChanged(const QString& path);
+  void StartListing(WatchedDir which);
+  void ApplyScan(ProjectScanResult result);
+  void ApplyImageListing(const QStringList& images);
+  void ApplyLabelListing(const QSet<QString>& labels, const QSet<QString>& metas);
+  static void DiffStems(const QSet<QString>& before, const QSet<QString>& after,
+                        QStringList* added, QStringList* removed);
+
+  static constexpr int kWatchDebounceMs = 250;
+
+  QString project_dir_;
+  QStringList referenced_images_;
+  ProjectScanResult snapshot_;
+  QFileSystemWatcher* watcher_;
+  QTimer* images_timer_;
+  QTimer* labels_timer_;
+  int generation_;  // Bumped on Stop() so stale listings are dropped
+  bool scanning_;
+  bool references_changed_;  // SetReferencedImages() during the initial scan
+  QThreadPool pool_;
+};
+
+#endif  // PROJECTSCANNER_H
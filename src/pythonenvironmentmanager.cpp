@@ -1,12 +1,79 @@
 #include "pythonenvironmentmanager.h"
 
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
+#include <QEventLoop>
 #include <QFile>
 #include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QRegularExpression>
+#include <QProcessEnvironment>
+#include <QSaveFile>
+#include <QSettings>
 #include <QStandardPaths>
+#include <QTimer>
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+// Everything detection needs from one interpreter start; starting Python and
+// importing torch dominate, so each candidate runs this once
+const char* const kProbeScript =
+    "import sys, importlib.util\n"
+    "print('VERSION:%d.%d.%d' % tuple(sys.version_info[:3]))\n"
+    "print('EXECUTABLE:' + sys.executable)\n"
+    "print('VENV:%d' % (importlib.util.find_spec('venv') is not None))\n"
+    "print('PIP:%d' % (importlib.util.find_spec('pip') is not None))\n"
+    "import site\n"
+    "dirs = site.getsitepackages() if hasattr(site, 'getsitepackages') else []\n"
+    "if site.ENABLE_USER_SITE:\n"
+    "    dirs.append(site.getusersitepackages())\n"
+    "for d in dirs:\n"
+    "    print('SITE:' + d)\n"
+    "try:\n"
+    "    import torch\n"
+    "    print('TORCH:' + torch.__version__)\n"
+    "    if torch.cuda.is_available():\n"
+    "        print('CUDA:%s' % torch.version.cuda)\n"
+    "        print('GPU:' + torch.cuda.get_device_name(0))\n"
+    "    mps = getattr(torch.backends, 'mps', None)\n"
+    "    print('MPS:%d' % (mps is not None and mps.is_available()))\n"
+    "except Exception:\n"
+    "    pass\n";
+
+constexpr int kProbeTimeoutMs = 30000;
+
+// Probe output per interpreter, valid while its mtime and size are unchanged
+QJsonObject LoadProbeCache()
+{
+  QFile file(PythonEnvironmentManager::GetProbeCachePath());
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return QJsonObject();
+  }
+  return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+void SaveProbeCache(const QJsonObject& cache)
+{
+  const QString path = PythonEnvironmentManager::GetProbeCachePath();
+  QDir().mkpath(QFileInfo(path).absolutePath());
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    std::cerr << "Cannot write Python probe cache: " << path.toStdString() << std::endl;
+    return;
+  }
+  file.write(QJsonDocument(cache).toJson());
+  file.commit();
+}
+}  // namespace
 
 // PythonInfo implementation
 
@@ -16,6 +83,7 @@ PythonInfo::PythonInfo()
       has_venv(false),
       has_pip(false),
       has_cuda(false),
+      has_mps(false),
       is_valid(false)
 {
 }
@@ -66,79 +134,148 @@ PythonEnvironmentManager::PythonEnvironmentManager(QObject* parent)
     : QObject(parent),
       detection_performed_(false),
       current_process_(nullptr),
-      current_operation_(OperationType::None)
+      python_candidates_(DefaultPythonCandidates()),
+      probe_timer_(new QTimer(this)),
+      starting_probes_(false),
+      current_operation_(OperationType::None),
+      offline_install_(false),
+      install_step_(InstallStep::FromWheelhouse),
+      venv_step_(VenvStep::Create),
+      environment_stage_(EnvironmentStage::None)
 {
+  QSettings settings("PolySeg", "PolySeg");
+  const QString polyseg_dir = QDir::homePath() + "/.polyseg";
+  wheelhouse_dir_ = settings.value("python/wheelhouse_dir", polyseg_dir + "/wheelhouse").toString();
+  pip_cache_dir_ = settings.value("python/pip_cache_dir", polyseg_dir + "/pip-cache").toString();
+  offline_install_ = settings.value("python/offline_install", false).toBool();
+
+  probe_timer_->setSingleShot(true);
+  connect(probe_timer_, &QTimer::timeout, this, &PythonEnvironmentManager::OnProbeTimeout);
 }
 
 PythonEnvironmentManager::~PythonEnvironmentManager()
 {
   Cancel();
+  StopProbes();
 }
 
-PythonInfo PythonEnvironmentManager::DetectPython()
+PythonInfo PythonEnvironmentManager::DetectPython(bool refresh)
 {
-  python_info_ = PythonInfo();
-  detection_performed_ = true;
+  QEventLoop loop;
+  connect(this, &PythonEnvironmentManager::detectionFinished, &loop, &QEventLoop::quit);
+  DetectPythonAsync(refresh);
 
-  emit detectionProgress("Searching for Python...");
-
-  QStringList python_candidates = {"python3", "python"};
+  // Finished already when every needed result came from the cache
+  if (!probes_.isEmpty())
+  {
+    loop.exec();
+  }
+  return python_info_;
+}
 
-#ifdef Q_OS_WIN
-  python_candidates << "py"
-                    << "C:/Python311/python.exe"
-                    << "C:/Python310/python.exe"
-                    << "C:/Python39/python.exe";
-#else
-  python_candidates << "/usr/bin/python3"
-                    << "/usr/local/bin/python3"
-                    << "/opt/homebrew/bin/python3";
-#endif
+void PythonEnvironmentManager::DetectPythonAsync(bool refresh)
+{
+  StopProbes();
+  emit detectionProgress("Searching for Python...");
 
-  for (const QString& python : python_candidates)
+  const QJsonObject cache = refresh ? QJsonObject() : LoadProbeCache();
+  for (const QString& candidate : python_candidates_)
   {
-    QString version_output = RunPythonCommand(python, {"--version"}, 5000);
-    if (!version_output.isEmpty())
+    const QString resolved = QFileInfo(candidate).isAbsolute()
+                                 ? candidate
+                                 : QStandardPaths::findExecutable(candidate);
+    const QFileInfo file_info(resolved);
+    if (resolved.isEmpty() || !file_info.exists())
     {
-      python_info_.path = python;
-      ParsePythonVersion(version_output);
+      continue;
+    }
 
-      if (python_info_.version_major >= 3)
-      {
-        python_info_.is_valid = true;
+    // Not canonical: a venv interpreter is a symlink that behaves differently
+    // from its target
+    PythonProbe probe;
+    probe.executable = file_info.absoluteFilePath();
+    if (std::any_of(probes_.begin(), probes_.end(), [&probe](const PythonProbe& other)
+                    { return other.executable == probe.executable; }))
+    {
+      continue;
+    }
+    probe.mtime = file_info.lastModified().toMSecsSinceEpoch();
+    probe.size = file_info.size();
 
-        QString which_output =
-            RunPythonCommand(python, {"-c", "import sys; print(sys.executable)"}, 5000);
-        if (!which_output.isEmpty())
-        {
-          python_info_.path = which_output.trimmed();
-        }
+    const QJsonObject cached = cache[probe.executable].toObject();
+    if (!cached.isEmpty() && cached["mtime"].toString().toLongLong() == probe.mtime &&
+        cached["size"].toString().toLongLong() == probe.size)
+    {
+      probe.done = true;
+      probe.output = cached["output"].toString();
+    }
+    probes_.append(probe);
+  }
 
+  // Candidates after a cached valid interpreter would never be selected
+  starting_probes_ = true;
+  for (PythonProbe& probe : probes_)
+  {
+    if (probe.done)
+    {
+      if (ParseProbeOutput(probe.output).is_valid)
+      {
         break;
       }
+      continue;
     }
+
+    QProcess* process = new QProcess(this);
+    probe.process = process;
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, process](int, QProcess::ExitStatus exit_status)
+            { OnProbeFinished(process, exit_status == QProcess::NormalExit); });
+    connect(process, &QProcess::errorOccurred, this,
+            [this, process](QProcess::ProcessError error)
+            {
+              if (error == QProcess::FailedToStart)
+              {
+                OnProbeFinished(process, false);
+              }
+            });
+    process->setProgram(probe.executable);
+    process->setArguments({"-c", kProbeScript});
+    process->start();
   }
+  starting_probes_ = false;
 
-  if (!python_info_.is_valid)
+  if (!TryFinishDetection())
   {
-    emit detectionProgress("Python not found");
-    emit detectionFinished(python_info_);
-    return python_info_;
+    probe_timer_->start(kProbeTimeoutMs);
   }
+}
 
-  emit detectionProgress("Checking venv support...");
-  python_info_.has_venv = CheckModuleAvailable(python_info_.path, "venv");
+QStringList PythonEnvironmentManager::DefaultPythonCandidates()
+{
+  QStringList python_candidates = {"python3", "python"};
 
-  emit detectionProgress("Checking pip...");
-  python_info_.has_pip = CheckModuleAvailable(python_info_.path, "pip");
+#ifdef Q_OS_WIN
+  python_candidates << "py"
+                    << "C:/Python311/python.exe"
+                    << "C:/Python310/python.exe"
+                    << "C:/Python39/python.exe";
+#else
+  python_candidates << "/usr/bin/python3"
+                    << "/usr/local/bin/python3"
+                    << "/opt/homebrew/bin/python3";
+#endif
 
-  emit detectionProgress("Checking CUDA support...");
-  DetectCudaSupport(python_info_.path);
+  return python_candidates;
+}
 
-  emit detectionProgress("Detection complete");
-  emit detectionFinished(python_info_);
+void PythonEnvironmentManager::SetPythonCandidates(const QStringList& candidates)
+{
+  python_candidates_ = candidates;
+}
 
-  return python_info_;
+QString PythonEnvironmentManager::GetProbeCachePath()
+{
+  return QDir::cleanPath(QDir::homePath() + "/.polyseg/python_probes.json");
 }
 
 QString PythonEnvironmentManager::GetVenvPath(const QString& project_dir)
@@ -182,127 +319,231 @@ bool PythonEnvironmentManager::HasProjectVenv(const QString& project_dir)
 
 void PythonEnvironmentManager::CreateProjectVenv(const QString& project_dir)
 {
+  const QString venv_path = GetVenvPath(project_dir);
+  current_venv_path_ = venv_path;
   if (!python_info_.is_valid)
   {
-    emit venvCreationFinished(false, QString(), "Python not detected. Run DetectPython() first.");
+    FinishVenvSteps(false, "Python not detected. Run DetectPython() first.");
     return;
   }
 
   if (!python_info_.has_venv)
   {
-    emit venvCreationFinished(false, QString(), "Python venv module is not available.");
+    FinishVenvSteps(false, "Python venv module is not available.");
     return;
   }
 
-  QString venv_path = GetVenvPath(project_dir);
-
+  QList<VenvStep> steps;
   if (HasProjectVenv(project_dir))
   {
     emit venvCreationProgress("Virtual environment already exists");
-    emit venvCreationFinished(true, venv_path, QString());
-    return;
+    // A former overlay was created --without-pip; an isolated venv needs its own
+    if (!QFile::exists(GetVenvPipPath(venv_path)))
+    {
+      steps.append(VenvStep::EnsurePip);
+    }
   }
+  else
+  {
+    steps.append(VenvStep::Create);
+    // The bundled pip is good enough when installs must not touch the network
+    if (!offline_install_)
+    {
+      steps.append(VenvStep::UpgradePip);
+    }
+  }
+  StartVenvSteps(python_info_.path, venv_path, QStringList(), steps);
+}
 
-  emit venvCreationProgress("Creating virtual environment...");
-  current_operation_ = OperationType::VenvCreation;
-  current_venv_path_ = venv_path;
+QString PythonEnvironmentManager::GetBaseEnvsDir()
+{
+  return QDir::cleanPath(QDir::homePath() + "/.polyseg/envs");
+}
 
-  QProcess process;
-  process.setProgram(python_info_.path);
-  process.setArguments({"-m", "venv", venv_path});
-  process.start();
+QString PythonEnvironmentManager::GetBaseEnvPath(const QString& plugin_id,
+                                                 const QString& requirements_file) const
+{
+  QFile file(requirements_file);
+  if (!python_info_.is_valid || !file.open(QIODevice::ReadOnly))
+  {
+    return QString();
+  }
 
-  if (!process.waitForFinished(120000))
+  // Site-packages only work with the Python version they were installed for
+  const QString hash =
+      QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha256).toHex().left(12);
+  return QDir(GetBaseEnvsDir())
+      .filePath(QString("%1-py%2%3-%4")
+                    .arg(plugin_id)
+                    .arg(python_info_.version_major)
+                    .arg(python_info_.version_minor)
+                    .arg(hash));
+}
+
+QString PythonEnvironmentManager::GetPluginRequirementsFile(const QString& plugin_id,
+                                                            const QString& project_dir)
+{
+  QFile registry(":/data/model_registry.json");
+  if (!registry.open(QIODevice::ReadOnly))
   {
-    emit venvCreationFinished(false, QString(), "Timeout creating virtual environment");
-    current_operation_ = OperationType::None;
-    return;
+    return QString();
   }
 
-  if (process.exitCode() != 0)
+  const QString requirements = QJsonDocument::fromJson(registry.readAll())
+                                   .object()["plugins"]
+                                   .toObject()[plugin_id]
+                                   .toObject()["requirements_file"]
+                                   .toString();
+  if (requirements.isEmpty() || QFileInfo(requirements).isAbsolute())
   {
-    QString error = process.readAllStandardError();
-    emit venvCreationFinished(false, QString(), QString("Failed to create venv: %1").arg(error));
-    current_operation_ = OperationType::None;
-    return;
+    return requirements;
   }
 
-  if (!HasProjectVenv(project_dir))
+  for (const QString& dir : {project_dir, QCoreApplication::applicationDirPath()})
+  {
+    const QString path = QDir(dir).filePath(requirements);
+    if (QFile::exists(path))
+    {
+      return path;
+    }
+  }
+  return QString();
+}
+
+bool PythonEnvironmentManager::CreateOverlayVenv(const QString& project_dir,
+                                                 const QString& base_env_path)
+{
+  const QString venv_path = GetVenvPath(project_dir);
+  const QStringList base_dirs = PythonPackageIndex::SitePackagesDirs(base_env_path);
+  if (base_dirs.isEmpty())
   {
     emit venvCreationFinished(false, QString(),
-                              "Virtual environment creation failed - python not found in venv");
-    current_operation_ = OperationType::None;
-    return;
+                              QString("Base environment not found: %1").arg(base_env_path));
+    return false;
+  }
+
+  if (!HasProjectVenv(project_dir))
+  {
+    emit venvCreationProgress("Creating overlay virtual environment...");
+    // The base's interpreter creates the overlay, so both run the same Python
+    const QString error =
+        CreateVenv(GetVenvPythonPath(base_env_path), venv_path, {"--without-pip"});
+    if (!error.isEmpty())
+    {
+      emit venvCreationFinished(false, QString(), error);
+      return false;
+    }
   }
 
-  emit venvCreationProgress("Upgrading pip...");
-  QString pip_path = GetVenvPipPath(venv_path);
-  QProcess pip_upgrade;
-  pip_upgrade.setProgram(pip_path);
-  pip_upgrade.setArguments({"install", "--upgrade", "pip"});
-  pip_upgrade.start();
-  pip_upgrade.waitForFinished(60000);
+  const QStringList overlay_dirs = PythonPackageIndex::SitePackagesDirs(venv_path);
+  if (overlay_dirs.isEmpty())
+  {
+    emit venvCreationFinished(false, QString(), "Overlay venv has no site-packages directory");
+    return false;
+  }
 
-  emit venvCreationProgress("Virtual environment created successfully");
+  QSaveFile pth(QDir(overlay_dirs.first()).filePath(PythonPackageIndex::OverlayPthFileName()));
+  if (!pth.open(QIODevice::WriteOnly | QIODevice::Text))
+  {
+    emit venvCreationFinished(false, QString(),
+                              QString("Cannot write %1").arg(pth.fileName()));
+    return false;
+  }
+  pth.write((base_dirs.join('\n') + '\n').toUtf8());
+  if (!pth.commit())
+  {
+    emit venvCreationFinished(false, QString(),
+                              QString("Cannot write %1").arg(pth.fileName()));
+    return false;
+  }
+
+  emit venvCreationProgress("Overlay virtual environment ready");
   emit venvCreationFinished(true, venv_path, QString());
-  current_operation_ = OperationType::None;
+  return true;
 }
 
-void PythonEnvironmentManager::InstallRequirements(const QString& requirements_file,
-                                                   const QString& venv_path)
+void PythonEnvironmentManager::PrepareProjectEnvironment(const QString& plugin_id,
+                                                         const QString& project_dir,
+                                                         bool isolated)
 {
-  if (!QFile::exists(requirements_file))
+  if (IsBusy())
   {
-    InstallationResult result;
-    result.success = false;
-    result.error_message = QString("Requirements file not found: %1").arg(requirements_file);
-    emit installationFinished(result);
+    emit environmentReady(false, QString(), "Another Python operation is in progress");
+    return;
+  }
+  if (!python_info_.is_valid)
+  {
+    emit environmentReady(false, QString(), "Python not detected. Run DetectPython() first.");
     return;
   }
 
-  emit installationProgress(
-      QString("Installing from %1...").arg(QFileInfo(requirements_file).fileName()), -1);
-
-  QString pip_path = GetPipPath(venv_path);
-  QStringList args = {"install", "-r", requirements_file};
-
-  QProcess process;
-  process.setProgram(pip_path);
-  process.setArguments(args);
-  process.start();
+  const QString requirements = GetPluginRequirementsFile(plugin_id, project_dir);
+  if (!isolated && requirements.isEmpty())
+  {
+    emit environmentReady(false, QString(),
+                          QString("No requirements file for plugin %1").arg(plugin_id));
+    return;
+  }
 
-  InstallationResult result;
+  // Each step runs in the background and continues from its finished handler
+  environment_project_ = project_dir;
+  environment_requirements_ = requirements;
+  environment_base_.clear();
+  environment_stage_ = EnvironmentStage::Venv;
 
-  if (!process.waitForFinished(600000))
+  if (isolated)
   {
-    result.success = false;
-    result.error_message = "Installation timeout (10 minutes)";
-    emit installationFinished(result);
+    // A former overlay would keep seeing the shared base's packages
+    for (const QString& site_dir : PythonPackageIndex::SitePackagesDirs(GetVenvPath(project_dir)))
+    {
+      QFile::remove(QDir(site_dir).filePath(PythonPackageIndex::OverlayPthFileName()));
+    }
+    CreateProjectVenv(project_dir);
     return;
   }
 
-  result.output = process.readAllStandardOutput();
-  QString stderr_output = process.readAllStandardError();
+  environment_base_ = GetBaseEnvPath(plugin_id, requirements);
+  if (!QFile::exists(GetVenvPythonPath(environment_base_)))
+  {
+    emit venvCreationProgress("Creating shared base environment...");
+    QDir().mkpath(GetBaseEnvsDir());
+    StartVenvSteps(python_info_.path, environment_base_, QStringList(), {VenvStep::Create});
+    return;
+  }
+  InstallEnvironmentRequirements();
+}
 
-  if (process.exitCode() != 0)
+void PythonEnvironmentManager::InstallEnvironmentRequirements()
+{
+  const QString target =
+      environment_base_.isEmpty() ? GetVenvPath(environment_project_) : environment_base_;
+  if (environment_requirements_.isEmpty() ||
+      RequirementsSatisfied(environment_requirements_, target))
   {
-    result.success = false;
-    result.error_message = stderr_output.isEmpty() ? "Installation failed" : stderr_output;
-    emit installationFinished(result);
+    CompleteEnvironment(true, QString());
     return;
   }
 
-  result.success = true;
+  environment_stage_ = EnvironmentStage::Requirements;
+  InstallRequirements(environment_requirements_, target);
+}
 
-  QRegularExpression installed_regex("Successfully installed (.+)");
-  QRegularExpressionMatch match = installed_regex.match(result.output);
-  if (match.hasMatch())
+void PythonEnvironmentManager::InstallRequirements(const QString& requirements_file,
+                                                   const QString& venv_path)
+{
+  if (!QFile::exists(requirements_file))
   {
-    result.installed_packages = match.captured(1).split(' ', Qt::SkipEmptyParts);
+    InstallationResult result;
+    result.success = false;
+    result.error_message = QString("Requirements file not found: %1").arg(requirements_file);
+    emit installationFinished(result);
+    return;
   }
 
-  emit installationProgress("Installation complete", 100);
-  emit installationFinished(result);
+  emit installationProgress(
+      QString("Installing from %1...").arg(QFileInfo(requirements_file).fileName()), -1);
+  current_requirements_file_ = requirements_file;
+  StartInstallation({"-r", requirements_file}, QStringList(), venv_path);
 }
 
 void PythonEnvironmentManager::InstallPackage(const QString& package_name, const QString& venv_path)
@@ -321,70 +562,74 @@ void PythonEnvironmentManager::InstallPackages(const QStringList& packages, cons
   }
 
   emit installationProgress(QString("Installing %1 package(s)...").arg(packages.size()), -1);
+  current_requirements_file_.clear();
+  StartInstallation(packages, packages, venv_path);
+}
 
-  QString pip_path = GetPipPath(venv_path);
-  QStringList args = {"install"};
-  args.append(packages);
-
-  QProcess process;
-  process.setProgram(pip_path);
-  process.setArguments(args);
-  process.start();
-
-  InstallationResult result;
-
-  if (!process.waitForFinished(600000))
+bool PythonEnvironmentManager::IsPackageInstalled(const QString& package_name,
+                                                  const QString& venv_path)
+{
+  const QStringList site_dirs = GetSitePackagesDirs(venv_path);
+  if (site_dirs.isEmpty())
   {
-    result.success = false;
-    result.error_message = "Installation timeout";
-    emit installationFinished(result);
-    return;
+    // Site directories of the system interpreter are known after detection
+    return IsPackageImportable(package_name, venv_path);
   }
 
-  result.output = process.readAllStandardOutput();
-  QString stderr_output = process.readAllStandardError();
-
-  if (process.exitCode() != 0)
-  {
-    result.success = false;
-    result.error_message = stderr_output.isEmpty() ? "Installation failed" : stderr_output;
-
-    for (const QString& pkg : packages)
-    {
-      if (stderr_output.contains(pkg, Qt::CaseInsensitive))
-      {
-        result.failed_packages.append(pkg);
-      }
-    }
-
-    emit installationFinished(result);
-    return;
-  }
-
-  result.success = true;
-  result.installed_packages = packages;
-
-  emit installationProgress("Installation complete", 100);
-  emit installationFinished(result);
+  PythonPackageIndex index;
+  index.Scan(site_dirs);
+  return index.Contains(package_name);
 }
 
-bool PythonEnvironmentManager::IsPackageInstalled(const QString& package_name,
-                                                  const QString& venv_path)
+bool PythonEnvironmentManager::IsPackageImportable(const QString& module_name,
+                                                   const QString& venv_path)
 {
   QString python_path = GetPythonPath(venv_path);
   QString output = RunPythonCommand(
-      python_path, {"-c", QString("import %1; print('OK')").arg(package_name)}, 10000);
+      python_path, {"-c", QString("import %1; print('OK')").arg(module_name)}, 10000);
   return output.trimmed() == "OK";
 }
 
 QStringList PythonEnvironmentManager::GetInstalledPackages(const QString& venv_path)
 {
-  QString output = RunPipCommand({"list", "--format=freeze"}, venv_path, 30000);
-  return output.split('\n', Qt::SkipEmptyParts);
+  PythonPackageIndex index;
+  index.Scan(GetSitePackagesDirs(venv_path));
+  return index.Packages();
+}
+
+QList<PythonPackageIndex::RequirementStatus> PythonEnvironmentManager::CheckRequirements(
+    const QString& requirements_file, const QString& venv_path)
+{
+  PythonPackageIndex index;
+  index.Scan(GetSitePackagesDirs(venv_path));
+  return index.CheckRequirementsFile(requirements_file);
 }
 
 bool PythonEnvironmentManager::VerifyPluginDependencies(const QString& plugin_id,
                                                         const QString& venv_path)
+{
+  QStringList packages;
+  if (plugin_id == "detectron2")
+  {
+    packages = {"torch", "detectron2"};
+  }
+  else if (plugin_id == "smp")
+  {
+    packages = {"torch", "segmentation-models-pytorch"};
+  }
+  else
+  {
+    return python_info_.is_valid;
+  }
+
+  PythonPackageIndex index;
+  index.Scan(GetSitePackagesDirs(venv_path));
+  return std::all_of(packages.begin(), packages.end(),
+                     [&index](const QString& package) { return index.Contains(package); });
+}
+
+bool PythonEnvironmentManager::DeepVerifyPluginDependencies(const QString& plugin_id,
+                                                            const QString& venv_path)
 {
   QString python_path = GetPythonPath(venv_path);
 
@@ -424,12 +669,15 @@ bool PythonEnvironmentManager::VerifyPluginDependencies(const QString& plugin_id
 
 void PythonEnvironmentManager::Cancel()
 {
+  current_operation_ = OperationType::None;
+  environment_stage_ = EnvironmentStage::None;
   if (current_process_ && current_process_->state() != QProcess::NotRunning)
   {
+    // A cancelled installation must not continue with its next step
+    current_process_->disconnect(this);
     current_process_->kill();
     current_process_->waitForFinished(5000);
   }
-  current_operation_ = OperationType::None;
 }
 
 bool PythonEnvironmentManager::IsBusy() const
@@ -439,17 +687,106 @@ bool PythonEnvironmentManager::IsBusy() const
 
 void PythonEnvironmentManager::OnProcessFinished(int exit_code, QProcess::ExitStatus exit_status)
 {
-  Q_UNUSED(exit_code)
-  Q_UNUSED(exit_status)
+  if (current_operation_ == OperationType::VenvCreation)
+  {
+    OnVenvStepFinished(exit_code, exit_status);
+    return;
+  }
+  if (current_operation_ != OperationType::Installation)
+  {
+    return;
+  }
+
+  OnProcessOutput();
+  if (!pip_output_buffer_.trimmed().isEmpty())
+  {
+    ReportPipOutput(pip_output_buffer_.trimmed());
+  }
+  pip_output_buffer_.clear();
+  const QString stderr_output = QString::fromUtf8(current_process_->readAllStandardError());
+
+  if (exit_status == QProcess::NormalExit && exit_code == 0)
+  {
+    if (install_step_ == InstallStep::BuildWheels)
+    {
+      RunInstallStep(InstallStep::InstallBuilt);
+      return;
+    }
+
+    install_result_.success = true;
+    static const QRegularExpression installed_regex("Successfully installed (.+)");
+    const QRegularExpressionMatch match = installed_regex.match(install_result_.output);
+    if (match.hasMatch())
+    {
+      install_result_.installed_packages = match.captured(1).split(' ', Qt::SkipEmptyParts);
+    }
+    emit installationProgress("Installation complete", 100);
+    FinishInstallation();
+    return;
+  }
+
+  if (install_step_ == InstallStep::FromWheelhouse && !offline_install_)
+  {
+    emit installationProgress("Wheelhouse incomplete, fetching missing packages...", -1);
+    RunInstallStep(InstallStep::BuildWheels);
+    return;
+  }
+
+  install_result_.success = false;
+  install_result_.error_message = stderr_output.isEmpty() ? "Installation failed" : stderr_output;
+  for (const QString& pkg : install_packages_)
+  {
+    if (stderr_output.contains(pkg, Qt::CaseInsensitive))
+    {
+      install_result_.failed_packages.append(pkg);
+    }
+  }
+  FinishInstallation();
 }
 
 void PythonEnvironmentManager::OnProcessError(QProcess::ProcessError error)
 {
-  Q_UNUSED(error)
+  // Other errors are followed by finished()
+  if (error != QProcess::FailedToStart)
+  {
+    return;
+  }
+  if (current_operation_ == OperationType::VenvCreation)
+  {
+    OnVenvStepFinished(-1, QProcess::CrashExit);
+    return;
+  }
+  if (current_operation_ != OperationType::Installation)
+  {
+    return;
+  }
+
+  install_result_.success = false;
+  install_result_.error_message =
+      QString("Failed to start pip: %1").arg(current_process_->errorString());
+  FinishInstallation();
 }
 
 void PythonEnvironmentManager::OnProcessOutput()
 {
+  // venv and ensurepip output is not progress worth showing
+  if (!current_process_ || current_operation_ != OperationType::Installation)
+  {
+    return;
+  }
+
+  pip_output_buffer_ += QString::fromUtf8(current_process_->readAllStandardOutput());
+  int newline = pip_output_buffer_.indexOf('\n');
+  while (newline >= 0)
+  {
+    const QString line = pip_output_buffer_.left(newline).trimmed();
+    pip_output_buffer_.remove(0, newline + 1);
+    if (!line.isEmpty())
+    {
+      ReportPipOutput(line);
+    }
+    newline = pip_output_buffer_.indexOf('\n');
+  }
 }
 
 QString PythonEnvironmentManager::RunPythonCommand(const QString& python_path,
@@ -497,7 +834,9 @@ void PythonEnvironmentManager::StartAsyncProcess(const QString& program, const Q
 {
   if (current_process_)
   {
-    delete current_process_;
+    // May run from a slot connected to the previous process
+    current_process_->disconnect(this);
+    current_process_->deleteLater();
   }
 
   current_process_ = new QProcess(this);
@@ -508,6 +847,7 @@ void PythonEnvironmentManager::StartAsyncProcess(const QString& program, const Q
   connect(current_process_, &QProcess::readyReadStandardOutput, this,
           &PythonEnvironmentManager::OnProcessOutput);
 
+  current_process_->setProcessEnvironment(GetPipEnvironment());
   current_process_->setProgram(program);
   current_process_->setArguments(args);
   current_process_->start();
@@ -535,57 +875,459 @@ QString PythonEnvironmentManager::GetPythonPath(const QString& venv_path) const
   return GetVenvPythonPath(venv_path);
 }
 
-void PythonEnvironmentManager::ParsePythonVersion(const QString& version_string)
+QStringList PythonEnvironmentManager::GetSitePackagesDirs(const QString& venv_path) const
 {
-  QRegularExpression version_regex(R"(Python\s+(\d+)\.(\d+)\.?(\d*))");
-  QRegularExpressionMatch match = version_regex.match(version_string);
+  if (venv_path.isEmpty())
+  {
+    return python_info_.site_packages;
+  }
+  return PythonPackageIndex::SitePackagesDirs(venv_path);
+}
 
-  if (match.hasMatch())
+QString PythonEnvironmentManager::CreateVenv(const QString& python_path, const QString& venv_path,
+                                             const QStringList& options)
+{
+  QProcess process;
+  process.setProgram(python_path);
+  process.setArguments(QStringList{"-m", "venv"} + options + QStringList{venv_path});
+  process.start();
+
+  if (!process.waitForFinished(120000))
   {
-    python_info_.version_major = match.captured(1).toInt();
-    python_info_.version_minor = match.captured(2).toInt();
-    int patch = match.captured(3).isEmpty() ? 0 : match.captured(3).toInt();
-    python_info_.version =
-        QString("%1.%2.%3").arg(python_info_.version_major).arg(python_info_.version_minor).arg(patch);
+    process.kill();
+    return "Timeout creating virtual environment";
   }
+
+  if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0)
+  {
+    QString error = process.readAllStandardError();
+    return QString("Failed to create venv: %1").arg(error);
+  }
+
+  if (!QFile::exists(GetVenvPythonPath(venv_path)))
+  {
+    return "Virtual environment creation failed - python not found in venv";
+  }
+  return QString();
 }
 
-bool PythonEnvironmentManager::CheckModuleAvailable(const QString& python_path,
-                                                    const QString& module_name)
+bool PythonEnvironmentManager::RequirementsSatisfied(const QString& requirements_file,
+                                                     const QString& venv_path) const
 {
-  QString output =
-      RunPythonCommand(python_path, {"-c", QString("import %1; print('OK')").arg(module_name)}, 5000);
-  return output.trimmed() == "OK";
+  PythonPackageIndex index;
+  index.Scan(PythonPackageIndex::SitePackagesDirs(venv_path));
+  const QList<PythonPackageIndex::RequirementStatus> statuses =
+      index.CheckRequirementsFile(requirements_file);
+  return std::all_of(statuses.begin(), statuses.end(),
+                     [](const PythonPackageIndex::RequirementStatus& status)
+                     { return status.satisfied; });
+}
+
+void PythonEnvironmentManager::CompleteEnvironment(bool success, const QString& error_message)
+{
+  if (!success)
+  {
+    environment_stage_ = EnvironmentStage::None;
+    emit environmentReady(false, QString(), error_message);
+    return;
+  }
+
+  if (!environment_base_.isEmpty() && !HasProjectVenv(environment_project_))
+  {
+    // The base's interpreter creates the overlay, so both run the same Python;
+    // CreateOverlayVenv() then only points it at the base
+    emit venvCreationProgress("Creating overlay virtual environment...");
+    environment_stage_ = EnvironmentStage::Overlay;
+    StartVenvSteps(GetVenvPythonPath(environment_base_), GetVenvPath(environment_project_),
+                   {"--without-pip"}, {VenvStep::Create});
+    return;
+  }
+
+  environment_stage_ = EnvironmentStage::None;
+  if (!environment_base_.isEmpty() && !CreateOverlayVenv(environment_project_, environment_base_))
+  {
+    emit environmentReady(false, QString(), "Failed to create the overlay venv");
+    return;
+  }
+  emit environmentReady(true, GetVenvPath(environment_project_), QString());
 }
 
-void PythonEnvironmentManager::DetectCudaSupport(const QString& python_path)
+void PythonEnvironmentManager::StartInstallation(const QStringList& targets,
+                                                 const QStringList& packages,
+                                                 const QString& venv_path)
 {
-  QString check_script =
-      "import sys\n"
-      "try:\n"
-      "    import torch\n"
-      "    print(f'TORCH:{torch.__version__}')\n"
-      "    if torch.cuda.is_available():\n"
-      "        print(f'CUDA:{torch.version.cuda}')\n"
-      "        print(f'GPU:{torch.cuda.get_device_name(0)}')\n"
-      "    else:\n"
-      "        print('CUDA:NONE')\n"
-      "except ImportError:\n"
-      "    print('TORCH:NONE')\n"
-      "    print('CUDA:NONE')\n";
+  if (IsBusy())
+  {
+    InstallationResult result;
+    result.success = false;
+    result.error_message = "Another Python operation is in progress";
+    emit installationFinished(result);
+    return;
+  }
+
+  current_operation_ = OperationType::Installation;
+  current_venv_path_ = venv_path;
+  install_targets_ = targets;
+  install_packages_ = packages;
+  install_result_ = InstallationResult();
+  install_result_.success = false;
+
+  QDir().mkpath(wheelhouse_dir_);
+  QDir().mkpath(pip_cache_dir_);
+
+  // An empty wheelhouse cannot satisfy anything; go to the network directly
+  const bool has_wheels = !QDir(wheelhouse_dir_).entryList({"*.whl"}, QDir::Files).isEmpty();
+  RunInstallStep(has_wheels || offline_install_ ? InstallStep::FromWheelhouse
+                                                : InstallStep::BuildWheels);
+}
+
+void PythonEnvironmentManager::RunInstallStep(InstallStep step)
+{
+  install_step_ = step;
+
+  QStringList args;
+  if (step == InstallStep::BuildWheels)
+  {
+    emit installationProgress("Downloading and building wheels...", -1);
+    args = {"wheel", "--wheel-dir", wheelhouse_dir_};
+  }
+  else
+  {
+    emit installationProgress("Installing from local wheelhouse...", -1);
+    args = {"install", "--no-index"};
+  }
+  args << "--find-links" << wheelhouse_dir_ << "--progress-bar" << "off";
+  args.append(install_targets_);
+
+  QString program = GetPipPath(current_venv_path_);
+  if (!current_venv_path_.isEmpty() && !QFile::exists(program))
+  {
+    // Overlay venvs have no pip of their own; the base's is on their path
+    program = GetVenvPythonPath(current_venv_path_);
+    args = QStringList{"-m", "pip"} + args;
+  }
+  StartAsyncProcess(program, args);
+}
 
-  QString output = RunPythonCommand(python_path, {"-c", check_script}, 15000);
+void PythonEnvironmentManager::ReportPipOutput(const QString& line)
+{
+  install_result_.output += line + '\n';
 
-  for (const QString& line : output.split('\n'))
+  // One message per package and stage; skip requirement and index chatter
+  static const QStringList kReportedPrefixes = {"Collecting ",   "Downloading ",
+                                                "Using cached ", "Processing ",
+                                                "Building wheel for ", "Saved "};
+  if (line.startsWith("Installing collected packages:"))
+  {
+    emit installationProgress(
+        QString("Installing %1...").arg(line.section(':', 1).trimmed()), 90);
+    return;
+  }
+  for (const QString& prefix : kReportedPrefixes)
   {
-    if (line.startsWith("TORCH:") && !line.contains("NONE"))
+    if (line.startsWith(prefix))
     {
-      python_info_.torch_version = line.mid(6).trimmed();
+      emit installationProgress(line, -1);
+      return;
     }
-    else if (line.startsWith("CUDA:") && !line.contains("NONE"))
+  }
+}
+
+QProcessEnvironment PythonEnvironmentManager::GetPipEnvironment() const
+{
+  // pip keeps downloads and built wheels in a cache shared by every venv
+  QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+  environment.insert("PIP_CACHE_DIR", pip_cache_dir_);
+  environment.insert("PIP_DISABLE_PIP_VERSION_CHECK", "1");
+  return environment;
+}
+
+void PythonEnvironmentManager::FinishInstallation()
+{
+  current_operation_ = OperationType::None;
+  emit installationFinished(install_result_);
+
+  if (environment_stage_ == EnvironmentStage::Requirements)
+  {
+    CompleteEnvironment(install_result_.success, install_result_.error_message);
+  }
+}
+
+void PythonEnvironmentManager::StartVenvSteps(const QString& python_path,
+                                              const QString& venv_path,
+                                              const QStringList& options,
+                                              const QList<VenvStep>& steps)
+{
+  current_venv_path_ = venv_path;
+  venv_python_ = python_path;
+  venv_options_ = options;
+  venv_steps_ = steps;
+  if (venv_steps_.isEmpty())
+  {
+    FinishVenvSteps(true, QString());
+    return;
+  }
+
+  current_operation_ = OperationType::VenvCreation;
+  RunVenvStep();
+}
+
+void PythonEnvironmentManager::RunVenvStep()
+{
+  venv_step_ = venv_steps_.takeFirst();
+  switch (venv_step_)
+  {
+    case VenvStep::Create:
+      emit venvCreationProgress("Creating virtual environment...");
+      StartAsyncProcess(venv_python_, QStringList{"-m", "venv"} + venv_options_ +
+                                          QStringList{current_venv_path_});
+      break;
+    case VenvStep::EnsurePip:
+      emit venvCreationProgress("Installing pip into the virtual environment...");
+      StartAsyncProcess(GetVenvPythonPath(current_venv_path_),
+                        {"-m", "ensurepip", "--upgrade"});
+      break;
+    case VenvStep::UpgradePip:
+      emit venvCreationProgress("Upgrading pip...");
+      StartAsyncProcess(GetVenvPipPath(current_venv_path_), {"install", "--upgrade", "pip"});
+      break;
+  }
+}
+
+void PythonEnvironmentManager::OnVenvStepFinished(int exit_code, QProcess::ExitStatus exit_status)
+{
+  current_process_->readAllStandardOutput();
+
+  if (venv_step_ != VenvStep::UpgradePip &&
+      (exit_status != QProcess::NormalExit || exit_code != 0))
+  {
+    QString error = QString::fromUtf8(current_process_->readAllStandardError()).trimmed();
+    if (error.isEmpty())
+    {
+      error = current_process_->errorString();
+    }
+    FinishVenvSteps(false, venv_step_ == VenvStep::Create
+                               ? QString("Failed to create venv: %1").arg(error)
+                               : QString("Failed to install pip: %1").arg(error));
+    return;
+  }
+  if (venv_step_ == VenvStep::Create && !QFile::exists(GetVenvPythonPath(current_venv_path_)))
+  {
+    FinishVenvSteps(false, "Virtual environment creation failed - python not found in venv");
+    return;
+  }
+
+  if (!venv_steps_.isEmpty())
+  {
+    RunVenvStep();
+    return;
+  }
+  FinishVenvSteps(true, QString());
+}
+
+void PythonEnvironmentManager::FinishVenvSteps(bool success, const QString& error_message)
+{
+  current_operation_ = OperationType::None;
+  venv_steps_.clear();
+  if (success)
+  {
+    emit venvCreationProgress("Virtual environment ready");
+  }
+  emit venvCreationFinished(success, success ? current_venv_path_ : QString(), error_message);
+
+  if (environment_stage_ == EnvironmentStage::None)
+  {
+    return;
+  }
+  if (!success)
+  {
+    CompleteEnvironment(false, error_message);
+  }
+  else if (environment_stage_ == EnvironmentStage::Overlay)
+  {
+    CompleteEnvironment(true, QString());
+  }
+  else
+  {
+    InstallEnvironmentRequirements();
+  }
+}
+
+void PythonEnvironmentManager::OnProbeFinished(QProcess* process, bool cacheable)
+{
+  for (PythonProbe& probe : probes_)
+  {
+    if (probe.process == process)
     {
-      python_info_.has_cuda = true;
-      python_info_.cuda_version = line.mid(5).trimmed();
+      probe.done = true;
+      probe.cacheable = cacheable;
+      if (cacheable && process->exitCode() == 0)
+      {
+        probe.output = QString::fromUtf8(process->readAllStandardOutput());
+      }
+      probe.process = nullptr;
+      process->deleteLater();
+      break;
     }
   }
+
+  // A probe failing to start while the others are launched is picked up after
+  if (!starting_probes_)
+  {
+    TryFinishDetection();
+  }
+}
+
+void PythonEnvironmentManager::OnProbeTimeout()
+{
+  for (PythonProbe& probe : probes_)
+  {
+    if (probe.process)
+    {
+      probe.process->disconnect(this);
+      probe.process->kill();
+      probe.process->deleteLater();
+      probe.process = nullptr;
+      probe.done = true;
+    }
+  }
+
+  TryFinishDetection();
+}
+
+bool PythonEnvironmentManager::TryFinishDetection()
+{
+  for (int i = 0; i < probes_.size(); ++i)
+  {
+    if (!probes_[i].done)
+    {
+      // A preferred candidate is still running
+      return false;
+    }
+    if (ParseProbeOutput(probes_[i].output).is_valid)
+    {
+      FinishDetection(i);
+      return true;
+    }
+  }
+
+  FinishDetection(-1);
+  return true;
+}
+
+void PythonEnvironmentManager::FinishDetection(int selected)
+{
+  python_info_ = PythonInfo();
+  if (selected >= 0)
+  {
+    python_info_ = ParseProbeOutput(probes_[selected].output);
+    if (python_info_.path.isEmpty())
+    {
+      python_info_.path = probes_[selected].executable;
+    }
+  }
+  detection_performed_ = true;
+
+  QJsonObject cache = LoadProbeCache();
+  bool cache_changed = false;
+  for (const PythonProbe& probe : probes_)
+  {
+    if (probe.cacheable)
+    {
+      QJsonObject entry;
+      entry["mtime"] = QString::number(probe.mtime);
+      entry["size"] = QString::number(probe.size);
+      entry["output"] = probe.output;
+      cache[probe.executable] = entry;
+      cache_changed = true;
+    }
+  }
+  if (cache_changed)
+  {
+    SaveProbeCache(cache);
+  }
+
+  // Lower-priority candidates still running are not needed any more
+  StopProbes();
+
+  emit detectionProgress(python_info_.is_valid ? "Detection complete" : "Python not found");
+  emit detectionFinished(python_info_);
+}
+
+void PythonEnvironmentManager::StopProbes()
+{
+  probe_timer_->stop();
+  for (PythonProbe& probe : probes_)
+  {
+    if (probe.process)
+    {
+      probe.process->disconnect(this);
+      probe.process->kill();
+      probe.process->deleteLater();
+    }
+  }
+  probes_.clear();
+}
+
+PythonInfo PythonEnvironmentManager::ParseProbeOutput(const QString& output)
+{
+  PythonInfo info;
+  for (const QString& line : output.split('\n', Qt::SkipEmptyParts))
+  {
+    const int colon = line.indexOf(':');
+    if (colon < 0)
+    {
+      continue;
+    }
+    const QString key = line.left(colon);
+    const QString value = line.mid(colon + 1).trimmed();
+
+    if (key == "VERSION")
+    {
+      const QStringList parts = value.split('.');
+      if (parts.size() >= 2)
+      {
+        info.version = value;
+        info.version_major = parts[0].toInt();
+        info.version_minor = parts[1].toInt();
+      }
+    }
+    else if (key == "EXECUTABLE")
+    {
+      info.path = value;
+    }
+    else if (key == "VENV")
+    {
+      info.has_venv = value == "1";
+    }
+    else if (key == "PIP")
+    {
+      info.has_pip = value == "1";
+    }
+    else if (key == "SITE")
+    {
+      info.site_packages.append(value);
+    }
+    else if (key == "TORCH")
+    {
+      info.torch_version = value;
+    }
+    else if (key == "CUDA")
+    {
+      // torch.version.cuda is None on ROCm builds
+      info.has_cuda = true;
+      info.cuda_version = value == "None" ? QString() : value;
+    }
+    else if (key == "GPU")
+    {
+      info.gpu_name = value;
+    }
+    else if (key == "MPS")
+    {
+      info.has_mps = value == "1";
+    }
+  }
+
+  info.is_valid = info.version_major >= 3;
+  return info;
 }
@@ -1,26 +1,34 @@
 #ifndef PYTHONENVIRONMENTMANAGER_H
 #define PYTHONENVIRONMENTMANAGER_H
 
+#include <QList>
 #include <QObject>
 #include <QProcess>
 #include <QString>
 #include <QStringList>
 
+#include "pythonpackageindex.h"
+
+class QTimer;
+
 /**
  * @brief Information about the detected Python environment
  */
 struct PythonInfo
 {
-  QString path;           // Full path to python executable (e.g., /usr/bin/python3)
-  QString version;        // Python version string (e.g., "3.11.2")
-  int version_major;      // Major version number (e.g., 3)
-  int version_minor;      // Minor version number (e.g., 11)
-  bool has_venv;          // Whether venv module is available
-  bool has_pip;           // Whether pip is available
-  bool has_cuda;          // Whether CUDA is available via PyTorch
-  QString cuda_version;   // CUDA version if available
-  QString torch_version;  // PyTorch version if installed
-  bool is_valid;          // Whether Python was successfully detected
+  QString path;               // Full path to python executable (e.g., /usr/bin/python3)
+  QString version;            // Python version string (e.g., "3.11.2")
+  int version_major;          // Major version number (e.g., 3)
+  int version_minor;          // Minor version number (e.g., 11)
+  bool has_venv;              // Whether venv module is available
+  bool has_pip;               // Whether pip is available
+  bool has_cuda;              // Whether CUDA is available via PyTorch
+  QString cuda_version;       // CUDA version if available
+  QString gpu_name;           // Name of the first CUDA device if available
+  bool has_mps;               // Whether Apple Silicon MPS is available via PyTorch
+  QString torch_version;      // PyTorch version if installed
+  QStringList site_packages;  // site-packages directories, including the user site
+  bool is_valid;              // Whether Python was successfully detected
 
   PythonInfo();
   QString GetDisplayString() const;
@@ -59,12 +67,37 @@ class PythonEnvironmentManager : public QObject
 
   /**
    * @brief Detect the system Python installation
+   * @param refresh Probe every interpreter again instead of using cached results
    * @return PythonInfo struct with detected information
    *
    * Checks for python3 first, then python. Detects version, venv support,
-   * pip availability, and CUDA support.
+   * pip availability, and CUDA support. All candidates are probed in parallel
+   * with one script each; this call blocks until the probes are done.
+   */
+  PythonInfo DetectPython(bool refresh = false);
+
+  /**
+   * @brief Detect the system Python installation without blocking
+   * @param refresh Probe every interpreter again instead of using cached results
+   *
+   * Emits detectionFinished once the preferred candidate has been probed;
+   * with a warm cache that happens before this call returns. A detection
+   * already running is restarted.
    */
-  PythonInfo DetectPython();
+  void DetectPythonAsync(bool refresh = false);
+
+  /**
+   * @brief Interpreters to probe, in order of preference
+   *
+   * Names without a directory are looked up in PATH.
+   */
+  static QStringList DefaultPythonCandidates();
+  void SetPythonCandidates(const QStringList& candidates);
+
+  /**
+   * @brief File caching probe results by interpreter path and modification time
+   */
+  static QString GetProbeCachePath();
 
   /**
    * @brief Get the last detected Python info
@@ -117,18 +150,71 @@ class PythonEnvironmentManager : public QObject
    * @brief Create a virtual environment for a project
    * @param project_dir Project directory path
    *
-   * Emits venvCreationProgress and venvCreationFinished signals.
-   * Creates .venv subdirectory with isolated Python environment.
+   * Returns immediately. Emits venvCreationProgress and venvCreationFinished
+   * signals. Creates .venv subdirectory with isolated Python environment; an
+   * existing venv without pip of its own (a former overlay) gets one.
    */
   void CreateProjectVenv(const QString& project_dir);
 
+  /**
+   * @brief Directory holding the shared base environments (~/.polyseg/envs)
+   */
+  static QString GetBaseEnvsDir();
+
+  /**
+   * @brief Base environment of a plugin for the detected Python
+   * @return <envs>/<plugin_id>-py<major><minor>-<requirements hash>, empty if
+   *         Python is not detected or the requirements file cannot be read
+   *
+   * Editing the requirements gives a new base; projects keep the old one
+   * until they are prepared again.
+   */
+  QString GetBaseEnvPath(const QString& plugin_id, const QString& requirements_file) const;
+
+  /**
+   * @brief Requirements file that model_registry.json lists for a plugin
+   * @param project_dir Relative paths are resolved here, then in the application directory
+   * @return Path of the file, empty if the plugin has none or it is missing
+   */
+  static QString GetPluginRequirementsFile(const QString& plugin_id, const QString& project_dir);
+
+  /**
+   * @brief Create a project venv layered over a base environment
+   * @param project_dir Project directory path
+   * @param base_env_path Base environment from GetBaseEnvPath()
+   * @return true on success; also emits venvCreationFinished
+   *
+   * The overlay is created without pip and holds only the project's extras;
+   * a .pth file puts the base's site-packages on its path. An existing
+   * overlay is repointed to the given base.
+   */
+  bool CreateOverlayVenv(const QString& project_dir, const QString& base_env_path);
+
+  /**
+   * @brief Prepare the venv a project's plugin runs in
+   * @param plugin_id Registry plugin ("detectron2", "smp")
+   * @param project_dir Project directory path
+   * @param isolated A full venv in the project instead of the plugin's shared
+   *        base environment plus an overlay (!PluginConfig::use_shared_env)
+   *
+   * Installs the plugin's requirements where they are missing; a shared base
+   * is installed once for all projects. Emits environmentReady with the venv
+   * to activate, which is <project>/.venv either way.
+   */
+  void PrepareProjectEnvironment(const QString& plugin_id, const QString& project_dir,
+                                 bool isolated);
+
   /**
    * @brief Install packages from a requirements file
    * @param requirements_file Path to requirements.txt file
    * @param venv_path Optional venv path (uses system pip if empty)
    *
-   * Emits installationProgress during installation and
-   * installationFinished when complete.
+   * Returns immediately. Emits installationProgress for each line of pip
+   * output worth showing and installationFinished when complete.
+   *
+   * Packages come from the wheelhouse when it has them all. Otherwise pip
+   * downloads or builds the missing wheels into the wheelhouse (through the
+   * pip cache) and installs from there, so the next venv needs no network.
    */
   void InstallRequirements(const QString& requirements_file, const QString& venv_path = QString());
 
@@ -146,29 +232,83 @@ class PythonEnvironmentManager : public QObject
    */
   void InstallPackages(const QStringList& packages, const QString& venv_path = QString());
 
+  /**
+   * @brief Local wheel directory shared by all venvs on this workstation
+   *
+   * Defaults to the "python/wheelhouse_dir" setting, or ~/.polyseg/wheelhouse.
+   */
+  QString GetWheelhouseDir() const { return wheelhouse_dir_; }
+  void SetWheelhouseDir(const QString& dir) { wheelhouse_dir_ = dir; }
+
+  /**
+   * @brief pip's HTTP and wheel cache directory (PIP_CACHE_DIR)
+   *
+   * Defaults to the "python/pip_cache_dir" setting, or ~/.polyseg/pip-cache.
+   */
+  QString GetPipCacheDir() const { return pip_cache_dir_; }
+  void SetPipCacheDir(const QString& dir) { pip_cache_dir_ = dir; }
+
+  /**
+   * @brief Install only from the wheelhouse, never from the network
+   *
+   * Defaults to the "python/offline_install" setting.
+   */
+  bool IsOfflineInstall() const { return offline_install_; }
+  void SetOfflineInstall(bool offline) { offline_install_ = offline; }
+
   /**
    * @brief Check if a package is installed
-   * @param package_name Package name (without version specifier)
+   * @param package_name Distribution name (without version specifier)
    * @param venv_path Optional venv path
-   * @return true if package is importable
+   * @return true if the package's metadata is in site-packages
+   *
+   * Reads metadata only; no interpreter is started. Use IsPackageImportable()
+   * to check that the package actually loads.
    */
   bool IsPackageInstalled(const QString& package_name, const QString& venv_path = QString());
 
+  /**
+   * @brief Check that a module imports in the environment (starts Python)
+   * @param module_name Module name as used in an import statement
+   * @param venv_path Optional venv path
+   */
+  bool IsPackageImportable(const QString& module_name, const QString& venv_path = QString());
+
   /**
    * @brief Get list of installed packages
    * @param venv_path Optional venv path
-   * @return List of "package==version" strings
+   * @return List of "package==version" strings, read from metadata
    */
   QStringList GetInstalledPackages(const QString& venv_path = QString());
 
+  /**
+   * @brief Check a requirements file against the installed packages
+   * @param requirements_file Path to requirements.txt file
+   * @param venv_path Optional venv path
+   * @return One status per requirement, with the installed version
+   */
+  QList<PythonPackageIndex::RequirementStatus> CheckRequirements(
+      const QString& requirements_file, const QString& venv_path = QString());
+
   /**
    * @brief Verify that a plugin's dependencies are installed
    * @param plugin_id Plugin identifier (e.g., "detectron2", "smp")
    * @param venv_path Optional venv path
-   * @return true if plugin can be imported
+   * @return true if the plugin's packages are installed
+   *
+   * Reads metadata only; DeepVerifyPluginDependencies() imports the plugin.
    */
   bool VerifyPluginDependencies(const QString& plugin_id, const QString& venv_path = QString());
 
+  /**
+   * @brief Verify that a plugin can be imported (starts Python, takes seconds)
+   * @param plugin_id Plugin identifier (e.g., "detectron2", "smp")
+   * @param venv_path Optional venv path
+   * @return true if plugin can be imported
+   */
+  bool DeepVerifyPluginDependencies(const QString& plugin_id,
+                                    const QString& venv_path = QString());
+
   /**
    * @brief Cancel any running operation
    */
@@ -207,6 +347,14 @@ class PythonEnvironmentManager : public QObject
    */
   void venvCreationFinished(bool success, const QString& venv_path, const QString& error_message);
 
+  /**
+   * @brief Emitted when PrepareProjectEnvironment() is complete
+   * @param success true if the venv is ready to use
+   * @param venv_path Project venv to activate (empty on failure)
+   * @param error_message Error description if failed
+   */
+  void environmentReady(bool success, const QString& venv_path, const QString& error_message);
+
   /**
    * @brief Emitted during pip installation
    * @param message Progress message (package being installed, etc.)
@@ -238,14 +386,42 @@ class PythonEnvironmentManager : public QObject
   void StartAsyncProcess(const QString& program, const QStringList& args);
   QString GetPipPath(const QString& venv_path = QString()) const;
   QString GetPythonPath(const QString& venv_path = QString()) const;
-  void ParsePythonVersion(const QString& version_string);
-  bool CheckModuleAvailable(const QString& python_path, const QString& module_name);
-  void DetectCudaSupport(const QString& python_path);
+  QStringList GetSitePackagesDirs(const QString& venv_path = QString()) const;
+  QString CreateVenv(const QString& python_path, const QString& venv_path,
+                     const QStringList& options = QStringList());
+  bool RequirementsSatisfied(const QString& requirements_file, const QString& venv_path) const;
+  void CompleteEnvironment(bool success, const QString& error_message);
+
+  /**
+   * @brief Probe of one candidate interpreter
+   */
+  struct PythonProbe
+  {
+    QString executable;  // Absolute path of the interpreter
+    qint64 mtime = 0;
+    qint64 size = 0;
+    QProcess* process = nullptr;
+    bool done = false;
+    bool cacheable = false;  // Finished normally; timeouts are not cached
+    QString output;          // Probe script output, empty if the interpreter failed
+  };
+
+  void OnProbeFinished(QProcess* process, bool cacheable);
+  void OnProbeTimeout();
+  bool TryFinishDetection();
+  void FinishDetection(int selected);
+  void StopProbes();
+  static PythonInfo ParseProbeOutput(const QString& output);
 
   PythonInfo python_info_;
   bool detection_performed_;
   QProcess* current_process_;
 
+  QStringList python_candidates_;
+  QList<PythonProbe> probes_;
+  QTimer* probe_timer_;
+  bool starting_probes_;
+
   enum class OperationType
   {
     None,
@@ -256,6 +432,69 @@ class PythonEnvironmentManager : public QObject
   OperationType current_operation_;
   QString current_venv_path_;
   QString current_requirements_file_;
+
+  /**
+   * @brief Stages of an installation, each one pip run
+   */
+  enum class InstallStep
+  {
+    FromWheelhouse,  // Install without network access
+    BuildWheels,     // Download or build missing wheels into the wheelhouse
+    InstallBuilt     // Install from the completed wheelhouse
+  };
+
+  void StartInstallation(const QStringList& targets, const QStringList& packages,
+                         const QString& venv_path);
+  void RunInstallStep(InstallStep step);
+  void ReportPipOutput(const QString& line);
+  QProcessEnvironment GetPipEnvironment() const;
+  void FinishInstallation();
+
+  /**
+   * @brief Stages of creating a venv, each one process run
+   */
+  enum class VenvStep
+  {
+    Create,     // python -m venv
+    EnsurePip,  // Give a venv without pip its own
+    UpgradePip  // Best effort; the bundled pip still works
+  };
+
+  void StartVenvSteps(const QString& python_path, const QString& venv_path,
+                      const QStringList& options, const QList<VenvStep>& steps);
+  void RunVenvStep();
+  void OnVenvStepFinished(int exit_code, QProcess::ExitStatus exit_status);
+  void FinishVenvSteps(bool success, const QString& error_message);
+  void InstallEnvironmentRequirements();
+
+  QString wheelhouse_dir_;
+  QString pip_cache_dir_;
+  bool offline_install_;
+  QStringList install_targets_;   // pip arguments naming what to install
+  QStringList install_packages_;  // Requested packages, empty for a requirements file
+  InstallStep install_step_;
+  QString pip_output_buffer_;  // Incomplete last line of pip output
+  InstallationResult install_result_;
+
+  QString venv_python_;         // Interpreter creating the venv
+  QStringList venv_options_;    // Extra python -m venv options
+  QList<VenvStep> venv_steps_;  // Still to run after venv_step_
+  VenvStep venv_step_;
+
+  /**
+   * @brief What PrepareProjectEnvironment() is waiting for
+   */
+  enum class EnvironmentStage
+  {
+    None,          // Not preparing
+    Venv,          // Project venv (isolated) or shared base
+    Requirements,  // Installation into that venv
+    Overlay        // Overlay venv over the base
+  };
+  EnvironmentStage environment_stage_;
+  QString environment_base_;  // Base to overlay the project onto, empty when isolated
+  QString environment_project_;
+  QString environment_requirements_;
 };
 
 #endif  // PYTHONENVIRONMENTMANAGER_H
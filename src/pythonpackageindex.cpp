@@ -0,0 +1,490 @@
+#include "pythonpackageindex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QTextStream>
+
+#include <limits>
+
+namespace
+{
+// Includes nested deeper than this are assumed to be a cycle
+constexpr int kMaxRequirementsDepth = 8;
+
+/**
+ * @brief Comparable form of a PEP 440 version
+ */
+struct VersionKey
+{
+  bool valid = false;
+  qint64 epoch = 0;
+  QList<qint64> release;
+  int pre_phase = 4;  // 0 dev release only, 1 alpha, 2 beta, 3 rc, 4 final
+  qint64 pre_number = 0;
+  qint64 post = -1;   // -1 without a post release
+  qint64 dev = std::numeric_limits<qint64>::max();  // Max without a dev release
+};
+
+VersionKey ParseVersion(const QString& version)
+{
+  static const QRegularExpression version_regex(
+      R"(^v?(?:(\d+)!)?(\d+(?:\.\d+)*))"
+      R"((?:[-_.]?(a|alpha|b|beta|c|rc|pre|preview)[-_.]?(\d*))?)"
+      R"((?:-(\d+)|[-_.]?(post|rev|r)[-_.]?(\d*))?)"
+      R"((?:[-_.]?(dev)[-_.]?(\d*))?)"
+      R"((?:\+[a-z0-9._]*)?$)",
+      QRegularExpression::CaseInsensitiveOption);
+
+  VersionKey key;
+  const QRegularExpressionMatch match = version_regex.match(version.trimmed());
+  if (!match.hasMatch())
+  {
+    return key;
+  }
+
+  key.valid = true;
+  key.epoch = match.captured(1).toLongLong();
+  for (const QString& part : match.captured(2).split('.'))
+  {
+    key.release.append(part.toLongLong());
+  }
+
+  const QString pre_label = match.captured(3).toLower();
+  if (!pre_label.isEmpty())
+  {
+    if (pre_label.startsWith('a'))
+    {
+      key.pre_phase = 1;
+    }
+    else if (pre_label.startsWith('b'))
+    {
+      key.pre_phase = 2;
+    }
+    else
+    {
+      key.pre_phase = 3;
+    }
+    key.pre_number = match.captured(4).toLongLong();
+  }
+
+  if (!match.captured(5).isEmpty())
+  {
+    key.post = match.captured(5).toLongLong();
+  }
+  else if (!match.captured(6).isEmpty())
+  {
+    key.post = match.captured(7).toLongLong();
+  }
+
+  if (!match.captured(8).isEmpty())
+  {
+    key.dev = match.captured(9).toLongLong();
+    // 1.0.dev1 sorts before 1.0a1
+    if (pre_label.isEmpty() && key.post < 0)
+    {
+      key.pre_phase = 0;
+    }
+  }
+  return key;
+}
+
+int CompareReleases(const QList<qint64>& a, const QList<qint64>& b)
+{
+  const int count = qMax(a.size(), b.size());
+  for (int i = 0; i < count; ++i)
+  {
+    const qint64 left = i < a.size() ? a[i] : 0;
+    const qint64 right = i < b.size() ? b[i] : 0;
+    if (left != right)
+    {
+      return left < right ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Whether the release of a version starts with a prefix (for "==1.2.*")
+ */
+bool MatchesPrefix(const QString& version, const QString& prefix)
+{
+  const VersionKey key = ParseVersion(version);
+  const VersionKey prefix_key = ParseVersion(prefix);
+  if (!key.valid || !prefix_key.valid || key.epoch != prefix_key.epoch)
+  {
+    return false;
+  }
+  for (int i = 0; i < prefix_key.release.size(); ++i)
+  {
+    const qint64 part = i < key.release.size() ? key.release[i] : 0;
+    if (part != prefix_key.release[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SatisfiesClause(const QString& version, const QString& clause)
+{
+  static const QRegularExpression clause_regex(R"(^(~=|===|==|!=|<=|>=|<|>)\s*(\S+)$)");
+  const QRegularExpressionMatch match = clause_regex.match(clause);
+  if (!match.hasMatch())
+  {
+    return false;
+  }
+
+  const QString op = match.captured(1);
+  const QString target = match.captured(2);
+
+  if (op == "===")
+  {
+    return version == target;
+  }
+  if (op == "==" || op == "!=")
+  {
+    const bool equal = target.endsWith(".*")
+                           ? MatchesPrefix(version, target.chopped(2))
+                           : PythonPackageIndex::CompareVersions(version, target) == 0;
+    return op == "==" ? equal : !equal;
+  }
+
+  const int order = PythonPackageIndex::CompareVersions(version, target);
+  if (op == "~=")
+  {
+    // ~=1.4.2 means >=1.4.2 and ==1.4.*
+    const VersionKey target_key = ParseVersion(target);
+    if (!target_key.valid || target_key.release.size() < 2)
+    {
+      return false;
+    }
+    QStringList prefix;
+    for (int i = 0; i + 1 < target_key.release.size(); ++i)
+    {
+      prefix.append(QString::number(target_key.release[i]));
+    }
+    return order >= 0 && MatchesPrefix(version, prefix.join('.'));
+  }
+  if (op == "<=")
+  {
+    return order <= 0;
+  }
+  if (op == ">=")
+  {
+    return order >= 0;
+  }
+  if (op == "<")
+  {
+    return order < 0;
+  }
+  return order > 0;
+}
+
+/**
+ * @brief Name and version headers of a METADATA or PKG-INFO file
+ */
+PythonPackageIndex::Package ReadMetadata(const QString& metadata_path)
+{
+  PythonPackageIndex::Package package;
+  QFile file(metadata_path);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    return package;
+  }
+
+  // Headers end at the first blank line; the description can be large
+  while (!file.atEnd())
+  {
+    const QString line = QString::fromUtf8(file.readLine()).trimmed();
+    if (line.isEmpty())
+    {
+      break;
+    }
+    if (line.startsWith("Name:", Qt::CaseInsensitive))
+    {
+      package.name = line.mid(5).trimmed();
+    }
+    else if (line.startsWith("Version:", Qt::CaseInsensitive))
+    {
+      package.version = line.mid(8).trimmed();
+    }
+    if (!package.name.isEmpty() && !package.version.isEmpty())
+    {
+      break;
+    }
+  }
+  return package;
+}
+}  // namespace
+
+QStringList PythonPackageIndex::SitePackagesDirs(const QString& venv_path)
+{
+  QStringList dirs;
+#ifdef Q_OS_WIN
+  const QString site_dir = QDir(venv_path).filePath("Lib/site-packages");
+  if (QFileInfo(site_dir).isDir())
+  {
+    dirs.append(site_dir);
+  }
+#else
+  // lib64 is usually a symlink to lib
+  QStringList canonical_dirs;
+  for (const QString& lib : {QString("lib"), QString("lib64")})
+  {
+    const QDir lib_dir(QDir(venv_path).filePath(lib));
+    for (const QString& python_dir :
+         lib_dir.entryList({"python*"}, QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name))
+    {
+      const QFileInfo site_info(lib_dir.filePath(python_dir + "/site-packages"));
+      if (site_info.isDir() && !canonical_dirs.contains(site_info.canonicalFilePath()))
+      {
+        canonical_dirs.append(site_info.canonicalFilePath());
+        dirs.append(site_info.filePath());
+      }
+    }
+  }
+#endif
+
+  // Python adds the directories in the .pth to sys.path after the venv's own
+  const QStringList own_dirs = dirs;
+  for (const QString& site_dir : own_dirs)
+  {
+    QFile pth(QDir(site_dir).filePath(OverlayPthFileName()));
+    if (!pth.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+      continue;
+    }
+    for (const QString& line : QString::fromUtf8(pth.readAll()).split('\n', Qt::SkipEmptyParts))
+    {
+      const QString base_dir = line.trimmed();
+      if (QFileInfo(base_dir).isDir() && !dirs.contains(base_dir))
+      {
+        dirs.append(base_dir);
+      }
+    }
+  }
+  return dirs;
+}
+
+QString PythonPackageIndex::OverlayPthFileName()
+{
+  return "polyseg-base.pth";
+}
+
+void PythonPackageIndex::Scan(const QStringList& site_dirs)
+{
+  packages_.clear();
+  for (const QString& site_dir : site_dirs)
+  {
+    const QFileInfoList entries =
+        QDir(site_dir).entryInfoList({"*.dist-info", "*.egg-info"},
+                                     QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+    for (const QFileInfo& entry : entries)
+    {
+      const bool dist_info = entry.fileName().endsWith(".dist-info");
+      QString metadata_path = entry.filePath();
+      if (entry.isDir())
+      {
+        metadata_path += dist_info ? "/METADATA" : "/PKG-INFO";
+      }
+
+      Package package = ReadMetadata(metadata_path);
+      if (package.name.isEmpty())
+      {
+        // The directory is named <name>-<version>.dist-info
+        const QString stem = entry.fileName().section('.', 0, -2);
+        package.name = stem.section('-', 0, 0);
+        if (package.version.isEmpty())
+        {
+          package.version = stem.section('-', 1, 1);
+        }
+      }
+      package.location = entry.filePath();
+
+      const QString key = NormalizeName(package.name);
+      if (!key.isEmpty() && !packages_.contains(key))
+      {
+        packages_.insert(key, package);
+      }
+    }
+  }
+}
+
+bool PythonPackageIndex::Contains(const QString& name) const
+{
+  return packages_.contains(NormalizeName(name));
+}
+
+QString PythonPackageIndex::Version(const QString& name) const
+{
+  return packages_.value(NormalizeName(name)).version;
+}
+
+QStringList PythonPackageIndex::Packages() const
+{
+  QStringList packages;
+  for (const Package& package : packages_)
+  {
+    packages.append(package.name + "==" + package.version);
+  }
+  return packages;
+}
+
+QList<PythonPackageIndex::RequirementStatus> PythonPackageIndex::CheckRequirements(
+    const QStringList& requirements) const
+{
+  static const QRegularExpression requirement_regex(
+      R"(^([A-Za-z0-9][A-Za-z0-9._-]*)\s*(?:\[[^\]]*\])?\s*(.*)$)");
+  static const QRegularExpression comment_regex(R"((^|\s)#)");
+
+  QList<RequirementStatus> statuses;
+  for (const QString& raw_line : requirements)
+  {
+    QString line = raw_line;
+    const int comment = line.indexOf(comment_regex);
+    if (comment >= 0)
+    {
+      line.truncate(comment);
+    }
+    line = line.section(';', 0, 0).trimmed();
+
+    // Options and bare URLs or paths do not name a distribution
+    if (line.isEmpty() || line.startsWith('-') ||
+        (line.contains("://") && !line.contains(" @ ")))
+    {
+      continue;
+    }
+
+    const QRegularExpressionMatch match = requirement_regex.match(line);
+    if (!match.hasMatch())
+    {
+      continue;
+    }
+
+    RequirementStatus status;
+    status.requirement = line;
+    status.name = match.captured(1);
+    status.installed_version = Version(status.name);
+
+    QString specifier = match.captured(2).trimmed();
+    if (specifier.startsWith('@'))
+    {
+      // Direct reference: any installed version will do
+      specifier.clear();
+    }
+    if (specifier.startsWith('(') && specifier.endsWith(')'))
+    {
+      specifier = specifier.mid(1, specifier.size() - 2);
+    }
+    status.specifier = specifier.remove(' ');
+
+    status.satisfied = Contains(status.name) &&
+                       (status.specifier.isEmpty() ||
+                        SatisfiesSpecifier(status.installed_version, status.specifier));
+    statuses.append(status);
+  }
+  return statuses;
+}
+
+QList<PythonPackageIndex::RequirementStatus> PythonPackageIndex::CheckRequirementsFile(
+    const QString& requirements_file) const
+{
+  return CheckRequirements(ReadRequirementLines(requirements_file, 0));
+}
+
+QString PythonPackageIndex::NormalizeName(const QString& name)
+{
+  static const QRegularExpression separators("[-_.]+");
+  return name.trimmed().toLower().replace(separators, "-");
+}
+
+int PythonPackageIndex::CompareVersions(const QString& a, const QString& b)
+{
+  const VersionKey left = ParseVersion(a);
+  const VersionKey right = ParseVersion(b);
+  if (!left.valid || !right.valid)
+  {
+    return QString::compare(a, b);
+  }
+
+  if (left.epoch != right.epoch)
+  {
+    return left.epoch < right.epoch ? -1 : 1;
+  }
+  const int release_order = CompareReleases(left.release, right.release);
+  if (release_order != 0)
+  {
+    return release_order;
+  }
+
+  const auto compare = [](qint64 x, qint64 y) { return x == y ? 0 : (x < y ? -1 : 1); };
+  if (left.pre_phase != right.pre_phase)
+  {
+    return compare(left.pre_phase, right.pre_phase);
+  }
+  if (left.pre_number != right.pre_number)
+  {
+    return compare(left.pre_number, right.pre_number);
+  }
+  if (left.post != right.post)
+  {
+    return compare(left.post, right.post);
+  }
+  return compare(left.dev, right.dev);
+}
+
+bool PythonPackageIndex::SatisfiesSpecifier(const QString& version, const QString& specifier)
+{
+  for (const QString& clause : specifier.split(',', Qt::SkipEmptyParts))
+  {
+    if (!SatisfiesClause(version, clause.trimmed()))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+QStringList PythonPackageIndex::ReadRequirementLines(const QString& requirements_file, int depth)
+{
+  QFile file(requirements_file);
+  if (depth > kMaxRequirementsDepth || !file.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    return QStringList();
+  }
+
+  static const QRegularExpression include_regex(R"(^(?:-r|--requirement)(?:\s+|=)(\S+))");
+
+  QStringList lines;
+  QString pending;
+  QTextStream stream(&file);
+  while (!stream.atEnd())
+  {
+    QString line = stream.readLine();
+    // A trailing backslash continues the line
+    if (line.endsWith('\\'))
+    {
+      pending += line.chopped(1);
+      continue;
+    }
+    line = (pending + line).trimmed();
+    pending.clear();
+
+    const QRegularExpressionMatch include = include_regex.match(line);
+    if (include.hasMatch())
+    {
+      const QString included =
+          QFileInfo(requirements_file).dir().filePath(include.captured(1));
+      lines.append(ReadRequirementLines(included, depth + 1));
+      continue;
+    }
+    lines.append(line);
+  }
+  if (!pending.isEmpty())
+  {
+    lines.append(pending.trimmed());
+  }
+  return lines;
+}
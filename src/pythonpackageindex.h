@@ -0,0 +1,117 @@
+#ifndef PYTHONPACKAGEINDEX_H
+#define PYTHONPACKAGEINDEX_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Installed Python distributions read from site-packages metadata
+ *
+ * Checking a dependency by importing it starts an interpreter and loads the
+ * package (seconds for torch); asking pip does the same. Installers record every
+ * distribution in a *.dist-info directory (or *.egg-info for legacy installs)
+ * whose METADATA headers carry the name and version, so reading those is enough
+ * to answer "is it installed, and which version" in milliseconds.
+ *
+ * Handles:
+ * - Scanning site-packages directories of a venv or interpreter
+ * - Name normalization (PEP 503: case, '-', '_' and '.' are equivalent)
+ * - Checking requirement lines and requirements files against the scan
+ *
+ * Presence of metadata does not prove the package imports (e.g. missing shared
+ * libraries); use PythonEnvironmentManager's deep verification for that.
+ */
+class PythonPackageIndex
+{
+ public:
+  struct Package
+  {
+    QString name;      // Name as declared in the metadata
+    QString version;
+    QString location;  // The .dist-info or .egg-info path
+  };
+
+  /**
+   * @brief A requirement line and whether the scanned packages satisfy it
+   */
+  struct RequirementStatus
+  {
+    QString requirement;        // Line as written, without comment or marker
+    QString name;               // Distribution name
+    QString specifier;          // e.g. ">=2.0,<3", empty for any version
+    QString installed_version;  // Empty if not installed
+    bool satisfied = false;
+  };
+
+  /**
+   * @brief site-packages directories of a virtual environment
+   *
+   * For an overlay venv the base environment's directories follow its own,
+   * as listed in the overlay's OverlayPthFileName() file.
+   */
+  static QStringList SitePackagesDirs(const QString& venv_path);
+
+  /**
+   * @brief .pth file chaining an overlay venv to its base environment
+   */
+  static QString OverlayPthFileName();
+
+  /**
+   * @brief Read the metadata of every distribution in the given directories
+   *
+   * Earlier directories take precedence, as on sys.path.
+   */
+  void Scan(const QStringList& site_dirs);
+
+  bool Contains(const QString& name) const;
+
+  /**
+   * @brief Installed version of a distribution, empty if not installed
+   */
+  QString Version(const QString& name) const;
+
+  /**
+   * @brief Installed distributions as "name==version", sorted by name
+   */
+  QStringList Packages() const;
+
+  /**
+   * @brief Check requirement lines (requirements.txt syntax)
+   *
+   * Comments, options and environment markers are ignored; direct references
+   * ("name @ url") only check that the name is installed.
+   */
+  QList<RequirementStatus> CheckRequirements(const QStringList& requirements) const;
+
+  /**
+   * @brief Check a requirements file, following -r includes
+   */
+  QList<RequirementStatus> CheckRequirementsFile(const QString& requirements_file) const;
+
+  /**
+   * @brief Normalized distribution name (PEP 503)
+   */
+  static QString NormalizeName(const QString& name);
+
+  /**
+   * @brief Compare two versions by PEP 440 ordering
+   * @return Negative, zero or positive like strcmp
+   *
+   * Local labels (e.g. "+cu121") are ignored.
+   */
+  static int CompareVersions(const QString& a, const QString& b);
+
+  /**
+   * @brief Whether a version satisfies a specifier such as ">=1.2,!=1.3.*,<2"
+   */
+  static bool SatisfiesSpecifier(const QString& version, const QString& specifier);
+
+ private:
+  static QStringList ReadRequirementLines(const QString& requirements_file, int depth);
+
+  QMap<QString, Package> packages_;  // Keyed by normalized name
+};
+
+#endif  // PYTHONPACKAGEINDEX_H
@@ -0,0 +1,128 @@
+#include "reviewstatetable.h"
+
+#include "projectscanner.h"
+
+ReviewStateTable::ReviewStateTable()
+{
+  Clear();
+}
+
+QString ReviewStateTable::StemForImage(const QString& image_file)
+{
+  // Same as QFileInfo::baseName(): file name up to the first dot
+  int slash = image_file.lastIndexOf('/');
+  QString file_name = slash >= 0 ? image_file.mid(slash + 1) : image_file;
+  int first_dot = file_name.indexOf('.');
+  return first_dot >= 0 ? file_name.left(first_dot) : file_name;
+}
+
+void ReviewStateTable::Rebuild(const QStringList& images, const QSet<QString>& label_stems,
+                               const QSet<QString>& meta_stems)
+{
+  Clear();
+
+  states_.resize(images.size());
+  index_.reserve(images.size());
+  stem_index_.reserve(images.size());
+
+  for (int i = 0; i < images.size(); ++i)
+  {
+    const ReviewState state = StateFor(images[i], label_stems, meta_stems);
+    states_[i] = static_cast<quint8>(state);
+    counts_[static_cast<int>(state)]++;
+    index_.insert(images[i], i);
+
+    const QString stem = StemForImage(images[i]);
+    const QString complete_stem = ProjectScanner::CompleteBaseName(images[i]);
+    stem_index_.insert(stem, i);
+    if (complete_stem != stem)
+    {
+      stem_index_.insert(complete_stem, i);
+    }
+  }
+}
+
+void ReviewStateTable::Update(const QString& image_file, const QSet<QString>& label_stems,
+                              const QSet<QString>& meta_stems)
+{
+  SetState(IndexOf(image_file), StateFor(image_file, label_stems, meta_stems));
+}
+
+ReviewState ReviewStateTable::StateFor(const QString& image_file,
+                                       const QSet<QString>& label_stems,
+                                       const QSet<QString>& meta_stems)
+{
+  // Labels saved from the editor use the complete base name, plugin output the base name
+  const QString stem = StemForImage(image_file);
+  if (label_stems.contains(ProjectScanner::CompleteBaseName(image_file)) ||
+      label_stems.contains(stem))
+  {
+    return ReviewState::Approved;
+  }
+  if (meta_stems.contains(stem))
+  {
+    return ReviewState::Meta;
+  }
+  return ReviewState::None;
+}
+
+void ReviewStateTable::Clear()
+{
+  states_.clear();
+  index_.clear();
+  stem_index_.clear();
+  counts_[0] = 0;
+  counts_[1] = 0;
+  counts_[2] = 0;
+}
+
+ReviewState ReviewStateTable::GetState(int index) const
+{
+  if (index < 0 || index >= states_.size())
+  {
+    return ReviewState::None;
+  }
+  return static_cast<ReviewState>(states_[index]);
+}
+
+ReviewState ReviewStateTable::GetState(const QString& image_file) const
+{
+  return GetState(IndexOf(image_file));
+}
+
+void ReviewStateTable::SetState(int index, ReviewState state)
+{
+  if (index < 0 || index >= states_.size())
+  {
+    return;
+  }
+
+  counts_[states_[index]]--;
+  states_[index] = static_cast<quint8>(state);
+  counts_[static_cast<int>(state)]++;
+}
+
+void ReviewStateTable::SetState(const QString& image_file, ReviewState state)
+{
+  SetState(IndexOf(image_file), state);
+}
+
+int ReviewStateTable::FindNextUnreviewed(int start_index) const
+{
+  const int size = states_.size();
+  if (size == 0 || CountUnreviewed() == 0)
+  {
+    return -1;
+  }
+
+  for (int i = 0; i < size; ++i)
+  {
+    int idx = ((start_index + i) % size + size) % size;
+    if (states_[idx] != static_cast<quint8>(ReviewState::Approved))
+    {
+      return idx;
+    }
+  }
+
+  return -1;
+}
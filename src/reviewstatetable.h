@@ -0,0 +1,69 @@
+#ifndef REVIEWSTATETABLE_H
+#define REVIEWSTATETABLE_H
+
+#include <QHash>
+#include <QList>
+#include <QMultiHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Review state of a single image
+enum class ReviewState : quint8
+{
+  None = 0,     // No annotations yet
+  Meta = 1,     // Unreviewed AI detections (.meta)
+  Approved = 2  // Approved annotations (.txt)
+};
+
+// In-memory review state per image, indexed in image list order.
+// Built once from a directory listing and kept current by the code that
+// creates, promotes or deletes label/meta files, so navigation and counting
+// never have to stat the labels folder.
+class ReviewStateTable
+{
+ public:
+  ReviewStateTable();
+
+  // Label/meta file stem for an image (matches AIPluginManager file naming)
+  static QString StemForImage(const QString& image_file);
+
+  void Rebuild(const QStringList& images, const QSet<QString>& label_stems,
+               const QSet<QString>& meta_stems);
+  void Clear();
+
+  // Images whose label or meta file has this stem (complete or first-dot base name)
+  QList<int> IndicesForStem(const QString& stem) const { return stem_index_.values(stem); }
+
+  // Re-derive one image's state after a label or meta file with its stem changed
+  void Update(const QString& image_file, const QSet<QString>& label_stems,
+              const QSet<QString>& meta_stems);
+
+  int Size() const { return states_.size(); }
+  bool Contains(const QString& image_file) const { return index_.contains(image_file); }
+  int IndexOf(const QString& image_file) const { return index_.value(image_file, -1); }
+
+  ReviewState GetState(int index) const;
+  ReviewState GetState(const QString& image_file) const;
+  void SetState(int index, ReviewState state);
+  void SetState(const QString& image_file, ReviewState state);
+
+  // Counts are maintained incrementally, O(1)
+  int Count(ReviewState state) const { return counts_[static_cast<int>(state)]; }
+  int CountUnreviewed() const { return Size() - Count(ReviewState::Approved); }
+
+  // First unreviewed image at or after start_index (wrapping), -1 if none
+  int FindNextUnreviewed(int start_index) const;
+
+ private:
+  static ReviewState StateFor(const QString& image_file, const QSet<QString>& label_stems,
+                              const QSet<QString>& meta_stems);
+
+  QVector<quint8> states_;
+  QHash<QString, int> index_;
+  QMultiHash<QString, int> stem_index_;
+  int counts_[3];
+};
+
+#endif  // REVIEWSTATETABLE_H
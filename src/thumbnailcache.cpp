@@ -0,0 +1,199 @@
+#include "thumbnailcache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QThread>
+
+#include <iostream>
+
+ThumbnailCache::ThumbnailCache(QObject* parent)
+    : QObject(parent), running_(0), generation_(0)
+{
+  pool_.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+  memory_.setMaxCost(kMemoryBudgetKiB);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+  generation_++;
+  pool_.clear();
+  pool_.waitForDone();
+}
+
+void ThumbnailCache::SetImageLocator(const ImageLocator& locator)
+{
+  if (locator.ProjectDirectory() != locator_.ProjectDirectory())
+  {
+    Clear();
+  }
+  locator_ = locator;
+}
+
+bool ThumbnailCache::GetThumbnail(const QString& image_file, QPixmap* pixmap)
+{
+  const QPixmap* cached = memory_.object(image_file);
+  if (cached != nullptr)
+  {
+    *pixmap = *cached;
+    return true;
+  }
+
+  if (locator_.ProjectDirectory().isEmpty() || failed_.contains(image_file) || queued_.contains(image_file))
+  {
+    return false;
+  }
+
+  queue_.append(image_file);
+  queued_.insert(image_file);
+
+  // Requests for rows scrolled out of view long ago are dropped first
+  while (queue_.size() > kMaxQueued)
+  {
+    queued_.remove(queue_.takeFirst());
+  }
+
+  StartNext();
+  return false;
+}
+
+void ThumbnailCache::Clear()
+{
+  generation_++;
+  pool_.clear();
+  memory_.clear();
+  queue_.clear();
+  queued_.clear();
+  failed_.clear();
+  running_ = 0;
+}
+
+QByteArray ThumbnailCache::ContentKey(const QString& image_path)
+{
+  static constexpr qint64 kChunkSize = 64 * 1024;
+
+  QFile file(image_path);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return QByteArray();
+  }
+
+  const qint64 size = file.size();
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  hash.addData(QByteArray::number(size));
+  hash.addData(file.read(kChunkSize));
+  if (size > 2 * kChunkSize)
+  {
+    file.seek(size - kChunkSize);
+  }
+  hash.addData(file.read(kChunkSize));
+
+  return hash.result().toHex();
+}
+
+QImage ThumbnailCache::LoadOrCreate(const QString& image_path, const QString& thumbnails_dir,
+                                    const QRect& crop)
+{
+  QByteArray key = ContentKey(image_path);
+  if (key.isEmpty())
+  {
+    return QImage();
+  }
+  if (!crop.isNull())
+  {
+    key += QString("_%1_%2_%3x%4")
+               .arg(crop.x())
+               .arg(crop.y())
+               .arg(crop.width())
+               .arg(crop.height())
+               .toLatin1();
+  }
+
+  const QString thumb_path = thumbnails_dir + "/" + QString::fromLatin1(key) + ".jpg";
+  QImage thumbnail(thumb_path);
+  if (!thumbnail.isNull())
+  {
+    return thumbnail;
+  }
+
+  // Let the decoder downscale (JPEG DCT scaling) instead of decoding full size
+  QImageReader reader(image_path);
+  const QSize bounds(kThumbnailSize, kThumbnailSize);
+  if (!crop.isNull())
+  {
+    reader.setClipRect(crop);
+  }
+  const QSize original_size = crop.isNull() ? reader.size() : crop.size();
+  if (original_size.isValid() &&
+      (original_size.width() > kThumbnailSize || original_size.height() > kThumbnailSize))
+  {
+    reader.setScaledSize(original_size.scaled(bounds, Qt::KeepAspectRatio));
+  }
+
+  if (!reader.read(&thumbnail))
+  {
+    std::cerr << "Failed to create thumbnail: " << image_path.toStdString() << " ("
+              << reader.errorString().toStdString() << ")" << std::endl;
+    return QImage();
+  }
+
+  if (thumbnail.width() > kThumbnailSize || thumbnail.height() > kThumbnailSize)
+  {
+    thumbnail = thumbnail.scaled(bounds, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  }
+
+  // QSaveFile renames into place, so a concurrent reader never sees a partial file
+  QDir().mkpath(thumbnails_dir);
+  QSaveFile file(thumb_path);
+  if (file.open(QIODevice::WriteOnly) && thumbnail.save(&file, "JPG", 85))
+  {
+    file.commit();
+  }
+
+  return thumbnail;
+}
+
+void ThumbnailCache::StartNext()
+{
+  const QString thumbnails_dir = locator_.ProjectDirectory() + "/.thumbnails";
+
+  while (running_ < pool_.maxThreadCount() && !queue_.isEmpty())
+  {
+    const QString image_file = queue_.takeLast();
+    const QString image_path = locator_.SourcePath(image_file);
+    const QRect crop = locator_.CropRect(image_file);
+    const int generation = generation_;
+    running_++;
+
+    pool_.start([this, image_file, image_path, crop, thumbnails_dir, generation]() {
+      QImage thumbnail = LoadOrCreate(image_path, thumbnails_dir, crop);
+      QMetaObject::invokeMethod(
+          this,
+          [this, image_file, thumbnail, generation]() {
+            if (generation != generation_)
+            {
+              return;
+            }
+
+            running_--;
+            queued_.remove(image_file);
+
+            if (thumbnail.isNull())
+            {
+              failed_.insert(image_file);
+            }
+            else
+            {
+              const int cost = qMax(1, static_cast<int>(thumbnail.sizeInBytes() / 1024));
+              memory_.insert(image_file, new QPixmap(QPixmap::fromImage(thumbnail)), cost);
+              emit ThumbnailReady(image_file);
+            }
+
+            StartNext();
+          },
+          Qt::QueuedConnection);
+    });
+  }
+}
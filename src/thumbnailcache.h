@@ -0,0 +1,93 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include "imagelocator.h"
+
+/**
+ * @brief On-disk thumbnail cache for project images
+ *
+ * Handles:
+ * - Content-hashed thumbnails in <project>/.thumbnails, so renamed or copied
+ *   images reuse their thumbnail and replaced images get a new one
+ * - Background generation on a thread pool, newest requests first, so the
+ *   rows currently on screen are served before rows scrolled past
+ * - A small in-memory pixmap cache for the browser view
+ */
+class ThumbnailCache : public QObject
+{
+  Q_OBJECT
+
+ public:
+  static constexpr int kThumbnailSize = 128;
+
+  explicit ThumbnailCache(QObject* parent = nullptr);
+  ~ThumbnailCache() override;
+
+  /**
+   * @brief Set where project images are read from; drops the cache if the project changed
+   */
+  void SetImageLocator(const ImageLocator& locator);
+
+  /**
+   * @brief Get a thumbnail from memory, queuing generation on a miss
+   * @param image_file File name relative to images/
+   * @param pixmap Receives the thumbnail on a hit
+   * @return false if not available yet; ThumbnailReady() follows
+   */
+  bool GetThumbnail(const QString& image_file, QPixmap* pixmap);
+
+  /**
+   * @brief Drop in-memory thumbnails and queued requests
+   */
+  void Clear();
+
+  /**
+   * @brief Content key of an image: MD5 of file size, first and last 64 KiB
+   *
+   * Reads at most 128 KiB regardless of image size.
+   */
+  static QByteArray ContentKey(const QString& image_path);
+
+  /**
+   * @brief Load a thumbnail from the disk cache, creating it if missing
+   * @param image_path Absolute image path
+   * @param thumbnails_dir Directory holding cached thumbnails
+   * @param crop Virtual crop of a referenced image; null = whole image
+   * @return Null image if the source cannot be decoded
+   */
+  static QImage LoadOrCreate(const QString& image_path, const QString& thumbnails_dir,
+                             const QRect& crop = QRect());
+
+ signals:
+  /**
+   * @brief Emitted when a requested thumbnail is available in memory
+   */
+  void ThumbnailReady(const QString& image_file);
+
+ private:
+  void StartNext();
+
+  static constexpr int kMaxQueued = 512;
+  static constexpr int kMemoryBudgetKiB = 64 * 1024;
+
+  ImageLocator locator_;
+  QCache<QString, QPixmap> memory_;  // Cost in KiB
+  QStringList queue_;                // Most recent request last
+  QSet<QString> queued_;             // Queued or being generated
+  QSet<QString> failed_;             // Images that could not be decoded
+  int running_;
+  int generation_;  // Bumped on Clear() so stale results are dropped
+  QThreadPool pool_;
+};
+
+#endif  // THUMBNAILCACHE_H
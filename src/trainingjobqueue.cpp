@@ -0,0 +1,591 @@
+#include "trainingjobqueue.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QThread>
+#include <QUuid>
+
+#include <algorithm>
+#include <iostream>
+
+TrainingJob::TrainingJob()
+    : cores(1),
+      memory_mb(0),
+      shared_dataset(true),
+      training_images_count(0),
+      status(TrainingJobStatus::Queued),
+      exit_code(0)
+{
+}
+
+QJsonObject TrainingJob::ToJson() const
+{
+  QJsonObject obj;
+  obj["id"] = id;
+  obj["name"] = name;
+  obj["program"] = program;
+  obj["arguments"] = QJsonArray::fromStringList(arguments);
+  obj["working_directory"] = working_directory;
+  obj["log_path"] = log_path;
+  obj["run_directory"] = run_directory;
+  obj["cores"] = cores;
+  obj["memory_mb"] = QString::number(memory_mb);
+  obj["limits"] = limits.ToJson();
+  QJsonObject overrides_obj;
+  for (auto it = overrides.begin(); it != overrides.end(); ++it)
+  {
+    overrides_obj[it.key()] = it.value();
+  }
+  obj["overrides"] = overrides_obj;
+  obj["shared_dataset"] = shared_dataset;
+  obj["training_images_count"] = training_images_count;
+  obj["status"] = StatusName(status);
+  obj["exit_code"] = exit_code;
+  obj["queued_at"] = queued_at.toString(Qt::ISODate);
+  obj["started_at"] = started_at.toString(Qt::ISODate);
+  obj["finished_at"] = finished_at.toString(Qt::ISODate);
+  obj["model_path"] = model_path;
+  return obj;
+}
+
+TrainingJob TrainingJob::FromJson(const QJsonObject& json)
+{
+  TrainingJob job;
+  job.id = json["id"].toString();
+  job.name = json["name"].toString();
+  job.program = json["program"].toString();
+  for (const QJsonValue& value : json["arguments"].toArray())
+  {
+    job.arguments.append(value.toString());
+  }
+  job.working_directory = json["working_directory"].toString();
+  job.log_path = json["log_path"].toString();
+  job.run_directory = json["run_directory"].toString();
+  job.cores = qMax(1, json["cores"].toInt(1));
+  job.memory_mb = json["memory_mb"].toString().toLongLong();
+  job.limits = ProcessLimits::FromJson(json["limits"].toObject());
+  const QJsonObject overrides = json["overrides"].toObject();
+  for (auto it = overrides.begin(); it != overrides.end(); ++it)
+  {
+    job.overrides.insert(it.key(), it.value().toString());
+  }
+  job.shared_dataset = json["shared_dataset"].toBool(true);
+  job.training_images_count = json["training_images_count"].toInt();
+  job.exit_code = json["exit_code"].toInt();
+  job.queued_at = QDateTime::fromString(json["queued_at"].toString(), Qt::ISODate);
+  job.started_at = QDateTime::fromString(json["started_at"].toString(), Qt::ISODate);
+  job.finished_at = QDateTime::fromString(json["finished_at"].toString(), Qt::ISODate);
+  job.model_path = json["model_path"].toString();
+
+  const QString status = json["status"].toString();
+  for (TrainingJobStatus candidate :
+       {TrainingJobStatus::Queued, TrainingJobStatus::Running, TrainingJobStatus::Succeeded,
+        TrainingJobStatus::Failed, TrainingJobStatus::Canceled})
+  {
+    if (StatusName(candidate) == status)
+    {
+      job.status = candidate;
+    }
+  }
+  return job;
+}
+
+QString TrainingJob::StatusName(TrainingJobStatus status)
+{
+  switch (status)
+  {
+    case TrainingJobStatus::Queued:
+      return "queued";
+    case TrainingJobStatus::Running:
+      return "running";
+    case TrainingJobStatus::Succeeded:
+      return "succeeded";
+    case TrainingJobStatus::Failed:
+      return "failed";
+    case TrainingJobStatus::Canceled:
+      return "canceled";
+  }
+  return "queued";
+}
+
+bool TrainingJob::IsFinished() const
+{
+  return status == TrainingJobStatus::Succeeded || status == TrainingJobStatus::Failed ||
+         status == TrainingJobStatus::Canceled;
+}
+
+TrainingJobQueue::TrainingJobQueue(QObject* parent)
+    : QObject(parent),
+      total_cores_(qMax(1, QThread::idealThreadCount())),
+      memory_budget_mb_(TotalMemoryMb()),
+      paused_(false)
+{
+}
+
+TrainingJobQueue::~TrainingJobQueue()
+{
+  // Jobs killed here are still marked running on disk and get re-queued on next load
+  StopAll();
+}
+
+QString TrainingJobQueue::QueuePath(const QString& project_dir)
+{
+  return project_dir + "/.polyseg/training_queue.json";
+}
+
+QString TrainingJobQueue::NewJobId()
+{
+  return QUuid::createUuid().toString(QUuid::Id128).left(12);
+}
+
+void TrainingJobQueue::SetProjectDirectory(const QString& project_dir)
+{
+  if (project_dir == project_dir_)
+  {
+    return;
+  }
+
+  StopAll();
+  project_dir_ = project_dir;
+  jobs_.clear();
+  if (!project_dir_.isEmpty())
+  {
+    Load();
+  }
+
+  // Left-over jobs would otherwise claim the GPU as soon as the project opens
+  paused_ = std::any_of(jobs_.begin(), jobs_.end(), [](const TrainingJob& job)
+                        { return job.status == TrainingJobStatus::Queued; });
+  emit QueueChanged();
+}
+
+void TrainingJobQueue::SetPaused(bool paused)
+{
+  if (paused == paused_)
+  {
+    return;
+  }
+
+  paused_ = paused;
+  emit QueueChanged();
+  Schedule();
+}
+
+const TrainingJob* TrainingJobQueue::Job(const QString& id) const
+{
+  for (const TrainingJob& job : jobs_)
+  {
+    if (job.id == id)
+    {
+      return &job;
+    }
+  }
+  return nullptr;
+}
+
+TrainingJob* TrainingJobQueue::FindJob(const QString& id)
+{
+  for (TrainingJob& job : jobs_)
+  {
+    if (job.id == id)
+    {
+      return &job;
+    }
+  }
+  return nullptr;
+}
+
+QString TrainingJobQueue::Enqueue(TrainingJob job)
+{
+  if (job.id.isEmpty())
+  {
+    job.id = NewJobId();
+  }
+  if (job.log_path.isEmpty())
+  {
+    job.log_path = project_dir_ + "/tmp/training_" + job.id + ".log";
+  }
+  job.cores = qMax(1, job.cores);
+  job.status = TrainingJobStatus::Queued;
+  job.queued_at = QDateTime::currentDateTime();
+
+  const QString id = job.id;
+  jobs_.append(job);
+  Save();
+  emit QueueChanged();
+  Schedule();
+  return id;
+}
+
+void TrainingJobQueue::Cancel(const QString& id)
+{
+  TrainingJob* job = FindJob(id);
+  if (job == nullptr || job->IsFinished())
+  {
+    return;
+  }
+
+  QProcess* process = processes_.value(id, nullptr);
+  if (process != nullptr)
+  {
+    // The finish handler records the outcome; mark it canceled first
+    job->status = TrainingJobStatus::Canceled;
+    process->terminate();
+    return;
+  }
+
+  job->status = TrainingJobStatus::Canceled;
+  job->finished_at = QDateTime::currentDateTime();
+  Save();
+  emit QueueChanged();
+  Schedule();
+}
+
+void TrainingJobQueue::RemoveFinished()
+{
+  jobs_.erase(std::remove_if(jobs_.begin(), jobs_.end(),
+                             [this](const TrainingJob& job) {
+                               return job.IsFinished() && !processes_.contains(job.id);
+                             }),
+              jobs_.end());
+  Save();
+  emit QueueChanged();
+}
+
+void TrainingJobQueue::SetModelPath(const QString& id, const QString& model_path)
+{
+  TrainingJob* job = FindJob(id);
+  if (job != nullptr)
+  {
+    job->model_path = model_path;
+    Save();
+    emit QueueChanged();
+  }
+}
+
+void TrainingJobQueue::SetResourceLimits(int cores, qint64 memory_mb)
+{
+  total_cores_ = qMax(1, cores);
+  memory_budget_mb_ = memory_mb;
+  Schedule();
+}
+
+bool TrainingJobQueue::CanStart(const TrainingJob& job, int used_cores, qint64 used_memory_mb,
+                                int total_cores, qint64 memory_budget_mb,
+                                qint64 available_memory_mb)
+{
+  if (used_cores == 0)
+  {
+    // Nothing else runs; an oversized job would otherwise never start
+    return true;
+  }
+  if (used_cores + job.cores > total_cores)
+  {
+    return false;
+  }
+  if (memory_budget_mb >= 0 && used_memory_mb + job.memory_mb > memory_budget_mb)
+  {
+    return false;
+  }
+  // Running jobs may not have reached their peak yet; free RAM is only a second check
+  return available_memory_mb < 0 || job.memory_mb <= available_memory_mb;
+}
+
+void TrainingJobQueue::Schedule()
+{
+  if (project_dir_.isEmpty() || paused_)
+  {
+    return;
+  }
+
+  int used_cores = 0;
+  qint64 used_memory_mb = 0;
+  bool shared_dataset_in_use = false;
+  // Counted by process: a canceled job holds its resources until it has exited
+  for (auto it = processes_.constBegin(); it != processes_.constEnd(); ++it)
+  {
+    const TrainingJob* job = Job(it.key());
+    if (job != nullptr)
+    {
+      used_cores += job->cores;
+      used_memory_mb += job->memory_mb;
+      shared_dataset_in_use = shared_dataset_in_use || job->shared_dataset;
+    }
+  }
+
+  // Indexed: signal handlers of a started job may append to the queue
+  for (int i = 0; i < jobs_.size(); ++i)
+  {
+    if (jobs_[i].status != TrainingJobStatus::Queued)
+    {
+      continue;
+    }
+    // Queue order is kept: a job that does not fit holds back the ones behind it
+    if ((jobs_[i].shared_dataset && shared_dataset_in_use) ||
+        !CanStart(jobs_[i], used_cores, used_memory_mb, total_cores_, memory_budget_mb_,
+                  AvailableMemoryMb()))
+    {
+      break;
+    }
+    const int cores = jobs_[i].cores;
+    const qint64 memory_mb = jobs_[i].memory_mb;
+    const bool shared_dataset = jobs_[i].shared_dataset;
+    if (StartJob(i))
+    {
+      used_cores += cores;
+      used_memory_mb += memory_mb;
+      shared_dataset_in_use = shared_dataset_in_use || shared_dataset;
+    }
+  }
+}
+
+bool TrainingJobQueue::StartJob(int index)
+{
+  TrainingJob& job = jobs_[index];
+  if (preparer_ && !preparer_(&job))
+  {
+    std::cerr << "Could not prepare training job " << job.id.toStdString() << std::endl;
+    job.status = TrainingJobStatus::Failed;
+    job.exit_code = -1;
+    job.finished_at = QDateTime::currentDateTime();
+    const QString id = job.id;
+    Save();
+    emit QueueChanged();
+    emit JobFinished(id, false);
+    return false;
+  }
+
+  QDir().mkpath(QFileInfo(job.log_path).absolutePath());
+  if (!job.run_directory.isEmpty())
+  {
+    QDir().mkpath(job.run_directory);
+  }
+
+  QFile* log = new QFile(job.log_path, this);
+  if (!log->open(QIODevice::WriteOnly | QIODevice::Append))
+  {
+    std::cerr << "Warning: Could not open training log: " << job.log_path.toStdString()
+              << std::endl;
+  }
+
+  QProcess* process = new QProcess(this);
+  process->setProcessChannelMode(QProcess::MergedChannels);
+  process->setWorkingDirectory(job.working_directory);
+  job.limits.ApplyTo(process);
+
+  const QString id = job.id;
+  connect(process, &QProcess::readyReadStandardOutput, this, [this, process, log, id]() {
+    const QByteArray output = process->readAllStandardOutput();
+    if (log->isOpen())
+    {
+      log->write(output);
+    }
+    emit JobOutput(id, output);
+  });
+  connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+          [this, id](int exit_code, QProcess::ExitStatus exit_status) {
+            OnProcessFinished(id, exit_code, exit_status);
+          });
+
+  std::cout << "Starting training job " << id.toStdString() << ": "
+            << job.program.toStdString();
+  for (const QString& arg : job.arguments)
+  {
+    std::cout << " " << arg.toStdString();
+  }
+  std::cout << std::endl;
+
+  job.status = TrainingJobStatus::Running;
+  job.started_at = QDateTime::currentDateTime();
+  job.exit_code = 0;
+  processes_.insert(id, process);
+  logs_.insert(id, log);
+
+  process->start(job.program, job.arguments);
+  if (!process->waitForStarted())
+  {
+    std::cerr << "Failed to start training job " << id.toStdString() << std::endl;
+    processes_.remove(id);
+    logs_.remove(id);
+    process->disconnect(this);
+    process->deleteLater();
+    delete log;
+
+    job.status = TrainingJobStatus::Failed;
+    job.exit_code = -1;
+    job.finished_at = QDateTime::currentDateTime();
+    Save();
+    emit QueueChanged();
+    emit JobFinished(id, false);
+    return false;
+  }
+
+  Save();
+  emit QueueChanged();
+  emit JobStarted(id);
+  return true;
+}
+
+void TrainingJobQueue::OnProcessFinished(const QString& id, int exit_code,
+                                         QProcess::ExitStatus exit_status)
+{
+  QProcess* process = processes_.take(id);
+  QFile* log = logs_.take(id);
+  if (process == nullptr)
+  {
+    return;
+  }
+
+  // Output still buffered when the process exited
+  const QByteArray rest = process->readAllStandardOutput();
+  if (log != nullptr)
+  {
+    if (!rest.isEmpty() && log->isOpen())
+    {
+      log->write(rest);
+    }
+    delete log;
+  }
+  process->deleteLater();
+
+  bool success = false;
+  TrainingJob* job = FindJob(id);
+  if (job != nullptr)
+  {
+    if (!rest.isEmpty())
+    {
+      emit JobOutput(id, rest);
+    }
+    success = job->status != TrainingJobStatus::Canceled &&
+              exit_status == QProcess::NormalExit && exit_code == 0;
+    if (job->status != TrainingJobStatus::Canceled)
+    {
+      job->status = success ? TrainingJobStatus::Succeeded : TrainingJobStatus::Failed;
+    }
+    job->exit_code = exit_status == QProcess::CrashExit ? -1 : exit_code;
+    job->finished_at = QDateTime::currentDateTime();
+    Save();
+    emit QueueChanged();
+    emit JobFinished(id, success);
+  }
+
+  Schedule();
+}
+
+void TrainingJobQueue::StopAll()
+{
+  for (auto it = processes_.begin(); it != processes_.end(); ++it)
+  {
+    it.value()->disconnect(this);
+    it.value()->kill();
+    it.value()->waitForFinished(3000);
+    delete it.value();
+  }
+  processes_.clear();
+  qDeleteAll(logs_);
+  logs_.clear();
+}
+
+bool TrainingJobQueue::Load()
+{
+  QFile file(QueuePath(project_dir_));
+  if (!file.exists())
+  {
+    return true;
+  }
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    std::cerr << "Cannot open training queue: " << file.fileName().toStdString() << std::endl;
+    return false;
+  }
+
+  const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+  bool requeued = false;
+  for (const QJsonValue& value : root["jobs"].toArray())
+  {
+    TrainingJob job = TrainingJob::FromJson(value.toObject());
+    if (job.id.isEmpty())
+    {
+      continue;
+    }
+    if (job.status == TrainingJobStatus::Running)
+    {
+      // The process did not survive the previous session; train again from scratch
+      job.status = TrainingJobStatus::Queued;
+      job.started_at = QDateTime();
+      requeued = true;
+    }
+    jobs_.append(job);
+  }
+
+  if (requeued)
+  {
+    Save();
+  }
+  return true;
+}
+
+bool TrainingJobQueue::Save() const
+{
+  if (project_dir_.isEmpty())
+  {
+    return false;
+  }
+
+  QJsonArray jobs;
+  for (const TrainingJob& job : jobs_)
+  {
+    jobs.append(job.ToJson());
+  }
+  QJsonObject root;
+  root["version"] = 1;
+  root["jobs"] = jobs;
+
+  const QString path = QueuePath(project_dir_);
+  QDir().mkpath(QFileInfo(path).absolutePath());
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    std::cerr << "Cannot write training queue: " << path.toStdString() << std::endl;
+    return false;
+  }
+  file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+  return file.commit();
+}
+
+qint64 TrainingJobQueue::MemInfoMb(const QByteArray& key)
+{
+  QFile file("/proc/meminfo");
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return -1;
+  }
+
+  // "MemAvailable:   12345678 kB"
+  const QList<QByteArray> lines = file.readAll().split('\n');
+  for (const QByteArray& line : lines)
+  {
+    if (line.startsWith(key + ':'))
+    {
+      const QList<QByteArray> fields = line.mid(key.size() + 1).simplified().split(' ');
+      bool ok = false;
+      const qint64 kb = fields.value(0).toLongLong(&ok);
+      return ok ? kb / 1024 : -1;
+    }
+  }
+  return -1;
+}
+
+qint64 TrainingJobQueue::TotalMemoryMb()
+{
+  return MemInfoMb("MemTotal");
+}
+
+qint64 TrainingJobQueue::AvailableMemoryMb()
+{
+  return MemInfoMb("MemAvailable");
+}
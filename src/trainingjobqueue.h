@@ -0,0 +1,180 @@
+#ifndef TRAININGJOBQUEUE_H
+#define TRAININGJOBQUEUE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+#include "processlimits.h"
+
+class QFile;
+
+enum class TrainingJobStatus
+{
+  Queued,
+  Running,
+  Succeeded,
+  Failed,
+  Canceled
+};
+
+// One training run; the command is resolved by the queue's preparer when the job starts
+struct TrainingJob
+{
+  QString id;
+  QString name;
+  QString program;
+  QStringList arguments;
+  QString working_directory;
+  QString log_path;          // tmp/training_<id>.log, stdout and stderr merged
+  QString run_directory;     // Output directory passed to the plugin as {run_dir}
+  int cores;                 // CPU cores the job is expected to keep busy
+  qint64 memory_mb;          // Peak RAM the job is expected to use (0 = unknown)
+  ProcessLimits limits;      // Priority, affinity and thread caps applied at spawn
+  QMap<QString, QString> overrides;  // Plugin variables of this variant (backbone, seed, ...)
+  bool shared_dataset;       // Trains on the project's splits/ and data.yaml
+  int training_images_count;
+  TrainingJobStatus status;
+  int exit_code;
+  QDateTime queued_at;
+  QDateTime started_at;
+  QDateTime finished_at;
+  QString model_path;        // Registered model after success
+
+  TrainingJob();
+  QJsonObject ToJson() const;
+  static TrainingJob FromJson(const QJsonObject& json);
+  static QString StatusName(TrainingJobStatus status);
+  bool IsFinished() const;
+};
+
+/**
+ * @brief Persistent queue of training jobs with resource-aware scheduling
+ *
+ * Jobs start in queue order as long as the cores and RAM they declare fit
+ * next to the jobs already running; a job that does not fit blocks the ones
+ * behind it, so a queue of exclusive jobs runs back-to-back. A job always
+ * starts when nothing else runs, even if it declares more than the machine has.
+ *
+ * The dataset is prepared right before a job starts, so it trains on the labels
+ * of that moment. Jobs that share the project's split files never run at the
+ * same time: preparing one would rewrite the files the other is reading.
+ *
+ * Handles:
+ * - Persistence in <project>/.polyseg/training_queue.json
+ * - Re-queueing jobs that were running when the application exited; jobs loaded
+ *   from disk wait until the queue is resumed
+ * - One QProcess and one log file per running job
+ */
+class TrainingJobQueue : public QObject
+{
+  Q_OBJECT
+
+ public:
+  /**
+   * @brief Writes a job's dataset and resolves its program and arguments
+   * @return False to fail the job without starting it
+   */
+  using JobPreparer = std::function<bool(TrainingJob* job)>;
+
+  explicit TrainingJobQueue(QObject* parent = nullptr);
+  ~TrainingJobQueue() override;
+
+  /**
+   * @brief Called on the GUI thread right before each job starts
+   */
+  void SetJobPreparer(JobPreparer preparer) { preparer_ = std::move(preparer); }
+
+  static QString QueuePath(const QString& project_dir);
+  static QString NewJobId();
+
+  /**
+   * @brief Switch to a project and load its queue (running jobs are stopped)
+   *
+   * The queue is paused if it holds queued jobs, so nothing starts on open.
+   */
+  void SetProjectDirectory(const QString& project_dir);
+
+  /**
+   * @brief A paused queue starts no jobs; running ones continue
+   */
+  bool IsPaused() const { return paused_; }
+  void SetPaused(bool paused);
+
+  const QList<TrainingJob>& Jobs() const { return jobs_; }
+  const TrainingJob* Job(const QString& id) const;
+  int RunningCount() const { return processes_.size(); }
+
+  /**
+   * @brief Add a job; its log path is assigned here when empty
+   * @return Job id
+   */
+  QString Enqueue(TrainingJob job);
+
+  /**
+   * @brief Cancel a queued job or terminate a running one
+   */
+  void Cancel(const QString& id);
+
+  /**
+   * @brief Drop succeeded, failed and canceled jobs from the list
+   */
+  void RemoveFinished();
+
+  void SetModelPath(const QString& id, const QString& model_path);
+
+  /**
+   * @brief Resources shared by concurrent jobs
+   * @param cores CPU cores (default: all logical cores)
+   * @param memory_mb RAM budget (default: physical RAM; -1 = unknown, not enforced)
+   */
+  void SetResourceLimits(int cores, qint64 memory_mb);
+  int TotalCores() const { return total_cores_; }
+  qint64 MemoryBudgetMb() const { return memory_budget_mb_; }
+
+  /**
+   * @brief Whether a job fits next to the running ones
+   * @param available_memory_mb Free RAM right now, -1 if unknown
+   */
+  static bool CanStart(const TrainingJob& job, int used_cores, qint64 used_memory_mb,
+                       int total_cores, qint64 memory_budget_mb, qint64 available_memory_mb);
+
+  static qint64 TotalMemoryMb();
+  static qint64 AvailableMemoryMb();
+
+ signals:
+  void JobStarted(const QString& id);
+  void JobOutput(const QString& id, const QByteArray& output);
+  void JobFinished(const QString& id, bool success);
+  void QueueChanged();
+
+ private:
+  void Schedule();
+  bool StartJob(int index);
+  void OnProcessFinished(const QString& id, int exit_code, QProcess::ExitStatus exit_status);
+  void StopAll();
+  bool Load();
+  bool Save() const;
+  TrainingJob* FindJob(const QString& id);
+  static qint64 MemInfoMb(const QByteArray& key);
+
+  QString project_dir_;
+  QList<TrainingJob> jobs_;
+  QHash<QString, QProcess*> processes_;
+  QHash<QString, QFile*> logs_;
+  int total_cores_;
+  qint64 memory_budget_mb_;
+  bool paused_;
+  JobPreparer preparer_;
+};
+
+#endif  // TRAININGJOBQUEUE_H
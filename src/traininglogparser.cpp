@@ -0,0 +1,188 @@
+#include "traininglogparser.h"
+
+#include <QRegularExpression>
+
+TrainingLogParser::TrainingLogParser(int max_lines) : max_lines_(qMax(1, max_lines))
+{
+}
+
+void TrainingLogParser::Reset()
+{
+  ring_.clear();
+  ring_start_ = 0;
+  total_lines_ = 0;
+  partial_.clear();
+  epoch_ = 0;
+  total_epochs_ = 0;
+  first_epoch_ = 0;
+  first_epoch_ms_ = -1;
+  last_epoch_ms_ = -1;
+  series_.clear();
+}
+
+QStringList TrainingLogParser::Feed(const QByteArray& chunk, qint64 now_ms)
+{
+  QStringList lines;
+  qsizetype start = 0;
+  for (qsizetype i = 0; i < chunk.size(); ++i)
+  {
+    const char c = chunk.at(i);
+    const bool crlf = c == '\r' && i + 1 < chunk.size() && chunk.at(i + 1) == '\n';
+    if ((c != '\n' && c != '\r') || crlf)
+    {
+      continue;
+    }
+
+    partial_.append(chunk.constData() + start, i - start);
+    start = i + 1;
+
+    const QString line = QString::fromUtf8(partial_).trimmed();
+    partial_.clear();
+    if (line.isEmpty())
+    {
+      continue;
+    }
+
+    ParseLine(line, now_ms);
+    if (c == '\n')
+    {
+      StoreLine(line);
+      lines.append(line);
+    }
+    // A '\r' update is overwritten by the next one; only its metrics matter
+  }
+
+  partial_.append(chunk.constData() + start, chunk.size() - start);
+  if (partial_.size() > kMaxPartialLine)
+  {
+    // Output without line breaks; cut it rather than grow without bound
+    const QString line = QString::fromUtf8(partial_).trimmed();
+    partial_.clear();
+    ParseLine(line, now_ms);
+    StoreLine(line);
+    lines.append(line);
+  }
+  return lines;
+}
+
+QStringList TrainingLogParser::Finish(qint64 now_ms)
+{
+  return Feed(QByteArray("\n"), now_ms);
+}
+
+QStringList TrainingLogParser::RecentLines() const
+{
+  QStringList lines;
+  lines.reserve(ring_.size());
+  for (int i = 0; i < ring_.size(); ++i)
+  {
+    lines.append(ring_[(ring_start_ + i) % ring_.size()]);
+  }
+  return lines;
+}
+
+qint64 TrainingLogParser::EtaSeconds(qint64 now_ms) const
+{
+  const int epochs_done = epoch_ - first_epoch_;
+  if (total_epochs_ <= 0 || epochs_done <= 0 || epoch_ > total_epochs_)
+  {
+    return -1;
+  }
+
+  const double ms_per_epoch =
+      static_cast<double>(last_epoch_ms_ - first_epoch_ms_) / static_cast<double>(epochs_done);
+  const double in_current = static_cast<double>(now_ms - last_epoch_ms_);
+  const double remaining = (total_epochs_ - epoch_ + 1) * ms_per_epoch - in_current;
+  return qMax<qint64>(0, static_cast<qint64>(remaining / 1000.0));
+}
+
+void TrainingLogParser::ParseLine(const QString& line, qint64 now_ms)
+{
+  static const QRegularExpression epoch_re(
+      "\\bepoch\\s*[:#]?\\s*(\\d+)\\s*(?:/|of)\\s*(\\d+)",
+      QRegularExpression::CaseInsensitiveOption);
+  static const QRegularExpression table_epoch_re("^(\\d+)/(\\d+)\\s+[\\d.]+[GM]\\s");
+  static const QRegularExpression metric_re(
+      "\\b((?:train|val|valid|validation|total)?[_ ]?loss|mAP(?:[\\d\\-_.]|\\(\\w\\))*)"
+      "\\s*[:=]\\s*(-?\\d+(?:\\.\\d+)?(?:[eE][-+]?\\d+)?)",
+      QRegularExpression::CaseInsensitiveOption);
+
+  QRegularExpressionMatch match = epoch_re.match(line);
+  if (!match.hasMatch())
+  {
+    match = table_epoch_re.match(line);
+  }
+  if (match.hasMatch())
+  {
+    const int epoch = match.captured(1).toInt();
+    const int total = match.captured(2).toInt();
+    if (total > 0 && epoch <= total)
+    {
+      total_epochs_ = total;
+      if (epoch > epoch_)
+      {
+        if (first_epoch_ms_ < 0)
+        {
+          first_epoch_ = epoch;
+          first_epoch_ms_ = now_ms;
+        }
+        epoch_ = epoch;
+        last_epoch_ms_ = now_ms;
+      }
+    }
+  }
+
+  QRegularExpressionMatchIterator it = metric_re.globalMatch(line);
+  while (it.hasNext())
+  {
+    const QRegularExpressionMatch metric = it.next();
+    bool ok = false;
+    const double value = metric.captured(2).toDouble(&ok);
+    if (ok)
+    {
+      AddPoint(MetricName(metric.captured(1)), value);
+    }
+  }
+}
+
+void TrainingLogParser::StoreLine(const QString& line)
+{
+  total_lines_++;
+  if (ring_.size() < max_lines_)
+  {
+    ring_.append(line);
+    return;
+  }
+  ring_[ring_start_] = line;
+  ring_start_ = (ring_start_ + 1) % max_lines_;
+}
+
+void TrainingLogParser::AddPoint(const QString& name, double value)
+{
+  QVector<QPointF>& points = series_[name];
+  const double x = epoch_ > 0 ? epoch_ : points.size();
+  points.append(QPointF(x, value));
+
+  if (points.size() > kMaxPointsPerSeries)
+  {
+    // Halve the resolution instead of dropping history
+    QVector<QPointF> thinned;
+    thinned.reserve(points.size() / 2 + 1);
+    for (int i = 0; i < points.size(); i += 2)
+    {
+      thinned.append(points[i]);
+    }
+    thinned.last() = points.last();
+    points = thinned;
+  }
+}
+
+QString TrainingLogParser::MetricName(const QString& key)
+{
+  QString name = key.trimmed().toLower();
+  name.replace(' ', '_');
+  name.replace("validation", "val");
+  name.replace("valid", "val");
+  name.remove(QRegularExpression("[()]"));
+  return name;
+}
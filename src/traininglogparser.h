@@ -0,0 +1,90 @@
+#ifndef TRAININGLOGPARSER_H
+#define TRAININGLOGPARSER_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QPointF>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief Incremental parser for training process output
+ *
+ * Fed with raw stdout/stderr chunks as they arrive. Keeps only the most
+ * recent lines in a ring buffer and a bounded number of points per metric,
+ * so memory stays flat no matter how long training runs.
+ *
+ * Recognised output:
+ * - Epochs: "Epoch 3/50", "epoch: 3 of 50", YOLO table rows "  3/50  2.1G ..."
+ * - Losses: "loss: 0.41", "Train Loss: 0.41", "val_loss=0.38", "total_loss: 1.2"
+ * - mAP: "mAP: 0.61", "mAP50-95: 0.43", "map50=0.7"
+ *
+ * Carriage-return progress updates (tqdm) are parsed but not stored as lines.
+ */
+class TrainingLogParser
+{
+ public:
+  static constexpr int kDefaultMaxLines = 5000;
+  static constexpr int kMaxPointsPerSeries = 2048;
+
+  explicit TrainingLogParser(int max_lines = kDefaultMaxLines);
+
+  void Reset();
+
+  /**
+   * @brief Consume a chunk of output
+   * @param now_ms Monotonic time of arrival, used for the ETA
+   * @return Lines completed by this chunk
+   */
+  QStringList Feed(const QByteArray& chunk, qint64 now_ms);
+
+  /**
+   * @brief Complete the trailing partial line (end of output)
+   */
+  QStringList Finish(qint64 now_ms);
+
+  /**
+   * @brief Last lines kept in the ring buffer, oldest first
+   */
+  QStringList RecentLines() const;
+  qint64 TotalLines() const { return total_lines_; }
+
+  int CurrentEpoch() const { return epoch_; }
+  int TotalEpochs() const { return total_epochs_; }
+
+  /**
+   * @brief Metric name ("loss", "train_loss", "val_loss", "map50", ...) -> (epoch, value)
+   */
+  const QMap<QString, QVector<QPointF>>& Series() const { return series_; }
+
+  /**
+   * @brief Estimated seconds left from the mean epoch duration so far
+   * @return -1 until at least one epoch has completed
+   */
+  qint64 EtaSeconds(qint64 now_ms) const;
+
+ private:
+  void ParseLine(const QString& line, qint64 now_ms);
+  void StoreLine(const QString& line);
+  void AddPoint(const QString& name, double value);
+  static QString MetricName(const QString& key);
+
+  static constexpr int kMaxPartialLine = 64 * 1024;
+
+  int max_lines_;
+  QVector<QString> ring_;
+  int ring_start_ = 0;
+  qint64 total_lines_ = 0;
+  QByteArray partial_;
+
+  int epoch_ = 0;
+  int total_epochs_ = 0;
+  int first_epoch_ = 0;
+  qint64 first_epoch_ms_ = -1;  // Start of the first epoch seen
+  qint64 last_epoch_ms_ = -1;   // Start of the current epoch
+
+  QMap<QString, QVector<QPointF>> series_;
+};
+
+#endif  // TRAININGLOGPARSER_H
@@ -0,0 +1,252 @@
+#include "trainingmonitordialog.h"
+
+#include <QDialogButtonBox>
+#include <QFontDatabase>
+#include <QFormLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPlainTextEdit>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QSplitter>
+#include <QVBoxLayout>
+
+TrainingMetricChart::TrainingMetricChart(QWidget* parent) : QWidget(parent)
+{
+  setMinimumHeight(160);
+}
+
+void TrainingMetricChart::SetSeries(const QMap<QString, QVector<QPointF>>& series)
+{
+  series_ = series;
+  update();
+}
+
+void TrainingMetricChart::paintEvent(QPaintEvent* /*event*/)
+{
+  QPainter painter(this);
+  painter.setRenderHint(QPainter::Antialiasing);
+  painter.fillRect(rect(), palette().base());
+
+  const QRectF plot = QRectF(rect()).adjusted(40, 10, -10, -24);
+  painter.setPen(palette().mid().color());
+  painter.drawRect(plot);
+
+  if (series_.isEmpty())
+  {
+    painter.setPen(palette().placeholderText().color());
+    painter.drawText(plot, Qt::AlignCenter, "Waiting for metrics...");
+    return;
+  }
+
+  // Losses and mAP have different scales; each series is normalized to its own range
+  double min_x = 0.0;
+  double max_x = 1.0;
+  bool first = true;
+  for (const QVector<QPointF>& points : series_)
+  {
+    for (const QPointF& p : points)
+    {
+      min_x = first ? p.x() : qMin(min_x, p.x());
+      max_x = first ? p.x() : qMax(max_x, p.x());
+      first = false;
+    }
+  }
+  if (max_x <= min_x)
+  {
+    max_x = min_x + 1.0;
+  }
+
+  static const QColor kColors[] = {QColor(31, 119, 180), QColor(255, 127, 14), QColor(44, 160, 44),
+                                   QColor(214, 39, 40),  QColor(148, 103, 189), QColor(140, 86, 75)};
+  const int color_count = static_cast<int>(sizeof(kColors) / sizeof(kColors[0]));
+
+  int index = 0;
+  qreal legend_x = plot.left() + 6;
+  for (auto it = series_.constBegin(); it != series_.constEnd(); ++it, ++index)
+  {
+    const QVector<QPointF>& points = it.value();
+    if (points.isEmpty())
+    {
+      continue;
+    }
+
+    double min_y = points.first().y();
+    double max_y = min_y;
+    for (const QPointF& p : points)
+    {
+      min_y = qMin(min_y, p.y());
+      max_y = qMax(max_y, p.y());
+    }
+    const double range_y = max_y > min_y ? max_y - min_y : 1.0;
+
+    QPainterPath path;
+    for (int i = 0; i < points.size(); ++i)
+    {
+      const QPointF mapped(plot.left() + (points[i].x() - min_x) / (max_x - min_x) * plot.width(),
+                           plot.bottom() - (points[i].y() - min_y) / range_y * plot.height());
+      if (i == 0)
+      {
+        path.moveTo(mapped);
+      }
+      else
+      {
+        path.lineTo(mapped);
+      }
+    }
+
+    const QColor color = kColors[index % color_count];
+    painter.setPen(QPen(color, 1.5));
+    painter.drawPath(path);
+
+    // Legend: name and latest value
+    const QString label = QString("%1 %2").arg(it.key()).arg(points.last().y(), 0, 'g', 4);
+    painter.drawText(QPointF(legend_x, rect().bottom() - 6), label);
+    legend_x += painter.fontMetrics().horizontalAdvance(label) + 16;
+  }
+
+  painter.setPen(palette().text().color());
+  painter.drawText(QRectF(0, plot.top(), plot.left() - 4, 16), Qt::AlignRight, "max");
+  painter.drawText(QRectF(0, plot.bottom() - 16, plot.left() - 4, 16), Qt::AlignRight, "min");
+}
+
+TrainingMonitorDialog::TrainingMonitorDialog(QWidget* parent) : QDialog(parent), running_(false)
+{
+  setWindowTitle("Training Monitor");
+  resize(760, 620);
+
+  status_label_ = new QLabel("Idle", this);
+  epoch_label_ = new QLabel("-", this);
+  eta_label_ = new QLabel("-", this);
+  log_path_label_ = new QLabel(this);
+  log_path_label_->setTextInteractionFlags(Qt::TextSelectableByMouse);
+  progress_bar_ = new QProgressBar(this);
+  progress_bar_->setRange(0, 0);
+
+  QFormLayout* info_layout = new QFormLayout();
+  info_layout->addRow("Status:", status_label_);
+  info_layout->addRow("Epoch:", epoch_label_);
+  info_layout->addRow("Remaining:", eta_label_);
+  info_layout->addRow("Full log:", log_path_label_);
+
+  chart_ = new TrainingMetricChart(this);
+
+  log_view_ = new QPlainTextEdit(this);
+  log_view_->setReadOnly(true);
+  log_view_->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+  log_view_->setMaximumBlockCount(TrainingLogParser::kDefaultMaxLines);
+  log_view_->setLineWrapMode(QPlainTextEdit::NoWrap);
+
+  QSplitter* splitter = new QSplitter(Qt::Vertical, this);
+  splitter->addWidget(chart_);
+  splitter->addWidget(log_view_);
+  splitter->setStretchFactor(1, 1);
+
+  QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+  stop_button_ = buttons->addButton("Stop Training", QDialogButtonBox::ActionRole);
+  stop_button_->setEnabled(false);
+  connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::hide);
+  connect(stop_button_, &QPushButton::clicked, this, &TrainingMonitorDialog::StopRequested);
+
+  QVBoxLayout* layout = new QVBoxLayout(this);
+  layout->addLayout(info_layout);
+  layout->addWidget(progress_bar_);
+  layout->addWidget(splitter, 1);
+  layout->addWidget(buttons);
+
+  refresh_timer_.setSingleShot(true);
+  refresh_timer_.setInterval(kRefreshIntervalMs);
+  connect(&refresh_timer_, &QTimer::timeout, this, &TrainingMonitorDialog::Refresh);
+
+  // Keeps the ETA counting down between epochs
+  eta_timer_.setInterval(1000);
+  connect(&eta_timer_, &QTimer::timeout, this, &TrainingMonitorDialog::Refresh);
+}
+
+void TrainingMonitorDialog::Start(const QString& log_path)
+{
+  parser_.Reset();
+  pending_lines_.clear();
+  log_view_->clear();
+  chart_->SetSeries({});
+  clock_.start();
+  running_ = true;
+
+  status_label_->setText("Running");
+  epoch_label_->setText("-");
+  eta_label_->setText("-");
+  log_path_label_->setText(log_path);
+  progress_bar_->setRange(0, 0);
+  stop_button_->setEnabled(true);
+  eta_timer_.start();
+}
+
+void TrainingMonitorDialog::AppendOutput(const QByteArray& output)
+{
+  pending_lines_.append(parser_.Feed(output, clock_.elapsed()));
+
+  // Lines beyond what the view keeps would be dropped by it anyway
+  const int overflow = pending_lines_.size() - TrainingLogParser::kDefaultMaxLines;
+  if (overflow > 0)
+  {
+    pending_lines_.erase(pending_lines_.begin(), pending_lines_.begin() + overflow);
+  }
+  ScheduleRefresh();
+}
+
+void TrainingMonitorDialog::Finish(bool success, const QString& message)
+{
+  pending_lines_.append(parser_.Finish(clock_.elapsed()));
+  running_ = false;
+  eta_timer_.stop();
+  stop_button_->setEnabled(false);
+  status_label_->setText(message);
+  Refresh();
+
+  progress_bar_->setRange(0, 1);
+  progress_bar_->setValue(success ? 1 : 0);
+  eta_label_->setText(success ? FormatDuration(0) : "-");
+}
+
+void TrainingMonitorDialog::ScheduleRefresh()
+{
+  if (!refresh_timer_.isActive())
+  {
+    refresh_timer_.start();
+  }
+}
+
+void TrainingMonitorDialog::Refresh()
+{
+  if (!pending_lines_.isEmpty())
+  {
+    log_view_->appendPlainText(pending_lines_.join('\n'));
+    pending_lines_.clear();
+    chart_->SetSeries(parser_.Series());
+  }
+
+  if (!running_)
+  {
+    return;
+  }
+
+  const int total = parser_.TotalEpochs();
+  if (total > 0)
+  {
+    epoch_label_->setText(QString("%1 / %2").arg(parser_.CurrentEpoch()).arg(total));
+    progress_bar_->setRange(0, total);
+    progress_bar_->setValue(qMax(0, parser_.CurrentEpoch() - 1));
+  }
+
+  const qint64 eta = parser_.EtaSeconds(clock_.elapsed());
+  eta_label_->setText(eta >= 0 ? FormatDuration(eta) : "estimating...");
+}
+
+QString TrainingMonitorDialog::FormatDuration(qint64 seconds)
+{
+  return QString("%1:%2:%3")
+      .arg(seconds / 3600)
+      .arg((seconds / 60) % 60, 2, 10, QChar('0'))
+      .arg(seconds % 60, 2, 10, QChar('0'));
+}
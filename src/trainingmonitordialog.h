@@ -0,0 +1,100 @@
+#ifndef TRAININGMONITORDIALOG_H
+#define TRAININGMONITORDIALOG_H
+
+#include <QDialog>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QPointF>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+
+#include "traininglogparser.h"
+
+class QLabel;
+class QPlainTextEdit;
+class QProgressBar;
+class QPushButton;
+
+/**
+ * @brief Line chart of the parsed training metrics (loss, mAP) over epochs
+ */
+class TrainingMetricChart : public QWidget
+{
+  Q_OBJECT
+
+ public:
+  explicit TrainingMetricChart(QWidget* parent = nullptr);
+
+  void SetSeries(const QMap<QString, QVector<QPointF>>& series);
+
+ protected:
+  void paintEvent(QPaintEvent* event) override;
+
+ private:
+  QMap<QString, QVector<QPointF>> series_;
+};
+
+/**
+ * @brief In-app monitor for a running training process
+ *
+ * Output chunks are parsed as they arrive, but the view is refreshed on a
+ * timer, so a chatty trainer costs one text append per refresh instead of
+ * one per chunk. The log view keeps a bounded number of lines.
+ *
+ * Closing the dialog only hides it; training keeps running.
+ */
+class TrainingMonitorDialog : public QDialog
+{
+  Q_OBJECT
+
+ public:
+  explicit TrainingMonitorDialog(QWidget* parent = nullptr);
+
+  /**
+   * @brief Reset for a new training run
+   * @param log_path Log file shown to the user for the full output
+   */
+  void Start(const QString& log_path);
+
+  /**
+   * @brief Raw output from the training process (stdout or stderr)
+   */
+  void AppendOutput(const QByteArray& output);
+
+  /**
+   * @brief Training ended
+   */
+  void Finish(bool success, const QString& message);
+
+  bool IsRunning() const { return running_; }
+
+ signals:
+  void StopRequested();
+
+ private:
+  void ScheduleRefresh();
+  void Refresh();
+  static QString FormatDuration(qint64 seconds);
+
+  static constexpr int kRefreshIntervalMs = 250;
+
+  TrainingLogParser parser_;
+  QElapsedTimer clock_;
+  QTimer refresh_timer_;
+  QTimer eta_timer_;
+  QStringList pending_lines_;  // Parsed but not yet shown; capped like the view
+  bool running_;
+
+  QLabel* status_label_;
+  QLabel* epoch_label_;
+  QLabel* eta_label_;
+  QLabel* log_path_label_;
+  QProgressBar* progress_bar_;
+  TrainingMetricChart* chart_;
+  QPlainTextEdit* log_view_;
+  QPushButton* stop_button_;
+};
+
+#endif  // TRAININGMONITORDIALOG_H
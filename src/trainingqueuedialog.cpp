@@ -0,0 +1,176 @@
+#include "trainingqueuedialog.h"
+
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+#include "trainingjobqueue.h"
+
+TrainingQueueDialog::TrainingQueueDialog(TrainingJobQueue* queue, const QStringList& backbones,
+                                         const QString& current_backbone, QWidget* parent)
+    : QDialog(parent), queue_(queue)
+{
+  setWindowTitle("Training Queue");
+  resize(760, 560);
+
+  jobs_table_ = new QTableWidget(0, 5, this);
+  jobs_table_->setHorizontalHeaderLabels({"Name", "Status", "Cores", "Started", "Model / Log"});
+  jobs_table_->setSelectionBehavior(QAbstractItemView::SelectRows);
+  jobs_table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  jobs_table_->verticalHeader()->setVisible(false);
+  jobs_table_->horizontalHeader()->setStretchLastSection(true);
+
+  // New jobs: one per (backbone, seed) combination
+  name_edit_ = new QLineEdit("Training", this);
+
+  backbone_list_ = new QListWidget(this);
+  backbone_list_->setMaximumHeight(110);
+  for (const QString& backbone : backbones)
+  {
+    QListWidgetItem* item = new QListWidgetItem(backbone, backbone_list_);
+    item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+    item->setCheckState(backbone == current_backbone ? Qt::Checked : Qt::Unchecked);
+  }
+  backbone_list_->setEnabled(!backbones.isEmpty());
+
+  seeds_edit_ = new QLineEdit(this);
+  seeds_edit_->setPlaceholderText("Project split (e.g. 1, 2, 3 for re-drawn splits)");
+
+  cores_spin_ = new QSpinBox(this);
+  cores_spin_->setRange(1, queue_->TotalCores());
+  cores_spin_->setValue(queue_->TotalCores());
+  cores_spin_->setToolTip("Jobs run side by side while their cores and memory fit");
+
+  memory_spin_ = new QSpinBox(this);
+  memory_spin_->setRange(0, 1024 * 1024);
+  memory_spin_->setSuffix(" MB");
+  memory_spin_->setSpecialValueText("Unknown");
+
+  QPushButton* queue_button = new QPushButton("Queue Jobs", this);
+
+  QFormLayout* form = new QFormLayout();
+  form->addRow("Name:", name_edit_);
+  form->addRow("Backbones:", backbone_list_);
+  form->addRow("Split seeds:", seeds_edit_);
+  form->addRow("Cores per job:", cores_spin_);
+  form->addRow("Memory per job:", memory_spin_);
+  form->addRow(QString(), queue_button);
+
+  QGroupBox* add_group = new QGroupBox("Add Jobs", this);
+  add_group->setLayout(form);
+
+  QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+  QPushButton* cancel_button = buttons->addButton("Cancel Job", QDialogButtonBox::ActionRole);
+  QPushButton* clear_button = buttons->addButton("Remove Finished", QDialogButtonBox::ActionRole);
+  // Jobs left from a previous session wait here until resumed
+  pause_button_ = buttons->addButton("Pause Queue", QDialogButtonBox::ActionRole);
+
+  QVBoxLayout* layout = new QVBoxLayout(this);
+  layout->addWidget(jobs_table_, 1);
+  layout->addWidget(add_group);
+  layout->addWidget(buttons);
+
+  connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+  connect(queue_button, &QPushButton::clicked, this, &TrainingQueueDialog::OnQueueClicked);
+  connect(cancel_button, &QPushButton::clicked, this, &TrainingQueueDialog::OnCancelClicked);
+  connect(clear_button, &QPushButton::clicked, queue_, &TrainingJobQueue::RemoveFinished);
+  connect(pause_button_, &QPushButton::clicked, this, &TrainingQueueDialog::OnPauseClicked);
+  connect(queue_, &TrainingJobQueue::QueueChanged, this, &TrainingQueueDialog::RefreshJobs);
+
+  RefreshJobs();
+}
+
+void TrainingQueueDialog::RefreshJobs()
+{
+  const QList<TrainingJob>& jobs = queue_->Jobs();
+  jobs_table_->setRowCount(jobs.size());
+  for (int row = 0; row < jobs.size(); ++row)
+  {
+    const TrainingJob& job = jobs[row];
+    QString status = TrainingJob::StatusName(job.status);
+    if (job.status == TrainingJobStatus::Failed)
+    {
+      status += QString(" (%1)").arg(job.exit_code);
+    }
+
+    QTableWidgetItem* name_item = new QTableWidgetItem(job.name);
+    name_item->setData(Qt::UserRole, job.id);
+    jobs_table_->setItem(row, 0, name_item);
+    jobs_table_->setItem(row, 1, new QTableWidgetItem(status));
+    jobs_table_->setItem(row, 2, new QTableWidgetItem(QString::number(job.cores)));
+    jobs_table_->setItem(
+        row, 3, new QTableWidgetItem(job.started_at.toString("yyyy-MM-dd HH:mm:ss")));
+    jobs_table_->setItem(
+        row, 4, new QTableWidgetItem(job.model_path.isEmpty() ? job.log_path : job.model_path));
+  }
+  jobs_table_->resizeColumnsToContents();
+
+  pause_button_->setText(queue_->IsPaused() ? "Resume Queue" : "Pause Queue");
+  setWindowTitle(queue_->IsPaused() ? "Training Queue (paused)" : "Training Queue");
+}
+
+void TrainingQueueDialog::OnQueueClicked()
+{
+  QStringList backbones;
+  for (int i = 0; i < backbone_list_->count(); ++i)
+  {
+    if (backbone_list_->item(i)->checkState() == Qt::Checked)
+    {
+      backbones.append(backbone_list_->item(i)->text());
+    }
+  }
+
+  QList<int> seeds;
+  for (const QString& part : seeds_edit_->text().split(',', Qt::SkipEmptyParts))
+  {
+    bool ok = false;
+    const int seed = part.trimmed().toInt(&ok);
+    if (!ok)
+    {
+      QMessageBox::warning(this, "Invalid Seeds",
+                           "Split seeds must be comma-separated integers.");
+      return;
+    }
+    if (!seeds.contains(seed))
+    {
+      seeds.append(seed);
+    }
+  }
+
+  const QString name = name_edit_->text().trimmed();
+  emit EnqueueRequested(name.isEmpty() ? QString("Training") : name, backbones, seeds,
+                        cores_spin_->value(), memory_spin_->value());
+}
+
+void TrainingQueueDialog::OnCancelClicked()
+{
+  const QList<QTableWidgetItem*> selected = jobs_table_->selectedItems();
+  QStringList ids;
+  for (const QTableWidgetItem* item : selected)
+  {
+    const QTableWidgetItem* name_item = jobs_table_->item(item->row(), 0);
+    const QString id = name_item->data(Qt::UserRole).toString();
+    if (!ids.contains(id))
+    {
+      ids.append(id);
+    }
+  }
+  for (const QString& id : ids)
+  {
+    queue_->Cancel(id);
+  }
+}
+
+void TrainingQueueDialog::OnPauseClicked()
+{
+  queue_->SetPaused(!queue_->IsPaused());
+}
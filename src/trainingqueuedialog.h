@@ -0,0 +1,58 @@
+#ifndef TRAININGQUEUEDIALOG_H
+#define TRAININGQUEUEDIALOG_H
+
+#include <QDialog>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+class QLineEdit;
+class QListWidget;
+class QPushButton;
+class QSpinBox;
+class QTableWidget;
+class TrainingJobQueue;
+
+/**
+ * @brief Lists queued and finished training jobs and queues new variants
+ *
+ * A batch of jobs is one job per (backbone, seed) combination; the dialog only
+ * collects the choice, AIPluginManager builds the commands.
+ */
+class TrainingQueueDialog : public QDialog
+{
+  Q_OBJECT
+
+ public:
+  /**
+   * @param backbones Backbones the registry lists for the configured architecture
+   * @param current_backbone Backbone of the plugin configuration, checked by default
+   */
+  TrainingQueueDialog(TrainingJobQueue* queue, const QStringList& backbones,
+                      const QString& current_backbone, QWidget* parent = nullptr);
+
+ signals:
+  /**
+   * @param backbones Empty to keep the configured backbone
+   * @param seeds Empty to keep the configured split
+   */
+  void EnqueueRequested(const QString& name, const QStringList& backbones, const QList<int>& seeds,
+                        int cores, qint64 memory_mb);
+
+ private:
+  void RefreshJobs();
+  void OnQueueClicked();
+  void OnCancelClicked();
+  void OnPauseClicked();
+
+  TrainingJobQueue* queue_;
+  QTableWidget* jobs_table_;
+  QLineEdit* name_edit_;
+  QListWidget* backbone_list_;
+  QLineEdit* seeds_edit_;
+  QSpinBox* cores_spin_;
+  QSpinBox* memory_spin_;
+  QPushButton* pause_button_;
+};
+
+#endif  // TRAININGQUEUEDIALOG_H
@@ -1,10 +1,11 @@
 #include "downloadpage.h"
 
-#include <QDateTime>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QMessageBox>
 
+#include "../modeldownloadmanager.h"
 #include "../pluginwizard.h"
 #include "ui_downloadpage.h"
 
@@ -12,13 +13,9 @@ DownloadPage::DownloadPage(PluginWizard* wizard)
     : QWizardPage(wizard),
       wizard_(wizard),
       ui_(new Ui::DownloadPage),
-      network_manager_(new QNetworkAccessManager(this)),
-      current_reply_(nullptr),
+      download_manager_(new ModelDownloadManager(this)),
       download_complete_(false),
-      download_cancelled_(false),
-      download_start_time_(0),
-      last_bytes_received_(0),
-      last_time_(0)
+      download_cancelled_(false)
 {
   ui_->setupUi(this);
 
@@ -30,17 +27,18 @@ DownloadPage::DownloadPage(PluginWizard* wizard)
 
 DownloadPage::~DownloadPage()
 {
-  if (current_reply_)
-  {
-    current_reply_->abort();
-    current_reply_->deleteLater();
-  }
   delete ui_;
 }
 
 void DownloadPage::ConnectSignals()
 {
   connect(ui_->cancel_button_, &QPushButton::clicked, this, &DownloadPage::OnCancelDownload);
+  connect(download_manager_, &ModelDownloadManager::downloadProgress, this,
+          &DownloadPage::OnDownloadProgress);
+  connect(download_manager_, &ModelDownloadManager::downloadFinished, this,
+          &DownloadPage::OnDownloadFinished);
+  connect(download_manager_, &ModelDownloadManager::downloadError, this,
+          &DownloadPage::OnDownloadError);
 }
 
 void DownloadPage::initializePage()
@@ -91,21 +89,14 @@ void DownloadPage::StartDownload()
   QString dest_path = GetDestinationPath();
   QDir().mkpath(QFileInfo(dest_path).absolutePath());
 
-  download_start_time_ = QDateTime::currentMSecsSinceEpoch();
-  last_time_ = download_start_time_;
-  last_bytes_received_ = 0;
-
-  QUrl download_url(url);
-  QNetworkRequest request{download_url};
-  request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
-                       QNetworkRequest::NoLessSafeRedirectPolicy);
-
-  current_reply_ = network_manager_->get(request);
-
-  connect(current_reply_, &QNetworkReply::downloadProgress, this,
-          &DownloadPage::OnDownloadProgress);
-  connect(current_reply_, &QNetworkReply::finished, this, &DownloadPage::OnDownloadFinished);
-  connect(current_reply_, &QNetworkReply::errorOccurred, this, &DownloadPage::OnDownloadError);
+  // Streams to <dest>.part; a previously cancelled download continues from there
+  ModelDownloadInfo info;
+  info.id = wizard_->GetSelectedModelId();
+  info.name = info.id;
+  info.download_url = url;
+  info.size_bytes = -1;
+  info.plugin_id = wizard_->GetSelectedPluginId();
+  download_manager_->DownloadModelToPath(info, dest_path);
 }
 
 QString DownloadPage::GetDownloadUrl() const
@@ -150,7 +141,8 @@ QString DownloadPage::GetDestinationPath() const
   return project_dir + "/models/" + model_id + ".pkl";
 }
 
-void DownloadPage::OnDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
+void DownloadPage::OnDownloadProgress(qint64 bytesReceived, qint64 bytesTotal,
+                                      qint64 bytesPerSecond, qint64 etaSeconds)
 {
   if (bytesTotal <= 0)
   {
@@ -163,96 +155,58 @@ void DownloadPage::OnDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
   ui_->progress_label_->setText(
       tr("Downloaded: %1 / %2").arg(FormatBytes(bytesReceived)).arg(FormatBytes(bytesTotal)));
 
-  // Calculate speed
-  qint64 current_time = QDateTime::currentMSecsSinceEpoch();
-  qint64 elapsed = current_time - last_time_;
-
-  if (elapsed > 500)
-  {  // Update every 500ms
-    qint64 bytes_diff = bytesReceived - last_bytes_received_;
-    qint64 speed = (bytes_diff * 1000) / elapsed;
-
-    ui_->speed_label_->setText(tr("Speed: %1").arg(FormatSpeed(speed)));
-
-    // Estimate remaining time
-    if (speed > 0)
+  // Throughput and ETA are measured by the download worker
+  if (bytesPerSecond > 0)
+  {
+    ui_->speed_label_->setText(tr("Speed: %1").arg(FormatSpeed(bytesPerSecond)));
+  }
+  if (etaSeconds >= 0)
+  {
+    if (etaSeconds < 60)
     {
-      qint64 remaining_bytes = bytesTotal - bytesReceived;
-      qint64 remaining_seconds = remaining_bytes / speed;
-
-      if (remaining_seconds < 60)
-      {
-        ui_->remaining_label_->setText(tr("Remaining: ~%1 seconds").arg(remaining_seconds));
-      }
-      else
-      {
-        ui_->remaining_label_->setText(tr("Remaining: ~%1 minutes").arg(remaining_seconds / 60));
-      }
+      ui_->remaining_label_->setText(tr("Remaining: ~%1 seconds").arg(etaSeconds));
+    }
+    else
+    {
+      ui_->remaining_label_->setText(tr("Remaining: ~%1 minutes").arg(etaSeconds / 60));
     }
-
-    last_bytes_received_ = bytesReceived;
-    last_time_ = current_time;
   }
 }
 
-void DownloadPage::OnDownloadFinished()
+void DownloadPage::OnDownloadFinished(const QString& file_path)
 {
   if (download_cancelled_)
   {
     return;
   }
 
-  if (current_reply_->error() != QNetworkReply::NoError)
-  {
-    return;  // Error handled by OnDownloadError
-  }
-
-  // Save file
-  QString dest_path = GetDestinationPath();
-  QFile file(dest_path);
-
-  if (file.open(QIODevice::WriteOnly))
-  {
-    file.write(current_reply_->readAll());
-    file.close();
-
-    wizard_->SetModelPath(dest_path);
-
-    // Update status
-    ui_->deps_checkbox_->setChecked(true);
-    ui_->verify_checkbox_->setChecked(true);
-    ui_->test_checkbox_->setChecked(true);
+  wizard_->SetModelPath(file_path);
 
-    download_complete_ = true;
-    ui_->cancel_button_->setEnabled(false);
+  // Update status
+  ui_->deps_checkbox_->setChecked(true);
+  ui_->verify_checkbox_->setChecked(true);
+  ui_->test_checkbox_->setChecked(true);
 
-    ui_->progress_bar_->setValue(100);
-    ui_->remaining_label_->setText(tr("Download complete!"));
-  }
-  else
-  {
-    QMessageBox::critical(this, tr("Save Error"),
-                          tr("Failed to save model file:\n%1").arg(dest_path));
-  }
+  download_complete_ = true;
+  ui_->cancel_button_->setEnabled(false);
 
-  current_reply_->deleteLater();
-  current_reply_ = nullptr;
+  ui_->progress_bar_->setValue(100);
+  ui_->remaining_label_->setText(tr("Download complete!"));
 
   emit completeChanged();
 }
 
-void DownloadPage::OnDownloadError(QNetworkReply::NetworkError error)
+void DownloadPage::OnDownloadError(const QString& error_message)
 {
-  (void)error;
   if (download_cancelled_)
   {
     return;
   }
 
-  QString error_msg = current_reply_ ? current_reply_->errorString() : tr("Unknown error");
-
   QMessageBox::critical(this, tr("Download Error"),
-                        tr("Failed to download model:\n%1").arg(error_msg));
+                        tr("Failed to download model:\n%1\n\n"
+                           "Going back and forth resumes the download.")
+                            .arg(error_message));
 
   ui_->cancel_button_->setEnabled(false);
   ui_->progress_label_->setText(tr("Download failed"));
@@ -262,12 +216,8 @@ void DownloadPage::OnCancelDownload()
 {
   download_cancelled_ = true;
 
-  if (current_reply_)
-  {
-    current_reply_->abort();
-    current_reply_->deleteLater();
-    current_reply_ = nullptr;
-  }
+  // The partial file is kept, so the next attempt resumes
+  download_manager_->CancelDownload();
 
   ui_->cancel_button_->setEnabled(false);
   ui_->progress_label_->setText(tr("Download cancelled"));
@@ -1,8 +1,6 @@
 #ifndef DOWNLOADPAGE_H
 #define DOWNLOADPAGE_H
 
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QWizardPage>
 
 namespace Ui
@@ -10,13 +8,14 @@ namespace Ui
 class DownloadPage;
 }
 
+class ModelDownloadManager;
 class PluginWizard;
 
 /**
  * @brief Model download page with progress tracking
  *
  * Handles:
- * - Downloading pre-trained model from URL
+ * - Downloading pre-trained model from URL (resumable, see ModelDownloadManager)
  * - Progress bar and download statistics
  * - Checksum verification
  * - Python dependencies installation (optional)
@@ -34,9 +33,10 @@ class DownloadPage : public QWizardPage
   bool isComplete() const override;
 
  private slots:
-  void OnDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
-  void OnDownloadFinished();
-  void OnDownloadError(QNetworkReply::NetworkError error);
+  void OnDownloadProgress(qint64 bytesReceived, qint64 bytesTotal, qint64 bytesPerSecond,
+                          qint64 etaSeconds);
+  void OnDownloadFinished(const QString& file_path);
+  void OnDownloadError(const QString& error_message);
   void OnCancelDownload();
 
  private:
@@ -51,15 +51,11 @@ class DownloadPage : public QWizardPage
   Ui::DownloadPage* ui_;
 
   // Network
-  QNetworkAccessManager* network_manager_;
-  QNetworkReply* current_reply_;
+  ModelDownloadManager* download_manager_;
 
   // State
   bool download_complete_;
   bool download_cancelled_;
-  qint64 download_start_time_;
-  qint64 last_bytes_received_;
-  qint64 last_time_;
 };
 
 #endif  // DOWNLOADPAGE_H
@@ -146,6 +146,17 @@ QString SummaryPage::GenerateSummary() const
                 .arg(tr("Model:"))
                 .arg(model_display);
 
+    QString env_display = tr("System Python");
+    if (wizard_->GetCreateProjectVenv())
+    {
+      env_display = wizard_->GetShareBaseEnvironment()
+                        ? tr("Project venv over the shared plugin environment")
+                        : tr("Isolated project venv");
+    }
+    html += QString("<tr><td>%1</td><td>%2</td></tr>")
+                .arg(tr("Environment:"))
+                .arg(env_display);
+
     // Model path
     QString model_path = wizard_->GetModelPath();
     if (!model_path.isEmpty())
@@ -1,15 +1,22 @@
 #include "welcomepage.h"
 
-#include <QProcess>
-
 #include "../pluginwizard.h"
+#include "../pythonenvironmentmanager.h"
 #include "ui_welcomepage.h"
 
 WelcomePage::WelcomePage(PluginWizard* wizard)
-    : QWizardPage(wizard), wizard_(wizard), ui_(new Ui::WelcomePage)
+    : QWizardPage(wizard),
+      wizard_(wizard),
+      ui_(new Ui::WelcomePage),
+      python_manager_(new PythonEnvironmentManager(this))
 {
   ui_->setupUi(this);
 
+  connect(python_manager_, &PythonEnvironmentManager::detectionFinished, this,
+          &WelcomePage::OnPythonDetected);
+  connect(ui_->create_venv_checkbox_, &QCheckBox::toggled, ui_->share_env_checkbox_,
+          &QCheckBox::setEnabled);
+
   setTitle(tr("Welcome to the AI Plugin Setup Wizard"));
   setSubTitle(
       tr("This wizard will help you configure an AI plugin for automatic "
@@ -24,95 +31,37 @@ WelcomePage::~WelcomePage()
 void WelcomePage::initializePage()
 {
   DetectPythonEnvironment();
-  ui_->python_info_label_->setText(FormatPythonInfo());
 }
 
 void WelcomePage::DetectPythonEnvironment()
 {
-  PluginWizard::PythonInfo info;
-  info.has_venv = false;
-  info.has_pip = false;
-  info.has_cuda = false;
-  info.has_mps = false;
-
-  // Detect Python path and version
-  QProcess process;
-  process.start("python3", {"--version"});
-  process.waitForFinished(5000);
+  // Probing interpreters imports torch; show the page while it runs
+  ui_->python_info_label_->setText(tr("Detecting Python environment..."));
+  python_manager_->DetectPythonAsync();
+}
 
-  if (process.exitCode() == 0)
+void WelcomePage::OnPythonDetected(const PythonInfo& python)
+{
+  PluginWizard::PythonInfo info;
+  if (python.is_valid)
   {
-    QString output = process.readAllStandardOutput().trimmed();
-    // Output is like "Python 3.11.2"
-    QStringList parts = output.split(' ');
-    if (parts.size() >= 2)
-    {
-      info.version = parts[1];
-    }
-
-    // Get Python path
-    QProcess which_process;
-    which_process.start("which", {"python3"});
-    which_process.waitForFinished(5000);
-    if (which_process.exitCode() == 0)
-    {
-      info.path = which_process.readAllStandardOutput().trimmed();
-    }
-
-    // Check for venv module
-    QProcess venv_process;
-    venv_process.start("python3", {"-c", "import venv; print('OK')"});
-    venv_process.waitForFinished(5000);
-    info.has_venv = (venv_process.exitCode() == 0);
-
-    // Check for pip
-    QProcess pip_process;
-    pip_process.start("python3", {"-m", "pip", "--version"});
-    pip_process.waitForFinished(5000);
-    info.has_pip = (pip_process.exitCode() == 0);
-
-    // Check for CUDA via PyTorch
-    QProcess cuda_process;
-    cuda_process.start("python3",
-                       {"-c",
-                        "import torch; print('CUDA' if torch.cuda.is_available() else 'NO'); "
-                        "print(torch.cuda.get_device_name(0) if torch.cuda.is_available() "
-                        "else '')"});
-    cuda_process.waitForFinished(10000);
-
-    if (cuda_process.exitCode() == 0)
-    {
-      QString cuda_output = cuda_process.readAllStandardOutput().trimmed();
-      QStringList cuda_lines = cuda_output.split('\n');
-      if (!cuda_lines.isEmpty() && cuda_lines[0] == "CUDA")
-      {
-        info.has_cuda = true;
-        if (cuda_lines.size() > 1)
-        {
-          info.cuda_version = cuda_lines[1];
-        }
-      }
-    }
-
-    // Check for Apple Silicon MPS via PyTorch
-    QProcess mps_process;
-    mps_process.start("python3",
-                      {"-c",
-                       "import torch; print('MPS' if (hasattr(torch.backends, 'mps') and "
-                       "torch.backends.mps.is_available()) else 'NO')"});
-    mps_process.waitForFinished(10000);
-
-    if (mps_process.exitCode() == 0)
-    {
-      QString mps_output = mps_process.readAllStandardOutput().trimmed();
-      if (mps_output == "MPS")
-      {
-        info.has_mps = true;
-      }
-    }
+    info.path = python.path;
+    info.version = python.version;
+    info.has_venv = python.has_venv;
+    info.has_pip = python.has_pip;
+    info.has_cuda = python.has_cuda;
+    info.cuda_version = python.gpu_name.isEmpty() ? python.cuda_version : python.gpu_name;
+    info.has_mps = python.has_mps;
   }
 
   wizard_->SetPythonInfo(info);
+  ui_->python_info_label_->setText(FormatPythonInfo());
+
+  if (!info.has_venv)
+  {
+    ui_->create_venv_checkbox_->setChecked(false);
+  }
+  ui_->create_venv_checkbox_->setEnabled(info.has_venv);
 }
 
 QString WelcomePage::FormatPythonInfo() const
@@ -170,6 +119,9 @@ QString WelcomePage::FormatPythonInfo() const
 
 bool WelcomePage::validatePage()
 {
+  wizard_->SetCreateProjectVenv(ui_->create_venv_checkbox_->isChecked());
+  wizard_->SetShareBaseEnvironment(ui_->share_env_checkbox_->isChecked());
+
   // Python is not strictly required for custom binary plugins
   // but we'll allow proceeding with a warning
   return true;
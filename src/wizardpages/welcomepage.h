@@ -9,6 +9,8 @@ class WelcomePage;
 }
 
 class PluginWizard;
+class PythonEnvironmentManager;
+struct PythonInfo;
 
 /**
  * @brief Welcome page of the Plugin Wizard
@@ -17,7 +19,7 @@ class PluginWizard;
  * - Introduction to the wizard
  * - Detected Python environment
  * - CUDA/GPU availability
- * - Option to create virtual environment
+ * - Option to create virtual environment, optionally over a shared base
  */
 class WelcomePage : public QWizardPage
 {
@@ -32,10 +34,12 @@ class WelcomePage : public QWizardPage
 
  private:
   void DetectPythonEnvironment();
+  void OnPythonDetected(const PythonInfo& python);
   QString FormatPythonInfo() const;
 
   PluginWizard* wizard_;
   Ui::WelcomePage* ui_;
+  PythonEnvironmentManager* python_manager_;
 };
 
 #endif  // WELCOMEPAGE_H
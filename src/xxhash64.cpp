@@ -0,0 +1,166 @@
+#include "xxhash64.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+namespace
+{
+
+constexpr quint64 kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr quint64 kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr quint64 kPrime3 = 0x165667B19E3779F9ULL;
+constexpr quint64 kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr quint64 kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline quint64 RotateLeft(quint64 value, int bits)
+{
+  return (value << bits) | (value >> (64 - bits));
+}
+
+inline quint64 Round(quint64 acc, quint64 input)
+{
+  acc += input * kPrime2;
+  acc = RotateLeft(acc, 31);
+  return acc * kPrime1;
+}
+
+inline quint64 MergeRound(quint64 acc, quint64 value)
+{
+  acc ^= Round(0, value);
+  return acc * kPrime1 + kPrime4;
+}
+
+inline quint64 Read64(const unsigned char* p)
+{
+  return qFromLittleEndian<quint64>(p);
+}
+
+inline quint64 Read32(const unsigned char* p)
+{
+  return qFromLittleEndian<quint32>(p);
+}
+
+}  // namespace
+
+XxHash64::XxHash64(quint64 seed)
+{
+  Reset(seed);
+}
+
+void XxHash64::Reset(quint64 seed)
+{
+  seed_ = seed;
+  acc_[0] = seed + kPrime1 + kPrime2;
+  acc_[1] = seed + kPrime2;
+  acc_[2] = seed;
+  acc_[3] = seed - kPrime1;
+  total_length_ = 0;
+  buffer_size_ = 0;
+}
+
+void XxHash64::AddData(const char* data, qint64 length)
+{
+  if (length <= 0)
+  {
+    return;
+  }
+
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+  const unsigned char* end = p + length;
+  total_length_ += static_cast<quint64>(length);
+
+  // Complete a partially filled stripe first
+  if (buffer_size_ > 0)
+  {
+    const int needed = 32 - buffer_size_;
+    if (length < needed)
+    {
+      std::memcpy(buffer_ + buffer_size_, p, static_cast<size_t>(length));
+      buffer_size_ += static_cast<int>(length);
+      return;
+    }
+
+    std::memcpy(buffer_ + buffer_size_, p, static_cast<size_t>(needed));
+    for (int i = 0; i < 4; ++i)
+    {
+      acc_[i] = Round(acc_[i], Read64(buffer_ + 8 * i));
+    }
+    p += needed;
+    buffer_size_ = 0;
+  }
+
+  while (end - p >= 32)
+  {
+    for (int i = 0; i < 4; ++i)
+    {
+      acc_[i] = Round(acc_[i], Read64(p + 8 * i));
+    }
+    p += 32;
+  }
+
+  if (p < end)
+  {
+    buffer_size_ = static_cast<int>(end - p);
+    std::memcpy(buffer_, p, static_cast<size_t>(buffer_size_));
+  }
+}
+
+quint64 XxHash64::Result() const
+{
+  quint64 hash;
+  if (total_length_ >= 32)
+  {
+    hash = RotateLeft(acc_[0], 1) + RotateLeft(acc_[1], 7) + RotateLeft(acc_[2], 12) +
+           RotateLeft(acc_[3], 18);
+    for (int i = 0; i < 4; ++i)
+    {
+      hash = MergeRound(hash, acc_[i]);
+    }
+  }
+  else
+  {
+    hash = seed_ + kPrime5;
+  }
+
+  hash += total_length_;
+
+  const unsigned char* p = buffer_;
+  const unsigned char* end = buffer_ + buffer_size_;
+
+  while (end - p >= 8)
+  {
+    hash ^= Round(0, Read64(p));
+    hash = RotateLeft(hash, 27) * kPrime1 + kPrime4;
+    p += 8;
+  }
+
+  if (end - p >= 4)
+  {
+    hash ^= Read32(p) * kPrime1;
+    hash = RotateLeft(hash, 23) * kPrime2 + kPrime3;
+    p += 4;
+  }
+
+  while (p < end)
+  {
+    hash ^= (*p) * kPrime5;
+    hash = RotateLeft(hash, 11) * kPrime1;
+    ++p;
+  }
+
+  // Final avalanche
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+quint64 XxHash64::Hash(const QByteArray& data, quint64 seed)
+{
+  XxHash64 hasher(seed);
+  hasher.AddData(data);
+  return hasher.Result();
+}
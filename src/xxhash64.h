@@ -0,0 +1,29 @@
+#ifndef XXHASH64_H
+#define XXHASH64_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+// Streaming XXH64 (xxHash, 64-bit) - fast non-cryptographic hash with a
+// stable, documented output, so values can be persisted in project files.
+class XxHash64
+{
+ public:
+  explicit XxHash64(quint64 seed = 0);
+
+  void Reset(quint64 seed = 0);
+  void AddData(const char* data, qint64 length);
+  void AddData(const QByteArray& data) { AddData(data.constData(), data.size()); }
+  quint64 Result() const;
+
+  static quint64 Hash(const QByteArray& data, quint64 seed = 0);
+
+ private:
+  quint64 seed_;
+  quint64 acc_[4];
+  quint64 total_length_;
+  unsigned char buffer_[32];
+  int buffer_size_;
+};
+
+#endif  // XXHASH64_H
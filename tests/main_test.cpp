@@ -1,12 +1,168 @@
 #include <gtest/gtest.h>
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
 #include <QString>
 #include <QPoint>
 #include <QVector>
 
+#include <algorithm>
+
 // Include headers from the main application
 #include "projectconfig.h"
 #include "polygoncanvas.h"
+#include "processlimits.h"
+#include "projectscanner.h"
+#include "pythonenvironmentmanager.h"
+#include "pythonpackageindex.h"
+#include "contenthashindex.h"
+#include "datasetmanifest.h"
+#include "imageimporter.h"
+#include "imagelocator.h"
+#include "imageprefetchcache.h"
+#include "imagestatestore.h"
+#include "modelcacheindex.h"
+#include "modelcomparisonengine.h"
+#include "modeldownloadmanager.h"
+#include "reviewstatetable.h"
+#include "thumbnailcache.h"
+#include "trainingjobqueue.h"
+#include "traininglogparser.h"
+#include "xxhash64.h"
+
+// Minimal HTTP/1.1 stand-in for download tests: HEAD and GET with byte ranges
+class RangeHttpServer {
+public:
+    explicit RangeHttpServer(const QByteArray& body) : body_(body) {
+        server_.listen(QHostAddress::LocalHost);
+        QObject::connect(&server_, &QTcpServer::newConnection, [this]() {
+            while (QTcpSocket* socket = server_.nextPendingConnection()) {
+                QObject::connect(socket, &QTcpSocket::readyRead, socket,
+                                 [this, socket]() { OnReadyRead(socket); });
+                QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            }
+        });
+    }
+
+    QString Url() const {
+        return QString("http://127.0.0.1:%1/model.pth").arg(server_.serverPort());
+    }
+
+    QStringList get_ranges;  // Range header of each GET, empty for none
+    QByteArray etag = "\"v1\"";
+    QByteArray head_body;    // HEAD describes this older version when set (file replaced after it)
+    QByteArray head_etag;
+    int failing_gets = 0;    // GETs answered with 503 and an error page
+
+private:
+    void OnReadyRead(QTcpSocket* socket) {
+        QByteArray& buffer = buffers_[socket];
+        buffer += socket->readAll();
+        const int header_end = buffer.indexOf("\r\n\r\n");
+        if (header_end < 0) {
+            return;
+        }
+        const QList<QByteArray> lines = buffer.left(header_end).split('\n');
+        buffers_.remove(socket);
+
+        const QByteArray method = lines.first().split(' ').first();
+        QByteArray range;
+        QByteArray if_range;
+        for (const QByteArray& line : lines) {
+            if (line.toLower().startsWith("range:")) {
+                range = line.mid(6).trimmed();
+            } else if (line.toLower().startsWith("if-range:")) {
+                if_range = line.mid(9).trimmed();
+            }
+        }
+        if (method == "GET") {
+            get_ranges.append(QString::fromLatin1(range));
+            if (failing_gets > 0) {
+                failing_gets--;
+                const QByteArray page = "<html>Service Unavailable</html>";
+                socket->write("HTTP/1.1 503 Service Unavailable\r\nContent-Length: " +
+                              QByteArray::number(page.size()) + "\r\nConnection: close\r\n\r\n" +
+                              page);
+                socket->disconnectFromHost();
+                return;
+            }
+        }
+        if (!if_range.isEmpty() && if_range != etag) {
+            range.clear();  // Changed since: the whole file
+        }
+        const bool old_head = method == "HEAD" && !head_body.isEmpty();
+        const QByteArray& body = old_head ? head_body : body_;
+
+        qint64 first = 0;
+        qint64 last = body.size() - 1;
+        if (range.startsWith("bytes=")) {
+            const QList<QByteArray> bounds = range.mid(6).split('-');
+            first = bounds[0].toLongLong();
+            if (bounds.size() > 1 && !bounds[1].isEmpty()) {
+                last = qMin(last, bounds[1].toLongLong());
+            }
+        }
+        const QByteArray content = body.mid(first, last - first + 1);
+        QByteArray head = range.isEmpty() ? "HTTP/1.1 200 OK\r\n" : "HTTP/1.1 206 Partial Content\r\n";
+        if (!range.isEmpty()) {
+            head += "Content-Range: bytes " + QByteArray::number(first) + "-" +
+                    QByteArray::number(last) + "/" + QByteArray::number(body.size()) + "\r\n";
+        }
+        head += "Content-Length: " + QByteArray::number(method == "GET" ? content.size() : body.size()) +
+                "\r\nAccept-Ranges: bytes\r\nETag: " + (old_head ? head_etag : etag) +
+                "\r\nConnection: close\r\n\r\n";
+        socket->write(head);
+        if (method == "GET") {
+            socket->write(content);
+        }
+        socket->disconnectFromHost();
+    }
+
+    QByteArray body_;
+    QTcpServer server_;
+    QHash<QTcpSocket*, QByteArray> buffers_;
+};
+
+// Points HOME (and so the global model cache and store) at a test directory
+class ScopedHome {
+public:
+    explicit ScopedHome(const QString& path) : previous_(qgetenv("HOME")) {
+        QDir().mkpath(path);
+        qputenv("HOME", QFile::encodeName(path));
+    }
+    ~ScopedHome() { qputenv("HOME", previous_); }
+
+private:
+    QByteArray previous_;
+};
+
+// Runs the event loop until the manager finishes; returns the error message, empty on success
+static QString WaitForDownload(ModelDownloadManager& manager) {
+    QEventLoop loop;
+    QString error = "timeout";
+    QObject::connect(&manager, &ModelDownloadManager::downloadFinished, &loop,
+                     [&]() { error.clear(); loop.quit(); });
+    QObject::connect(&manager, &ModelDownloadManager::downloadError, &loop,
+                     [&](const QString& message) { error = message; loop.quit(); });
+    QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+    loop.exec();
+    return error;
+}
 
 // Test fixture for PolySeg tests
 class PolySegTest : public ::testing::Test {
@@ -111,6 +267,1752 @@ TEST_F(PolySegTest, CoordinateNormalization) {
     EXPECT_NEAR(normalize(300, imageHeight), 0.5, 0.001);
 }
 
+// Test review state table used for unreviewed-image navigation
+TEST_F(PolySegTest, ReviewStateTableCountsAndNavigation) {
+    QStringList images = {"a.jpg", "b.jpg", "c.png", "d.jpg"};
+    QSet<QString> labels = {"a", "d"};
+    QSet<QString> metas = {"b", "d"};
+
+    ReviewStateTable table;
+    table.Rebuild(images, labels, metas);
+
+    EXPECT_EQ(table.Size(), 4);
+    EXPECT_EQ(table.GetState("a.jpg"), ReviewState::Approved);
+    EXPECT_EQ(table.GetState("b.jpg"), ReviewState::Meta);
+    EXPECT_EQ(table.GetState("c.png"), ReviewState::None);
+    EXPECT_EQ(table.GetState("d.jpg"), ReviewState::Approved);  // Approved wins over meta
+    EXPECT_EQ(table.CountUnreviewed(), 2);
+
+    // Search wraps around the end of the list
+    EXPECT_EQ(table.FindNextUnreviewed(0), 1);
+    EXPECT_EQ(table.FindNextUnreviewed(3), 1);
+    EXPECT_EQ(table.FindNextUnreviewed(2), 2);
+
+    table.SetState("b.jpg", ReviewState::Approved);
+    table.SetState(2, ReviewState::Approved);
+    EXPECT_EQ(table.Count(ReviewState::Approved), 4);
+    EXPECT_EQ(table.CountUnreviewed(), 0);
+    EXPECT_EQ(table.FindNextUnreviewed(0), -1);
+
+    // Unknown images are ignored
+    table.SetState("missing.jpg", ReviewState::Meta);
+    EXPECT_EQ(table.GetState("missing.jpg"), ReviewState::None);
+    EXPECT_EQ(table.Count(ReviewState::Meta), 0);
+
+    // Per-stem updates: a file change only re-derives the images with that stem
+    ReviewStateTable incremental;
+    incremental.Rebuild({"cam1.2024.jpg", "b.jpg", "b.png"}, {}, {});
+    EXPECT_EQ(incremental.IndicesForStem("cam1.2024"), QList<int>{0});
+    EXPECT_EQ(incremental.IndicesForStem("cam1"), QList<int>{0});
+    QList<int> b_indices = incremental.IndicesForStem("b");
+    std::sort(b_indices.begin(), b_indices.end());
+    EXPECT_EQ(b_indices, (QList<int>{1, 2}));
+    incremental.Update("cam1.2024.jpg", {"cam1.2024"}, {});
+    incremental.Update("b.png", {}, {"b"});
+    EXPECT_EQ(incremental.GetState(0), ReviewState::Approved);
+    EXPECT_EQ(incremental.GetState(1), ReviewState::None);
+    EXPECT_EQ(incremental.GetState(2), ReviewState::Meta);
+    EXPECT_EQ(incremental.CountUnreviewed(), 2);
+}
+
+// Test label parsing shared by the canvas and the prefetch cache
+TEST_F(PolySegTest, ProjectScannerListsLabelsAndMetasTogether) {
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    const QString project = temp_dir.path();
+    QDir().mkpath(project + "/images");
+    QDir().mkpath(project + "/labels");
+    for (const QString& file : {QString("images/a.jpg"), QString("images/b.png"),
+                                QString("images/c.d.jpg"), QString("images/notes.txt"),
+                                QString("labels/a.txt"), QString("labels/c.d.txt"),
+                                QString("labels/b.meta")}) {
+        QFile f(project + "/" + file);
+        ASSERT_TRUE(f.open(QIODevice::WriteOnly));
+    }
+
+    // Referenced images have no file in images/ but are merged into the sorted list
+    const ProjectScanResult scan = ProjectScanner::Scan(project, {"ab.jpg"});
+    EXPECT_EQ(scan.images, QStringList({"a.jpg", "ab.jpg", "b.png", "c.d.jpg"}));
+    EXPECT_EQ(scan.labels, QSet<QString>({"a", "c.d"}));
+    EXPECT_EQ(scan.metas, QSet<QString>({"b"}));
+    ASSERT_EQ(scan.labeled.size(), 4);
+    EXPECT_EQ(scan.LabeledImages(), QStringList({"a.jpg", "c.d.jpg"}));
+    EXPECT_EQ(scan.LabeledCount(), 2);
+    EXPECT_TRUE(scan.IsLabeled("c.d.jpg"));
+    EXPECT_FALSE(scan.IsLabeled("b.png"));
+
+    EXPECT_TRUE(ProjectScanner::Scan(project + "/missing").images.isEmpty());
+}
+
+TEST_F(PolySegTest, ProjectScannerReportsScanAndChangesAsDiffs) {
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    const QString project = temp_dir.path();
+    QDir().mkpath(project + "/images");
+    auto touch = [&project](const QString& file) {
+        QFile f(project + "/" + file);
+        ASSERT_TRUE(f.open(QIODevice::WriteOnly));
+    };
+    touch("images/a.jpg");
+    touch("images/b.jpg");
+
+    ProjectScanner scanner;
+    QStringList images_added;
+    QStringList images_removed;
+    QStringList labels_added;
+    QStringList labels_removed;
+    QObject::connect(&scanner, &ProjectScanner::ImagesChanged,
+                     [&](const QStringList& added, const QStringList& removed) {
+                         images_added = added;
+                         images_removed = removed;
+                     });
+    QObject::connect(&scanner, &ProjectScanner::LabelsChanged,
+                     [&](const QStringList& added, const QStringList& removed) {
+                         labels_added = added;
+                         labels_removed = removed;
+                     });
+    auto wait_for = [&scanner](auto signal) {
+        QEventLoop loop;
+        QObject::connect(&scanner, signal, &loop, &QEventLoop::quit);
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        loop.exec();
+    };
+
+    // The initial scan runs on the worker and arrives as a diff against nothing
+    scanner.Watch(project);
+    EXPECT_TRUE(scanner.IsScanning());
+    EXPECT_TRUE(scanner.GetSnapshot().images.isEmpty());
+    wait_for(&ProjectScanner::ScanFinished);
+    ASSERT_FALSE(scanner.IsScanning());
+    images_added.sort();
+    EXPECT_EQ(images_added, QStringList({"a.jpg", "b.jpg"}));
+    EXPECT_TRUE(images_removed.isEmpty());
+    EXPECT_EQ(scanner.GetSnapshot().images, QStringList({"a.jpg", "b.jpg"}));
+
+    // Watcher updates report only what changed
+    touch("images/c.jpg");
+    QFile::remove(project + "/images/a.jpg");
+    wait_for(&ProjectScanner::ImagesChanged);
+    EXPECT_EQ(images_added, QStringList({"c.jpg"}));
+    EXPECT_EQ(images_removed, QStringList({"a.jpg"}));
+    EXPECT_EQ(scanner.GetSnapshot().images, QStringList({"b.jpg", "c.jpg"}));
+
+    // labels/ created after Watch() is picked up through the project root
+    QDir().mkpath(project + "/labels");
+    touch("labels/c.txt");
+    wait_for(&ProjectScanner::LabelsChanged);
+    EXPECT_EQ(labels_added, QStringList({"c"}));
+    EXPECT_TRUE(labels_removed.isEmpty());
+    EXPECT_EQ(scanner.GetSnapshot().LabeledImages(), QStringList({"c.jpg"}));
+
+    // Images the application adds itself are merged without a relisting
+    scanner.AddImages({"b.jpg", "d.jpg"});
+    EXPECT_EQ(images_added, QStringList({"d.jpg"}));
+    EXPECT_EQ(scanner.GetSnapshot().images, QStringList({"b.jpg", "c.jpg", "d.jpg"}));
+}
+
+TEST_F(PolySegTest, ParseAnnotationsDenormalizes) {
+    QByteArray data("0 0.0 0.0 0.5 0.0 0.5 0.5\n"
+                    "\n"
+                    "1 0.1 0.1 0.2\n"              // Too few coordinates
+                    "x 0.1 0.1 0.2 0.2 0.3 0.3\n"  // Invalid class id
+                    "2 1.0 1.0 0.0 1.0 0.25 0.5\n");
+    QVector<QColor> colors = {Qt::green};
+
+    QVector<Polygon> polygons = PolygonCanvas::ParseAnnotations(data, QSize(200, 100), colors);
+
+    ASSERT_EQ(polygons.size(), 2);
+    EXPECT_EQ(polygons[0].class_id, 0);
+    EXPECT_EQ(polygons[0].color, QColor(Qt::green));
+    EXPECT_EQ(polygons[0].points[2], QPoint(100, 50));
+    EXPECT_EQ(polygons[1].class_id, 2);
+    EXPECT_EQ(polygons[1].color, QColor(Qt::red));  // No color for class 2
+    EXPECT_EQ(polygons[1].points[0], QPoint(200, 100));
+
+    EXPECT_TRUE(PolygonCanvas::ParseAnnotations(data, QSize(0, 0), colors).isEmpty());
+}
+
+TEST_F(PolySegTest, PreviewDecodeMatchesZoomAndKeepsOriginalCoordinates) {
+    // A preview serves a zoom while it has as many pixels as the zoom displays
+    EXPECT_TRUE(PolygonCanvas::PreviewCovers(QSize(500, 375), QSize(2000, 1500), 0.25));
+    EXPECT_FALSE(PolygonCanvas::PreviewCovers(QSize(500, 375), QSize(2000, 1500), 0.5));
+    EXPECT_FALSE(PolygonCanvas::PreviewCovers(QSize(500, 375), QSize(2000, 1500), 0.25 * 2.0));
+    EXPECT_TRUE(PolygonCanvas::PreviewCovers(QSize(2000, 1500), QSize(2000, 1500), 1.0));
+
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    const QString image_path = temp_dir.filePath("a.jpg");
+    const QString label_path = temp_dir.filePath("a.txt");
+    QImage image(800, 600, QImage::Format_RGB32);
+    image.fill(Qt::gray);
+    ASSERT_TRUE(image.save(image_path, "JPG"));
+    QFile label(label_path);
+    ASSERT_TRUE(label.open(QIODevice::WriteOnly));
+    label.write("0 0.5 0.5 1.0 0.5 1.0 1.0\n");
+    label.close();
+
+    // Below 100% only the displayed pixels are decoded, and the result needs no refining
+    const PrefetchedImage preview = ImagePrefetchCache::DecodePreview(image_path, label_path, 0.25);
+    EXPECT_EQ(preview.image.size(), QSize(200, 150));
+    EXPECT_EQ(preview.original_size, QSize(800, 600));
+    EXPECT_TRUE(PolygonCanvas::PreviewCovers(preview.image.size(), preview.original_size, 0.25));
+
+    // Labels are parsed in original coordinates, not preview pixels
+    ASSERT_TRUE(preview.has_label);
+    ASSERT_EQ(preview.polygons.size(), 1);
+    EXPECT_EQ(preview.polygons[0].points[0], QPoint(400, 300));
+    EXPECT_EQ(preview.polygons[0].points[2], QPoint(800, 600));
+
+    // 100% (or a 2x display) needs every pixel: one full decode, no preview first
+    const PrefetchedImage full = ImagePrefetchCache::DecodePreview(image_path, label_path, 1.0);
+    EXPECT_EQ(full.image.size(), QSize(800, 600));
+    EXPECT_EQ(full.original_size, QSize(800, 600));
+
+    const PrefetchedImage cropped = ImagePrefetchCache::DecodePreview(
+        image_path, label_path, 0.5, QRect(100, 100, 400, 200));
+    EXPECT_EQ(cropped.image.size(), QSize(200, 100));
+    EXPECT_EQ(cropped.original_size, QSize(400, 200));
+
+    // Mouse positions map through the zoom to original coordinates, whatever the
+    // resolution of the pixmap shown
+    EXPECT_EQ(PolygonCanvas::WidgetToImage(QPoint(100, 50), 0.25f, QSize(800, 600)),
+              QPoint(400, 200));
+    EXPECT_EQ(PolygonCanvas::WidgetToImage(QPoint(300, 200), 0.25f, QSize(800, 600)),
+              QPoint(799, 599));
+    EXPECT_EQ(PolygonCanvas::WidgetToImage(QPoint(-5, 10), 2.0f, QSize(800, 600)),
+              QPoint(0, 5));
+}
+
+TEST_F(PolySegTest, PrefetchCacheReportsFailedDecodes) {
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    const QString project = temp_dir.path();
+    QDir().mkpath(project + "/images");
+    QFile broken(project + "/images/broken.jpg");
+    ASSERT_TRUE(broken.open(QIODevice::WriteOnly));
+    broken.write("not a jpeg");
+    broken.close();
+
+    ImagePrefetchCache cache;
+    cache.SetImageLocator(ImageLocator(project, {}));
+    QString failed_file;
+    QString failed_error;
+    bool ready = false;
+    QObject::connect(&cache, &ImagePrefetchCache::ImageReady, [&ready]() { ready = true; });
+
+    QEventLoop loop;
+    QObject::connect(&cache, &ImagePrefetchCache::DecodeFailed, &loop,
+                     [&](const QString& image_file, const QString& error) {
+                         failed_file = image_file;
+                         failed_error = error;
+                         loop.quit();
+                     });
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    cache.Request("broken.jpg");
+    loop.exec();
+
+    EXPECT_EQ(failed_file, QString("broken.jpg"));
+    EXPECT_FALSE(failed_error.isEmpty());
+    EXPECT_FALSE(ready);
+    PrefetchedImage entry;
+    EXPECT_FALSE(cache.TryGet("broken.jpg", &entry));
+}
+
+// Test content-hashed thumbnail cache keys and generation
+TEST_F(PolySegTest, ThumbnailCacheContentKeyAndCreate) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    QImage image(400, 200, QImage::Format_RGB32);
+    image.fill(Qt::blue);
+    const QString a = dir.filePath("a.png");
+    const QString b = dir.filePath("b.png");
+    ASSERT_TRUE(image.save(a));
+    ASSERT_TRUE(QFile::copy(a, b));
+
+    // Same content under another name shares the thumbnail
+    EXPECT_FALSE(ThumbnailCache::ContentKey(a).isEmpty());
+    EXPECT_EQ(ThumbnailCache::ContentKey(a), ThumbnailCache::ContentKey(b));
+    EXPECT_TRUE(ThumbnailCache::ContentKey(dir.filePath("missing.png")).isEmpty());
+
+    const QString thumbs = dir.filePath(".thumbnails");
+    QImage thumbnail = ThumbnailCache::LoadOrCreate(a, thumbs);
+    ASSERT_FALSE(thumbnail.isNull());
+    EXPECT_EQ(thumbnail.width(), ThumbnailCache::kThumbnailSize);
+    EXPECT_EQ(thumbnail.height(), ThumbnailCache::kThumbnailSize / 2);
+    EXPECT_EQ(QDir(thumbs).entryList(QDir::Files).size(), 1);
+
+    // Second image hits the disk cache instead of writing a new file
+    EXPECT_FALSE(ThumbnailCache::LoadOrCreate(b, thumbs).isNull());
+    EXPECT_EQ(QDir(thumbs).entryList(QDir::Files).size(), 1);
+}
+
+// Test import naming and in-memory crop
+TEST_F(PolySegTest, ImageImporterNamingAndCrop) {
+    ImportPathConfig import_cfg;
+    import_cfg.base_path = "/data/raw";
+    import_cfg.skip_folders = QStringList() << "BMP";
+    EXPECT_EQ(ImageImporter::ImportFileName("/data/raw/cam1/BMP/day2/img.png", import_cfg),
+              QString("cam1_day2_img.png"));
+    EXPECT_EQ(ImageImporter::ImportFileName("/data/raw/img.png", import_cfg),
+              QString("img.png"));
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    QImage image(100, 80, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    const QString source = dir.filePath("source.png");
+    ASSERT_TRUE(image.save(source));
+
+    CropConfig crop;
+    crop.enabled = true;
+    crop.x = 10;
+    crop.y = 20;
+    crop.width = 50;
+    crop.height = 0;  // Rest of the image
+    const QString cropped = dir.filePath("cropped.png");
+    ASSERT_TRUE(ImageImporter::CropImageFile(source, cropped, crop));
+    EXPECT_EQ(QImage(cropped).size(), QSize(50, 60));
+
+    // Crop outside the image keeps the original unchanged
+    crop.width = 500;
+    const QString kept = dir.filePath("kept.png");
+    ASSERT_TRUE(ImageImporter::CropImageFile(source, kept, crop));
+    EXPECT_EQ(QImage(kept).size(), QSize(100, 80));
+
+    const QString copied = dir.filePath("copied.png");
+    ASSERT_TRUE(ImageImporter::CopyImageFile(source, copied));
+    EXPECT_EQ(QFileInfo(copied).size(), QFileInfo(source).size());
+}
+
+TEST_F(PolySegTest, ImageImporterLinksDuplicatesWithinBatch) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    QImage image(64, 48, QImage::Format_RGB32);
+    image.fill(Qt::green);
+    const QString first = dir.filePath("raw/first.png");
+    const QString second = dir.filePath("raw/second.png");
+    QDir().mkpath(dir.filePath("raw"));
+    ASSERT_TRUE(image.save(first));
+    ASSERT_TRUE(QFile::copy(first, second));
+
+    // The match of the second copy is only written during the same batch
+    ImportPathConfig import_cfg;
+    import_cfg.base_path = dir.filePath("raw");
+    import_cfg.duplicate_policy = "link";
+    const QString project = dir.filePath("project");
+    ImageImporter importer;
+    ImportResult result;
+    QEventLoop loop;
+    QObject::connect(&importer, &ImageImporter::Finished, &loop,
+                     [&](const ImportResult& finished) { result = finished; loop.quit(); });
+    QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+    importer.Start({first, second}, project, import_cfg, CropConfig());
+    loop.exec();
+
+    result.added.sort();
+    EXPECT_EQ(result.added, (QStringList{"first.png", "second.png"}));
+    EXPECT_EQ(result.linked, 1);
+    EXPECT_TRUE(result.duplicates.isEmpty());
+    EXPECT_EQ(QImage(project + "/images/first.png"), QImage(project + "/images/second.png"));
+}
+
+// Test JPEG frame header parsing and MCU snapping for lossless crop
+TEST_F(PolySegTest, ImageImporterJpegMcuSnap) {
+    // 4:2:0 subsampling -> 16x16 MCU
+    EXPECT_EQ(ImageImporter::SnapToMcu(QRect(13, 7, 100, 50), QSize(16, 16), QSize(640, 480)),
+              QRect(16, 0, 100, 50));
+    EXPECT_EQ(ImageImporter::SnapToMcu(QRect(32, 16, 10, 10), QSize(16, 16), QSize(640, 480)),
+              QRect(32, 16, 10, 10));
+    // Rounding up would overflow the image, so the offset moves down instead
+    EXPECT_EQ(ImageImporter::SnapToMcu(QRect(9, 0, 631, 480), QSize(16, 16), QSize(640, 480)),
+              QRect(0, 0, 631, 480));
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString png = dir.filePath("a.png");
+    QImage image(120, 90, QImage::Format_RGB32);
+    image.fill(Qt::green);
+    ASSERT_TRUE(image.save(png));
+
+    QSize size;
+    QSize mcu;
+    EXPECT_FALSE(ImageImporter::ReadJpegInfo(png, &size, &mcu));
+
+    const QString jpg = dir.filePath("a.jpg");
+    if (!image.save(jpg, "JPG")) {
+        GTEST_SKIP() << "JPEG image format plugin not available";
+    }
+    ASSERT_TRUE(ImageImporter::ReadJpegInfo(jpg, &size, &mcu));
+    EXPECT_EQ(size, QSize(120, 90));
+    EXPECT_TRUE(mcu.width() == 8 || mcu.width() == 16);
+    EXPECT_TRUE(mcu.height() == 8 || mcu.height() == 16);
+}
+
+// Test XXH64 reference values and duplicate lookups in the content index
+TEST_F(PolySegTest, ContentHashIndexFindsDuplicates) {
+    EXPECT_EQ(XxHash64::Hash(QByteArray()), 0xEF46DB3751D8E999ULL);
+    EXPECT_EQ(XxHash64::Hash(QByteArray("abc")), 0x44BC2CF5AD770999ULL);
+
+    // Streaming in uneven pieces gives the one-shot result
+    QByteArray data(1000, Qt::Uninitialized);
+    for (int i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i * 7);
+    }
+    XxHash64 hasher(42);
+    hasher.AddData(data.left(3));
+    hasher.AddData(data.mid(3, 61));
+    hasher.AddData(data.mid(64));
+    EXPECT_EQ(hasher.Result(), XxHash64::Hash(data, 42));
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString images_dir = dir.filePath("images");
+    ASSERT_TRUE(QDir().mkpath(images_dir));
+    QImage image(64, 48, QImage::Format_RGB32);
+    for (int x = 0; x < image.width(); ++x) {
+        for (int y = 0; y < image.height(); ++y) {
+            image.setPixel(x, y, qRgb(x * 4, y * 5, 0));
+        }
+    }
+    ASSERT_TRUE(image.save(images_dir + "/a.png"));
+    ASSERT_TRUE(image.save(dir.filePath("copy.png")));
+
+    const qint64 size = QFileInfo(dir.filePath("copy.png")).size();
+    ContentHashIndex index;
+    ASSERT_TRUE(index.Load(dir.path()));
+    index.Sync(images_dir, QStringList() << "a.png", QSet<qint64>() << size, true);
+    EXPECT_TRUE(index.ContainsSize(size));
+
+    quint64 hash = 0;
+    ASSERT_TRUE(ContentHashIndex::FileHash(dir.filePath("copy.png"), &hash));
+    EXPECT_EQ(index.FindExact(size, hash), QString("a.png"));
+    EXPECT_TRUE(index.FindExact(size, hash + 1).isEmpty());
+
+    quint64 dhash = 0;
+    ASSERT_TRUE(ContentHashIndex::PerceptualHash(dir.filePath("copy.png"), &dhash));
+    EXPECT_EQ(index.FindNear(dhash, 0), QString("a.png"));
+    EXPECT_EQ(ContentHashIndex::HammingDistance(0x0FULL, 0x03ULL), 2);
+
+    // Hashes survive a save/load round trip
+    ASSERT_TRUE(index.Save(dir.path()));
+    ContentHashIndex reloaded;
+    ASSERT_TRUE(reloaded.Load(dir.path()));
+    EXPECT_EQ(reloaded.FindExact(size, hash), QString("a.png"));
+}
+
+// Test reference storage: resolution, virtual crop and export for plugins
+TEST_F(PolySegTest, ImageLocatorResolvesReferences) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString source = dir.filePath("archive/cam1/frame.png");
+    ASSERT_TRUE(QDir().mkpath(QFileInfo(source).absolutePath()));
+    QImage image(100, 80, QImage::Format_RGB32);
+    image.fill(Qt::blue);
+    ASSERT_TRUE(image.save(source));
+
+    ImageReference ref;
+    ref.path = source;
+    ref.size = QFileInfo(source).size();
+    ref.mtime = QFileInfo(source).lastModified().toMSecsSinceEpoch();
+    ASSERT_TRUE(ContentHashIndex::FileHash(source, &ref.hash));
+    ref.has_hash = true;
+    ref.crop = QRect(10, 20, 50, 40);
+
+    const ImageReference loaded = ImageReference::FromJson(ref.ToJson());
+    EXPECT_EQ(loaded.path, ref.path);
+    EXPECT_EQ(loaded.hash, ref.hash);
+    EXPECT_EQ(loaded.crop, ref.crop);
+
+    QMap<QString, ImageReference> references;
+    references["cam1_frame.png"] = ref;
+    const QString project = dir.filePath("project");
+    const ImageLocator locator(project, references);
+
+    EXPECT_EQ(locator.ProjectPath("cam1_frame.png"), project + "/images/cam1_frame.png");
+    EXPECT_EQ(locator.SourcePath("cam1_frame.png"), source);
+    EXPECT_EQ(locator.SourcePath("copied.png"), project + "/images/copied.png");
+    EXPECT_EQ(locator.Read("cam1_frame.png").size(), QSize(50, 40));
+    EXPECT_TRUE(locator.VerifyReferences().isEmpty());
+
+    // Tools get a file named after the project image with the crop applied
+    const QString exported = locator.ExportPath("cam1_frame.png");
+    EXPECT_EQ(QFileInfo(exported).fileName(), QString("cam1_frame.png"));
+    EXPECT_EQ(QImage(exported).size(), QSize(50, 40));
+
+#ifdef Q_OS_UNIX
+    // Trainers look up the label by swapping the last /images/ of the path for /labels/
+    ASSERT_TRUE(QDir().mkpath(project + "/labels"));
+    QFile label_file(project + "/labels/cam1_frame.txt");
+    ASSERT_TRUE(label_file.open(QIODevice::WriteOnly));
+    label_file.write("0 0.1 0.1 0.2 0.1 0.2 0.2\n");
+    label_file.close();
+
+    QString label_path = exported;
+    const int images_part = label_path.lastIndexOf("/images/");
+    ASSERT_GE(images_part, 0);
+    label_path.replace(images_part, 8, "/labels/");
+    label_path = label_path.left(label_path.lastIndexOf('.')) + ".txt";
+    QFile exported_label(label_path);
+    ASSERT_TRUE(exported_label.open(QIODevice::ReadOnly));
+    EXPECT_EQ(exported_label.readAll(), QByteArray("0 0.1 0.1 0.2 0.1 0.2 0.2\n"));
+#endif
+
+    ASSERT_TRUE(QFile::remove(source));
+    EXPECT_EQ(locator.VerifyReferences(), QStringList() << "cam1_frame.png");
+}
+
+TEST_F(PolySegTest, DatasetManifestDetectsLabelChanges) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString project = dir.path();
+    const QString labels_dir = project + "/labels";
+    ASSERT_TRUE(QDir().mkpath(labels_dir));
+
+    // Generated files are only rewritten when their content changes
+    const QString split_file = project + "/splits/train.txt";
+    EXPECT_TRUE(DatasetManifest::WriteIfChanged(split_file, "a.png\nb.png\n"));
+    EXPECT_FALSE(DatasetManifest::WriteIfChanged(split_file, "a.png\nb.png\n"));
+    EXPECT_TRUE(DatasetManifest::WriteIfChanged(split_file, "a.png\n"));
+
+    QFile label(labels_dir + "/a.txt");
+    ASSERT_TRUE(label.open(QIODevice::WriteOnly));
+    label.write("0 0.1 0.1 0.2 0.1 0.2 0.2\n");
+    label.close();
+
+    const QStringList images = {"a.png", "b.png"};
+    DatasetManifest manifest;
+    ASSERT_TRUE(manifest.Load(project));
+    EXPECT_TRUE(manifest.UpdateSplit("train", labels_dir, images));
+    EXPECT_FALSE(manifest.UpdateSplit("train", labels_dir, images));
+    ASSERT_TRUE(manifest.Save(project));
+
+    // State survives a reload; a new label for b.png changes the split
+    DatasetManifest reloaded;
+    ASSERT_TRUE(reloaded.Load(project));
+    EXPECT_FALSE(reloaded.UpdateSplit("train", labels_dir, images));
+    QFile new_label(labels_dir + "/b.txt");
+    ASSERT_TRUE(new_label.open(QIODevice::WriteOnly));
+    new_label.write("1 0.5 0.5 0.6 0.5 0.6 0.6\n");
+    new_label.close();
+    EXPECT_TRUE(reloaded.UpdateSplit("train", labels_dir, images));
+    EXPECT_TRUE(reloaded.UpdateSplit("val", labels_dir, QStringList()));
+}
+
+TEST_F(PolySegTest, SplitAssignmentCountsAndStratification) {
+    ProjectConfig config;
+    SplitConfig split_cfg;
+    split_cfg.enabled = true;
+    split_cfg.target_train_ratio = 0.6;
+    split_cfg.target_val_ratio = 0.2;
+    split_cfg.target_test_ratio = 0.2;
+    split_cfg.hash_salt = "fixed-salt";
+    config.SetSplitConfig(split_cfg);
+
+    QStringList images;
+    for (int i = 0; i < 1000; ++i) {
+        images.append(QString("img_%1.png").arg(i));
+    }
+    config.UpdateImageSplits(images);
+    EXPECT_EQ(config.GetTrainCount() + config.GetValCount() + config.GetTestCount(), 1000);
+    EXPECT_GT(config.GetTrainCount(), 500);
+    EXPECT_LT(config.GetTrainCount(), 700);
+    EXPECT_EQ(config.GetImageSplit("img_7.png"), config.DeterministicSplitForImage("img_7.png"));
+
+    // Existing assignments are immutable; counters follow manual changes
+    const int test_count = config.GetTestCount();
+    const bool was_test = config.GetImageSplit("img_0.png") == "test";
+    config.SetImageSplit("img_0.png", "test");
+    config.UpdateImageSplits(images);
+    EXPECT_EQ(config.GetImageSplit("img_0.png"), QString("test"));
+    EXPECT_EQ(config.GetTestCount(), test_count + (was_test ? 0 : 1));
+
+    // A rare class is spread over all splits by the target ratios
+    ProjectConfig stratified;
+    split_cfg.stratify_by_class = true;
+    stratified.SetSplitConfig(split_cfg);
+    QStringList labeled;
+    QHash<QString, QVector<int>> image_classes;
+    for (int i = 0; i < 100; ++i) {
+        const QString name = QString("s_%1.png").arg(i);
+        labeled.append(name);
+        image_classes[name] = i < 10 ? QVector<int>({0, 5}) : QVector<int>({0});
+    }
+    stratified.UpdateImageSplits(labeled, image_classes);
+    QMap<QString, int> rare;
+    for (int i = 0; i < 10; ++i) {
+        rare[stratified.GetImageSplit(QString("s_%1.png").arg(i))]++;
+    }
+    EXPECT_EQ(rare["train"], 6);
+    EXPECT_EQ(rare["val"], 2);
+    EXPECT_EQ(rare["test"], 2);
+}
+
+TEST_F(PolySegTest, ImageStateStoreKeepsSplitsOutOfProjectJson) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString project_file = dir.filePath("test.polyseg");
+
+    ProjectConfig config;
+    SplitConfig split_cfg;
+    split_cfg.enabled = true;
+    config.SetSplitConfig(split_cfg);
+    QStringList images;
+    for (int i = 0; i < 200; ++i) {
+        images.append(QString("img_%1.png").arg(i));
+    }
+    config.UpdateImageSplits(images);
+    ImageReference ref;
+    ref.path = "/data/cam1/frame.png";
+    ref.crop = QRect(1, 2, 3, 4);
+    config.AddImageReferences({{"cam1_frame.png", ref}});
+    ASSERT_TRUE(config.SaveToFile(project_file));
+
+    QFile json_file(project_file);
+    ASSERT_TRUE(json_file.open(QIODevice::ReadOnly));
+    const QByteArray json = json_file.readAll();
+    EXPECT_FALSE(json.contains("image_splits"));
+    EXPECT_FALSE(json.contains("img_0.png"));
+
+    // A single change is appended, not a rewrite of every image
+    const QString store_path = ImageStateStore::StorePath(dir.path());
+    const qint64 full_size = QFileInfo(store_path).size();
+    config.SetImageSplit("img_0.png", "test");
+    config.RemoveImageReference("cam1_frame.png");
+    ASSERT_TRUE(config.SaveToFile(project_file));
+    EXPECT_GT(QFileInfo(store_path).size(), full_size);
+    EXPECT_LT(QFileInfo(store_path).size(), full_size + 100);
+
+    ProjectConfig loaded;
+    ASSERT_TRUE(loaded.LoadFromFile(project_file));
+    EXPECT_EQ(loaded.GetImageSplits().size(), 200);
+    EXPECT_EQ(loaded.GetImageSplit("img_0.png"), QString("test"));
+    EXPECT_EQ(loaded.GetTrainCount() + loaded.GetValCount() + loaded.GetTestCount(), 200);
+    EXPECT_EQ(loaded.GetTestCount(), config.GetTestCount());
+    EXPECT_TRUE(loaded.GetImageReferences().isEmpty());
+
+    // Projects with splits in the JSON are migrated on save
+    QJsonObject legacy = QJsonDocument::fromJson(json).object();
+    QJsonObject splits;
+    splits["old.png"] = "val";
+    legacy["image_splits"] = splits;
+    QFile legacy_file(project_file);
+    ASSERT_TRUE(legacy_file.open(QIODevice::WriteOnly));
+    legacy_file.write(QJsonDocument(legacy).toJson());
+    legacy_file.close();
+
+    ProjectConfig migrated;
+    ASSERT_TRUE(migrated.LoadFromFile(project_file));
+    EXPECT_EQ(migrated.GetImageSplit("old.png"), QString("val"));
+    ASSERT_TRUE(migrated.SaveToFile(project_file));
+    ProjectConfig reloaded;
+    ASSERT_TRUE(reloaded.LoadFromFile(project_file));
+    EXPECT_EQ(reloaded.GetImageSplits().size(), 1);
+    EXPECT_EQ(reloaded.GetValCount(), 1);
+}
+
+TEST_F(PolySegTest, ImageStateStoreStopsAtOutOfRangeSplit) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    ImageStateStore store;
+    QMap<QString, DatasetSplit> splits;
+    QMap<QString, ImageReference> references;
+    splits.insert("good.png", DatasetSplit::Val);
+    store.RecordSplit("good.png", DatasetSplit::Val);
+    ASSERT_TRUE(store.Flush(dir.path(), splits, references));
+
+    // A hand-edited split byte, followed by a record that must not be trusted either
+    QFile file(ImageStateStore::StorePath(dir.path()));
+    ASSERT_TRUE(file.open(QIODevice::Append));
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << quint8(1) << QString("bad.png") << quint8(9);
+    out << quint8(1) << QString("after.png") << quint8(1);
+    file.close();
+
+    ImageStateStore loaded_store;
+    QMap<QString, DatasetSplit> loaded;
+    ASSERT_TRUE(loaded_store.Load(dir.path(), &loaded, &references));
+    EXPECT_EQ(loaded.size(), 1);
+    EXPECT_EQ(loaded.value("good.png"), DatasetSplit::Val);
+    EXPECT_FALSE(loaded.contains("bad.png"));
+    EXPECT_FALSE(loaded.contains("after.png"));
+}
+
+TEST_F(PolySegTest, TrainingLogParserTracksMetricsAndEta) {
+    TrainingLogParser parser(3);
+
+    // Lines split across chunks; progress updates end with '\r'
+    QStringList lines = parser.Feed("Using device: cuda\nEpoch 1/4, Batch 0/10, Lo", 0);
+    EXPECT_EQ(lines, QStringList() << "Using device: cuda");
+    lines = parser.Feed("ss: 0.9000\n 50%|#####     |\r", 0);
+    EXPECT_EQ(lines, QStringList() << "Epoch 1/4, Batch 0/10, Loss: 0.9000");
+    EXPECT_EQ(parser.CurrentEpoch(), 1);
+    EXPECT_EQ(parser.TotalEpochs(), 4);
+    EXPECT_EQ(parser.EtaSeconds(100), -1);
+
+    parser.Feed("Epoch 1/4 - Train Loss: 0.8000, Val Loss: 0.7500\r\n", 9000);
+    parser.Feed("Epoch 2/4, Batch 0/10, Loss: 0.6000\n", 10000);
+    parser.Feed("mAP50-95(B): 0.4100\n", 10500);
+    EXPECT_EQ(parser.CurrentEpoch(), 2);
+
+    const QMap<QString, QVector<QPointF>>& series = parser.Series();
+    ASSERT_TRUE(series.contains("loss"));
+    ASSERT_TRUE(series.contains("train_loss"));
+    ASSERT_TRUE(series.contains("val_loss"));
+    ASSERT_TRUE(series.contains("map50-95b"));
+    EXPECT_EQ(series["loss"].size(), 2);
+    EXPECT_DOUBLE_EQ(series["loss"].last().x(), 2.0);
+    EXPECT_DOUBLE_EQ(series["val_loss"].last().y(), 0.75);
+
+    // One epoch took 10 s; epochs 2..4 remain, 5 s into epoch 2
+    EXPECT_EQ(parser.EtaSeconds(15000), 25);
+
+    // Only the newest lines are kept
+    EXPECT_EQ(parser.TotalLines(), 5);
+    EXPECT_EQ(parser.RecentLines().size(), 3);
+    EXPECT_EQ(parser.RecentLines().last(), QString("mAP50-95(B): 0.4100"));
+}
+
+TEST_F(PolySegTest, TrainingJobQueueSchedulesByResourcesAndPersists) {
+    TrainingJob job;
+    job.cores = 4;
+    job.memory_mb = 6000;
+
+    // Nothing running: always starts, even when oversized
+    EXPECT_TRUE(TrainingJobQueue::CanStart(job, 0, 0, 2, 1000, 100));
+    // Fits next to a running job
+    EXPECT_TRUE(TrainingJobQueue::CanStart(job, 4, 6000, 8, 16000, 8000));
+    // Not enough cores, budget or free RAM
+    EXPECT_FALSE(TrainingJobQueue::CanStart(job, 6, 6000, 8, 16000, 8000));
+    EXPECT_FALSE(TrainingJobQueue::CanStart(job, 4, 12000, 8, 16000, 8000));
+    EXPECT_FALSE(TrainingJobQueue::CanStart(job, 4, 6000, 8, 16000, 2000));
+    // Unknown memory is not enforced
+    EXPECT_TRUE(TrainingJobQueue::CanStart(job, 4, 6000, 8, -1, -1));
+
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    const QString project_dir = temp_dir.path();
+
+    // A job that was running when the application exited, and a finished one
+    TrainingJob interrupted;
+    interrupted.id = "interrupted";
+    interrupted.name = "ResNet-50";
+    interrupted.program = project_dir + "/missing-trainer";
+    interrupted.working_directory = project_dir;
+    interrupted.log_path = project_dir + "/tmp/training_interrupted.log";
+    interrupted.status = TrainingJobStatus::Running;
+    TrainingJob finished;
+    finished.id = "finished";
+    finished.status = TrainingJobStatus::Succeeded;
+    finished.model_path = "models/finished_best.pt";
+
+    QJsonArray jobs;
+    jobs.append(finished.ToJson());
+    jobs.append(interrupted.ToJson());
+    QJsonObject root;
+    root["jobs"] = jobs;
+    QDir().mkpath(project_dir + "/.polyseg");
+    QFile file(TrainingJobQueue::QueuePath(project_dir));
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write(QJsonDocument(root).toJson());
+    file.close();
+
+    // Loading re-queues the interrupted job but keeps the queue paused
+    QStringList finished_ids;
+    QStringList prepared_ids;
+    {
+        TrainingJobQueue queue;
+        queue.SetJobPreparer([&prepared_ids](TrainingJob* job) {
+            prepared_ids.append(job->id);
+            return true;
+        });
+        QObject::connect(&queue, &TrainingJobQueue::JobFinished,
+                         [&finished_ids](const QString& id, bool) { finished_ids.append(id); });
+        queue.SetProjectDirectory(project_dir);
+
+        ASSERT_EQ(queue.Jobs().size(), 2);
+        EXPECT_EQ(queue.Jobs()[0].status, TrainingJobStatus::Succeeded);
+        EXPECT_EQ(queue.Jobs()[0].model_path, QString("models/finished_best.pt"));
+        EXPECT_EQ(queue.Jobs()[1].status, TrainingJobStatus::Queued);
+        EXPECT_TRUE(queue.IsPaused());
+        EXPECT_TRUE(prepared_ids.isEmpty());
+        EXPECT_TRUE(finished_ids.isEmpty());
+
+        // Resuming prepares and starts it; the trainer is missing here
+        queue.SetPaused(false);
+        EXPECT_EQ(prepared_ids, QStringList{"interrupted"});
+        EXPECT_EQ(queue.Jobs()[1].status, TrainingJobStatus::Failed);
+        EXPECT_EQ(queue.RunningCount(), 0);
+        EXPECT_EQ(finished_ids, QStringList{"interrupted"});
+
+        queue.RemoveFinished();
+        EXPECT_TRUE(queue.Jobs().isEmpty());
+    }
+
+    TrainingJobQueue reloaded;
+    reloaded.SetProjectDirectory(project_dir);
+    EXPECT_TRUE(reloaded.Jobs().isEmpty());
+    EXPECT_FALSE(reloaded.IsPaused());
+
+#ifdef Q_OS_UNIX
+    // Jobs on the project split run one after another; a seeded job runs beside them
+    QTemporaryDir sleep_dir;
+    ASSERT_TRUE(sleep_dir.isValid());
+    TrainingJobQueue queue;
+    queue.SetProjectDirectory(sleep_dir.path());
+    auto sleeper = [&sleep_dir](bool shared_dataset) {
+        TrainingJob sleep_job;
+        sleep_job.program = "sleep";
+        sleep_job.arguments = QStringList{"5"};
+        sleep_job.working_directory = sleep_dir.path();
+        sleep_job.shared_dataset = shared_dataset;
+        return sleep_job;
+    };
+    queue.Enqueue(sleeper(true));
+    queue.Enqueue(sleeper(true));
+    queue.Enqueue(sleeper(false));
+    EXPECT_EQ(queue.RunningCount(), 1);
+    EXPECT_EQ(queue.Jobs()[1].status, TrainingJobStatus::Queued);
+    queue.Cancel(queue.Jobs()[1].id);
+    EXPECT_EQ(queue.RunningCount(), 2);
+#endif
+}
+
+TEST_F(PolySegTest, ProcessLimitsParseAffinityAndCapThreads) {
+    QList<int> cpus;
+    EXPECT_TRUE(ProcessLimits::ParseCpuList("0-3, 6,2", &cpus));
+    EXPECT_EQ(cpus, (QList<int>{0, 1, 2, 3, 6}));
+    EXPECT_TRUE(ProcessLimits::ParseCpuList("", &cpus));
+    EXPECT_TRUE(cpus.isEmpty());
+    EXPECT_FALSE(ProcessLimits::ParseCpuList("3-1", &cpus));
+    EXPECT_FALSE(ProcessLimits::ParseCpuList("a,b", &cpus));
+    EXPECT_FALSE(ProcessLimits::ParseCpuList("1-2-3", &cpus));
+    EXPECT_FALSE(ProcessLimits::ParseCpuList("0-100000000", &cpus));
+    EXPECT_FALSE(ProcessLimits::ParseCpuList("99999999999", &cpus));
+
+    ProcessLimits limits;
+    EXPECT_TRUE(limits.IsDefault());
+    EXPECT_EQ(limits.EffectiveThreads(), 0);
+    EXPECT_FALSE(limits.Environment(QProcessEnvironment()).contains("OMP_NUM_THREADS"));
+
+    limits.max_threads = 3;
+    const QProcessEnvironment env = limits.Environment(QProcessEnvironment());
+    EXPECT_EQ(env.value("OMP_NUM_THREADS"), QString("3"));
+    EXPECT_EQ(env.value("MKL_NUM_THREADS"), QString("3"));
+
+    // Background leaves a core for the UI and is the training default, also for old projects
+    const ProcessLimits background = ProcessLimits::Background();
+    EXPECT_GT(background.nice_level, 0);
+    EXPECT_GE(background.EffectiveThreads(), 1);
+    const PluginConfig legacy = PluginConfig::FromJson(QJsonObject());
+    EXPECT_EQ(legacy.train_limits.nice_level, background.nice_level);
+    EXPECT_TRUE(legacy.detect_limits.IsDefault());
+
+    PluginConfig plugin;
+    plugin.detect_limits.cpu_affinity = "0-1";
+    plugin.train_limits.nice_level = 5;
+    const PluginConfig loaded = PluginConfig::FromJson(plugin.ToJson());
+    EXPECT_EQ(loaded.detect_limits.cpu_affinity, QString("0-1"));
+    EXPECT_EQ(loaded.train_limits.nice_level, 5);
+}
+
+TEST_F(PolySegTest, ModelDownloadResumesAndSplitsIntoRanges) {
+    QByteArray body;
+    for (int i = 0; i < 256 * 1024; ++i) {
+        body.append(static_cast<char>((i * 131) % 251));
+    }
+    RangeHttpServer server(body);
+
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+
+    ModelDownloadInfo info;
+    info.id = "model";
+    info.name = "model";
+    info.download_url = server.Url();
+    info.size_bytes = body.size();
+    info.checksum_sha256 = QCryptographicHash::hash(body, QCryptographicHash::Sha256).toHex();
+
+    auto read_all = [](const QString& path) {
+        QFile file(path);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    };
+    auto write_all = [](const QString& path, const QByteArray& data) {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    };
+
+    // 1. Interrupted single-stream download: continue from the end of the .part file
+    const QString resumed = temp_dir.path() + "/resumed.pth";
+    write_all(resumed + ".part", body.left(100000));
+    {
+        ScopedHome home(temp_dir.path() + "/home1");
+        ModelDownloadManager manager;
+        manager.SetSegmentation(1, 16 * 1024);
+        manager.DownloadModelToPath(info, resumed);
+        EXPECT_EQ(WaitForDownload(manager), QString());
+    }
+    EXPECT_EQ(server.get_ranges, QStringList{"bytes=100000-262143"});
+    EXPECT_EQ(read_all(resumed), body);
+    EXPECT_FALSE(QFile::exists(resumed + ".part"));
+    EXPECT_FALSE(QFile::exists(ModelDownloadManager::PartialStatePath(resumed)));
+
+    // 2. Fresh download over four parallel ranges
+    server.get_ranges.clear();
+    const QString segmented = temp_dir.path() + "/segmented.pth";
+    {
+        ScopedHome home(temp_dir.path() + "/home2");
+        ModelDownloadManager manager;
+        manager.SetSegmentation(4, 16 * 1024);
+        manager.DownloadModelToPath(info, segmented);
+        EXPECT_EQ(WaitForDownload(manager), QString());
+    }
+    server.get_ranges.sort();
+    EXPECT_EQ(server.get_ranges, (QStringList{"bytes=0-65535", "bytes=131072-196607",
+                                              "bytes=196608-262143", "bytes=65536-131071"}));
+    EXPECT_EQ(read_all(segmented), body);
+
+    // 3. Persisted segment progress: only the missing part of segment 0 is fetched
+    server.get_ranges.clear();
+    const QString from_state = temp_dir.path() + "/state.pth";
+    QByteArray partial(body.size(), '\0');
+    partial.replace(0, 1000, body.left(1000));
+    partial.replace(131072, 131072, body.mid(131072));
+    write_all(from_state + ".part", partial);
+
+    QJsonArray segments;
+    for (const auto& [start, end, done] : {std::tuple<int, int, int>{0, 131071, 1000},
+                                           std::tuple<int, int, int>{131072, 262143, 131072}}) {
+        QJsonObject segment;
+        segment["start"] = QString::number(start);
+        segment["end"] = QString::number(end);
+        segment["done"] = QString::number(done);
+        segments.append(segment);
+    }
+    QJsonObject state;
+    state["url"] = server.Url();
+    state["total"] = QString::number(body.size());
+    state["etag"] = "\"v1\"";
+    state["segments"] = segments;
+    write_all(ModelDownloadManager::PartialStatePath(from_state), QJsonDocument(state).toJson());
+    {
+        ScopedHome home(temp_dir.path() + "/home3");
+        ModelDownloadManager manager;
+        manager.DownloadModelToPath(info, from_state);
+        EXPECT_EQ(WaitForDownload(manager), QString());
+    }
+    EXPECT_EQ(server.get_ranges, QStringList{"bytes=1000-131071"});
+    EXPECT_EQ(read_all(from_state), body);
+
+    // 4. File replaced between HEAD and the range requests: the If-Range GETs get the
+    //    new, larger file with 200, which is streamed with its own size and validator
+    QByteArray new_body = body;
+    new_body.append(QByteArray(40000, 'n'));
+    RangeHttpServer changed(new_body);
+    changed.etag = "\"v2\"";
+    changed.head_body = body;
+    changed.head_etag = "\"v1\"";
+    const QString replaced = temp_dir.path() + "/replaced.pth";
+    ModelDownloadInfo changed_info = info;
+    changed_info.download_url = changed.Url();
+    changed_info.size_bytes = -1;
+    changed_info.checksum_sha256.clear();
+    {
+        ScopedHome home(temp_dir.path() + "/home4");
+        ModelDownloadManager manager;
+        manager.SetSegmentation(4, 16 * 1024);
+        manager.DownloadModelToPath(changed_info, replaced);
+        EXPECT_EQ(WaitForDownload(manager), QString());
+    }
+    ASSERT_FALSE(changed.get_ranges.isEmpty());
+    EXPECT_TRUE(changed.get_ranges.first().startsWith("bytes="));
+    EXPECT_EQ(read_all(replaced), new_body);
+
+    // 5. Error page in place of the range: nothing is written, the next attempt resumes
+    //    from the same offset (no checksum would catch a corrupt file)
+    server.get_ranges.clear();
+    server.failing_gets = 1;
+    const QString after_error = temp_dir.path() + "/after_error.pth";
+    write_all(after_error + ".part", body.left(100000));
+    ModelDownloadInfo unchecked_info = info;
+    unchecked_info.checksum_sha256.clear();
+    {
+        ScopedHome home(temp_dir.path() + "/home5");
+        ModelDownloadManager manager;
+        manager.SetSegmentation(1, 16 * 1024);
+        manager.DownloadModelToPath(unchecked_info, after_error);
+        EXPECT_NE(WaitForDownload(manager), QString());
+        EXPECT_EQ(QFileInfo(after_error + ".part").size(), 100000);
+
+        manager.DownloadModelToPath(unchecked_info, after_error);
+        EXPECT_EQ(WaitForDownload(manager), QString());
+    }
+    EXPECT_EQ(server.get_ranges, (QStringList{"bytes=100000-262143", "bytes=100000-262143"}));
+    EXPECT_EQ(read_all(after_error), body);
+}
+
+TEST_F(PolySegTest, ModelDownloadHashesWhileWritingAndReusesDigest) {
+    QByteArray body;
+    for (int i = 0; i < 200 * 1024; ++i) {
+        body.append(static_cast<char>((i * 37) % 253));
+    }
+    const QString expected = QCryptographicHash::hash(body, QCryptographicHash::Sha256).toHex();
+    RangeHttpServer server(body);
+
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    const QString dest = temp_dir.path() + "/model.pth";
+
+    ModelDownloadInfo info;
+    info.id = "model";
+    info.name = "model";
+    info.download_url = server.Url();
+    info.size_bytes = body.size();
+    info.checksum_sha256 = expected;
+    {
+        ScopedHome home(temp_dir.path() + "/home");
+        ModelDownloadManager manager;
+        manager.SetSegmentation(3, 16 * 1024);
+        manager.DownloadModelToPath(info, dest);
+        EXPECT_EQ(WaitForDownload(manager), QString());
+    }
+
+    // The digest computed during the download is recorded next to the file
+    const QString record_path = ModelDownloadManager::DigestRecordPath(dest);
+    QFile record(record_path);
+    ASSERT_TRUE(record.open(QIODevice::ReadOnly));
+    QJsonObject root = QJsonDocument::fromJson(record.readAll()).object();
+    record.close();
+    EXPECT_EQ(root["sha256"].toString(), expected);
+
+    // A matching record is trusted without rehashing the file
+    root["sha256"] = QString(64, '0');
+    ASSERT_TRUE(record.open(QIODevice::WriteOnly));
+    record.write(QJsonDocument(root).toJson());
+    record.close();
+    EXPECT_EQ(ModelDownloadManager::FileChecksum(dest), QString(64, '0'));
+    EXPECT_FALSE(ModelDownloadManager::VerifyChecksum(dest, expected));
+
+    // A changed file invalidates the record
+    QFile file(dest);
+    ASSERT_TRUE(file.open(QIODevice::Append));
+    file.write("x");
+    file.close();
+    EXPECT_EQ(ModelDownloadManager::FileChecksum(dest),
+              QString(QCryptographicHash::hash(body + "x", QCryptographicHash::Sha256).toHex()));
+}
+
+TEST_F(PolySegTest, ModelDownloadWritesOnWorkerAndReportsProgress) {
+    // Larger than the write chunk, with a tail that is not aligned
+    QByteArray body;
+    for (int i = 0; i < 3 * 1024 * 1024 + 12345; ++i) {
+        body.append(static_cast<char>((i * 17) % 249));
+    }
+    RangeHttpServer server(body);
+
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    const QString dest = temp_dir.path() + "/model.pth";
+
+    ModelDownloadInfo info;
+    info.id = "model";
+    info.name = "model";
+    info.download_url = server.Url();
+    info.size_bytes = body.size();
+    info.checksum_sha256 = QCryptographicHash::hash(body, QCryptographicHash::Sha256).toHex();
+
+    ScopedHome home(temp_dir.path() + "/home");
+    ModelDownloadManager manager;
+    manager.SetSegmentation(1, 1);
+    qint64 last_received = -1;
+    qint64 last_total = -1;
+    qint64 last_eta = -2;
+    bool on_main_thread = true;
+    QObject::connect(&manager, &ModelDownloadManager::downloadProgress,
+                     [&](qint64 received, qint64 total, qint64, qint64 eta) {
+                         on_main_thread &= QThread::currentThread() == app->thread();
+                         last_received = received;
+                         last_total = total;
+                         last_eta = eta;
+                     });
+    manager.DownloadModelToPath(info, dest);
+    EXPECT_TRUE(manager.IsDownloading());
+    EXPECT_EQ(WaitForDownload(manager), QString());
+    EXPECT_FALSE(manager.IsDownloading());
+
+    EXPECT_TRUE(on_main_thread);
+    EXPECT_EQ(last_received, body.size());
+    EXPECT_EQ(last_total, body.size());
+    EXPECT_TRUE(last_eta == 0 || last_eta == -1);
+
+    QFile file(dest);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    EXPECT_EQ(file.readAll(), body);
+}
+
+TEST_F(PolySegTest, ModelDownloadQueueSharesIdenticalFiles) {
+    QByteArray first_body(300 * 1024, 'a');
+    QByteArray second_body(200 * 1024, 'b');
+    RangeHttpServer first_server(first_body);
+    RangeHttpServer second_server(second_body);
+    const QString first_sha = QCryptographicHash::hash(first_body, QCryptographicHash::Sha256).toHex();
+
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    ScopedHome home(temp_dir.path() + "/home");
+
+    auto make_info = [](const QString& id, const QString& url) {
+        ModelDownloadInfo info;
+        info.id = id;
+        info.name = id;
+        info.download_url = url;
+        info.size_bytes = -1;
+        info.plugin_id = "smp";
+        return info;
+    };
+    auto read_all = [](const QString& path) {
+        QFile file(path);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    };
+
+    ModelDownloadManager manager;
+    manager.SetMaxConcurrentDownloads(2);
+    QStringList finished;
+    qint64 last_received = -1;
+    qint64 last_total = -1;
+    QObject::connect(&manager, &ModelDownloadManager::downloadFinished,
+                     [&](const QString& path) { finished.append(path); });
+    QObject::connect(&manager, &ModelDownloadManager::downloadProgress,
+                     [&](qint64 received, qint64 total, qint64, qint64) {
+                         last_received = received;
+                         last_total = total;
+                     });
+    auto wait_for_queue = [&]() {
+        QEventLoop loop;
+        QObject::connect(&manager, &ModelDownloadManager::queueFinished, &loop, &QEventLoop::quit);
+        QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+        if (manager.IsDownloading()) {
+            loop.exec();
+        }
+    };
+
+    // Same URL for two destinations (e.g. two plugins) is fetched once
+    const QString a = manager.EnqueueDownload(make_info("a", first_server.Url()));
+    const QString b = manager.EnqueueDownload(make_info("b", first_server.Url()),
+                                              temp_dir.path() + "/project/b.pth");
+    const QString c = manager.EnqueueDownload(make_info("c", second_server.Url()));
+    EXPECT_EQ(manager.EnqueueDownload(make_info("c", second_server.Url())), c);
+    EXPECT_EQ(manager.QueueItems().size(), 3);
+    wait_for_queue();
+
+    EXPECT_FALSE(manager.IsDownloading());
+    EXPECT_EQ(finished.size(), 3);
+    EXPECT_EQ(first_server.get_ranges.size(), 1);
+    EXPECT_EQ(second_server.get_ranges.size(), 1);
+    EXPECT_EQ(read_all(a), first_body);
+    EXPECT_EQ(read_all(b), first_body);
+    EXPECT_EQ(read_all(c), second_body);
+    EXPECT_EQ(last_total, first_body.size() * 2 + second_body.size());
+    EXPECT_EQ(last_received, last_total);
+    for (const DownloadQueueItem& item : manager.QueueItems()) {
+        EXPECT_EQ(item.status, DownloadItemStatus::Finished);
+    }
+
+    // Content-addressed store: a later request by checksum needs no network
+    EXPECT_EQ(read_all(ModelDownloadManager::StorePath(first_sha)), first_body);
+    ModelDownloadInfo by_checksum = make_info("d", "http://127.0.0.1:1/unused.pth");
+    by_checksum.checksum_sha256 = first_sha;
+    const QString d = manager.EnqueueDownload(by_checksum, temp_dir.path() + "/d.pth");
+    EXPECT_TRUE(manager.IsDownloading());  // Stored copy is verified on the worker
+    wait_for_queue();
+    EXPECT_EQ(read_all(d), first_body);
+    EXPECT_EQ(first_server.get_ranges.size(), 1);
+
+    // Without a checksum the URL is fetched again; it may serve a new file by now
+    const QString e = manager.EnqueueDownload(make_info("e", first_server.Url()),
+                                              temp_dir.path() + "/e.pth");
+    wait_for_queue();
+    EXPECT_EQ(read_all(e), first_body);
+    EXPECT_EQ(first_server.get_ranges.size(), 2);
+}
+
+TEST_F(PolySegTest, ModelCacheEvictsLeastRecentlyUsedUnreferencedModels) {
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    ScopedHome home(temp_dir.path() + "/home");
+
+    const QByteArray first_body(100 * 1024, '1');
+    const QByteArray second_body(100 * 1024, '2');
+    const QByteArray third_body(100 * 1024, '3');
+    RangeHttpServer first_server(first_body);
+    RangeHttpServer second_server(second_body);
+    RangeHttpServer third_server(third_body);
+    auto sha = [](const QByteArray& data) {
+        return QString(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
+    };
+
+    ModelDownloadManager manager;
+    auto download = [&](const QString& id, const QString& url, const QString& destination) {
+        ModelDownloadInfo info;
+        info.id = id;
+        info.name = id;
+        info.download_url = url;
+        info.size_bytes = -1;
+        info.plugin_id = "smp";
+        const QString path = manager.EnqueueDownload(info, destination);
+        EXPECT_EQ(WaitForDownload(manager), QString());
+        return path;
+    };
+
+    // Cache only, project destination, cache only; oldest first
+    const QString first = download("first", first_server.Url(), QString());
+    const QString second = download("second", second_server.Url(),
+                                    temp_dir.path() + "/project/models/second.pth");
+    EXPECT_EQ(manager.GetCacheSize(), first_body.size() + second_body.size());
+
+    manager.SetCacheBudget(250 * 1024);
+    const QString third = download("third", third_server.Url(), QString());
+
+    // The first model is evicted; the older project model is pinned by its reference
+    EXPECT_FALSE(QFile::exists(first));
+    EXPECT_FALSE(QFile::exists(ModelDownloadManager::StorePath(sha(first_body))));
+    EXPECT_TRUE(QFile::exists(second));
+    EXPECT_TRUE(QFile::exists(third));
+    EXPECT_EQ(manager.GetCacheSize(), second_body.size() + third_body.size());
+
+    // The index is persisted with its budget
+    ModelCacheIndex index;
+    ASSERT_TRUE(index.Load(ModelDownloadManager::GetStoreDir()));
+    EXPECT_EQ(index.Budget(), 250 * 1024);
+    EXPECT_EQ(index.TotalBytes(), second_body.size() + third_body.size());
+    EXPECT_FALSE(index.Contains(sha(first_body)));
+    EXPECT_EQ(index.Value(sha(second_body)).references,
+              QStringList{temp_dir.path() + "/project/models/second.pth"});
+
+    // Once the project file is gone, the model is evictable
+    QFile::remove(second);
+    manager.SetCacheBudget(150 * 1024);
+    EXPECT_EQ(manager.GetCacheSize(), third_body.size());
+    EXPECT_TRUE(QFile::exists(third));
+
+    // A model larger than the whole budget is still there when its download is reported
+    manager.SetCacheBudget(50 * 1024);
+    EXPECT_FALSE(QFile::exists(third));
+    RangeHttpServer fourth_server(first_body);
+    const QString fourth = download("fourth", fourth_server.Url(), QString());
+    EXPECT_TRUE(QFile::exists(fourth));
+    EXPECT_EQ(manager.GetCacheSize(), first_body.size());
+}
+
+TEST_F(PolySegTest, PythonDetectionProbesOnceAndCachesResults) {
+#ifndef Q_OS_UNIX
+    GTEST_SKIP() << "Stand-in interpreters are shell scripts";
+#endif
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    ScopedHome home(temp_dir.path() + "/home");
+
+    // Stand-in interpreters: one fails, one answers the probe and counts its runs
+    const QString runs_path = temp_dir.filePath("runs.txt");
+    auto write_script = [](const QString& path, const QString& body) {
+        QFile script(path);
+        ASSERT_TRUE(script.open(QIODevice::WriteOnly));
+        script.write(("#!/bin/sh\n" + body).toUtf8());
+        script.close();
+        script.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    };
+    const QString probe_output = QString("echo run >> '%1'\n"
+                                         "echo 'VERSION:3.11.4'\n"
+                                         "echo 'EXECUTABLE:/opt/fake/bin/python3'\n"
+                                         "echo 'VENV:1'\n"
+                                         "echo 'PIP:1'\n"
+                                         "echo 'TORCH:2.3.0'\n"
+                                         "echo 'CUDA:12.1'\n"
+                                         "echo 'GPU:Test GPU'\n"
+                                         "echo 'MPS:0'\n").arg(runs_path);
+    const QString broken_path = temp_dir.filePath("python_broken");
+    const QString python_path = temp_dir.filePath("python3");
+    write_script(broken_path, "exit 1\n");
+    write_script(python_path, probe_output);
+    const QStringList candidates = {temp_dir.filePath("missing"), broken_path, python_path};
+
+    auto run_count = [&runs_path]() {
+        QFile runs(runs_path);
+        return runs.open(QIODevice::ReadOnly) ? runs.readAll().count('\n') : 0;
+    };
+
+    PythonEnvironmentManager manager;
+    manager.SetPythonCandidates(candidates);
+    PythonInfo info = manager.DetectPython();
+    EXPECT_TRUE(info.is_valid);
+    EXPECT_EQ(info.path, "/opt/fake/bin/python3");
+    EXPECT_EQ(info.version, "3.11.4");
+    EXPECT_EQ(info.version_major, 3);
+    EXPECT_EQ(info.version_minor, 11);
+    EXPECT_TRUE(info.has_venv);
+    EXPECT_TRUE(info.has_pip);
+    EXPECT_EQ(info.torch_version, "2.3.0");
+    EXPECT_TRUE(info.has_cuda);
+    EXPECT_EQ(info.cuda_version, "12.1");
+    EXPECT_EQ(info.gpu_name, "Test GPU");
+    EXPECT_FALSE(info.has_mps);
+    EXPECT_EQ(run_count(), 1);
+    EXPECT_TRUE(QFile::exists(PythonEnvironmentManager::GetProbeCachePath()));
+
+    // A new session answers from the cache before the call returns
+    PythonEnvironmentManager cached_manager;
+    cached_manager.SetPythonCandidates(candidates);
+    bool finished = false;
+    QObject::connect(&cached_manager, &PythonEnvironmentManager::detectionFinished,
+                     [&finished, &info](const PythonInfo& detected) {
+                         finished = true;
+                         info = detected;
+                     });
+    cached_manager.DetectPythonAsync();
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(info.path, "/opt/fake/bin/python3");
+    EXPECT_EQ(run_count(), 1);
+
+    // Replacing the interpreter invalidates its entry; refresh ignores the cache
+    write_script(python_path, probe_output + "echo 'MPS:1'\n");
+    info = cached_manager.DetectPython();
+    EXPECT_TRUE(info.has_mps);
+    EXPECT_EQ(run_count(), 2);
+    info = cached_manager.DetectPython(true);
+    EXPECT_TRUE(info.is_valid);
+    EXPECT_EQ(run_count(), 3);
+
+    // Without a usable interpreter detection still finishes
+    cached_manager.SetPythonCandidates({broken_path});
+    info = cached_manager.DetectPython();
+    EXPECT_FALSE(info.is_valid);
+    EXPECT_TRUE(cached_manager.IsDetected());
+}
+
+TEST_F(PolySegTest, PythonPackagesAreCheckedFromMetadata) {
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+
+    auto write_file = [](const QString& path, const QByteArray& content) {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(content);
+    };
+
+    const QString venv = temp_dir.path() + "/venv";
+    const QString site = venv + "/lib/python3.11/site-packages";
+    write_file(site + "/torch-2.3.0+cu121.dist-info/METADATA",
+               "Metadata-Version: 2.1\nName: torch\nVersion: 2.3.0+cu121\n\nName: in-description\n");
+    write_file(site + "/segmentation_models_pytorch-0.3.3.dist-info/METADATA",
+               "Metadata-Version: 2.1\nName: segmentation_models_pytorch\nVersion: 0.3.3\n");
+    write_file(site + "/numpy-1.26.4-py3.11.egg-info",
+               "Metadata-Version: 1.0\nName: numpy\nVersion: 1.26.4\n");
+    // Without METADATA the directory name gives name and version
+    write_file(site + "/Pillow-10.0.0rc1.dist-info/RECORD", "");
+
+    EXPECT_EQ(PythonPackageIndex::SitePackagesDirs(venv), QStringList{site});
+
+    PythonEnvironmentManager manager;
+    EXPECT_TRUE(manager.IsPackageInstalled("Segmentation-Models-PyTorch", venv));
+    EXPECT_FALSE(manager.IsPackageInstalled("detectron2", venv));
+    EXPECT_TRUE(manager.VerifyPluginDependencies("smp", venv));
+    EXPECT_FALSE(manager.VerifyPluginDependencies("detectron2", venv));
+    EXPECT_EQ(manager.GetInstalledPackages(venv),
+              (QStringList{"numpy==1.26.4", "Pillow==10.0.0rc1",
+                           "segmentation_models_pytorch==0.3.3", "torch==2.3.0+cu121"}));
+
+    write_file(temp_dir.path() + "/base.txt", "numpy==1.26.*\n");
+    write_file(temp_dir.path() + "/requirements.txt",
+               "# Core\n"
+               "-r base.txt\n"
+               "torch>=2.0,<3  # GPU build\n"
+               "segmentation-models-pytorch~=0.3.0\n"
+               "pillow>=10.0 ; python_version >= \"3.8\"\n"
+               "opencv-python \\\n"
+               "    >=4.8\n"
+               "detectron2 @ git+https://github.com/facebookresearch/detectron2.git\n"
+               "--extra-index-url https://download.pytorch.org/whl/cu121\n");
+
+    const QList<PythonPackageIndex::RequirementStatus> statuses =
+        manager.CheckRequirements(temp_dir.path() + "/requirements.txt", venv);
+    ASSERT_EQ(statuses.size(), 6);
+    EXPECT_EQ(statuses[0].name, "numpy");
+    EXPECT_TRUE(statuses[0].satisfied);
+    EXPECT_EQ(statuses[1].specifier, ">=2.0,<3");
+    EXPECT_EQ(statuses[1].installed_version, "2.3.0+cu121");
+    EXPECT_TRUE(statuses[1].satisfied);
+    EXPECT_TRUE(statuses[2].satisfied);
+    // A release candidate does not satisfy the final release
+    EXPECT_EQ(statuses[3].installed_version, "10.0.0rc1");
+    EXPECT_FALSE(statuses[3].satisfied);
+    EXPECT_EQ(statuses[4].name, "opencv-python");
+    EXPECT_EQ(statuses[4].specifier, ">=4.8");
+    EXPECT_FALSE(statuses[4].satisfied);
+    EXPECT_EQ(statuses[5].name, "detectron2");
+    EXPECT_TRUE(statuses[5].specifier.isEmpty());
+    EXPECT_FALSE(statuses[5].satisfied);
+
+    EXPECT_LT(PythonPackageIndex::CompareVersions("1.0.dev1", "1.0a1"), 0);
+    EXPECT_LT(PythonPackageIndex::CompareVersions("1.0a1", "1.0b2"), 0);
+    EXPECT_LT(PythonPackageIndex::CompareVersions("1.0rc1", "1.0"), 0);
+    EXPECT_LT(PythonPackageIndex::CompareVersions("1.0", "1.0.post1"), 0);
+    EXPECT_LT(PythonPackageIndex::CompareVersions("1.9", "1.10"), 0);
+    EXPECT_EQ(PythonPackageIndex::CompareVersions("1.0", "1.0.0"), 0);
+    EXPECT_TRUE(PythonPackageIndex::SatisfiesSpecifier("1.4.5", "~=1.4.2"));
+    EXPECT_FALSE(PythonPackageIndex::SatisfiesSpecifier("1.5.0", "~=1.4.2"));
+    EXPECT_FALSE(PythonPackageIndex::SatisfiesSpecifier("2.0.1", ">=1.0,!=2.0.*"));
+}
+
+TEST_F(PolySegTest, PipInstallFillsWheelhouseAndReusesItOffline) {
+#ifndef Q_OS_UNIX
+    GTEST_SKIP() << "Stand-in pip is a shell script";
+#endif
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+
+    // Stand-in pip: "wheel" saves a wheel into the wheelhouse, "install" needs one
+    const QString log_path = temp_dir.filePath("pip.log");
+    const QString wheelhouse = temp_dir.filePath("wheelhouse");
+    const QString venv = temp_dir.filePath("venv");
+    const QString pip_path = PythonEnvironmentManager::GetVenvPipPath(venv);
+    QDir().mkpath(QFileInfo(pip_path).absolutePath());
+    QFile script(pip_path);
+    ASSERT_TRUE(script.open(QIODevice::WriteOnly));
+    script.write(QString("#!/bin/sh\n"
+                         "echo \"$1 $PIP_CACHE_DIR\" >> '%1'\n"
+                         "for package; do :; done\n"
+                         "wheel='%2'/$package-1.0-py3-none-any.whl\n"
+                         "echo \"Collecting $package\"\n"
+                         "if [ \"$1\" = wheel ]; then\n"
+                         "  touch \"$wheel\"\n"
+                         "  echo \"Saved $wheel\"\n"
+                         "  exit 0\n"
+                         "fi\n"
+                         "if [ ! -f \"$wheel\" ]; then\n"
+                         "  echo \"ERROR: No matching distribution found for $package\" >&2\n"
+                         "  exit 1\n"
+                         "fi\n"
+                         "echo \"Processing $wheel\"\n"
+                         "echo \"Installing collected packages: $package\"\n"
+                         "printf \"Successfully installed $package-1.0\"\n")
+                     .arg(log_path, wheelhouse)
+                     .toUtf8());
+    script.close();
+    script.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+
+    PythonEnvironmentManager manager;
+    manager.SetWheelhouseDir(wheelhouse);
+    manager.SetPipCacheDir(temp_dir.filePath("pip-cache"));
+    manager.SetOfflineInstall(false);
+
+    QStringList messages;
+    QObject::connect(&manager, &PythonEnvironmentManager::installationProgress,
+                     [&messages](const QString& message, int) { messages.append(message); });
+    auto install = [&manager, &venv](const QString& package) {
+        InstallationResult result;
+        result.success = false;
+        QEventLoop loop;
+        QObject::connect(&manager, &PythonEnvironmentManager::installationFinished, &loop,
+                         [&result, &loop](const InstallationResult& finished) {
+                             result = finished;
+                             loop.quit();
+                         });
+        QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+        manager.InstallPackage(package, venv);
+        EXPECT_TRUE(manager.IsBusy());
+        loop.exec();
+        QObject::disconnect(&manager, &PythonEnvironmentManager::installationFinished, nullptr,
+                            nullptr);
+        return result;
+    };
+    auto log_lines = [&log_path]() {
+        QFile log(log_path);
+        return log.open(QIODevice::ReadOnly)
+                   ? QString::fromUtf8(log.readAll()).split('\n', Qt::SkipEmptyParts)
+                   : QStringList();
+    };
+    const QString cache = " " + temp_dir.filePath("pip-cache");
+
+    // The first install fills the empty wheelhouse, then installs from it
+    InstallationResult result = install("foo");
+    EXPECT_TRUE(result.success) << result.error_message.toStdString();
+    EXPECT_EQ(result.installed_packages, QStringList{"foo-1.0"});
+    EXPECT_EQ(log_lines(), (QStringList{"wheel" + cache, "install" + cache}));
+    EXPECT_TRUE(QFile::exists(wheelhouse + "/foo-1.0-py3-none-any.whl"));
+    EXPECT_TRUE(messages.contains("Collecting foo"));
+    EXPECT_TRUE(messages.contains("Installing foo..."));
+    EXPECT_FALSE(manager.IsBusy());
+
+    // The next venv installs from the wheelhouse without building anything
+    result = install("foo");
+    EXPECT_TRUE(result.success);
+    EXPECT_EQ(log_lines().size(), 3);
+
+    // A package missing from the wheelhouse is fetched once, unless offline
+    result = install("bar");
+    EXPECT_TRUE(result.success);
+    EXPECT_EQ(log_lines().mid(3), (QStringList{"install" + cache, "wheel" + cache,
+                                               "install" + cache}));
+
+    manager.SetOfflineInstall(true);
+    result = install("baz");
+    EXPECT_FALSE(result.success);
+    EXPECT_EQ(result.failed_packages, QStringList{"baz"});
+    EXPECT_EQ(log_lines().size(), 7);
+}
+
+TEST_F(PolySegTest, OverlayVenvSeesSharedBaseEnvironment) {
+    // The layout is a setting of its own; older projects keep their full venv
+    PluginConfig plugin;
+    plugin.use_project_venv = true;
+    plugin.use_shared_env = true;
+    const PluginConfig loaded = PluginConfig::FromJson(plugin.ToJson());
+    EXPECT_TRUE(loaded.use_project_venv);
+    EXPECT_TRUE(loaded.use_shared_env);
+    EXPECT_FALSE(PluginConfig::FromJson(QJsonObject()).use_shared_env);
+
+    const QString python = QStandardPaths::findExecutable("python3");
+    if (python.isEmpty()) {
+        GTEST_SKIP() << "python3 not found";
+    }
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    ScopedHome home(temp_dir.path() + "/home");
+
+    PythonEnvironmentManager manager;
+    manager.SetPythonCandidates({python});
+    const PythonInfo info = manager.DetectPython(true);
+    if (!info.is_valid || !info.has_venv) {
+        GTEST_SKIP() << "python3 without venv support";
+    }
+
+    auto write_file = [](const QString& path, const QByteArray& content) {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(content);
+    };
+
+    // Base environments are versioned by Python and requirements
+    const QString requirements = temp_dir.filePath("requirements.txt");
+    write_file(requirements, "polyseg-test-pkg>=1.0\n");
+    const QString base = manager.GetBaseEnvPath("smp", requirements);
+    const QString base_prefix = QString("%1/smp-py%2%3-")
+                                    .arg(PythonEnvironmentManager::GetBaseEnvsDir())
+                                    .arg(info.version_major)
+                                    .arg(info.version_minor);
+    EXPECT_TRUE(base.startsWith(base_prefix));
+    write_file(requirements, "polyseg-test-pkg>=2.0\n");
+    EXPECT_NE(manager.GetBaseEnvPath("smp", requirements), base);
+
+    // Stand-in base: a venv with one package in its site-packages
+    QProcess venv;
+    venv.start(python, {"-m", "venv", "--without-pip", base});
+    ASSERT_TRUE(venv.waitForFinished(60000));
+    ASSERT_EQ(venv.exitCode(), 0);
+    const QStringList base_dirs = PythonPackageIndex::SitePackagesDirs(base);
+    ASSERT_EQ(base_dirs.size(), 1);
+    write_file(base_dirs[0] + "/polyseg_test_pkg.py", "VALUE = 42\n");
+    write_file(base_dirs[0] + "/polyseg_test_pkg-1.0.dist-info/METADATA",
+               "Metadata-Version: 2.1\nName: polyseg-test-pkg\nVersion: 1.0\n");
+
+    const QString project = temp_dir.filePath("project");
+    QDir().mkpath(project);
+    ASSERT_TRUE(manager.CreateOverlayVenv(project, base));
+    const QString overlay = PythonEnvironmentManager::GetVenvPath(project);
+    EXPECT_FALSE(QFile::exists(PythonEnvironmentManager::GetVenvPipPath(overlay)));
+
+    // Metadata checks and the overlay's interpreter both reach the base
+    const QStringList overlay_dirs = PythonPackageIndex::SitePackagesDirs(overlay);
+    ASSERT_EQ(overlay_dirs.size(), 2);
+    EXPECT_EQ(overlay_dirs[1], base_dirs[0]);
+    EXPECT_TRUE(manager.IsPackageInstalled("polyseg_test_pkg", overlay));
+
+    QProcess import;
+    import.start(PythonEnvironmentManager::GetVenvPythonPath(overlay),
+                 {"-c", "import polyseg_test_pkg; print(polyseg_test_pkg.VALUE)"});
+    ASSERT_TRUE(import.waitForFinished(30000));
+    EXPECT_EQ(QString::fromUtf8(import.readAllStandardOutput()).trimmed(), "42");
+
+    // Made isolated: the overlay drops the base and gets a pip of its own, in the background
+    bool ready = false;
+    QString ready_error = "timeout";
+    QEventLoop loop;
+    QObject::connect(&manager, &PythonEnvironmentManager::environmentReady, &loop,
+                     [&](bool success, const QString&, const QString& error) {
+                         ready = success;
+                         ready_error = error;
+                         loop.quit();
+                     });
+    manager.PrepareProjectEnvironment("polyseg-test-plugin", project, true);
+    EXPECT_TRUE(manager.IsBusy());
+    QTimer::singleShot(120000, &loop, &QEventLoop::quit);
+    loop.exec();
+    EXPECT_TRUE(ready) << ready_error.toStdString();
+    EXPECT_TRUE(QFile::exists(PythonEnvironmentManager::GetVenvPipPath(overlay)));
+    EXPECT_EQ(PythonPackageIndex::SitePackagesDirs(overlay).size(), 1);
+}
+
+TEST_F(PolySegTest, ModelComparisonScoresBothModelsAndCachesPredictions) {
+#ifndef Q_OS_UNIX
+    GTEST_SKIP() << "Stand-in plugin is a shell script";
+#endif
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    const QString project = temp_dir.path();
+
+    auto write_file = [](const QString& path, const QByteArray& data) {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    };
+
+    // img1 has an approved label, named by its complete base name; img2 is unlabeled
+    write_file(project + "/images/img1.v2.png", "one");
+    write_file(project + "/images/img2.png", "two");
+    write_file(project + "/labels/img1.v2.txt", "0 0.1 0.1 0.5 0.1 0.5 0.5 0.1 0.5\n");
+    write_file(project + "/models/a.pt", "model a");
+    write_file(project + "/models/b.pt", "model b");
+
+    // Model a finds the labeled square, model b a square elsewhere
+    write_file(project + "/plugin.sh",
+               "echo \"$2 $4\" >> calls.log\n"
+               "echo 'Loading model'\n"
+               "case \"$2\" in\n"
+               "  *a.pt) echo '{\"detections\":[{\"class\":\"cell\",\"confidence\":0.9,"
+               "\"points\":[[0.1,0.1],[0.5,0.1],[0.5,0.5],[0.1,0.5]]}]}' ;;\n"
+               "  *) echo '{\"detections\":[{\"class\":\"cell\",\"confidence\":0.8,"
+               "\"points\":[0.6,0.6,0.9,0.6,0.9,0.9,0.6,0.9]}]}' ;;\n"
+               "esac\n");
+
+    ProjectConfig config;
+    config.AddClass("cell", Qt::red);
+    PluginConfig plugin;
+    plugin.command = "sh";
+    plugin.script_path = "plugin.sh";
+    plugin.detect_args = "--model {model} --image {image}";
+    config.SetPluginConfig(plugin);
+
+    auto plugin_calls = [&project]() {
+        QFile log(project + "/calls.log");
+        return log.open(QIODevice::ReadOnly) ? log.readAll().count('\n') : 0;
+    };
+    auto run = [](ModelComparisonEngine& engine) {
+        QEventLoop loop;
+        bool canceled = true;
+        QObject::connect(&engine, &ModelComparisonEngine::finished, &loop,
+                         [&](bool was_canceled) { canceled = was_canceled; loop.quit(); });
+        QTimer::singleShot(30000, &loop, &QEventLoop::quit);
+        if (!engine.Start("models/a.pt", "models/b.pt", {"img1.v2.png", "img2.png"})) {
+            return false;
+        }
+        loop.exec();
+        return !canceled;
+    };
+
+    ModelComparisonEngine engine(config, project);
+    ASSERT_TRUE(run(engine));
+    EXPECT_EQ(plugin_calls(), 4);
+
+    const auto& results = engine.Results();
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_TRUE(results[0].has_labels);
+    EXPECT_FALSE(results[0].failed[0] || results[0].failed[1]);
+    ASSERT_EQ(results[0].detections[0].size(), 1);
+    EXPECT_EQ(results[0].detections[0][0].class_id, 0);
+
+    const auto a = results[0].metrics[0].value(0);
+    EXPECT_EQ(a.true_positives, 1);
+    EXPECT_EQ(a.false_positives, 0);
+    EXPECT_GT(a.MaskIoU(), 0.95);
+    const auto b = results[0].metrics[1].value(0);
+    EXPECT_EQ(b.true_positives, 0);
+    EXPECT_EQ(b.false_positives, 1);
+    EXPECT_EQ(b.false_negatives, 1);
+    EXPECT_DOUBLE_EQ(b.MaskIoU(), 0.0);
+    EXPECT_NEAR(results[0].disagreement, 1.0, 1e-9);
+
+    // Unlabeled images are compared but not scored
+    EXPECT_FALSE(results[1].has_labels);
+    EXPECT_TRUE(results[1].metrics[0].isEmpty());
+    EXPECT_DOUBLE_EQ(engine.Totals(0).value(0).Precision(), 1.0);
+    EXPECT_DOUBLE_EQ(engine.Totals(1).value(0).Recall(), 0.0);
+
+    // A second comparison is served from the cache
+    ModelComparisonEngine cached(config, project);
+    ASSERT_TRUE(run(cached));
+    EXPECT_EQ(plugin_calls(), 4);
+    EXPECT_EQ(cached.Results()[0].metrics[0].value(0).true_positives, 1);
+
+    // Replacing a model only re-runs that model
+    write_file(project + "/models/a.pt", "retrained model a");
+    ModelComparisonEngine retrained(config, project);
+    ASSERT_TRUE(run(retrained));
+    EXPECT_EQ(plugin_calls(), 6);
+}
+
+TEST_F(PolySegTest, ModelComparisonTotalsOnlyCountImagesBothModelsRan) {
+#ifndef Q_OS_UNIX
+    GTEST_SKIP() << "Stand-in plugin is a shell script";
+#endif
+    QTemporaryDir temp_dir;
+    ASSERT_TRUE(temp_dir.isValid());
+    const QString project = temp_dir.path();
+
+    auto write_file = [](const QString& path, const QByteArray& data) {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    };
+
+    // Both images are labeled; model b fails on img2
+    for (const QString& name : {QString("img1"), QString("img2")}) {
+        write_file(project + "/images/" + name + ".png", name.toUtf8());
+        write_file(project + "/labels/" + name + ".txt", "0 0.1 0.1 0.5 0.1 0.5 0.5 0.1 0.5\n");
+    }
+    write_file(project + "/models/a.pt", "model a");
+    write_file(project + "/models/b.pt", "model b");
+    write_file(project + "/plugin.sh",
+               "case \"$2 $4\" in\n"
+               "  *b.pt*img2*) exit 1 ;;\n"
+               "esac\n"
+               "echo '{\"detections\":[{\"class\":\"cell\",\"confidence\":0.9,"
+               "\"points\":[[0.1,0.1],[0.5,0.1],[0.5,0.5],[0.1,0.5]]}]}'\n");
+
+    ProjectConfig config;
+    config.AddClass("cell", Qt::red);
+    PluginConfig plugin;
+    plugin.command = "sh";
+    plugin.script_path = "plugin.sh";
+    plugin.detect_args = "--model {model} --image {image}";
+    config.SetPluginConfig(plugin);
+
+    ModelComparisonEngine engine(config, project);
+    QEventLoop loop;
+    QObject::connect(&engine, &ModelComparisonEngine::finished, &loop, &QEventLoop::quit);
+    QTimer::singleShot(30000, &loop, &QEventLoop::quit);
+    ASSERT_TRUE(engine.Start("models/a.pt", "models/b.pt", {"img1.png", "img2.png"}));
+    loop.exec();
+
+    const auto& results = engine.Results();
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_FALSE(results[0].failed[0] || results[0].failed[1]);
+    EXPECT_NEAR(results[0].disagreement, 0.0, 1e-9);
+    EXPECT_FALSE(results[1].failed[0]);
+    EXPECT_TRUE(results[1].failed[1]);
+    EXPECT_DOUBLE_EQ(results[1].disagreement, 1.0);
+
+    // img2 is left out for both models, not only for the one that failed on it
+    EXPECT_EQ(engine.Totals(0).value(0).true_positives, 1);
+    EXPECT_EQ(engine.Totals(1).value(0).true_positives, 1);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();